@@ -9,17 +9,31 @@
  */
 #pragma once
 
+#include <map>
+#include <string>
+
+#include "common/fb303/if/gen-cpp2/FacebookService.h"
+#include "common/stats/ServiceData.h"
+
 namespace folly {
 class EventBaseManager;
 }
 
 namespace facebook { namespace fb303 {
 
-class FacebookBase2 {
+class FacebookBase2 : virtual public cpp2::FacebookServiceSvIf {
 public:
   explicit FacebookBase2(const char*) {}
 
   void setEventBaseManager(folly::EventBaseManager*) {}
+
+  /*
+   * Serve the counters set in fbData, and everything exported from its
+   * stats and histograms.
+   */
+  void getCounters(std::map<std::string, int64_t>& counters) override {
+    fbData->getCounters(counters);
+  }
 };
 
 }}
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "common/stats/ExportedHistogramMap.h"
+
+#include <algorithm>
+
+#include <folly/Conv.h>
+#include <glog/logging.h>
+
+using std::chrono::seconds;
+
+namespace facebook { namespace stats {
+
+ExportedHistogram::ExportedHistogram(int64_t bucketWidth,
+                                     int64_t min,
+                                     int64_t max)
+  : bucketWidth_(bucketWidth),
+    min_(min),
+    max_(max) {
+  CHECK_GT(bucketWidth, 0);
+  CHECK_LT(min, max);
+  // The buckets between min and max, plus one either side
+  auto numBuckets = (max - min + bucketWidth - 1) / bucketWidth;
+  buckets_.resize(numBuckets + 2);
+}
+
+size_t ExportedHistogram::getBucketIdx(int64_t value) const {
+  if (value < min_) {
+    return 0;
+  }
+  if (value >= max_) {
+    return buckets_.size() - 1;
+  }
+  return (value - min_) / bucketWidth_ + 1;
+}
+
+void ExportedHistogram::addValue(seconds now, int64_t value, int64_t times) {
+  if (buckets_.empty()) {
+    return;
+  }
+  buckets_[getBucketIdx(value)].addValue(now, value * times, times);
+}
+
+void ExportedHistogram::addToBucket(seconds now,
+                                    size_t bucket,
+                                    int64_t sum,
+                                    int64_t count) {
+  if (bucket < buckets_.size()) {
+    buckets_[bucket].addValue(now, sum, count);
+  }
+}
+
+void ExportedHistogram::update(seconds now) {
+  for (auto& bucket : buckets_) {
+    bucket.update(now);
+  }
+}
+
+int64_t ExportedHistogram::sum(int level) const {
+  int64_t sum = 0;
+  for (const auto& bucket : buckets_) {
+    sum += bucket.sum(level);
+  }
+  return sum;
+}
+
+int64_t ExportedHistogram::count(int level) const {
+  int64_t count = 0;
+  for (const auto& bucket : buckets_) {
+    count += bucket.count(level);
+  }
+  return count;
+}
+
+int64_t ExportedHistogram::get(ExportType type, int level) const {
+  auto n = count(level);
+  switch (type) {
+    case SUM:
+      return sum(level);
+    case COUNT:
+      return n;
+    case AVG:
+      return n ? sum(level) / n : 0;
+    case RATE: {
+      auto duration = ExportedStat::levelDuration(level).count();
+      return duration ? sum(level) / duration : 0;
+    }
+    case PERCENT:
+      return n ? sum(level) * 100 / n : 0;
+    case NUM_TYPES:
+      break;
+  }
+  return 0;
+}
+
+int64_t ExportedHistogram::getPercentileEstimate(double pct,
+                                                 int level) const {
+  auto total = count(level);
+  if (total == 0) {
+    return 0;
+  }
+  double target = total * pct / 100.0;
+  double seen = 0;
+  for (size_t idx = 0; idx < buckets_.size(); ++idx) {
+    auto n = buckets_[idx].count(level);
+    if (n == 0 || seen + n < target) {
+      seen += n;
+      continue;
+    }
+    if (idx == 0) {
+      return min_;
+    }
+    if (idx == buckets_.size() - 1) {
+      return max_;
+    }
+    auto low = min_ + (idx - 1) * bucketWidth_;
+    auto high = std::min(low + bucketWidth_, max_);
+    return low + static_cast<int64_t>((high - low) * (target - seen) / n);
+  }
+  return max_;
+}
+
+ExportedHistogramMap::LockAndHistogram
+ExportedHistogramMap::getOrCreateLockAndHistogram(
+    folly::StringPiece name,
+    const ExportedHistogram* copyMe,
+    bool* createdPtr) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& item = histograms_[name.str()];
+  bool created = !item.hist.second;
+  if (created) {
+    item.hist.first = std::make_shared<SpinLock>();
+    item.hist.second = copyMe ?
+      std::make_shared<ExportedHistogram>(*copyMe) :
+      std::make_shared<ExportedHistogram>();
+  }
+  if (createdPtr) {
+    *createdPtr = created;
+  }
+  return item.hist;
+}
+
+void ExportedHistogramMap::exportStat(folly::StringPiece name,
+                                      ExportType type) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& types = histograms_[name.str()].types;
+  if (std::find(types.begin(), types.end(), type) == types.end()) {
+    types.push_back(type);
+  }
+}
+
+void ExportedHistogramMap::exportPercentile(folly::StringPiece name,
+                                            int pct) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& pcts = histograms_[name.str()].percentiles;
+  if (std::find(pcts.begin(), pcts.end(), pct) == pcts.end()) {
+    pcts.push_back(pct);
+  }
+}
+
+void ExportedHistogramMap::getCounters(
+    std::map<std::string, int64_t>& counters,
+    seconds now) {
+  std::lock_guard<std::mutex> g(mutex_);
+  for (const auto& entry : histograms_) {
+    const auto& item = entry.second;
+    if (!item.hist.second) {
+      continue;
+    }
+    SpinLockGuard guard(item.hist.first.get());
+    auto* hist = item.hist.second.get();
+    hist->update(now);
+    for (int level = 0; level < hist->numLevels(); ++level) {
+      for (auto type : item.types) {
+        counters[counterName(entry.first, exportTypeName(type), level)] =
+          hist->get(type, level);
+      }
+      for (auto pct : item.percentiles) {
+        counters[counterName(
+            entry.first, folly::to<std::string>("p", pct), level)] =
+          hist->getPercentileEstimate(pct, level);
+      }
+    }
+  }
+}
+
+}}
@@ -13,19 +13,67 @@
 
 namespace facebook { namespace stats {
 
+/*
+ * ExportedHistogram is a histogram of fixed width buckets between min and
+ * max, plus one bucket for values below min and one for values at or above
+ * max.  Each bucket is an ExportedStat, so the histogram is kept at the same
+ * minute, hour and all time levels as the stats are.
+ *
+ * Like ExportedStat, it does no locking of its own.
+ */
 class ExportedHistogram {
 public:
   ExportedHistogram() {}
-  ExportedHistogram(int, int, size_t) {}
-  void addValue(std::chrono::seconds, int, int64_t) {}
-  int numLevels() {return 1;}
-  int sum(int numLevels) {return 0;}
+  ExportedHistogram(int64_t bucketWidth, int64_t min, int64_t max);
+
+  /*
+   * Add the value to the histogram the given number of times.
+   */
+  void addValue(std::chrono::seconds now, int64_t value, int64_t times = 1);
+
+  /*
+   * Add to a bucket directly, for samples which have already been bucketed.
+   */
+  void addToBucket(std::chrono::seconds now,
+                   size_t bucket,
+                   int64_t sum,
+                   int64_t count);
+
+  void update(std::chrono::seconds now);
+
+  size_t getBucketIdx(int64_t value) const;
+  size_t getNumBuckets() const {
+    return buckets_.size();
+  }
+
+  int numLevels() const {
+    return ExportedStat::kNumLevels;
+  }
+  int64_t sum(int level) const;
+  int64_t count(int level) const;
+  int64_t get(ExportType type, int level) const;
+
+  /*
+   * An estimate of the given percentile at the given level, interpolated
+   * within the bucket it falls in.
+   */
+  int64_t getPercentileEstimate(double pct, int level) const;
+
+private:
+  int64_t bucketWidth_{1};
+  int64_t min_{0};
+  int64_t max_{0};
+  std::vector<ExportedStat> buckets_;
 };
 
 class ExportedHistogramMap {
 public:
   class SpinLockGuard {
-      /* no op */
+  public:
+    explicit SpinLockGuard(SpinLock* lock) : guard_(*lock) {}
+
+  private:
+    std::unique_lock<SpinLock> guard_;
   };
 
   struct LockAndHistogram {
@@ -33,26 +81,63 @@ public:
     std::shared_ptr<ExportedHistogram> second;
   };
 
-  LockAndHistogram getOrCreateLockAndHistogram(folly::StringPiece,
-                                                const ExportedHistogram*,
-                                                bool* createdPtr = nullptr) {
-    if (createdPtr) *createdPtr = true;
-    return LockAndHistogram();
-  }
+  /*
+   * Get the named histogram, creating it as a copy of copyMe if it doesn't
+   * exist yet.
+   */
+  LockAndHistogram getOrCreateLockAndHistogram(folly::StringPiece name,
+                                               const ExportedHistogram* copyMe,
+                                               bool* createdPtr = nullptr);
 
-  struct LockableHistogram : public ExportedHistogram {
-    SpinLockGuard makeLockGuard() {return SpinLockGuard();}
-    void addValueLocked(SpinLockGuard&, std::chrono::seconds::rep, int, uint64_t) {}
-  };
+  struct LockableHistogram {
+    LockableHistogram() {}
+    explicit LockableHistogram(LockAndHistogram item)
+      : item_(std::move(item)) {}
 
-  LockableHistogram getOrCreateLockableHistogram(folly::StringPiece,
-                                                const ExportedHistogram*,
-                                                bool* createdPtr = nullptr) {
-    if (createdPtr) {
-        *createdPtr = true;
+    SpinLockGuard makeLockGuard() {
+      return SpinLockGuard(item_.first.get());
     }
-    return LockableHistogram();
+    void addValueLocked(SpinLockGuard&,
+                        std::chrono::seconds::rep now,
+                        int64_t value,
+                        uint64_t times) {
+      item_.second->addValue(std::chrono::seconds(now), value, times);
+    }
+
+  private:
+    LockAndHistogram item_;
+  };
+
+  LockableHistogram getOrCreateLockableHistogram(
+      folly::StringPiece name,
+      const ExportedHistogram* copyMe,
+      bool* createdPtr = nullptr) {
+    return LockableHistogram(
+        getOrCreateLockAndHistogram(name, copyMe, createdPtr));
   }
+
+  /*
+   * Export the histogram's stat of the given type, or its estimate of the
+   * given percentile, as counters named e.g. "name.avg.60" or "name.p50.60".
+   */
+  void exportStat(folly::StringPiece name, ExportType type);
+  void exportPercentile(folly::StringPiece name, int pct);
+
+  /*
+   * Add every exported counter, as of the given time, to the map.
+   */
+  void getCounters(std::map<std::string, int64_t>& counters,
+                   std::chrono::seconds now);
+
+private:
+  struct Item {
+    LockAndHistogram hist;
+    std::vector<ExportType> types;
+    std::vector<int> percentiles;
+  };
+
+  std::mutex mutex_;
+  std::map<std::string, Item> histograms_;
 };
 
 }}
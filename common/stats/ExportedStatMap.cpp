@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "common/stats/ExportedStatMap.h"
+
+#include <algorithm>
+
+#include <folly/Conv.h>
+
+using std::chrono::seconds;
+
+namespace facebook { namespace stats {
+
+constexpr int ExportedStat::kNumLevels;
+constexpr int ExportedStat::kNumBuckets;
+
+folly::StringPiece exportTypeName(ExportType type) {
+  switch (type) {
+    case SUM:
+      return "sum";
+    case COUNT:
+      return "count";
+    case AVG:
+      return "avg";
+    case RATE:
+      return "rate";
+    case PERCENT:
+      return "pct";
+    case NUM_TYPES:
+      break;
+  }
+  return "unknown";
+}
+
+std::string counterName(folly::StringPiece name,
+                        folly::StringPiece type,
+                        int level) {
+  auto duration = ExportedStat::levelDuration(level);
+  if (duration.count() == 0) {
+    return folly::to<std::string>(name, ".", type);
+  }
+  return folly::to<std::string>(name, ".", type, ".", duration.count());
+}
+
+seconds ExportedStat::levelDuration(int level) {
+  switch (level) {
+    case 0:
+      return seconds(60);
+    case 1:
+      return seconds(3600);
+    default:
+      return seconds(0);
+  }
+}
+
+void ExportedStat::addValue(seconds now, int64_t value, int64_t count) {
+  auto t = now.count();
+  if (first_ < 0 || t < first_) {
+    first_ = t;
+  }
+  latest_ = std::max(latest_, t);
+  totalSum_ += value;
+  totalCount_ += count;
+
+  for (int level = 0; level < kNumLevels - 1; ++level) {
+    auto width = levelDuration(level).count() / kNumBuckets;
+    auto start = t - t % width;
+    if (start + levelDuration(level).count() <= latest_) {
+      // Too old for this level
+      continue;
+    }
+    auto& bucket = buckets_[level][(t / width) % kNumBuckets];
+    if (bucket.start != start) {
+      if (bucket.start > start) {
+        // The bucket already holds newer data
+        continue;
+      }
+      bucket = Bucket();
+      bucket.start = start;
+    }
+    bucket.sum += value;
+    bucket.count += count;
+  }
+}
+
+void ExportedStat::update(seconds now) {
+  latest_ = std::max(latest_, now.count());
+}
+
+bool ExportedStat::inWindow(const Bucket& bucket, int level) const {
+  return bucket.start >= 0 &&
+    bucket.start + levelDuration(level).count() > latest_;
+}
+
+int64_t ExportedStat::sum(int level) const {
+  if (level >= kNumLevels - 1) {
+    return totalSum_;
+  }
+  int64_t sum = 0;
+  for (const auto& bucket : buckets_[level]) {
+    if (inWindow(bucket, level)) {
+      sum += bucket.sum;
+    }
+  }
+  return sum;
+}
+
+int64_t ExportedStat::count(int level) const {
+  if (level >= kNumLevels - 1) {
+    return totalCount_;
+  }
+  int64_t count = 0;
+  for (const auto& bucket : buckets_[level]) {
+    if (inWindow(bucket, level)) {
+      count += bucket.count;
+    }
+  }
+  return count;
+}
+
+int64_t ExportedStat::avg(int level) const {
+  auto n = count(level);
+  return n ? sum(level) / n : 0;
+}
+
+int64_t ExportedStat::rate(int level) const {
+  if (first_ < 0) {
+    return 0;
+  }
+  // Per second, over the part of the level that has data in it
+  auto elapsed = latest_ - first_ + 1;
+  auto duration = levelDuration(level).count();
+  if (duration > 0) {
+    elapsed = std::min(elapsed, duration);
+  }
+  return sum(level) / elapsed;
+}
+
+int64_t ExportedStat::get(ExportType type, int level) const {
+  switch (type) {
+    case SUM:
+      return sum(level);
+    case COUNT:
+      return count(level);
+    case AVG:
+      return avg(level);
+    case RATE:
+      return rate(level);
+    case PERCENT: {
+      auto n = count(level);
+      return n ? sum(level) * 100 / n : 0;
+    }
+    case NUM_TYPES:
+      break;
+  }
+  return 0;
+}
+
+ExportedStatMap::LockAndStatItem ExportedStatMap::getStatItem(
+    folly::StringPiece name) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& item = stats_[name.str()];
+  if (!item.stat.second) {
+    item.stat.first = std::make_shared<SpinLock>();
+    item.stat.second = std::make_shared<ExportedStat>();
+  }
+  return item.stat;
+}
+
+ExportedStatMap::LockAndStatItem ExportedStatMap::getLockAndStatItem(
+    folly::StringPiece name,
+    const ExportType* type) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& item = stats_[name.str()];
+  if (!item.stat.second) {
+    item.stat.first = std::make_shared<SpinLock>();
+    item.stat.second = std::make_shared<ExportedStat>();
+  }
+  auto exportType = type ? *type : AVG;
+  if (type || item.types.empty()) {
+    if (std::find(item.types.begin(), item.types.end(), exportType) ==
+        item.types.end()) {
+      item.types.push_back(exportType);
+    }
+  }
+  return item.stat;
+}
+
+ExportedStatMap::LockedStatPtr ExportedStatMap::getLockedStatPtr(
+    folly::StringPiece name) {
+  return LockedStatPtr(getStatItem(name));
+}
+
+void ExportedStatMap::getCounters(std::map<std::string, int64_t>& counters,
+                                  seconds now) {
+  std::lock_guard<std::mutex> g(mutex_);
+  for (const auto& entry : stats_) {
+    const auto& item = entry.second;
+    if (item.types.empty()) {
+      continue;
+    }
+    SpinLockHolder guard(item.stat.first.get());
+    auto* stat = item.stat.second.get();
+    stat->update(now);
+    for (auto type : item.types) {
+      for (int level = 0; level < stat->numLevels(); ++level) {
+        counters[counterName(entry.first, exportTypeName(type), level)] =
+          stat->get(type, level);
+      }
+    }
+  }
+}
+
+}}
@@ -10,16 +10,44 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/SpinLock.h>
+#include <array>
 #include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace facebook {
 
 class SpinLock {
+public:
+  void lock() {
+    lock_.lock();
+  }
+  void unlock() {
+    lock_.unlock();
+  }
+
+private:
+  folly::SpinLock lock_;
 };
 
 class SpinLockHolder {
 public:
-  explicit SpinLockHolder(SpinLock*) {}
+  explicit SpinLockHolder(SpinLock* lock) : lock_(lock) {
+    lock_->lock();
+  }
+  ~SpinLockHolder() {
+    lock_->unlock();
+  }
+
+private:
+  SpinLockHolder(const SpinLockHolder&) = delete;
+  SpinLockHolder& operator=(const SpinLockHolder&) = delete;
+
+  SpinLock* lock_;
 };
 
 namespace stats {
@@ -33,15 +61,88 @@ enum ExportType {
   NUM_TYPES,
 };
 
-struct ExportedStat {
-  void addValue(std::chrono::seconds, int64_t) {}
-  void addValue(std::chrono::seconds::rep, uint64_t) {}
-  void addValueLocked(std::chrono::seconds::rep, uint64_t) {}
-  int numLevels() {return 1;}
-  int getSum(int level) {return 0;}
-  int sum(int level) {return 0;}
+/*
+ * The name an ExportType is exported under, such as "sum" or "avg".
+ */
+folly::StringPiece exportTypeName(ExportType type);
+
+/*
+ * ExportedStat is a timeseries kept at three levels: the last minute, the
+ * last hour, and all time.  The minute and hour levels are each a ring of 60
+ * buckets, so old data ages out a bucket at a time.
+ *
+ * ExportedStat does no locking of its own: the owning ExportedStatMap hands
+ * out a lock with each stat.
+ */
+class ExportedStat {
+public:
+  static constexpr int kNumLevels = 3;
+
+  void addValue(std::chrono::seconds now, int64_t value, int64_t count = 1);
+  void addValue(std::chrono::seconds::rep now, uint64_t value) {
+    addValue(std::chrono::seconds(now), static_cast<int64_t>(value));
+  }
+  void addValueLocked(std::chrono::seconds::rep now, uint64_t value) {
+    addValue(now, value);
+  }
+
+  /*
+   * Age out any data which is no longer in the minute and hour levels as of
+   * the given time.  The getters below return the data as of the latest
+   * time the stat has been updated to or had a value added at.
+   */
+  void update(std::chrono::seconds now);
+
+  int numLevels() const {
+    return kNumLevels;
+  }
+
+  /*
+   * The duration of a level, or zero for the all time level.
+   */
+  static std::chrono::seconds levelDuration(int level);
+
+  int64_t sum(int level) const;
+  int64_t count(int level) const;
+  int64_t avg(int level) const;
+  int64_t rate(int level) const;
+  int64_t getSum(int level) const {
+    return sum(level);
+  }
+
+  /*
+   * The value exported for the given type at the given level.
+   */
+  int64_t get(ExportType type, int level) const;
+
+private:
+  static constexpr int kNumBuckets = 60;
+
+  struct Bucket {
+    int64_t sum{0};
+    int64_t count{0};
+    // The start of the time the bucket covers, or -1 if it is empty
+    int64_t start{-1};
+  };
+
+  bool inWindow(const Bucket& bucket, int level) const;
+
+  std::array<std::array<Bucket, kNumBuckets>, kNumLevels - 1> buckets_;
+  int64_t totalSum_{0};
+  int64_t totalCount_{0};
+  // The time of the first value added, or -1 if there are none
+  int64_t first_{-1};
+  int64_t latest_{0};
 };
 
+/*
+ * The name a counter is exported under for the given stat, type and level,
+ * e.g. "trapped.pkts.sum.60", or "trapped.pkts.sum" for the all time level.
+ */
+std::string counterName(folly::StringPiece name,
+                        folly::StringPiece type,
+                        int level);
+
 class ExportedStatMap {
 public:
   class LockAndStatItem {
@@ -49,30 +150,83 @@ public:
     std::shared_ptr<SpinLock> first;
     std::shared_ptr<ExportedStat> second;
   };
-  LockAndStatItem getLockAndStatItem(folly::StringPiece,
-                                     const ExportType* = nullptr) {
-    static LockAndStatItem it = {
-      std::make_shared<SpinLock>(), std::make_shared<ExportedStat>()
-    };
-    return it;
-  }
 
-  class LockableStat : public ExportedStat {
+  /*
+   * Get the named stat, creating it if need be, and export it with the
+   * given type as well as any it is already exported with.  With no type
+   * given, a new stat is exported as an AVG.
+   */
+  LockAndStatItem getLockAndStatItem(folly::StringPiece name,
+                                     const ExportType* type = nullptr);
+
+  /*
+   * A handle on a stat which takes the stat's lock for each update.
+   */
+  class LockableStat {
+  public:
+    LockableStat() {}
+    explicit LockableStat(LockAndStatItem item) : item_(std::move(item)) {}
+
+    void addValue(std::chrono::seconds::rep now, int64_t value) {
+      if (!item_.second) {
+        return;
+      }
+      SpinLockHolder guard(item_.first.get());
+      item_.second->addValue(std::chrono::seconds(now), value);
+    }
+
+  private:
+    LockAndStatItem item_;
   };
 
-  LockableStat getLockableStat(folly::StringPiece,
-                               const ExportType* = nullptr) {
-    static LockableStat stat;
-    return stat;
+  LockableStat getLockableStat(folly::StringPiece name,
+                               const ExportType* type = nullptr) {
+    return LockableStat(getLockAndStatItem(name, type));
   }
 
-  std::shared_ptr<ExportedStat> getLockedStatPtr(folly::StringPiece name) {
-      return std::make_shared<ExportedStat>();
-  }
+  /*
+   * A pointer to a stat which holds the stat's lock while it exists.
+   */
+  class LockedStatPtr {
+  public:
+    explicit LockedStatPtr(LockAndStatItem item)
+      : item_(std::move(item)),
+        guard_(*item_.first) {}
+
+    ExportedStat* operator->() const {
+      return item_.second.get();
+    }
+    ExportedStat& operator*() const {
+      return *item_.second;
+    }
+
+  private:
+    LockAndStatItem item_;
+    std::unique_lock<SpinLock> guard_;
+  };
+
+  LockedStatPtr getLockedStatPtr(folly::StringPiece name);
 
   std::shared_ptr<ExportedStat> getStatPtr(folly::StringPiece name) {
-      return std::make_shared<ExportedStat>();
+    return getStatItem(name).second;
   }
+
+  /*
+   * Add every exported counter, as of the given time, to the map.
+   */
+  void getCounters(std::map<std::string, int64_t>& counters,
+                   std::chrono::seconds now);
+
+private:
+  struct Item {
+    LockAndStatItem stat;
+    std::vector<ExportType> types;
+  };
+
+  LockAndStatItem getStatItem(folly::StringPiece name);
+
+  std::mutex mutex_;
+  std::map<std::string, Item> stats_;
 };
 
 }}
@@ -10,15 +10,55 @@
 #pragma once
 
 #include "common/stats/ExportedHistogramMap.h"
+#include "common/stats/ServiceData.h"
 #include <folly/Range.h>
 
 namespace facebook { namespace stats {
 
+/*
+ * MonotonicCounter exports a counter kept elsewhere, such as a hardware
+ * counter, which only ever goes up.  Each updateValue() adds the increase
+ * since the previous one to the named stat.
+ */
 class MonotonicCounter {
 public:
-  MonotonicCounter(folly::StringPiece, ExportType, ExportType) {}
-  void updateValue(std::chrono::seconds, int64_t) {}
-  void swap(MonotonicCounter& counter) {}
+  MonotonicCounter(folly::StringPiece name,
+                   ExportType type1,
+                   ExportType type2 = NUM_TYPES)
+    : name_(name.str()) {
+    auto* statMap = fbData->getStatMap();
+    stat_ = statMap->getLockAndStatItem(name, &type1);
+    if (type2 != NUM_TYPES) {
+      statMap->getLockAndStatItem(name, &type2);
+    }
+  }
+
+  void updateValue(std::chrono::seconds now, int64_t value) {
+    if (havePrev_ && value >= prev_) {
+      SpinLockHolder guard(stat_.first.get());
+      stat_.second->addValue(now, value - prev_);
+    }
+    // The first value, or the counter being reset, is only a new baseline
+    prev_ = value;
+    havePrev_ = true;
+  }
+
+  void swap(MonotonicCounter& counter) {
+    std::swap(name_, counter.name_);
+    std::swap(stat_, counter.stat_);
+    std::swap(prev_, counter.prev_);
+    std::swap(havePrev_, counter.havePrev_);
+  }
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+private:
+  std::string name_;
+  ExportedStatMap::LockAndStatItem stat_;
+  int64_t prev_{0};
+  bool havePrev_{false};
 };
 
 }}
@@ -13,4 +13,50 @@ static facebook::stats::ServiceData payload;
 
 namespace facebook {
 facebook::stats::ServiceData* fbData = &payload;
+
+namespace stats {
+
+void ServiceData::getCounters(std::map<std::string, int64_t>& counters) {
+  using namespace std::chrono;
+  auto now = duration_cast<seconds>(system_clock::now().time_since_epoch());
+  {
+    std::lock_guard<std::mutex> g(countersMutex_);
+    for (const auto& counter : counters_) {
+      counters[counter.first] = counter.second;
+    }
+  }
+  statMap_.getCounters(counters, now);
+  histMap_.getCounters(counters, now);
+}
+
+int64_t ServiceData::getCounter(folly::StringPiece name) {
+  {
+    std::lock_guard<std::mutex> g(countersMutex_);
+    auto it = counters_.find(name.str());
+    if (it != counters_.end()) {
+      return it->second;
+    }
+  }
+  std::map<std::string, int64_t> counters;
+  getCounters(counters);
+  auto it = counters.find(name.str());
+  return it != counters.end() ? it->second : 0;
+}
+
+bool ServiceData::clearCounter(folly::StringPiece name) {
+  std::lock_guard<std::mutex> g(countersMutex_);
+  return counters_.erase(name.str()) > 0;
 }
+
+void ServiceData::setCounter(folly::StringPiece name, int64_t value) {
+  std::lock_guard<std::mutex> g(countersMutex_);
+  counters_[name.str()] = value;
+}
+
+int64_t ServiceData::incrementCounter(folly::StringPiece name,
+                                      int64_t amount) {
+  std::lock_guard<std::mutex> g(countersMutex_);
+  return counters_[name.str()] += amount;
+}
+
+}} // facebook::stats
@@ -12,24 +12,51 @@
 #include "common/stats/ExportedStatMap.h"
 #include "common/stats/ExportedHistogramMap.h"
 #include <map>
+#include <mutex>
+#include <string>
 
 namespace facebook { namespace stats {
 
+/*
+ * ServiceData holds the process's stats and histograms, along with any
+ * counters set directly, and exports them all as fb303 counters.
+ */
 class ServiceData {
 public:
   ExportedStatMap* getStatMap() {
-    static ExportedStatMap it;
-    return &it;
+    return &statMap_;
   }
   ExportedHistogramMap* getHistogramMap() {
-    static ExportedHistogramMap it;
-    return &it;
+    return &histMap_;
   }
-  void getCounters(std::map<std::string, int64_t>&) {}
-  long getCounter(std::string) {return 0;};
-  long clearCounter(std::string) {return 0;};
+
+  /*
+   * Add all the counters, and the current value of every exported stat and
+   * histogram, to the map.
+   */
+  void getCounters(std::map<std::string, int64_t>& counters);
+
+  /*
+   * Get a single counter, or 0 if there is no such counter.
+   */
+  int64_t getCounter(folly::StringPiece name);
+
+  /*
+   * Remove a counter set with setCounter(), returning whether it existed.
+   */
+  bool clearCounter(folly::StringPiece name);
+
+  void setCounter(folly::StringPiece name, int64_t value);
+  int64_t incrementCounter(folly::StringPiece name, int64_t amount = 1);
+
   void setUseOptionsAsFlags(bool) {}
-  void setCounter(folly::StringPiece, uint32_t) {}
+
+private:
+  ExportedStatMap statMap_;
+  ExportedHistogramMap histMap_;
+
+  std::mutex countersMutex_;
+  std::map<std::string, int64_t> counters_;
 };
 
 }
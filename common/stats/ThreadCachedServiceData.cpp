@@ -0,0 +1,186 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "common/stats/ThreadCachedServiceData.h"
+
+#include "common/stats/ServiceData.h"
+
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+
+namespace facebook { namespace stats {
+
+ThreadCachedServiceData::ThreadLocalStatsMap::ThreadLocalStatsMap(
+    ThreadCachedServiceData* parent)
+  : parent_(parent) {
+  parent_->registerMap(this);
+}
+
+ThreadCachedServiceData::ThreadLocalStatsMap::~ThreadLocalStatsMap() {
+  // Once unregistered, no publishStats() call can be looking at us, so
+  // whatever the thread counted since the last one can be published safely
+  parent_->unregisterMap(this);
+  publish(duration_cast<seconds>(system_clock::now().time_since_epoch()));
+}
+
+ThreadCachedServiceData::TimeseriesCell*
+ThreadCachedServiceData::ThreadLocalStatsMap::getTimeseries(
+    folly::StringPiece name,
+    const ExportedStatMap::LockAndStatItem& stat) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& cell = timeseries_[name.str()];
+  if (!cell) {
+    cell = std::make_unique<folly::CachelinePadded<TimeseriesCell>>();
+    (*cell)->stat = stat;
+  }
+  return cell->get();
+}
+
+ThreadCachedServiceData::HistogramCell*
+ThreadCachedServiceData::ThreadLocalStatsMap::getHistogram(
+    folly::StringPiece name,
+    int64_t bucketWidth,
+    int64_t min,
+    int64_t max,
+    const ExportedHistogramMap::LockAndHistogram& hist) {
+  std::lock_guard<std::mutex> g(mutex_);
+  auto& cell = histograms_[name.str()];
+  if (!cell) {
+    cell = std::make_unique<folly::CachelinePadded<HistogramCell>>(
+        bucketWidth, min, max, hist.second->getNumBuckets());
+    (*cell)->hist = hist;
+  }
+  return cell->get();
+}
+
+void ThreadCachedServiceData::ThreadLocalStatsMap::publish(seconds now) {
+  std::lock_guard<std::mutex> g(mutex_);
+  for (auto& entry : timeseries_) {
+    auto* cell = entry.second->get();
+    auto sum = cell->sum.load(std::memory_order_relaxed);
+    auto count = cell->count.load(std::memory_order_relaxed);
+    if (count == cell->publishedCount) {
+      continue;
+    }
+    {
+      SpinLockHolder guard(cell->stat.first.get());
+      cell->stat.second->addValue(now, sum - cell->publishedSum,
+                                  count - cell->publishedCount);
+    }
+    cell->publishedSum = sum;
+    cell->publishedCount = count;
+  }
+
+  for (auto& entry : histograms_) {
+    auto* cell = entry.second->get();
+    ExportedHistogramMap::SpinLockGuard guard(cell->hist.first.get());
+    for (size_t idx = 0; idx < cell->buckets.size(); ++idx) {
+      auto& bucket = cell->buckets[idx];
+      auto sum = bucket.sum.load(std::memory_order_relaxed);
+      auto count = bucket.count.load(std::memory_order_relaxed);
+      if (count == bucket.publishedCount) {
+        continue;
+      }
+      cell->hist.second->addToBucket(now, idx, sum - bucket.publishedSum,
+                                     count - bucket.publishedCount);
+      bucket.publishedSum = sum;
+      bucket.publishedCount = count;
+    }
+  }
+}
+
+ThreadCachedServiceData::TLTimeseries::TLTimeseries(
+    ThreadLocalStatsMap* map,
+    folly::StringPiece name,
+    ExportType type1,
+    ExportType type2) {
+  auto* statMap = fbData->getStatMap();
+  auto stat = statMap->getLockAndStatItem(name, &type1);
+  if (type2 != NUM_TYPES) {
+    statMap->getLockAndStatItem(name, &type2);
+  }
+  cell_ = map->getTimeseries(name, stat);
+}
+
+ThreadCachedServiceData::TLHistogram::TLHistogram(
+    ThreadLocalStatsMap* map,
+    folly::StringPiece name,
+    int64_t bucketWidth,
+    int64_t min,
+    int64_t max)
+  : TLHistogram(map, name, bucketWidth, min, max, AVG, -1, -1) {}
+
+ThreadCachedServiceData::TLHistogram::TLHistogram(
+    ThreadLocalStatsMap* map,
+    folly::StringPiece name,
+    int64_t bucketWidth,
+    int64_t min,
+    int64_t max,
+    ExportType type,
+    int pct1,
+    int pct2) {
+  auto* histMap = fbData->getHistogramMap();
+  ExportedHistogram layout(bucketWidth, min, max);
+  auto hist = histMap->getOrCreateLockAndHistogram(name, &layout);
+  histMap->exportStat(name, type);
+  for (auto pct : {pct1, pct2}) {
+    if (pct >= 0) {
+      histMap->exportPercentile(name, pct);
+    }
+  }
+  cell_ = map->getHistogram(name, bucketWidth, min, max, hist);
+}
+
+void ThreadCachedServiceData::TLHistogram::addRepeatedValue(
+    int64_t value,
+    int64_t nsamples) {
+  auto& bucket = cell_->buckets[cell_->bucketIdx(value)];
+  add(&bucket.sum, value * nsamples);
+  add(&bucket.count, nsamples);
+}
+
+ThreadCachedServiceData::ThreadCachedServiceData() {}
+
+ThreadCachedServiceData* ThreadCachedServiceData::get() {
+  // Never destroyed, as threads may still publish their stats as they exit
+  // during shutdown
+  static auto* instance = new ThreadCachedServiceData();
+  return instance;
+}
+
+ThreadCachedServiceData::ThreadLocalStatsMap*
+ThreadCachedServiceData::getThreadStats() {
+  auto* map = threadStats_.get();
+  if (!map) {
+    map = new ThreadLocalStatsMap(this);
+    threadStats_.reset(map);
+  }
+  return map;
+}
+
+void ThreadCachedServiceData::publishStats() {
+  auto now = duration_cast<seconds>(system_clock::now().time_since_epoch());
+  std::lock_guard<std::mutex> g(mapsMutex_);
+  for (auto* map : maps_) {
+    map->publish(now);
+  }
+}
+
+void ThreadCachedServiceData::registerMap(ThreadLocalStatsMap* map) {
+  std::lock_guard<std::mutex> g(mapsMutex_);
+  maps_.insert(map);
+}
+
+void ThreadCachedServiceData::unregisterMap(ThreadLocalStatsMap* map) {
+  std::lock_guard<std::mutex> g(mapsMutex_);
+  maps_.erase(map);
+}
+
+}}
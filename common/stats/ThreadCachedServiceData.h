@@ -9,47 +9,203 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <folly/CachelinePadded.h>
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
+
+#include "common/stats/ExportedHistogramMap.h"
 #include "common/stats/ExportedStatMap.h"
 
 namespace facebook { namespace stats {
 
+/*
+ * ThreadCachedServiceData keeps stats in per-thread counters, so that
+ * updating one is a plain add to memory only the current thread writes,
+ * with no locking and no shared cache lines.  publishStats() periodically
+ * adds what each thread has counted since the last publish to the global
+ * ExportedStatMap and ExportedHistogramMap in fbData, from where they are
+ * exported as fb303 counters.
+ */
 class ThreadCachedServiceData {
 public:
+  class ThreadLocalStatsMap;
+
+  /*
+   * A per-thread counter cell.  Only the owning thread writes the values;
+   * the atomics just make the publishing thread's reads well defined, and
+   * are only ever loaded and stored with relaxed ordering on the fast path.
+   */
+  struct TimeseriesCell {
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> count{0};
+    // What has been published so far, only accessed while publishing
+    int64_t publishedSum{0};
+    int64_t publishedCount{0};
+    ExportedStatMap::LockAndStatItem stat;
+  };
+
+  struct HistogramCell {
+    struct Bucket {
+      std::atomic<int64_t> sum{0};
+      std::atomic<int64_t> count{0};
+      int64_t publishedSum{0};
+      int64_t publishedCount{0};
+    };
+    HistogramCell(int64_t bucketWidth, int64_t min, int64_t max,
+                  size_t numBuckets)
+      : bucketWidth(bucketWidth),
+        min(min),
+        max(max),
+        buckets(numBuckets) {}
+
+    // The same bucketing as ExportedHistogram::getBucketIdx()
+    size_t bucketIdx(int64_t value) const {
+      if (value < min) {
+        return 0;
+      }
+      if (value >= max) {
+        return buckets.size() - 1;
+      }
+      return (value - min) / bucketWidth + 1;
+    }
+
+    const int64_t bucketWidth;
+    const int64_t min;
+    const int64_t max;
+    std::vector<Bucket> buckets;
+    ExportedHistogramMap::LockAndHistogram hist;
+  };
+
+  /*
+   * The counter cells for one thread.
+   */
   class ThreadLocalStatsMap {
+  public:
+    explicit ThreadLocalStatsMap(ThreadCachedServiceData* parent);
+    ~ThreadLocalStatsMap();
+
+    /*
+     * Get the cell for the named stat or histogram, creating it to add to
+     * the given global one if this thread doesn't have one yet.
+     */
+    TimeseriesCell* getTimeseries(folly::StringPiece name,
+                                  const ExportedStatMap::LockAndStatItem& stat);
+    HistogramCell* getHistogram(
+        folly::StringPiece name,
+        int64_t bucketWidth,
+        int64_t min,
+        int64_t max,
+        const ExportedHistogramMap::LockAndHistogram& hist);
+
+    /*
+     * Add everything counted since the last publish to the global stats.
+     */
+    void publish(std::chrono::seconds now);
+
+  private:
+    ThreadLocalStatsMap(const ThreadLocalStatsMap&) = delete;
+    ThreadLocalStatsMap& operator=(const ThreadLocalStatsMap&) = delete;
+
+    ThreadCachedServiceData* parent_{nullptr};
+    // Held by the owning thread to add cells, and while publishing
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<folly::CachelinePadded<
+      TimeseriesCell>>> timeseries_;
+    std::map<std::string, std::unique_ptr<folly::CachelinePadded<
+      HistogramCell>>> histograms_;
   };
 
   class TLTimeseries {
   public:
-    TLTimeseries(ThreadLocalStatsMap*, folly::StringPiece,
-                 ExportType, ExportType = ExportType()) {}
-    void addValue(int64_t) {}
+    TLTimeseries(ThreadLocalStatsMap* map,
+                 folly::StringPiece name,
+                 ExportType type1,
+                 ExportType type2 = NUM_TYPES);
+
+    void addValue(int64_t value) {
+      add(&cell_->sum, value);
+      add(&cell_->count, 1);
+    }
+
+  private:
+    TimeseriesCell* cell_{nullptr};
   };
 
+  /*
+   * A histogram of buckets bucketWidth wide between min and max.  It is
+   * exported with the given stat type and percentiles, or just its average
+   * if none are given.
+   */
   class TLHistogram {
   public:
-    TLHistogram(ThreadLocalStatsMap*, folly::StringPiece, int, int, int) {}
-    TLHistogram(
-        ThreadLocalStatsMap*, folly::StringPiece, int, int, int,
-        facebook::stats::ExportType, int, int) {}
-    void addValue(int64_t) {}
-    void addRepeatedValue(int64_t /*value*/, int64_t /*nsamples*/) {}
+    TLHistogram(ThreadLocalStatsMap* map,
+                folly::StringPiece name,
+                int64_t bucketWidth,
+                int64_t min,
+                int64_t max);
+    TLHistogram(ThreadLocalStatsMap* map,
+                folly::StringPiece name,
+                int64_t bucketWidth,
+                int64_t min,
+                int64_t max,
+                ExportType type,
+                int pct1,
+                int pct2);
+
+    void addValue(int64_t value) {
+      addRepeatedValue(value, 1);
+    }
+    void addRepeatedValue(int64_t value, int64_t nsamples);
+
+  private:
+    HistogramCell* cell_{nullptr};
   };
 
-  static ThreadCachedServiceData* get() {
-    static ThreadCachedServiceData it;
-    return &it;
-  }
-  ThreadLocalStatsMap* getThreadStats() {
-    static ThreadLocalStatsMap it;
-    return &it;
-  }
+  static ThreadCachedServiceData* get();
+
+  /*
+   * The counter cells for the calling thread.
+   */
+  ThreadLocalStatsMap* getThreadStats();
+
   bool publishThreadRunning() const {
     return false;
   }
-  void publishStats() {
+
+  /*
+   * Publish the stats counted by every thread so far.  This can be called
+   * from any thread, and should be called about once a second.
+   */
+  void publishStats();
+
+private:
+  friend class ThreadLocalStatsMap;
+
+  ThreadCachedServiceData();
+
+  static void add(std::atomic<int64_t>* counter, int64_t value) {
+    // Only the owning thread writes the counter, so this needn't be an
+    // atomic read-modify-write
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
   }
+
+  void registerMap(ThreadLocalStatsMap* map);
+  void unregisterMap(ThreadLocalStatsMap* map);
+
+  struct ThreadLocalTag {};
+  folly::ThreadLocalPtr<ThreadLocalStatsMap, ThreadLocalTag> threadStats_;
+  std::mutex mapsMutex_;
+  std::set<ThreadLocalStatsMap*> maps_;
 };
 
 }}
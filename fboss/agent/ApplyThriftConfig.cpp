@@ -71,11 +71,13 @@ class ThriftConfigApplier {
   ThriftConfigApplier(const std::shared_ptr<SwitchState>& orig,
                       const cfg::SwitchConfig* config,
                       const Platform* platform,
-                      const cfg::SwitchConfig* prevCfg)
+                      const cfg::SwitchConfig* prevCfg,
+                      bool prevCfgApplied)
     : orig_(orig),
       cfg_(config),
       platform_(platform),
-      prevCfg_(prevCfg) {}
+      prevCfg_(prevCfg),
+      prevCfgApplied_(prevCfgApplied) {}
 
   std::shared_ptr<SwitchState> run();
 
@@ -102,6 +104,17 @@ class ThriftConfigApplier {
     }
   }
 
+  /*
+   * Whether a section of the config differs from the previous config.  Each
+   * section is a top level field, compared as a whole.  This is only known
+   * when orig_ is the result of applying the previous config, otherwise
+   * every section is taken to have changed.
+   */
+  template<typename T>
+  bool sectionChanged(T cfg::SwitchConfig::* section) const {
+    return !prevCfgApplied_ || !(cfg_->*section == prevCfg_->*section);
+  }
+
   // Interface route prefix. IPAddress has mask applied
   typedef std::pair<folly::IPAddress, uint8_t> Prefix;
   typedef std::pair<InterfaceID, folly::IPAddress> IntfAddress;
@@ -164,9 +177,7 @@ class ThriftConfigApplier {
   bool updateNeighborResponseTables(Vlan* vlan, const cfg::Vlan* config);
   bool updateDhcpOverrides(Vlan* vlan, const cfg::Vlan* config);
   std::shared_ptr<InterfaceMap> updateInterfaces();
-  std::shared_ptr<RouteTableMap> updateInterfaceRoutes();
-  std::shared_ptr<RouteTableMap> updateStaticRoutes(
-      const std::shared_ptr<RouteTableMap>& curRoutingTables);
+  void updateInterfaceRoutes(RouteUpdater* updater);
   shared_ptr<Interface> createInterface(const cfg::Interface* config,
                                         const Interface::Addresses& addrs);
   shared_ptr<Interface> updateInterface(const shared_ptr<Interface>& orig,
@@ -180,6 +191,7 @@ class ThriftConfigApplier {
   const cfg::SwitchConfig* cfg_{nullptr};
   const Platform* platform_{nullptr};
   const cfg::SwitchConfig* prevCfg_{nullptr};
+  const bool prevCfgApplied_{false};
 
   struct VlanIpInfo {
     VlanIpInfo(uint8_t mask, MacAddress mac, InterfaceID intf)
@@ -206,6 +218,21 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
   auto newState = orig_->clone();
   bool changed = false;
 
+  // The sections that are the same as in the previous config are skipped,
+  // as the state already has them.  The ports are always applied, since
+  // their admin state is changed at run time too, and a reload puts it back
+  // as configured.
+  bool aggPortsChanged = sectionChanged(&cfg::SwitchConfig::aggregatePorts);
+  bool intfsChanged = sectionChanged(&cfg::SwitchConfig::interfaces);
+  bool vlansChanged = intfsChanged ||
+    sectionChanged(&cfg::SwitchConfig::vlans) ||
+    sectionChanged(&cfg::SwitchConfig::vlanPorts);
+  bool staticRoutesChanged =
+    sectionChanged(&cfg::SwitchConfig::staticRoutesWithNhops) ||
+    sectionChanged(&cfg::SwitchConfig::staticRoutesToNull) ||
+    sectionChanged(&cfg::SwitchConfig::staticRoutesToCPU);
+  bool aclsChanged = sectionChanged(&cfg::SwitchConfig::acls);
+
   processVlanPorts();
 
   {
@@ -216,7 +243,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
     }
   }
 
-  {
+  if (aggPortsChanged) {
     auto newAggPorts = updateAggregatePorts();
     if (newAggPorts) {
       newState->resetAggregatePorts(std::move(newAggPorts));
@@ -224,7 +251,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
     }
   }
 
-  {
+  if (vlansChanged) {
     auto newIntfs = updateInterfaces();
     if (newIntfs) {
       newState->resetIntfs(std::move(newIntfs));
@@ -234,7 +261,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
 
   // Note: updateInterfaces() must be called before updateVlans(),
   // as updateInterfaces() populates the vlanInterfaces_ data structure.
-  {
+  if (vlansChanged) {
     auto newVlans = updateVlans();
     if (newVlans) {
       newState->resetVlans(std::move(newVlans));
@@ -244,16 +271,19 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
 
   // Note: updateInterfaces() must be called before updateInterfaceRoutes(),
   // as updateInterfaces() populates the intfRouteTables_ data structure.
-  {
-    auto newTables = updateInterfaceRoutes();
-    if (newTables) {
-      newState->resetRouteTables(newTables);
-      changed = true;
+  // The interface and static routes are changed together, so that the
+  // routes are only resolved once.
+  if (intfsChanged || staticRoutesChanged) {
+    RouteUpdater updater(orig_->getRouteTables());
+    if (intfsChanged) {
+      updateInterfaceRoutes(&updater);
+    }
+    if (staticRoutesChanged) {
+      updater.updateStaticRoutes(*cfg_, *prevCfg_);
     }
-    auto newerTables = updateStaticRoutes(newTables ? newTables :
-        orig_->getRouteTables());
-    if (newerTables) {
-      newState->resetRouteTables(std::move(newerTables));
+    auto newTables = updater.updateDone();
+    if (newTables) {
+      newState->resetRouteTables(std::move(newTables));
       changed = true;
     }
   }
@@ -287,7 +317,7 @@ shared_ptr<SwitchState> ThriftConfigApplier::run() {
    }
   }
 
-  {
+  if (aclsChanged) {
     auto newAcls = updateAcls();
     if (newAcls) {
       newState->resetAcls(std::move(newAcls));
@@ -867,10 +897,9 @@ bool ThriftConfigApplier::updateNeighborResponseTables(
   return changed;
 }
 
-shared_ptr<RouteTableMap> ThriftConfigApplier::updateInterfaceRoutes() {
+void ThriftConfigApplier::updateInterfaceRoutes(RouteUpdater* updater) {
   flat_set<RouterID> newToAddTables;
   flat_set<RouterID> oldToDeleteTables;
-  RouteUpdater updater(orig_->getRouteTables());
   // add or update the interface routes
   for (const auto& table : intfRouteTables_) {
     for (const auto& entry : table.second) {
@@ -886,7 +915,7 @@ shared_ptr<RouteTableMap> ThriftConfigApplier::updateInterfaceRoutes() {
         continue;
       }
 
-      updater.addRoute(table.first, intf, addr, len);
+      updater->addRoute(table.first, intf, addr, len);
     }
     newToAddTables.insert(table.first);
   }
@@ -912,27 +941,18 @@ shared_ptr<RouteTableMap> ThriftConfigApplier::updateInterfaceRoutes() {
         }
       }
       if (!found) {
-        updater.delRouteWithNoNexthops(id, addr.first, addr.second);
+        updater->delRouteWithNoNexthops(id, addr.first, addr.second);
       }
     }
   }
   // delete v6 link route from no long existing router ID
   for (auto id : oldToDeleteTables) {
-    updater.delLinkLocalRoutes(id);
+    updater->delLinkLocalRoutes(id);
   }
   // add v6 link route to the new router
   for (auto id : newToAddTables) {
-    updater.addLinkLocalRoutes(id);
+    updater->addLinkLocalRoutes(id);
   }
-  return updater.updateDone();
-}
-
-
-std::shared_ptr<RouteTableMap> ThriftConfigApplier::updateStaticRoutes(
-    const std::shared_ptr<RouteTableMap>& curRoutingTables) {
-  RouteUpdater updater(curRoutingTables);
-  updater.updateStaticRoutes(*cfg_, *prevCfg_);
-  return updater.updateDone();
 }
 
 std::shared_ptr<InterfaceMap> ThriftConfigApplier::updateInterfaces() {
@@ -1104,29 +1124,33 @@ shared_ptr<SwitchState> applyThriftConfig(
     const cfg::SwitchConfig* prevConfig) {
   cfg::SwitchConfig emptyConfig;
   return ThriftConfigApplier(state, config, platform,
-      prevConfig ? prevConfig : &emptyConfig).run();
+      prevConfig ? prevConfig : &emptyConfig, prevConfig != nullptr).run();
 }
 
 std::pair<std::shared_ptr<SwitchState>, std::string> applyThriftConfigFile(
   const std::shared_ptr<SwitchState>& state,
   const folly::StringPiece path,
   const Platform* platform,
-  const cfg::SwitchConfig* prevConfig) {
+  const cfg::SwitchConfig* prevConfig,
+  cfg::SwitchConfig* newConfig) {
   //
   // This is basically what configerator's getConfigAndParse() code does,
   // except that we manually read the file from disk for now.
   // We may not be able to rely on the configerator infrastructure for
   // distributing the config files.
   cfg::SwitchConfig config;
+  if (!newConfig) {
+    newConfig = &config;
+  }
   std::string configStr;
   if (!folly::readFile(path.toString().c_str(), configStr)) {
     throw FbossError("unable to read ", path);
   }
   apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
-      configStr.c_str(), config);
+      configStr.c_str(), *newConfig);
 
   return std::make_pair(
-      applyThriftConfig(state, &config, platform, prevConfig), configStr);
+      applyThriftConfig(state, newConfig, platform, prevConfig), configStr);
 }
 
 }} // facebook::fboss
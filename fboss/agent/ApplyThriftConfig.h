@@ -26,6 +26,9 @@ class SwitchState;
  *
  * Returns a new SwitchState object with the resulting state, or null if
  * the config file results in no changes.
+ *
+ * prevConfig, if given, must be the config the state is the result of.  The
+ * sections of the config that are the same in both are then skipped.
  */
 std::shared_ptr<SwitchState> applyThriftConfig(
   const std::shared_ptr<SwitchState>& state,
@@ -33,15 +36,22 @@ std::shared_ptr<SwitchState> applyThriftConfig(
   const Platform* platform,
   const cfg::SwitchConfig* prevConfig = nullptr);
 
+/*
+ * As applyThriftConfig(), reading the config from a file.  Returns the
+ * config file contents along with the new state, and leaves the parsed
+ * config in newConfig if given.
+ */
 std::pair<std::shared_ptr<SwitchState>, std::string> applyThriftConfigFile(
   const std::shared_ptr<SwitchState>& state,
   const folly::StringPiece path,
   const Platform* platform,
-  const cfg::SwitchConfig* prevConfig);
+  const cfg::SwitchConfig* prevConfig,
+  cfg::SwitchConfig* newConfig = nullptr);
 
 std::pair<std::shared_ptr<SwitchState>, std::string> applyThriftConfigDefault(
   const std::shared_ptr<SwitchState> state,
   const Platform* platform,
-  const cfg::SwitchConfig* prevConfig);
+  const cfg::SwitchConfig* prevConfig,
+  cfg::SwitchConfig* newConfig = nullptr);
 
 }} // facebook::fboss
@@ -27,30 +27,39 @@ namespace facebook { namespace fboss {
 // Wrapper for the actual Thrift call
 inline void SampleSender::publish(unique_ptr<CounterPublication> pub) {
   if (!killSwitch_->isSet()) {
-    // Note that it's okay to give the callback a shared_ptr to the client
-    // without the eventBase because the actual call and callback are run in
-    // the eventbase thread.
-    auto& client = client_;
-    auto& killSwitch = killSwitch_;
-    client->publishCounters(
-        [killSwitch, client](
-            apache::thrift::ClientReceiveState&& state) mutable {
-          // For oneway functions like this one, only exceptions make it here.
-          if (state.isException()) {
-            if (!killSwitch->set()) {
-              LOG(ERROR) << "Exception sending publication: "
-                         << folly::exceptionStr(state.exception());
-            }
-            // else, we were already dying so don't beat a dead horse
-          } else {
-            LOG(ERROR) << "There was a result to a oneway call";
-          }
-        },
-        *pub);
+    client_->publishCounters(makeCallback(), *pub);
     rateCalc_.finishedSamples(pub->times.size() * numCounters_);
   }
 }
 
+inline void SampleSender::publish(unique_ptr<CompactCounterPublication> pub) {
+  if (!killSwitch_->isSet()) {
+    client_->publishCompactCounters(makeCallback(), *pub);
+    rateCalc_.finishedSamples(pub->numSamples * numCounters_);
+  }
+}
+
+inline SampleSender::PublishCallback SampleSender::makeCallback() {
+  // Note that it's okay to give the callback a shared_ptr to the client
+  // without the eventBase because the actual call and callback are run in
+  // the eventbase thread.
+  auto& client = client_;
+  auto& killSwitch = killSwitch_;
+  return [killSwitch, client](
+      apache::thrift::ClientReceiveState&& state) mutable {
+    // For oneway functions like this one, only exceptions make it here.
+    if (state.isException()) {
+      if (!killSwitch->set()) {
+        LOG(ERROR) << "Exception sending publication: "
+                   << folly::exceptionStr(state.exception());
+      }
+      // else, we were already dying so don't beat a dead horse
+    } else {
+      LOG(ERROR) << "There was a result to a oneway call";
+    }
+  };
+}
+
 // Helper function to get the current machine's hostname
 string getLocalHostname() {
   const size_t kHostnameMaxLen = 256;  // from gethostname man page
@@ -83,6 +92,9 @@ SampleProducer::SampleProducer(unique_ptr<HighresSamplerList> samplers,
       numCounters_(numCounters) {
   overloadWarningCounter_ = 0;
   numSamplesAtLastOverloadWarning_ = 0;
+  if (negotiatePublicationFormat(req.formats) == PublicationFormat::COMPACT) {
+    encoder_ = make_unique<CompactPublicationEncoder>(hostname_);
+  }
 }
 
 inline void SampleProducer::nanosleepHelper(const nanoseconds& timeLeft) {
@@ -151,19 +163,33 @@ inline void SampleProducer::buildPublication(
   }
 }
 
-void SampleProducer::publish(unique_ptr<CounterPublication> pub) {
+void SampleProducer::startPublication(CounterPublication* pub) {
+  pub->hostname = hostname_;
+  pub->times.reserve(batchSize_);
+  for (const auto& sampler : (*samplers_.get())) {
+    sampler->startPublication(pub, batchSize_);
+  }
+}
+
+void SampleProducer::publish(unique_ptr<CounterPublication>* pub) {
   auto& sender = sender_;
-  auto wrappedPub = folly::makeMoveWrapper(std::move(pub));
   // Schedule the send in a eb thread.  We include the a shared pointer to the
   // sender so it doesn't get destroyed too early.
-  eventBase_->runInEventBaseThread(
-      [sender, wrappedPub]() mutable { sender->publish(wrappedPub.move()); });
+  if (encoder_) {
+    auto wrappedPub = folly::makeMoveWrapper(encoder_->encode(pub->get()));
+    eventBase_->runInEventBaseThread(
+        [sender, wrappedPub]() mutable { sender->publish(wrappedPub.move()); });
+  } else {
+    auto wrappedPub = folly::makeMoveWrapper(std::move(*pub));
+    eventBase_->runInEventBaseThread(
+        [sender, wrappedPub]() mutable { sender->publish(wrappedPub.move()); });
+    *pub = make_unique<CounterPublication>();
+  }
 }
 
 void SampleProducer::produce() {
   auto pub = make_unique<CounterPublication>();
-
-  pub->hostname = hostname_;
+  startPublication(pub.get());
   auto batchCounter = 0;
 
   sender_->initialize();
@@ -176,12 +202,11 @@ void SampleProducer::produce() {
        ++i) {
     buildPublication(pub.get(), currentTime);
 
-    // Check if we have a full batch.  If so move it to the queue and make a new
-    // publication.
+    // Check if we have a full batch.  If so move it to the queue and start a
+    // new publication.
     if (++batchCounter >= batchSize_) {
-      publish(std::move(pub));
-      pub = make_unique<CounterPublication>();
-      pub->hostname = hostname_;
+      publish(&pub);
+      startPublication(pub.get());
       batchCounter = 0;
     }
 
@@ -194,7 +219,7 @@ void SampleProducer::produce() {
   }
 
   if (batchCounter > 0) {
-    publish(std::move(pub));
+    publish(&pub);
   }
 }
 }} // facebook::fboss
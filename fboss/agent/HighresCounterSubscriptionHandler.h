@@ -39,6 +39,7 @@
 #include <folly/MoveWrapper.h>
 
 #include "fboss/agent/HighresCounterUtil.h"
+#include "fboss/agent/HighresPublicationCodec.h"
 #include "fboss/agent/if/gen-cpp2/FbossHighresClient.h"
 
 namespace facebook { namespace fboss {
@@ -118,12 +119,19 @@ class SampleSender {
    *                     after this function returns.
    */
   void publish(std::unique_ptr<CounterPublication> pub);
+  void publish(std::unique_ptr<CompactCounterPublication> pub);
 
  private:
   // Non-copyable
   SampleSender(const SampleSender&) = delete;
   SampleSender& operator=(const SampleSender&) = delete;
 
+  typedef std::function<void(apache::thrift::ClientReceiveState&&)>
+    PublishCallback;
+
+  // The callback for publish calls, which sets the kill switch on errors
+  PublishCallback makeCallback();
+
   std::shared_ptr<FbossHighresClientAsyncClient> client_;
   std::shared_ptr<Signal> killSwitch_;
   folly::EventBase* const eventBase_;
@@ -189,8 +197,13 @@ class SampleProducer {
       CounterPublication* pub,
       const std::chrono::high_resolution_clock::time_point& time);
 
-  // Schedule the SampleSender in a tm thread
-  inline void publish(std::unique_ptr<CounterPublication> pub);
+  // Make room in pub for a full batch, and let the samplers set up their
+  // columns in it
+  inline void startPublication(CounterPublication* pub);
+
+  // Schedule the SampleSender in a tm thread.  In the COMPACT format the
+  // batch is encoded and pub is left empty to be reused for the next one.
+  inline void publish(std::unique_ptr<CounterPublication>* pub);
 
   // For the normal polling loop
   std::unique_ptr<HighresSamplerList> samplers_;
@@ -207,6 +220,8 @@ class SampleProducer {
   const std::chrono::nanoseconds interval_;
   const int32_t batchSize_;
   const SleepMethod sleepMethod_;
+  // Only set for the COMPACT format
+  std::unique_ptr<CompactPublicationEncoder> encoder_;
 
   // For keeping track of the rate at which we are processing updates
   SingleThreadRateCalculator rateCalc_;
@@ -9,9 +9,14 @@
  */
 #include "fboss/agent/HighresCounterUtil.h"
 
-#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 
-#include <sstream>
+#include <algorithm>
+
+#include <folly/Conv.h>
 
 DEFINE_bool(print_rates,
             false,
@@ -19,13 +24,46 @@ DEFINE_bool(print_rates,
 
 namespace facebook { namespace fboss {
 
+namespace {
+const char* const kProcNetDev = "/proc/net/dev";
+// Enough for a couple of hundred interfaces
+const size_t kProcNetDevBufSize = 32 * 1024;
+
+// In/out traffic in bytes are the 1st and the 9th fields after the
+// interface name.  Indexes start at 0.
+const int kRxBytesField = 0;
+const int kTxBytesField = 8;
+
+// Parse the unsigned number at *p, skipping any spaces before it
+uint64_t parseField(const char** p, const char* end) {
+  auto pos = *p;
+  while (pos < end && *pos == ' ') {
+    ++pos;
+  }
+  uint64_t value = 0;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    value = value * 10 + (*pos - '0');
+    ++pos;
+  }
+  *p = pos;
+  return value;
+}
+}
+
+void SampleColumns::start(CounterPublication* pub, size_t batchSize) {
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    auto& column = pub->counterValues[counters_[i]];
+    column.reserve(column.size() + batchSize);
+    columns_[i] = &column;
+  }
+}
+
 DumbCounterSampler::DumbCounterSampler(
     const std::set<CounterRequest>& counters) {
   for (const auto& c: counters) {
     if (c.counterName.compare(kDumbCounterName) == 0) {
-      // If there are duplicate requests, overwrite
-      req_ = c;
-      numCounters_ = 1;
+      // There can only be one request for the counter in the set
+      columns_.addCounter(c);
     } else {
       LOG(WARNING) << "Requested counter " << c.counterName
                    << " does not exist";
@@ -33,24 +71,105 @@ DumbCounterSampler::DumbCounterSampler(
   }
 }
 
+void DumbCounterSampler::startPublication(CounterPublication* pub,
+                                          size_t batchSize) {
+  columns_.start(pub, batchSize);
+}
+
 void DumbCounterSampler::sample(CounterPublication* pub) {
-  pub->counterValues[req_].push_back(++counter_);
+  ++counter_;
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    columns_.append(i, counter_);
+  }
 }
 
 InterfaceRateSampler::InterfaceRateSampler(
     const std::set<CounterRequest>& counters) {
-  struct stat buffer;
-  if (stat("/proc/net/dev", &buffer) != 0) {
-    LOG(ERROR) << "/proc/net/dev does not exist."
-               << " Ignoring any InterfaceRateSamplers";
+  fd_ = open(kProcNetDev, O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    PLOG(ERROR) << "Unable to open " << kProcNetDev
+                << ". Ignoring any InterfaceRateSamplers";
     return;
   }
+  buf_.resize(kProcNetDevBufSize);
 
   for (const auto& c : counters) {
-    if (c.counterName.compare(kTxBytesCounterName) == 0 ||
-        c.counterName.compare(kRxBytesCounterName) == 0) {
-      counters_.insert(c);
+    if (c.counterName.compare(kTxBytesCounterName) == 0) {
+      columns_.addCounter(c);
+      isTx_.push_back(true);
+    } else if (c.counterName.compare(kRxBytesCounterName) == 0) {
+      columns_.addCounter(c);
+      isTx_.push_back(false);
+    }
+  }
+}
+
+InterfaceRateSampler::~InterfaceRateSampler() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void InterfaceRateSampler::startPublication(CounterPublication* pub,
+                                            size_t batchSize) {
+  columns_.start(pub, batchSize);
+}
+
+ssize_t InterfaceRateSampler::readProcNetDev() {
+  while (true) {
+    // proc files are generated as they are read, so read from the start
+    // until EOF, rather than relying on a single read getting everything
+    size_t len = 0;
+    while (len < buf_.size()) {
+      auto n = pread(fd_, buf_.data() + len, buf_.size() - len, len);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return -1;
+      }
+      if (n == 0) {
+        return len;
+      }
+      len += n;
     }
+    // Out of room, so there must be more interfaces than when we started
+    buf_.resize(buf_.size() * 2);
+  }
+}
+
+void InterfaceRateSampler::parseProcNetDev(folly::StringPiece data,
+                                           uint64_t* rxBytes,
+                                           uint64_t* txBytes) {
+  *rxBytes = 0;
+  *txBytes = 0;
+
+  // After two header lines there is a line per interface, of the form
+  // "  eth0: <rx bytes> <rx packets> ... <tx bytes> ...".  We consider only
+  // ethN interfaces.
+  auto pos = data.begin();
+  auto end = data.end();
+  while (pos < end) {
+    auto eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    if (!eol) {
+      eol = end;
+    }
+    while (pos < eol && *pos == ' ') {
+      ++pos;
+    }
+    auto colon = static_cast<const char*>(memchr(pos, ':', eol - pos));
+    if (colon && colon - pos >= 3 && memcmp(pos, "eth", 3) == 0) {
+      pos = colon + 1;
+      for (int field = 0; field <= kTxBytesField; ++field) {
+        auto value = parseField(&pos, eol);
+        if (field == kRxBytesField) {
+          *rxBytes += value;
+        } else if (field == kTxBytesField) {
+          *txBytes += value;
+        }
+      }
+    }
+    pos = eol + 1;
   }
 }
 
@@ -58,37 +177,79 @@ void InterfaceRateSampler::sample(CounterPublication* pub) {
   uint64_t sin = -1;
   uint64_t sout = -1;
 
-  ifs_.open("/proc/net/dev");
-  std::string line, buf;
-  if (ifs_.is_open()) {
-    // In/out traffic in bytes are located at the 1st and the 9th tokens
-    // for each interface. Indexes start at 0.
-    // We consider only ethN interfaces.
-    sin = sout = 0;
-    while (getline(ifs_, line)) {
-      std::istringstream iss(line);
-
-      iss >> buf;
-      const std::string prefix = "eth";
-
-      if (buf.substr(0, prefix.size()) == prefix) {
-        iss >> buf;
-        sin += atoll(buf.c_str());
-
-        for (int tokid = 2; tokid < 10; ++tokid)
-          iss >> buf;
-        sout += atoll(buf.c_str());
+  auto len = readProcNetDev();
+  if (len >= 0) {
+    parseProcNetDev(folly::StringPiece(buf_.data(), len), &sin, &sout);
+  }
+
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    columns_.append(i, isTx_[i] ? sout : sin);
+  }
+}
+
+const char* const PortCounterSampler::kStatNames[NUM_STATS] = {
+  "in_bytes",
+  "in_pkts",
+  "out_bytes",
+  "out_pkts",
+};
+
+PortCounterSampler::PortCounterSampler(
+    const std::set<CounterRequest>& counters,
+    ReadFn read)
+  : read_(std::move(read)) {
+  std::vector<uint64_t> values(NUM_STATS);
+  for (const auto& c : counters) {
+    // Parse "port<id>.<stat>"
+    folly::StringPiece name(c.counterName);
+    auto dot = name.find('.');
+    int stat = NUM_STATS;
+    PortID port(0);
+    if (name.startsWith("port") && dot != folly::StringPiece::npos) {
+      auto statName = name.subpiece(dot + 1);
+      for (int i = 0; i < NUM_STATS; ++i) {
+        if (statName == kStatNames[i]) {
+          stat = i;
+          break;
+        }
       }
+      try {
+        port = PortID(folly::to<uint16_t>(name.subpiece(4, dot - 4)));
+      } catch (const std::exception&) {
+        stat = NUM_STATS;
+      }
+    }
+    if (stat == NUM_STATS || !read_(port, values.data())) {
+      LOG(WARNING) << "Requested counter " << c.counterName
+                   << " does not exist";
+      continue;
     }
-    ifs_.close();
+
+    auto iter = std::find(ports_.begin(), ports_.end(), port);
+    auto portIdx = iter - ports_.begin();
+    if (iter == ports_.end()) {
+      ports_.push_back(port);
+    }
+    columns_.addCounter(c);
+    valueIdx_.push_back(portIdx * NUM_STATS + stat);
   }
+  values_.resize(ports_.size() * NUM_STATS);
+}
 
-  for (const auto& c : counters_) {
-    if (c.counterName.compare(kTxBytesCounterName) == 0) {
-      pub->counterValues[c].push_back(sout);
-    } else if (c.counterName.compare(kRxBytesCounterName) == 0) {
-      pub->counterValues[c].push_back(sin);
+void PortCounterSampler::startPublication(CounterPublication* pub,
+                                          size_t batchSize) {
+  columns_.start(pub, batchSize);
+}
+
+void PortCounterSampler::sample(CounterPublication* pub) {
+  for (size_t i = 0; i < ports_.size(); ++i) {
+    if (!read_(ports_[i], &values_[i * NUM_STATS])) {
+      std::fill_n(values_.begin() + i * NUM_STATS, NUM_STATS, -1);
     }
   }
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    columns_.append(i, values_[valueIdx_[i]]);
+  }
 }
+
 }} // facebook::fboss
@@ -9,13 +9,16 @@
  */
  #pragma once
 
+#include <folly/Range.h>
 #include <folly/Synchronized.h>
 
 #include "fboss/agent/if/gen-cpp2/highres_types.h"
+#include "fboss/agent/types.h"
 
 #include <chrono>
-#include <fstream>
+#include <functional>
 #include <set>
+#include <vector>
 
 DECLARE_bool(print_rates);
 
@@ -41,6 +44,16 @@ class HighresSampler {
    */
   virtual void sample(CounterPublication* pub) = 0;
 
+  /*
+   * Called with each new publication before it is sampled into, with the
+   * number of samples it will hold.  Samplers can use this to look up and
+   * reserve their columns in pub once, rather than on every sample.
+   *
+   * @param[out]   pub        The publication about to be sampled into.
+   * @param[in]    batchSize  The number of rounds of samples pub will hold.
+   */
+  virtual void startPublication(CounterPublication* pub, size_t batchSize) {}
+
   /*
    * The number of counters handled by this sampler.  Potential reasons why a
    * counter is invalid are if the namespace is not valid on our hardware or if
@@ -52,6 +65,38 @@ class HighresSampler {
   virtual int numCounters() const = 0;
 };
 
+/*
+ * The columns of a publication that a sampler appends its values to, one per
+ * counter.  The columns are looked up, and have room reserved for a whole
+ * batch, once per publication in start(), so that after that appending a
+ * value neither searches the publication nor allocates.
+ */
+class SampleColumns {
+ public:
+  void addCounter(const CounterRequest& counter) {
+    counters_.push_back(counter);
+    columns_.push_back(nullptr);
+  }
+
+  void start(CounterPublication* pub, size_t batchSize);
+
+  void append(size_t idx, int64_t value) {
+    columns_[idx]->push_back(value);
+  }
+
+  size_t size() const {
+    return counters_.size();
+  }
+  const CounterRequest& counter(size_t idx) const {
+    return counters_[idx];
+  }
+
+ private:
+  std::vector<CounterRequest> counters_;
+  // Point into the current publication's counterValues
+  std::vector<std::vector<int64_t>*> columns_;
+};
+
 /*
  * A sampler that simply increments and returns a counter.  Used for performance
  * testing/debugging.
@@ -61,7 +106,8 @@ class DumbCounterSampler : public HighresSampler {
   explicit DumbCounterSampler(const std::set<CounterRequest>& counters);
   ~DumbCounterSampler() override {}
   void sample(CounterPublication* pub) override;
-  int numCounters() const override {return numCounters_;}
+  void startPublication(CounterPublication* pub, size_t batchSize) override;
+  int numCounters() const override {return columns_.size();}
 
   /// constant strings representing the namespace and counter names.  We store
   /// everything explicitly for speed.
@@ -69,21 +115,35 @@ class DumbCounterSampler : public HighresSampler {
   static constexpr const char* const kDumbCounterName = "foo";
 
  private:
-  CounterRequest req_;
+  SampleColumns columns_;
   int counter_ = 0;
-  int numCounters_ = 0;
 };
 
 /*
  * A sampler that polls the proc file system for interface Tx/Rx rates.
+ *
+ * /proc/net/dev is kept open and read into the same buffer every time, and
+ * parsed in place, so sampling doesn't reopen the file or allocate.  Each
+ * sample preads from the start until EOF, which takes a few calls when the
+ * file is bigger than one read returns, and the buffer only grows if the
+ * file outgrows it.
  */
 class InterfaceRateSampler : public HighresSampler {
  public:
   explicit InterfaceRateSampler(const std::set<CounterRequest>& counters);
-  ~InterfaceRateSampler() override {}
+  ~InterfaceRateSampler() override;
   void sample(CounterPublication* pub) override;
+  void startPublication(CounterPublication* pub, size_t batchSize) override;
 
-  int numCounters() const override { return counters_.size(); }
+  int numCounters() const override { return columns_.size(); }
+
+  /*
+   * Add up the received and transmitted bytes of the ethN interfaces in the
+   * contents of /proc/net/dev.
+   */
+  static void parseProcNetDev(folly::StringPiece data,
+                              uint64_t* rxBytes,
+                              uint64_t* txBytes);
 
   /// constant strings representing the namespace and counter names.  We store
   /// everything explicitly for speed.
@@ -92,10 +152,59 @@ class InterfaceRateSampler : public HighresSampler {
   static constexpr const char* const kRxBytesCounterName = "rx";
 
  private:
-  // We save an ifstream for reading counters without needing to repeatedly call
-  // the constructor
-  std::ifstream ifs_;
-  std::set<CounterRequest> counters_;
+  // Read /proc/net/dev into buf_, returning the number of bytes read or -1
+  ssize_t readProcNetDev();
+
+  int fd_{-1};
+  // Only grows if /proc/net/dev doesn't fit, i.e. when interfaces are added
+  std::vector<char> buf_;
+  SampleColumns columns_;
+  // Whether each column is tx rather than rx
+  std::vector<bool> isTx_;
+};
+
+/*
+ * A sampler for per-port hardware counters, for HwSwitch implementations to
+ * hand out from getHighresSamplers().  Counters are named
+ * "port<id>.<stat>", e.g. "port1.in_bytes".
+ *
+ * Each port's counters are read in one call into a scratch array sized up
+ * front, and appended from there to the publication's columns.
+ */
+class PortCounterSampler : public HighresSampler {
+ public:
+  enum Stat {
+    IN_BYTES,
+    IN_PKTS,
+    OUT_BYTES,
+    OUT_PKTS,
+    NUM_STATS,
+  };
+
+  /*
+   * Reads the current value of every Stat of a port into values, which has
+   * room for NUM_STATS values.  Returns false if there is no such port.
+   */
+  typedef std::function<bool(PortID port, uint64_t* values)> ReadFn;
+
+  PortCounterSampler(const std::set<CounterRequest>& counters, ReadFn read);
+  ~PortCounterSampler() override {}
+  void sample(CounterPublication* pub) override;
+  void startPublication(CounterPublication* pub, size_t batchSize) override;
+
+  int numCounters() const override { return columns_.size(); }
+
+  static constexpr const char* const kIdentifier = "port_counters";
+  static const char* const kStatNames[NUM_STATS];
+
+ private:
+  ReadFn read_;
+  // The ports to read, and a NUM_STATS slice of values_ for each
+  std::vector<PortID> ports_;
+  std::vector<uint64_t> values_;
+  SampleColumns columns_;
+  // The index into values_ of each column
+  std::vector<size_t> valueIdx_;
 };
 
 /*
@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HighresPublicationCodec.h"
+
+#include <algorithm>
+
+#include <folly/Range.h>
+#include <glog/logging.h>
+
+#include "fboss/agent/FbossError.h"
+
+using folly::ByteRange;
+using std::string;
+
+namespace facebook { namespace fboss {
+
+namespace {
+
+constexpr int64_t kNsPerSec = 1000 * 1000 * 1000;
+// Longest possible varint encoding of a 64 bit value
+constexpr size_t kMaxVarintSize = 10;
+
+uint64_t zigzagEncode(int64_t val) {
+  return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+int64_t zigzagDecode(uint64_t val) {
+  return static_cast<int64_t>((val >> 1) ^ -(val & 1));
+}
+
+// The differences wrap rather than overflow, as do the sums when decoding
+int64_t delta(int64_t val, int64_t last) {
+  return static_cast<int64_t>(
+      static_cast<uint64_t>(val) - static_cast<uint64_t>(last));
+}
+
+int64_t undelta(int64_t last, int64_t delta) {
+  return static_cast<int64_t>(
+      static_cast<uint64_t>(last) + static_cast<uint64_t>(delta));
+}
+
+void appendDelta(string* out, int64_t val, int64_t* last) {
+  auto zz = zigzagEncode(delta(val, *last));
+  *last = val;
+
+  char buf[kMaxVarintSize];
+  size_t len = 0;
+  while (zz >= 0x80) {
+    buf[len++] = 0x80 | (zz & 0x7f);
+    zz >>= 7;
+  }
+  buf[len++] = zz;
+  out->append(buf, len);
+}
+
+class DeltaReader {
+ public:
+  explicit DeltaReader(const string& data)
+    : data_(reinterpret_cast<const uint8_t*>(data.data()), data.size()) {}
+
+  int64_t next(int64_t* last) {
+    uint64_t val = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (data_.empty()) {
+        throw FbossError("truncated compact counter publication");
+      }
+      auto byte = data_[0];
+      data_.advance(1);
+      val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        *last = undelta(*last, zigzagDecode(val));
+        return *last;
+      }
+    }
+    throw FbossError("invalid varint in compact counter publication");
+  }
+
+  bool done() const {
+    return data_.empty();
+  }
+
+ private:
+  ByteRange data_;
+};
+
+}
+
+PublicationFormat negotiatePublicationFormat(
+    const std::vector<PublicationFormat>& formats) {
+  if (std::find(formats.begin(), formats.end(), PublicationFormat::COMPACT) !=
+      formats.end()) {
+    return PublicationFormat::COMPACT;
+  }
+  return PublicationFormat::STRUCT;
+}
+
+std::unique_ptr<CompactCounterPublication> CompactPublicationEncoder::encode(
+    CounterPublication* pub) {
+  auto numSamples = pub->times.size();
+  auto out = std::make_unique<CompactCounterPublication>();
+  out->hostname = hostname_;
+  out->seqNum = seqNum_;
+  out->numSamples = numSamples;
+
+  if (seqNum_++ == 0) {
+    // Send the counter ids
+    for (const auto& column : pub->counterValues) {
+      out->counters.push_back(column.first);
+    }
+    lastValues_.resize(pub->counterValues.size());
+  }
+  CHECK_EQ(pub->counterValues.size(), lastValues_.size());
+
+  // Most deltas take a byte or two
+  out->times.reserve(numSamples * 2);
+  for (const auto& time : pub->times) {
+    appendDelta(&out->times,
+                time.seconds * kNsPerSec + time.nanoseconds,
+                &lastTime_);
+  }
+  pub->times.clear();
+
+  out->values.reserve(pub->counterValues.size() * numSamples * 2);
+  auto last = lastValues_.begin();
+  for (auto& column : pub->counterValues) {
+    DCHECK_EQ(column.second.size(), numSamples);
+    for (auto value : column.second) {
+      appendDelta(&out->values, value, &*last);
+    }
+    column.second.clear();
+    ++last;
+  }
+
+  return out;
+}
+
+void CompactPublicationDecoder::decode(const CompactCounterPublication& pub,
+                                       CounterPublication* out) {
+  if (pub.seqNum != nextSeqNum_) {
+    throw FbossError("expected compact counter publication ", nextSeqNum_,
+                     " but got ", pub.seqNum);
+  }
+  if (pub.seqNum == 0) {
+    counters_ = pub.counters;
+    lastValues_.assign(counters_.size(), 0);
+  } else if (!pub.counters.empty()) {
+    throw FbossError("counters sent again in compact counter publication ",
+                     pub.seqNum);
+  }
+  if (pub.numSamples < 0) {
+    throw FbossError("invalid number of samples in compact counter "
+                     "publication: ", pub.numSamples);
+  }
+
+  out->hostname = pub.hostname;
+  out->times.clear();
+  out->counterValues.clear();
+
+  DeltaReader times(pub.times);
+  out->times.reserve(pub.numSamples);
+  for (int i = 0; i < pub.numSamples; ++i) {
+    auto ns = times.next(&lastTime_);
+    out->times.emplace_back(apache::thrift::FragileConstructor::FRAGILE,
+                            ns / kNsPerSec, ns % kNsPerSec);
+  }
+
+  DeltaReader values(pub.values);
+  for (size_t c = 0; c < counters_.size(); ++c) {
+    auto& column = out->counterValues[counters_[c]];
+    column.reserve(pub.numSamples);
+    for (int i = 0; i < pub.numSamples; ++i) {
+      column.push_back(values.next(&lastValues_[c]));
+    }
+  }
+
+  if (!times.done() || !values.done()) {
+    throw FbossError("extra data in compact counter publication ",
+                     pub.seqNum);
+  }
+  ++nextSeqNum_;
+}
+
+}} // facebook::fboss
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/if/gen-cpp2/highres_types.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * Choose the publication format to use for a subscription from the ones the
+ * client can receive.
+ */
+PublicationFormat negotiatePublicationFormat(
+    const std::vector<PublicationFormat>& formats);
+
+/*
+ * Encodes the batches of samples of a subscription as
+ * CompactCounterPublications.  See highres.thrift for the format.
+ *
+ * The samples are taken into a CounterPublication as usual, which encode()
+ * empties again afterwards, leaving its columns with their capacity, so the
+ * same one can be refilled for every batch without allocating.  Its set of
+ * counters mustn't change over the subscription.
+ */
+class CompactPublicationEncoder {
+ public:
+  explicit CompactPublicationEncoder(std::string hostname)
+    : hostname_(std::move(hostname)) {}
+
+  std::unique_ptr<CompactCounterPublication> encode(CounterPublication* pub);
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  CompactPublicationEncoder(CompactPublicationEncoder const &) = delete;
+  CompactPublicationEncoder& operator=(CompactPublicationEncoder const &) =
+    delete;
+
+  const std::string hostname_;
+  int64_t seqNum_{0};
+  int64_t lastTime_{0};
+  // The last value of each counter, in column order
+  std::vector<int64_t> lastValues_;
+};
+
+/*
+ * Decodes the CompactCounterPublications of a subscription, for clients.
+ * They must be decoded in order.
+ */
+class CompactPublicationDecoder {
+ public:
+  CompactPublicationDecoder() {}
+
+  /*
+   * Decode pub into out, replacing anything out had in it.  Throws
+   * FbossError if pub is out of sequence or malformed.
+   */
+  void decode(const CompactCounterPublication& pub, CounterPublication* out);
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  CompactPublicationDecoder(CompactPublicationDecoder const &) = delete;
+  CompactPublicationDecoder& operator=(CompactPublicationDecoder const &) =
+    delete;
+
+  int64_t nextSeqNum_{0};
+  int64_t lastTime_{0};
+  std::vector<CounterRequest> counters_;
+  std::vector<int64_t> lastValues_;
+};
+
+}} // facebook::fboss
@@ -25,6 +25,7 @@ struct dynamic;
 
 namespace facebook { namespace fboss {
 
+class RouteBatch;
 class SwitchState;
 class SwitchStats;
 class StateDelta;
@@ -130,6 +131,17 @@ class HwSwitch {
    */
   virtual bool isValidStateUpdate(const StateDelta& delta) const = 0;
 
+  /*
+   * Program a batch of route changes.
+   *
+   * The routes in batch.getRemoved() are removed first, then the ones in
+   * batch.getGroups() are added or updated.  Each group shares the same
+   * forwarding info, so implementations should resolve the nexthops (and
+   * create any ECMP object) once per group.  stateChanged() programs the
+   * routes of its delta through the same path.
+   */
+  virtual void programRoutes(const RouteBatch& batch) = 0;
+
   /*
    * Allocate a new TxPacket.
    */
@@ -234,6 +246,17 @@ class HwSwitch {
    */
    virtual bool getPortFECConfig(PortID /* unused */ ) const { return false; }
 
+  /*
+   * Fill in the port's cumulative counters as of the last updateStats().
+   * Returns false if the HwSwitch doesn't keep them, in which case they
+   * have to be read from the exported stats.
+   */
+  virtual bool getPortCounters(PortID /* unused */,
+                               PortCounters* /* unused */,
+                               PortCounters* /* unused */) const {
+    return false;
+  }
+
   /*
    * Returns true if the arp/ndp entry for the passed in ip/intf has been hit
    * since the last call to getAndClearNeighborHit.
@@ -12,6 +12,7 @@
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/NeighborCacheImpl-defs.h"
 #include "fboss/agent/NeighborCacheEntry.h"
+#include "fboss/agent/TimerWheel.h"
 
 #include <chrono>
 #include <folly/Memory.h>
@@ -40,7 +41,15 @@ class NeighborCache {
  public:
   typedef typename NTable::Entry::AddressType AddressType;
 
-  virtual ~NeighborCache() {}
+  virtual ~NeighborCache() {
+    // The entries cancel their timers as they are destroyed, so they have to
+    // go first, and the wheel has to be destroyed on the background thread.
+    impl_.reset();
+    sw_->getBackgroundEVB()->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [this]() {
+        timers_.reset();
+      });
+  }
 
   bool flushEntryBlocking (AddressType ip) {
     std::lock_guard<std::mutex> g(cacheLock_);
@@ -99,6 +108,14 @@ class NeighborCache {
         timeout_(timeout),
         maxNeighborProbes_(maxNeighborProbes),
         staleEntryInterval_(staleEntryInterval),
+        // The probe interval is a second, so timeouts are only rounded up
+        // to the next 10ms.
+        timers_(std::make_unique<TimerWheel>(
+            sw->getBackgroundEVB(),
+            std::chrono::milliseconds(10),
+            [this](const std::vector<TimerWheel::Timer*>& timers) {
+              processEntries(timers);
+            })),
         impl_(std::make_unique<NeighborCacheImpl<NTable>>(
             this, sw, vlanID, vlanName, intfID)) {}
 
@@ -179,9 +196,19 @@ class NeighborCache {
     return impl_->flushEntry(ip);
   }
 
-  void processEntry(AddressType ip) {
+  // Process all the entries whose timeouts expired on the same tick
+  void processEntries(const std::vector<TimerWheel::Timer*>& timers) {
     std::lock_guard<std::mutex> g(cacheLock_);
-    return impl_->processEntry(ip);
+    for (auto* timer : timers) {
+      impl_->processEntry(
+          static_cast<NeighborCacheEntry<NTable>*>(timer)->getIP());
+    }
+  }
+
+  // The timer wheel the entries schedule their updates on.  This is only
+  // used on the background thread.
+  TimerWheel* getTimers() const {
+    return timers_.get();
   }
 
   // Has the entry corresponding to ip has been hit in hw
@@ -197,6 +224,7 @@ class NeighborCache {
   std::chrono::seconds timeout_;
   uint32_t maxNeighborProbes_{0};
   std::chrono::seconds staleEntryInterval_;
+  std::unique_ptr<TimerWheel> timers_;
   std::unique_ptr<NeighborCacheImpl<NTable>> impl_;
   std::mutex cacheLock_;
 };
@@ -12,6 +12,7 @@
 #include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/FbossError.h"
+#include "fboss/agent/TimerWheel.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NeighborEntry.h"
 
@@ -51,7 +52,8 @@
  * UNINITIALIZED - Placeholder on startup.
  *
  * Once an entry is created, it is responsible for scheduling the timeout for
- * its next update. When that timeout expires, the state machine is run and the
+ * its next update, on the timer wheel shared by all the entries of the
+ * cache. When that timeout expires, the state machine is run and the
  * next update is scheduled. If the entry ever transitions to the EXPIRED state,
  * we do not schedule another update and the cache will flush the entry.
  *
@@ -77,7 +79,7 @@ enum class NeighborEntryState : uint8_t {
 template <typename NTable> class NeighborCache;
 
 template <typename NTable>
-class NeighborCacheEntry : private folly::AsyncTimeout {
+class NeighborCacheEntry : public TimerWheel::Timer {
  public:
   typedef typename NTable::Entry::AddressType AddressType;
   typedef NeighborCache<NTable> Cache;
@@ -87,8 +89,7 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
                      folly::EventBase* evb,
                      Cache* cache,
                      NeighborEntryState state)
-      : AsyncTimeout(evb),
-        fields_(fields),
+      : fields_(fields),
         cache_(cache),
         evb_(evb),
         probesLeft_(cache_->getMaxNeighborProbes()) {
@@ -216,18 +217,22 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
 
  private:
   /*
-   * We tell the cache that this entry needs to be processed. The cache is
-   * responsible for serializing this with other flush or rx events to prevent
-   * races.
+   * Timeouts go on the cache's timer wheel.  When one expires, the cache
+   * processes the entry, serializing it with other flush or rx events to
+   * prevent races.
    */
-  virtual void timeoutExpired() noexcept {
-    cache_->processEntry(getIP());
+  void scheduleTimeout(std::chrono::milliseconds timeout) {
+    cache_->getTimers()->schedule(this, timeout);
+  }
+
+  void cancelTimeout() {
+    cache_->getTimers()->cancel(this);
   }
 
   /*
    * Schedules an update on the evb_. This is done synchronously so that we
    * can have a destructor guard around both running the state machine and
-   * scheduling the next update in timeoutExpired.
+   * scheduling the next update when the timeout expires.
    */
   void scheduleNextUpdate() {
     CHECK(evb_->inRunningEventBaseThread());
@@ -13,6 +13,7 @@
 #include "fboss/agent/types.h"
 #include "fboss/agent/ArpHandler.h"
 #include "fboss/agent/IPv6Handler.h"
+#include "fboss/agent/NeighborUpdateBatcher.h"
 #include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/state/Vlan.h"
 #include "fboss/agent/state/ArpTable.h"
@@ -98,8 +99,7 @@ void NeighborCacheImpl<NTable>::programEntry(Entry* entry) {
     return newState;
   };
 
-  sw_->updateState(folly::to<std::string>("add neighbor ", fields.ip),
-                   std::move(updateFn));
+  sw_->getNeighborUpdateBatcher()->addUpdate(std::move(updateFn));
 }
 
 
@@ -138,9 +138,7 @@ void NeighborCacheImpl<NTable>::programPendingEntry(Entry* entry, bool force) {
     return newState;
   };
 
-  sw_->updateStateNoCoalescing(
-    folly::to<std::string>("add pending entry ", fields.ip),
-    std::move(updateFn));
+  sw_->getNeighborUpdateBatcher()->addUpdate(std::move(updateFn), false);
 }
 
 template <typename NTable>
@@ -352,7 +350,7 @@ void NeighborCacheImpl<NTable>::flushEntry(AddressType ip, bool* flushed) {
     // was actually flushed
     sw_->updateStateBlocking("flush neighbor entry", std::move(updateFn));
   } else {
-    sw_->updateState("remove neighbor entry", std::move(updateFn));
+    sw_->getNeighborUpdateBatcher()->addUpdate(std::move(updateFn));
   }
 }
 
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/NeighborUpdateBatcher.h"
+
+#include <folly/ExceptionString.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+#include "fboss/agent/state/StateUpdate.h"
+#include "fboss/agent/state/SwitchState.h"
+
+DEFINE_int32(max_neighbor_batch_size, 1000,
+             "The most ARP/NDP table changes to apply in one state update");
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+using std::shared_ptr;
+
+namespace facebook { namespace fboss {
+
+class NeighborUpdateBatcher::BatchUpdate : public StateUpdate {
+ public:
+  BatchUpdate(SwSwitch* sw,
+              shared_ptr<Queue> queue,
+              shared_ptr<Batch> batch,
+              bool allowCoalesce)
+    : StateUpdate("update neighbor entries", allowCoalesce),
+      sw_(sw),
+      queue_(std::move(queue)),
+      batch_(std::move(batch)) {}
+
+  shared_ptr<SwitchState> applyUpdate(
+      const shared_ptr<SwitchState>& origState) override {
+    std::vector<StateUpdateFn> fns;
+    {
+      std::lock_guard<std::mutex> g(queue_->lock);
+      if (queue_->open == batch_) {
+        queue_->open.reset();
+      }
+      fns.swap(batch_->fns);
+    }
+    sw_->stats()->neighborBatch(
+        fns.size(),
+        duration_cast<microseconds>(steady_clock::now() - batch_->opened));
+
+    auto state = origState;
+    for (const auto& fn : fns) {
+      auto newState = fn(state);
+      if (newState) {
+        state = newState;
+      }
+    }
+    return state != origState ? state : nullptr;
+  }
+
+  void onError(const std::exception& ex) noexcept override {
+    LOG(FATAL) << "unexpected error applying state update <" <<
+      getName() << ">: " << folly::exceptionStr(ex);
+  }
+
+ private:
+  SwSwitch* sw_{nullptr};
+  shared_ptr<Queue> queue_;
+  shared_ptr<Batch> batch_;
+};
+
+NeighborUpdateBatcher::NeighborUpdateBatcher(SwSwitch* sw)
+  : sw_(sw),
+    queue_(std::make_shared<Queue>()) {}
+
+NeighborUpdateBatcher::~NeighborUpdateBatcher() {}
+
+void NeighborUpdateBatcher::addUpdate(StateUpdateFn fn, bool allowCoalesce) {
+  std::lock_guard<std::mutex> g(queue_->lock);
+  auto& batch = queue_->open;
+  if (!allowCoalesce) {
+    // Close the open batch, which is queued already, so nothing joins it
+    // after this change.  The change then goes in a batch of its own, which
+    // is never left open.
+    batch.reset();
+    auto single = std::make_shared<Batch>();
+    single->opened = steady_clock::now();
+    single->fns.push_back(std::move(fn));
+    sw_->updateState(
+        std::make_unique<BatchUpdate>(sw_, queue_, single, false));
+    return;
+  }
+  if (!batch || batch->fns.size() >= size_t(FLAGS_max_neighbor_batch_size)) {
+    batch = std::make_shared<Batch>();
+    batch->opened = steady_clock::now();
+    // Queue the batch while still holding the lock, so that it can't be
+    // overtaken by an update queued after a change in it was added.
+    sw_->updateState(
+        std::make_unique<BatchUpdate>(sw_, queue_, batch, true));
+  }
+  batch->fns.push_back(std::move(fn));
+}
+
+}} // facebook::fboss
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class SwSwitch;
+class SwitchState;
+
+/*
+ * NeighborUpdateBatcher collects the changes the neighbor caches make to the
+ * ARP and NDP tables, and applies them to the SwitchState in batches.
+ *
+ * The first change queued opens a batch, which is put on the SwSwitch update
+ * queue straight away.  Changes queued after that join the open batch until
+ * the update thread gets to it, at which point every change in the batch is
+ * applied, in order, as a single state update.  The batch window is therefore
+ * however long the update thread is busy: nothing when it is idle, and long
+ * enough to fold thousands of changes into one update (and one clone of each
+ * VLAN's neighbor table) when they are relearned after a port flap.  A batch
+ * is also closed once it holds --max_neighbor_batch_size changes.
+ *
+ * As the batch is queued when it is opened, a change is never applied later
+ * than it would have been as an update of its own, so updates scheduled with
+ * updateStateBlocking() after a change still see it.
+ */
+class NeighborUpdateBatcher {
+ public:
+  typedef std::function<
+    std::shared_ptr<SwitchState>(const std::shared_ptr<SwitchState>&)>
+    StateUpdateFn;
+
+  explicit NeighborUpdateBatcher(SwSwitch* sw);
+  ~NeighborUpdateBatcher();
+
+  /*
+   * Queue a change to the neighbor tables.  The function follows the same
+   * rules as for SwSwitch::updateState(), except that it may be called with
+   * an unpublished state, already modified by the changes before it.
+   *
+   * A change that doesn't allow coalescing closes the open batch and is
+   * applied on its own after it, without waiting for any updates queued
+   * after it, like SwSwitch::updateStateNoCoalescing().
+   */
+  void addUpdate(StateUpdateFn fn, bool allowCoalesce = true);
+
+ private:
+  struct Batch {
+    std::vector<StateUpdateFn> fns;
+    std::chrono::steady_clock::time_point opened;
+  };
+  struct Queue {
+    std::mutex lock;
+    // The batch changes can still be added to, if any
+    std::shared_ptr<Batch> open;
+  };
+  class BatchUpdate;
+
+  // Forbidden copy constructor and assignment operator
+  NeighborUpdateBatcher(NeighborUpdateBatcher const &) = delete;
+  NeighborUpdateBatcher& operator=(NeighborUpdateBatcher const &) = delete;
+
+  SwSwitch* sw_{nullptr};
+  // Shared with the queued updates, which may outlive the batcher
+  std::shared_ptr<Queue> queue_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/PacketDispatcher.h"
+
+#include <folly/Conv.h>
+#include <folly/ExceptionString.h>
+#include <folly/Hash.h>
+#include <folly/ThreadName.h>
+#include <glog/logging.h>
+
+#include "fboss/agent/PortStats.h"
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+
+namespace facebook { namespace fboss {
+
+PacketDispatcher::PacketDispatcher(SwSwitch* sw,
+                                   unsigned numThreads,
+                                   uint32_t queueDepth,
+                                   Handler handler)
+  : sw_(sw),
+    handler_(std::move(handler)) {
+  CHECK_GT(numThreads, 0);
+  CHECK_GT(queueDepth, 0);
+  if (!handler_) {
+    handler_ = [sw](std::unique_ptr<RxPacket> pkt, const L2Header& hdr) {
+      sw->handleParsedPacket(std::move(pkt), hdr);
+    };
+  }
+  for (unsigned i = 0; i < numThreads; ++i) {
+    queues_.push_back(std::make_unique<Queue>(queueDepth));
+  }
+  for (unsigned i = 0; i < numThreads; ++i) {
+    workers_.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+PacketDispatcher::~PacketDispatcher() {
+  for (auto& queue : queues_) {
+    queue->blockingWrite(Item());
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+bool PacketDispatcher::dispatch(std::unique_ptr<RxPacket> pkt,
+                                const L2Header& hdr) {
+  auto index = queueIndex(pkt.get(), hdr);
+  auto port = pkt->getSrcPort();
+  Item item;
+  item.pkt = std::move(pkt);
+  item.hdr = hdr;
+  if (!queues_[index]->write(std::move(item))) {
+    sw_->stats()->dispatchQueueDrop(index);
+    VLOG(4) << "dropping packet from port " << port
+            << ": dispatch queue " << index << " is full";
+    return false;
+  }
+  return true;
+}
+
+void PacketDispatcher::flush() {
+  std::vector<folly::Baton<>> flushed(queues_.size());
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    Item item;
+    item.flushed = &flushed[i];
+    queues_[i]->blockingWrite(std::move(item));
+  }
+  for (auto& baton : flushed) {
+    baton.wait();
+  }
+}
+
+size_t PacketDispatcher::queueIndex(const RxPacket* pkt,
+                                    const L2Header& hdr) const {
+  auto hash = folly::hash::hash_combine(
+      hdr.ethertype, static_cast<uint16_t>(pkt->getSrcPort()));
+  return hash % queues_.size();
+}
+
+void PacketDispatcher::workerLoop(unsigned index) {
+  folly::setThreadName(folly::to<std::string>("fbossPktDisp", index));
+  auto& queue = *queues_[index];
+  while (true) {
+    Item item;
+    queue.blockingRead(item);
+    if (!item.pkt) {
+      if (!item.flushed) {
+        return;
+      }
+      item.flushed->post();
+      continue;
+    }
+
+    auto port = item.pkt->getSrcPort();
+    try {
+      handler_(std::move(item.pkt), item.hdr);
+    } catch (const std::exception& ex) {
+      sw_->stats()->port(port)->pktError();
+      LOG(ERROR) << "error processing trapped packet: " <<
+        folly::exceptionStr(ex);
+    }
+  }
+}
+
+}} // facebook::fboss
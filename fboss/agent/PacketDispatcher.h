@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/Baton.h>
+#include <folly/MPMCQueue.h>
+#include <folly/MacAddress.h>
+
+#include "fboss/agent/types.h"
+
+namespace facebook { namespace fboss {
+
+class RxPacket;
+class SwSwitch;
+
+/*
+ * The L2 header of a trapped packet, parsed once before the packet is
+ * dispatched.
+ */
+struct L2Header {
+  folly::MacAddress dst;
+  folly::MacAddress src;
+  uint16_t ethertype{0};
+  // The offset of the L3 header from the start of the packet
+  uint32_t l3Offset{0};
+};
+
+/*
+ * PacketDispatcher hands trapped packets off from the HwSwitch RX thread to
+ * a pool of worker threads, so that a slow handler (a DHCP relay, or a
+ * write to a TUN interface) holds up only the packets queued behind it
+ * rather than all control plane packets.
+ *
+ * Each worker has its own bounded queue.  Packets are sharded across the
+ * queues by ethertype and source port, so packets of the same type from the
+ * same port are always handled in the order they were received.  When a
+ * queue is full the packet is dropped, and counted against that queue in
+ * the SwitchStats.
+ *
+ * With more than one worker the ARP, NDP, IPv4, IPv6 and LLDP handlers run
+ * concurrently.  The state they share is already safe to use from several
+ * threads, as the thrift threads use it too:
+ *  - the SwitchState is only read, through SwSwitch::getState()
+ *  - SwSwitch::stats() is thread local
+ *  - the NeighborUpdater caches are locked by cachesMutex_ and each
+ *    NeighborCache by its own lock, and state updates are queued to the
+ *    update thread
+ *  - the LLDP LinkNeighborDB and the TunManager interfaces are each locked
+ *  - packet captures go through PcapQueue, which takes several producers
+ * The IPv6Handler route advertisers aren't used when handling packets.  A
+ * handler that keeps other state across packets must lock it before packets
+ * are dispatched to more than one worker.
+ *
+ * Packets of the same type from different ports can be handled out of
+ * order, so for instance ARP replies for a host that moved ports may be
+ * applied in either order.  The next reply or probe corrects the entry.
+ */
+class PacketDispatcher {
+ public:
+  typedef std::function<void(std::unique_ptr<RxPacket>, const L2Header&)>
+    Handler;
+
+  /*
+   * Packets are handled by SwSwitch::handleParsedPacket() unless a handler
+   * is given, which is only done in tests.
+   */
+  PacketDispatcher(SwSwitch* sw, unsigned numThreads, uint32_t queueDepth,
+                   Handler handler = nullptr);
+
+  /*
+   * Handles any packets already queued, and stops the worker threads.
+   */
+  ~PacketDispatcher();
+
+  /*
+   * Queue a packet to be handled by the handler.
+   * Returns false if the packet was dropped because its queue was full.
+   */
+  bool dispatch(std::unique_ptr<RxPacket> pkt, const L2Header& hdr);
+
+  /*
+   * Wait until all the packets dispatched before the call have been handled.
+   */
+  void flush();
+
+  unsigned numQueues() const {
+    return queues_.size();
+  }
+
+ private:
+  struct Item {
+    std::unique_ptr<RxPacket> pkt;
+    L2Header hdr;
+    // Set instead of pkt for flush() markers.  Neither is set to tell the
+    // worker to stop.
+    folly::Baton<>* flushed{nullptr};
+  };
+  typedef folly::MPMCQueue<Item> Queue;
+
+  // Forbidden copy constructor and assignment operator
+  PacketDispatcher(PacketDispatcher const &) = delete;
+  PacketDispatcher& operator=(PacketDispatcher const &) = delete;
+
+  size_t queueIndex(const RxPacket* pkt, const L2Header& hdr) const;
+  void workerLoop(unsigned index);
+
+  SwSwitch* sw_{nullptr};
+  Handler handler_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/RouteChangeNotifier.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/state/DeltaFunctions.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteDelta.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+
+using facebook::network::toBinaryAddress;
+using facebook::network::toIPAddress;
+using folly::IPAddress;
+
+namespace facebook { namespace fboss {
+
+namespace {
+
+template <typename AddrT>
+RouteChange makeRouteChange(RouteChangeType type,
+                            RouterID vrf,
+                            const Route<AddrT>& route) {
+  RouteChange change;
+  change.type = type;
+  change.vrf = vrf;
+  change.prefix.ip = toBinaryAddress(IPAddress(route.prefix().network));
+  change.prefix.prefixLength = route.prefix().mask;
+  if (type != RouteChangeType::REMOVED) {
+    change.route = route.toRouteDetails();
+    change.__isset.route = true;
+  }
+  return change;
+}
+
+template <typename AddrT>
+void handleChangedRoute(RouterID vrf,
+                        RouteChangeBatch* batch,
+                        const std::shared_ptr<Route<AddrT>>& /*oldRoute*/,
+                        const std::shared_ptr<Route<AddrT>>& newRoute) {
+  batch->changes.push_back(
+      makeRouteChange(RouteChangeType::CHANGED, vrf, *newRoute));
+}
+
+template <typename AddrT>
+void handleAddedRoute(RouterID vrf,
+                      RouteChangeBatch* batch,
+                      const std::shared_ptr<Route<AddrT>>& newRoute) {
+  batch->changes.push_back(
+      makeRouteChange(RouteChangeType::ADDED, vrf, *newRoute));
+}
+
+template <typename AddrT>
+void handleRemovedRoute(RouterID vrf,
+                        RouteChangeBatch* batch,
+                        const std::shared_ptr<Route<AddrT>>& oldRoute) {
+  batch->changes.push_back(
+      makeRouteChange(RouteChangeType::REMOVED, vrf, *oldRoute));
+}
+
+} // anonymous namespace
+
+RouteChangeNotifier::RouteChangeNotifier(SwSwitch* sw)
+    : AutoRegisterStateObserver(sw, "RouteChangeNotifier") {}
+
+void RouteChangeNotifier::registerListener(Listener listener) {
+  std::lock_guard<std::mutex> g(listenerMutex_);
+  listener_ = std::move(listener);
+}
+
+void RouteChangeNotifier::stateUpdated(const StateDelta& delta) {
+  if (numSubscribers_.load() <= 0) {
+    return;
+  }
+  auto batch = std::make_shared<RouteChangeBatch>();
+  batch->generation = delta.newState()->getGeneration();
+  for (const auto& rtDelta : delta.getRouteTablesDelta()) {
+    auto vrf = rtDelta.getOld() ? rtDelta.getOld()->getID()
+                                : rtDelta.getNew()->getID();
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV4Delta(),
+        &handleChangedRoute<folly::IPAddressV4>,
+        &handleAddedRoute<folly::IPAddressV4>,
+        &handleRemovedRoute<folly::IPAddressV4>,
+        vrf,
+        batch.get());
+    DeltaFunctions::forEachChanged(
+        rtDelta.getRoutesV6Delta(),
+        &handleChangedRoute<folly::IPAddressV6>,
+        &handleAddedRoute<folly::IPAddressV6>,
+        &handleRemovedRoute<folly::IPAddressV6>,
+        vrf,
+        batch.get());
+  }
+  if (batch->changes.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> g(listenerMutex_);
+  if (listener_) {
+    listener_(std::move(batch));
+  }
+}
+
+RouteChangeQueue::RouteChangeQueue(
+    folly::Optional<folly::CIDRNetwork> filter,
+    size_t maxPending)
+    : filter_(std::move(filter)),
+      maxPending_(maxPending) {}
+
+bool RouteChangeQueue::wanted(const IPAddress& ip, uint8_t mask) const {
+  if (!filter_) {
+    return true;
+  }
+  return ip.family() == filter_->first.family() &&
+    mask >= filter_->second && ip.inSubnet(filter_->first, filter_->second);
+}
+
+void RouteChangeQueue::add(const RouteChangeBatch& batch) {
+  generation_ = batch.generation;
+  if (resyncNeeded_) {
+    // The subscriber dumps the routes after the next batch, and that has
+    // these changes already
+    return;
+  }
+  for (const auto& change : batch.changes) {
+    auto ip = toIPAddress(change.prefix.ip);
+    uint8_t mask = change.prefix.prefixLength;
+    if (wanted(ip, mask)) {
+      merge(Key(change.vrf, std::move(ip), mask), change);
+    }
+  }
+  if (pending_.size() > maxPending_) {
+    pending_.clear();
+    resyncNeeded_ = true;
+  }
+}
+
+void RouteChangeQueue::merge(Key key, const RouteChange& change) {
+  auto it = pending_.find(key);
+  if (it == pending_.end()) {
+    pending_.emplace(std::move(key), change);
+    return;
+  }
+  auto prevType = it->second.type;
+  it->second = change;
+  // Added then removed stays removed: the subscriber may have the route from
+  // a dump taken in between, and removing a route it doesn't have is a no-op
+  if (prevType == RouteChangeType::ADDED &&
+      change.type != RouteChangeType::REMOVED) {
+    it->second.type = RouteChangeType::ADDED;
+  } else if (prevType == RouteChangeType::REMOVED &&
+             change.type == RouteChangeType::ADDED) {
+    it->second.type = RouteChangeType::CHANGED;
+  }
+}
+
+RouteChangeBatch RouteChangeQueue::take() {
+  RouteChangeBatch batch;
+  batch.generation = generation_;
+  batch.resyncNeeded = resyncNeeded_;
+  batch.changes.reserve(pending_.size());
+  for (auto& entry : pending_) {
+    batch.changes.push_back(std::move(entry.second));
+  }
+  pending_.clear();
+  resyncNeeded_ = false;
+  return batch;
+}
+
+}} // facebook::fboss
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/StateObserver.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace facebook { namespace fboss {
+
+class SwSwitch;
+class StateDelta;
+
+/*
+ * Turn the route changes of each state update into a RouteChangeBatch for
+ * the route change subscribers.  Nothing is done while there are none.
+ */
+class RouteChangeNotifier : public AutoRegisterStateObserver {
+ public:
+  using Listener =
+    std::function<void(std::shared_ptr<const RouteChangeBatch> batch)>;
+
+  explicit RouteChangeNotifier(SwSwitch* sw);
+
+  void stateUpdated(const StateDelta& delta) override;
+
+  /*
+   * Register the function to call with each batch.  Only one listener is
+   * supported, and calling this again replaces it.
+   */
+  void registerListener(Listener listener);
+
+  void addSubscriber() {
+    ++numSubscribers_;
+  }
+  void removeSubscriber() {
+    --numSubscribers_;
+  }
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  RouteChangeNotifier(RouteChangeNotifier const &) = delete;
+  RouteChangeNotifier& operator=(RouteChangeNotifier const &) = delete;
+
+  std::atomic<int> numSubscribers_{0};
+  std::mutex listenerMutex_;
+  Listener listener_{nullptr};
+};
+
+/*
+ * The changes waiting to be sent to one subscriber.  A route changed again
+ * before the last change was sent is sent once, as it is now.  Once more
+ * than maxPending routes are waiting the changes are dropped, and the next
+ * batch tells the subscriber to resync instead.
+ */
+class RouteChangeQueue {
+ public:
+  RouteChangeQueue(folly::Optional<folly::CIDRNetwork> filter,
+                   size_t maxPending);
+
+  void add(const RouteChangeBatch& batch);
+
+  bool empty() const {
+    return pending_.empty() && !resyncNeeded_;
+  }
+  size_t size() const {
+    return pending_.size();
+  }
+
+  // Everything waiting, as one batch
+  RouteChangeBatch take();
+
+ private:
+  using Key = std::tuple<int32_t, folly::IPAddress, uint8_t>;
+
+  bool wanted(const folly::IPAddress& ip, uint8_t mask) const;
+  void merge(Key key, const RouteChange& change);
+
+  const folly::Optional<folly::CIDRNetwork> filter_;
+  const size_t maxPending_;
+  int64_t generation_{0};
+  std::map<Key, RouteChange> pending_;
+  bool resyncNeeded_{false};
+};
+
+}} // facebook::fboss
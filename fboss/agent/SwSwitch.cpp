@@ -9,14 +9,15 @@
  */
 #include "fboss/agent/SwSwitch.h"
 
-#include <thrift/lib/cpp2/protocol/Serializer.h>
-
 #include "fboss/agent/ArpHandler.h"
 #include "fboss/agent/Constants.h"
 #include "fboss/agent/IPv4Handler.h"
 #include "fboss/agent/IPv6Handler.h"
+#include "fboss/agent/RouteChangeNotifier.h"
 #include "fboss/agent/RouteUpdateLogger.h"
+#include "fboss/agent/NeighborUpdateBatcher.h"
 #include "fboss/agent/NeighborUpdater.h"
+#include "fboss/agent/PacketDispatcher.h"
 #include "fboss/agent/UnresolvedNhopsProber.h"
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/HwSwitch.h"
@@ -65,6 +66,11 @@ using namespace std::chrono;
 
 DEFINE_string(config, "", "The path to the local JSON configuration file");
 DEFINE_int32(thread_heartbeat_ms, 5000, "Thread hearbeat interval (ms)");
+DEFINE_int32(packet_dispatch_threads, 0,
+             "The number of threads to handle trapped packets on, or 0 to "
+             "handle them in the HwSwitch RX thread");
+DEFINE_int32(packet_dispatch_queue_depth, 1024,
+             "The most trapped packets to queue for each dispatch thread");
 
 namespace {
 
@@ -147,9 +153,11 @@ SwSwitch::SwSwitch(std::unique_ptr<Platform> platform)
     arp_(new ArpHandler(this)),
     ipv4_(new IPv4Handler(this)),
     ipv6_(new IPv6Handler(this)),
+    nBatcher_(new NeighborUpdateBatcher(this)),
     nUpdater_(new NeighborUpdater(this)),
     pcapMgr_(new PktCaptureManager(this)),
-    routeUpdateLogger_(new RouteUpdateLogger(this)) {
+    routeUpdateLogger_(new RouteUpdateLogger(this)),
+    routeChangeNotifier_(new RouteChangeNotifier(this)) {
   // Create the platform-specific state directories if they
   // don't exist already.
   utilCreateDir(platform_->getVolatileStateDir());
@@ -158,6 +166,10 @@ SwSwitch::SwSwitch(std::unique_ptr<Platform> platform)
   // This means the platform is now able to do async events on the
   // background thread
   platform_->setEventBase(&backgroundEventBase_);
+  if (FLAGS_packet_dispatch_threads > 0) {
+    pktDispatcher_ = std::make_unique<PacketDispatcher>(
+        this, FLAGS_packet_dispatch_threads, FLAGS_packet_dispatch_queue_depth);
+  }
 }
 
 SwSwitch::~SwSwitch() {
@@ -173,6 +185,8 @@ void SwSwitch::stop() {
   // After this we should no longer receive packets or link state changed events
   // while we are destroying ourselves
   hw_->unregisterCallbacks();
+  // Then finish handling any packets that were already received
+  pktDispatcher_.reset();
 
   // Several member variables are performing operations in the background
   // thread.  Ask them to stop, before we shut down the background thread.
@@ -187,6 +201,7 @@ void SwSwitch::stop() {
   portRemediator_.reset();
   ipv6_.reset();
   nUpdater_.reset();
+  nBatcher_.reset();
   if (lldpManager_) {
     lldpManager_->stop();
   }
@@ -200,6 +215,7 @@ void SwSwitch::stop() {
   tunMgr_.reset();
 
   routeUpdateLogger_.reset();
+  routeChangeNotifier_.reset();
 
   bgThreadHeartbeat_.reset();
   updThreadHeartbeat_.reset();
@@ -763,7 +779,7 @@ void SwSwitch::setPortStatusCounter(PortID port, bool up) {
 void SwSwitch::packetReceived(std::unique_ptr<RxPacket> pkt) noexcept {
   PortID port = pkt->getSrcPort();
   try {
-    handlePacket(std::move(pkt));
+    handlePacket(std::move(pkt), true);
   } catch (const std::exception& ex) {
     stats()->port(port)->pktError();
     LOG(ERROR) << "error processing trapped packet: " <<
@@ -775,10 +791,11 @@ void SwSwitch::packetReceived(std::unique_ptr<RxPacket> pkt) noexcept {
 
 void SwSwitch::packetReceivedThrowExceptionOnError(
     std::unique_ptr<RxPacket> pkt) {
-  handlePacket(std::move(pkt));
+  handlePacket(std::move(pkt), false);
 }
 
-void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
+void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt,
+                            bool allowDispatch) {
   // If we are not fully initialized or are already exiting, don't handle
   // packets since the individual handlers, h/w sdk data structures
   // may not be ready or may already be (partially) destroyed
@@ -799,39 +816,54 @@ void SwSwitch::handlePacket(std::unique_ptr<RxPacket> pkt) {
   }
 
   // Parse the source and destination MAC, as well as the ethertype.
+  L2Header hdr;
   Cursor c(pkt->buf());
-  auto dstMac = PktUtil::readMac(&c);
-  auto srcMac = PktUtil::readMac(&c);
-  auto ethertype = c.readBE<uint16_t>();
-  if (ethertype == 0x8100) {
+  hdr.dst = PktUtil::readMac(&c);
+  hdr.src = PktUtil::readMac(&c);
+  hdr.ethertype = c.readBE<uint16_t>();
+  if (hdr.ethertype == 0x8100) {
     // 802.1Q
     c += 2; // Advance over the VLAN tag.  We ignore it for now
-    ethertype = c.readBE<uint16_t>();
+    hdr.ethertype = c.readBE<uint16_t>();
   }
+  hdr.l3Offset = len - c.totalLength();
 
   VLOG(5) << "trapped packet: src_port=" << pkt->getSrcPort() <<
     " vlan=" << pkt->getSrcVlan() <<
     " length=" << len <<
-    " src=" << srcMac <<
-    " dst=" << dstMac <<
-    " ethertype=0x" << std::hex << ethertype <<
+    " src=" << hdr.src <<
+    " dst=" << hdr.dst <<
+    " ethertype=0x" << std::hex << hdr.ethertype <<
     " :: " << pkt->describeDetails();
 
-  switch (ethertype) {
+  if (allowDispatch && pktDispatcher_) {
+    pktDispatcher_->dispatch(std::move(pkt), hdr);
+    return;
+  }
+  handleParsedPacket(std::move(pkt), hdr);
+}
+
+void SwSwitch::handleParsedPacket(std::unique_ptr<RxPacket> pkt,
+                                  const L2Header& hdr) {
+  PortID port = pkt->getSrcPort();
+  Cursor c(pkt->buf());
+  c += hdr.l3Offset;
+
+  switch (hdr.ethertype) {
   case ArpHandler::ETHERTYPE_ARP:
-    arp_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+    arp_->handlePacket(std::move(pkt), hdr.dst, hdr.src, c);
     return;
   case LldpManager::ETHERTYPE_LLDP:
     if (lldpManager_) {
-      lldpManager_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+      lldpManager_->handlePacket(std::move(pkt), hdr.dst, hdr.src, c);
       return;
     }
     break;
   case IPv4Handler::ETHERTYPE_IPV4:
-    ipv4_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+    ipv4_->handlePacket(std::move(pkt), hdr.dst, hdr.src, c);
     return;
   case IPv6Handler::ETHERTYPE_IPV6:
-    ipv6_->handlePacket(std::move(pkt), dstMac, srcMac, c);
+    ipv6_->handlePacket(std::move(pkt), hdr.dst, hdr.src, c);
     return;
   default:
     break;
@@ -1145,26 +1177,33 @@ void SwSwitch::applyConfig(const std::string& reason) {
       [&](const shared_ptr<SwitchState>& state) -> shared_ptr<SwitchState> {
         std::string configFilename = FLAGS_config;
         std::pair<shared_ptr<SwitchState>, std::string> rval;
+        cfg::SwitchConfig newConfig;
+        // Until a config has been applied, the state isn't the result of
+        // curConfig_, so none of the new config can be skipped
+        auto prevConfig = curConfigStr_.empty() ? nullptr : &curConfig_;
         if (!configFilename.empty()) {
           LOG(INFO) << "Loading config from local config file "
                     << configFilename;
           rval = applyThriftConfigFile(state, configFilename, platform_.get(),
-              &curConfig_);
+              prevConfig, &newConfig);
         } else {
           // Loading config from default location. The message will be printed
           // there.
           rval = applyThriftConfigDefault(state, platform_.get(),
-              &curConfig_);
+              prevConfig, &newConfig);
         }
-        if (!isValidStateUpdate(StateDelta(state, rval.first))) {
+        auto& newState = rval.first;
+        if (newState && !isValidStateUpdate(StateDelta(state, newState))) {
           throw FbossError("Invalid config passed in, skipping");
         }
         curConfigStr_ = rval.second;
-        apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
-            curConfigStr_.c_str(), curConfig_);
+        curConfig_ = std::move(newConfig);
+        if (!newState) {
+          LOG(INFO) << "Config has no changes";
+          return nullptr;
+        }
 
         // Set oper status of interfaces in SwitchState
-        auto& newState = rval.first;
         for (auto const& port : *newState->getPorts()) {
           port->setOperState(hw_->isPortUp(port->getID()));
         }
@@ -43,6 +43,10 @@ class SwitchState;
 class SwitchStats;
 class StateDelta;
 class NeighborUpdater;
+class NeighborUpdateBatcher;
+class PacketDispatcher;
+struct L2Header;
+class RouteChangeNotifier;
 class RouteUpdateLogger;
 class StateObserver;
 class TunManager;
@@ -388,6 +392,22 @@ class SwSwitch : public HwSwitch::Callback {
    */
   void packetReceivedThrowExceptionOnError(std::unique_ptr<RxPacket> pkt);
 
+  /*
+   * Handle a trapped packet whose L2 header has already been parsed.
+   *
+   * This is called from the PacketDispatcher worker threads when dispatch
+   * threads are configured, and directly from packetReceived() otherwise.
+   */
+  void handleParsedPacket(std::unique_ptr<RxPacket> pkt, const L2Header& hdr);
+
+  /*
+   * Get the PacketDispatcher, or nullptr if trapped packets are handled
+   * in the HwSwitch RX thread.
+   */
+  PacketDispatcher* getPacketDispatcher() {
+    return pktDispatcher_.get();
+  }
+
   // HwSwitch::Callback methods
   void packetReceived(std::unique_ptr<RxPacket> pkt) noexcept override;
   void linkStateChanged(PortID port, bool up) override;
@@ -485,6 +505,14 @@ class SwSwitch : public HwSwitch::Callback {
     return nUpdater_.get();
   }
 
+  /*
+   * Get the NeighborUpdateBatcher, through which the neighbor caches make
+   * their changes to the ARP and NDP tables.
+   */
+  NeighborUpdateBatcher* getNeighborUpdateBatcher() {
+    return nBatcher_.get();
+  }
+
   /*
    * Get the PktCaptureManager object.
    */
@@ -506,6 +534,13 @@ class SwSwitch : public HwSwitch::Callback {
     return routeUpdateLogger_.get();
   }
 
+  /*
+   * Get the RouteChangeNotifier object
+   */
+  RouteChangeNotifier* getRouteChangeNotifier() {
+    return routeChangeNotifier_.get();
+  }
+
   /*
    * Gets the flags the SwSwitch was initialized with.
    */
@@ -577,7 +612,7 @@ class SwSwitch : public HwSwitch::Callback {
   SwitchRunState getSwitchRunState() const;
   void setSwitchRunState(SwitchRunState desiredState);
   SwitchStats* createSwitchStats();
-  void handlePacket(std::unique_ptr<RxPacket> pkt);
+  void handlePacket(std::unique_ptr<RxPacket> pkt, bool allowDispatch);
 
   static void handlePendingUpdatesHelper(SwSwitch* sw);
   void handlePendingUpdates();
@@ -685,9 +720,14 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<ArpHandler> arp_;
   std::unique_ptr<IPv4Handler> ipv4_;
   std::unique_ptr<IPv6Handler> ipv6_;
+  // Declared before nUpdater_, as the neighbor caches use it until they are
+  // destroyed
+  std::unique_ptr<NeighborUpdateBatcher> nBatcher_;
   std::unique_ptr<NeighborUpdater> nUpdater_;
   std::unique_ptr<PktCaptureManager> pcapMgr_;
+  std::unique_ptr<PacketDispatcher> pktDispatcher_;
   std::unique_ptr<RouteUpdateLogger> routeUpdateLogger_;
+  std::unique_ptr<RouteChangeNotifier> routeChangeNotifier_;
   std::unique_ptr<UnresolvedNhopsProber> unresolvedNhopsProber_;
 
   BootType bootType_{BootType::UNINITIALIZED};
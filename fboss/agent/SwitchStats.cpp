@@ -11,6 +11,7 @@
 
 #include "fboss/agent/PortStats.h"
 #include "common/stats/ExportedStatMapImpl.h"
+#include <folly/Conv.h>
 #include <folly/Memory.h>
 
 using facebook::stats::SUM;
@@ -29,6 +30,8 @@ SwitchStats::SwitchStats()
 SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
     : trapPkts_(map, kCounterPrefix + "trapped.pkts", SUM, RATE),
       trapPktDrops_(map, kCounterPrefix + "trapped.drops", SUM, RATE),
+      trapPktDispatchDrops_(map, kCounterPrefix + "trapped.dispatch_drops",
+                            SUM, RATE),
       trapPktBogus_(map, kCounterPrefix + "trapped.bogus", SUM, RATE),
       trapPktErrors_(map, kCounterPrefix + "trapped.error", SUM, RATE),
       trapPktUnhandled_(map, kCounterPrefix + "trapped.unhandled", SUM, RATE),
@@ -82,8 +85,30 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap *map)
                       1, 0, 200, AVG, 50, 100),
       updEventBacklog_(map, kCounterPrefix + "upd_event_backlog",
                        1, 0, 200, AVG, 50, 100),
+      neighborBatchSize_(map, kCounterPrefix + "neighbor_batch.size",
+                         10, 0, 1000, AVG, 50, 100),
+      neighborBatchLatency_(map, kCounterPrefix + "neighbor_batch.latency.us",
+                            1000, 0, 100000, AVG, 50, 100),
 
-      linkStateChange_(map, kCounterPrefix + "link_state.down", SUM) {
+      linkStateChange_(map, kCounterPrefix + "link_state.down", SUM),
+      map_(map) {
+}
+
+void SwitchStats::dispatchQueueDrop(size_t queue) {
+  if (queue >= dispatchQueueDrops_.size()) {
+    dispatchQueueDrops_.resize(queue + 1);
+  }
+  auto& drops = dispatchQueueDrops_[queue];
+  if (!drops) {
+    drops = std::make_unique<TLTimeseries>(
+        map_,
+        folly::to<std::string>(kCounterPrefix, "dispatch_queue.", queue,
+                               ".drops"),
+        SUM, RATE);
+  }
+  drops->addValue(1);
+  trapPktDispatchDrops_.addValue(1);
+  trapPktDrops_.addValue(1);
 }
 
 PortStats* SwitchStats::port(PortID portID) {
@@ -10,6 +10,8 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/noncopyable.hpp>
 #include "common/stats/ThreadCachedServiceData.h"
@@ -53,6 +55,11 @@ class SwitchStats : public boost::noncopyable {
   void pktDropped() {
     trapPktDrops_.addValue(1);
   }
+  /*
+   * A trapped packet was dropped because the PacketDispatcher queue it was
+   * sharded to was full.
+   */
+  void dispatchQueueDrop(size_t queue);
   void pktBogus() {
     trapPktBogus_.addValue(1);
     trapPktDrops_.addValue(1);
@@ -221,6 +228,11 @@ class SwitchStats : public boost::noncopyable {
     updEventBacklog_.addValue(value);
   }
 
+  void neighborBatch(uint32_t size, std::chrono::microseconds latency) {
+    neighborBatchSize_.addValue(size);
+    neighborBatchLatency_.addValue(latency.count());
+  }
+
   void linkStateChange() {
     linkStateChange_.addValue(1);
   }
@@ -241,6 +253,8 @@ class SwitchStats : public boost::noncopyable {
   TLTimeseries trapPkts_;
   // Number of trapped packets that were intentionally dropped.
   TLTimeseries trapPktDrops_;
+  // Trapped packets dropped because their dispatch queue was full
+  TLTimeseries trapPktDispatchDrops_;
   // Malformed packets received
   TLTimeseries trapPktBogus_;
   // Number of times the controller encountered an error trying to process
@@ -360,6 +374,16 @@ class SwitchStats : public boost::noncopyable {
    */
   TLHistogram updEventBacklog_;
 
+  /**
+   * Number of neighbor table changes applied in each batched state update
+   */
+  TLHistogram neighborBatchSize_;
+
+  /**
+   * Time from a neighbor update batch being opened to it being applied (us)
+   */
+  TLHistogram neighborBatchLatency_;
+
   /**
    * Link state up/down change count
    */
@@ -368,6 +392,13 @@ class SwitchStats : public boost::noncopyable {
   // Create a PortStats object for the given PortID
   PortStats* createPortStats(PortID portID);
 
+  // The map our counters are in, for creating counters on demand
+  ThreadLocalStatsMap* map_{nullptr};
+
+  // Dispatch queue drops, indexed by queue, created the first time each
+  // queue drops a packet
+  std::vector<std::unique_ptr<TLTimeseries>> dispatchQueueDrops_;
+
   // Individual port stats objects, indexed by PortID
   PortStatsMap ports_;
 };
@@ -22,6 +22,7 @@
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/NeighborUpdater.h"
+#include "fboss/agent/RouteChangeNotifier.h"
 #include "fboss/agent/RouteUpdateLogger.h"
 #include "fboss/agent/capture/PktCapture.h"
 #include "fboss/agent/capture/PktCaptureManager.h"
@@ -42,11 +43,13 @@
 #include "fboss/agent/state/Vlan.h"
 #include "fboss/agent/state/VlanMap.h"
 #include "fboss/agent/if/gen-cpp2/NeighborListenerClient.h"
+#include "fboss/agent/if/gen-cpp2/RouteChangeListenerClient.h"
 
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/MoveWrapper.h>
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <thrift/lib/cpp2/async/DuplexChannel.h>
 
 using apache::thrift::ClientReceiveState;
@@ -75,6 +78,16 @@ using facebook::network::toBinaryAddress;
 using facebook::network::toAddress;
 using facebook::network::toIPAddress;
 
+DEFINE_int32(route_table_snapshot_timeout, 60,
+             "Seconds a paged route table dump can wait between pages before "
+             "the switch state it reads from is released");
+DEFINE_int32(max_route_table_snapshots, 16,
+             "The most paged route table dumps in progress at once, past "
+             "which the least recently used are dropped");
+DEFINE_int32(max_pending_route_changes, 100000,
+             "The most route changes to hold for a route change subscriber "
+             "that is behind, past which it is told to resync instead");
+
 namespace facebook { namespace fboss {
 
 namespace util {
@@ -120,6 +133,139 @@ class RouteUpdateStats {
   std::chrono::time_point<std::chrono::steady_clock> start_;
 };
 
+namespace {
+
+void toAddr(const IPAddress& ip, IPAddressV4* addr) {
+  *addr = ip.asV4();
+}
+
+void toAddr(const IPAddress& ip, IPAddressV6* addr) {
+  *addr = ip.asV6();
+}
+
+typedef folly::Optional<std::pair<IPAddress, uint8_t>> RouteTableFilter;
+
+/*
+ * The prefix a route table dump is limited to, if any.  Throws if the
+ * request's prefix is invalid.
+ */
+RouteTableFilter getRouteTableFilter(const RouteTablePageRequest& request) {
+  if (!request.__isset.prefix) {
+    return folly::none;
+  }
+  auto ip = toIPAddress(request.prefix.ip);
+  auto mask = request.prefix.prefixLength;
+  if (mask < 0 || mask > static_cast<int>(ip.bitCount())) {
+    throw FbossError("invalid prefix length ", mask, " for ", ip);
+  }
+  return std::make_pair(ip.mask(mask), uint8_t(mask));
+}
+
+/*
+ * Fills a page of a route table dump, a RIB at a time.
+ */
+class RouteTablePager {
+ public:
+  RouteTablePager(const RouteTablePageRequest& request, RouteTableFilter filter,
+                  int64_t snapshotId, RouteTablePage* page)
+      : request_(request),
+        snapshotId_(snapshotId),
+        page_(page),
+        remaining_(request.maxRoutes),
+        filter_(std::move(filter)) {}
+
+  /*
+   * Add the routes of rib that pass the filters, after the given route if
+   * any.  Returns false once the page is full.
+   */
+  template <typename AddrT>
+  bool addRoutes(RouterID vrf, const RouteTableRib<AddrT>& rib,
+                 const RoutePrefix<AddrT>* after) {
+    const auto& routes = rib.routes();
+    auto itr = routes.begin();
+    AddrT filterIp;
+    uint8_t filterMask = 0;
+    if (filter_) {
+      if (filter_->first.isV4() != std::is_same<AddrT, IPAddressV4>::value) {
+        return true;
+      }
+      toAddr(filter_->first, &filterIp);
+      filterMask = filter_->second;
+      itr = routes.subTreeBegin(filterIp, filterMask);
+    }
+    if (after) {
+      itr = routes.exactMatch(after->network, after->mask);
+      if (itr == routes.end()) {
+        throw FbossError("route ", after->str(), " not in route table");
+      }
+      ++itr;
+    }
+    // The routes within the filter prefix are all together
+    for (; itr != routes.end(); ++itr) {
+      if (filter_ && (itr.masklen() < filterMask ||
+                      itr.ipAddress().mask(filterMask) != filterIp)) {
+        break;
+      }
+      const auto& route = itr.value();
+      if (!addRoute(*route)) {
+        continue;
+      }
+      if (--remaining_ == 0) {
+        page_->cursor.snapshotId = snapshotId_;
+        page_->cursor.vrf = vrf;
+        page_->cursor.lastPrefix.ip = toBinaryAddress(route->prefix().network);
+        page_->cursor.lastPrefix.prefixLength = route->prefix().mask;
+        page_->__isset.cursor = true;
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  template <typename AddrT>
+  bool addRoute(const Route<AddrT>& route) {
+    if (request_.__isset.clientId) {
+      auto nhs = route.getNexthopsForClient(ClientID(request_.clientId));
+      if (!nhs.hasValue()) {
+        return false;
+      }
+      if (request_.details) {
+        page_->routeDetails.push_back(route.toRouteDetails());
+      } else {
+        UnicastRoute unicastRoute;
+        unicastRoute.dest.ip = toBinaryAddress(route.prefix().network);
+        unicastRoute.dest.prefixLength = route.prefix().mask;
+        unicastRoute.nextHopAddrs = util::fromRouteNextHops(nhs.value());
+        page_->routes.push_back(std::move(unicastRoute));
+      }
+      return true;
+    }
+    if (request_.details) {
+      page_->routeDetails.push_back(route.toRouteDetails());
+      return true;
+    }
+    if (!route.isResolved()) {
+      return false;
+    }
+    UnicastRoute unicastRoute;
+    unicastRoute.dest.ip = toBinaryAddress(route.prefix().network);
+    unicastRoute.dest.prefixLength = route.prefix().mask;
+    unicastRoute.nextHopAddrs =
+      util::fromFwdNextHops(route.getForwardInfo().getNexthops());
+    page_->routes.push_back(std::move(unicastRoute));
+    return true;
+  }
+
+  const RouteTablePageRequest& request_;
+  const int64_t snapshotId_;
+  RouteTablePage* page_;
+  int32_t remaining_;
+  RouteTableFilter filter_;
+};
+
+}
+
 ThriftHandler::ThriftHandler(SwSwitch* sw) : FacebookBase2("FBOSS"), sw_(sw) {
   sw->registerNeighborListener(
     [=](const std::vector<std::string>& added,
@@ -133,6 +279,14 @@ ThriftHandler::ThriftHandler(SwSwitch* sw) : FacebookBase2("FBOSS"), sw_(sw) {
               invokeNeighborListeners(listenerPtr, added, deleted); });
       }
   });
+  sw->getRouteChangeNotifier()->registerListener(
+    [=](std::shared_ptr<const RouteChangeBatch> batch) {
+      for (auto& listener : routeChangeListeners_.accessAllThreads()) {
+        auto listenerPtr = &listener;
+        listener.eventBase->runInEventBaseThread(
+            [=] { invokeRouteChangeListeners(listenerPtr, batch); });
+      }
+  });
 }
 
 fb_status ThriftHandler::getStatus() {
@@ -358,12 +512,18 @@ void ThriftHandler::getL2Table(std::vector<L2EntryThrift>& l2Table) {
 
 void ThriftHandler::fillPortStats(PortInfoThrift& portInfo) {
   auto portId = portInfo.portId;
+  // Use the HwSwitch's snapshot if it keeps one, rather than format and look
+  // up a dozen stat names for every port
+  if (sw_->getHw()->getPortCounters(
+          PortID(portId), &portInfo.input, &portInfo.output)) {
+    return;
+  }
   auto statMap = fbData->getStatMap();
+  // Currently, the internal name of the port is "port<n>", even though
+  // `the external name is "eth<a>/<b>/<c>"
+  auto portName = folly::to<std::string>("port", portId);
 
   auto getSumStat = [&] (StringPiece prefix, StringPiece name) {
-    // Currently, the internal name of the port is "port<n>", even though
-    // `the external name is "eth<a>/<b>/<c>"
-    auto portName = folly::to<std::string>("port", portId);
     auto statName = folly::to<std::string>(portName, ".", prefix, name);
     auto statPtr = statMap->getLockedStatPtr(statName);
     auto numLevels = statPtr->numLevels();
@@ -484,7 +644,7 @@ void ThriftHandler::getRouteTable(std::vector<UnicastRoute>& routes) {
       UnicastRoute tempRoute;
       auto ipv4 = ipv4Rib.value().get();
       if (!ipv4->isResolved()) {
-        LOG(INFO) << "Skipping unresolved route: " << ipv4->toFollyDynamic();
+        VLOG(3) << "Skipping unresolved route: " << ipv4->str();
         continue;
       }
       auto fwdInfo = ipv4->getForwardInfo();
@@ -497,7 +657,7 @@ void ThriftHandler::getRouteTable(std::vector<UnicastRoute>& routes) {
       UnicastRoute tempRoute;
       auto ipv6 = ipv6Rib.value().get();
       if (!ipv6->isResolved()) {
-        LOG(INFO) << "Skipping unresolved route: " << ipv6->toFollyDynamic();
+        VLOG(3) << "Skipping unresolved route: " << ipv6->str();
         continue;
       }
       auto fwdInfo = ipv6->getForwardInfo();
@@ -559,6 +719,115 @@ void ThriftHandler::getRouteTableDetails(std::vector<RouteDetails>& routes) {
   }
 }
 
+void ThriftHandler::getRouteTablePage(
+    RouteTablePage& page,
+    unique_ptr<RouteTablePageRequest> request) {
+  ensureConfigured();
+  if (request->maxRoutes <= 0) {
+    throw FbossError("maxRoutes must be positive, not ", request->maxRoutes);
+  }
+  // Check the whole request before pinning a snapshot for it
+  auto filter = getRouteTableFilter(*request);
+  IPAddress lastIp;
+  if (request->__isset.cursor) {
+    lastIp = toIPAddress(request->cursor.lastPrefix.ip);
+  }
+  int64_t snapshotId;
+  auto state = getRouteTableSnapshot(*request, &snapshotId);
+  // A dump that fails on its first page would never be continued, so don't
+  // keep its snapshot around until it times out
+  bool firstPage = !request->__isset.cursor;
+  SCOPE_FAIL {
+    if (firstPage) {
+      releaseRouteTableSnapshot(snapshotId);
+    }
+  };
+  RouteTablePager pager(*request, std::move(filter), snapshotId, &page);
+  page.generation = state->getGeneration();
+
+  const RouteTableCursor* cursor =
+    request->__isset.cursor ? &request->cursor : nullptr;
+  bool more = true;
+  for (const auto& routeTable : *state->getRouteTables()) {
+    auto vrf = routeTable->getID();
+    if (cursor && vrf < RouterID(cursor->vrf)) {
+      continue;
+    }
+    // Each VRF's IPv4 routes come before its IPv6 routes
+    if (cursor && vrf == RouterID(cursor->vrf) && lastIp.isV6()) {
+      RoutePrefixV6 after{lastIp.asV6(),
+                          uint8_t(cursor->lastPrefix.prefixLength)};
+      more = pager.addRoutes(vrf, *routeTable->getRibV6(), &after);
+    } else if (cursor && vrf == RouterID(cursor->vrf)) {
+      RoutePrefixV4 after{lastIp.asV4(),
+                          uint8_t(cursor->lastPrefix.prefixLength)};
+      more = pager.addRoutes(vrf, *routeTable->getRibV4(), &after) &&
+        pager.addRoutes<IPAddressV6>(vrf, *routeTable->getRibV6(), nullptr);
+    } else {
+      more = pager.addRoutes<IPAddressV4>(
+                 vrf, *routeTable->getRibV4(), nullptr) &&
+        pager.addRoutes<IPAddressV6>(vrf, *routeTable->getRibV6(), nullptr);
+    }
+    if (!more) {
+      break;
+    }
+  }
+  if (more) {
+    // That was the last page
+    releaseRouteTableSnapshot(snapshotId);
+  }
+}
+
+shared_ptr<SwitchState> ThriftHandler::getRouteTableSnapshot(
+    const RouteTablePageRequest& request,
+    int64_t* snapshotId) {
+  auto now = steady_clock::now();
+  auto timeout = seconds(FLAGS_route_table_snapshot_timeout);
+  size_t maxSnapshots = std::max(1, FLAGS_max_route_table_snapshots);
+  shared_ptr<SwitchState> state;
+  if (!request.__isset.cursor) {
+    state = sw_->getState();
+  }
+  SYNCHRONIZED(routeTableSnapshots_) {
+    auto& snapshots = routeTableSnapshots_.snapshots;
+    for (auto it = snapshots.begin(); it != snapshots.end();) {
+      if (now - it->second.lastUsed > timeout) {
+        it = snapshots.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (request.__isset.cursor) {
+      auto it = snapshots.find(request.cursor.snapshotId);
+      if (it == snapshots.end()) {
+        throw FbossError("route table snapshot ", request.cursor.snapshotId,
+                         " has expired, the dump has to be restarted");
+      }
+      it->second.lastUsed = now;
+      *snapshotId = it->first;
+      return it->second.state;
+    }
+    while (snapshots.size() >= maxSnapshots) {
+      auto lru = snapshots.begin();
+      for (auto it = snapshots.begin(); it != snapshots.end(); ++it) {
+        if (it->second.lastUsed < lru->second.lastUsed) {
+          lru = it;
+        }
+      }
+      snapshots.erase(lru);
+    }
+    *snapshotId = routeTableSnapshots_.nextId++;
+    snapshots[*snapshotId] = RouteTableSnapshot{state, now};
+  }
+  return state;
+}
+
+void ThriftHandler::releaseRouteTableSnapshot(int64_t snapshotId) {
+  SYNCHRONIZED(routeTableSnapshots_) {
+    routeTableSnapshots_.snapshots.erase(snapshotId);
+  }
+}
+
 void ThriftHandler::getIpRoute(UnicastRoute& route,
                                 std::unique_ptr<Address> addr, int32_t vrfId) {
   ensureConfigured();
@@ -709,10 +978,101 @@ void ThriftHandler::async_eb_registerForNeighborChanged(
   cb->done();
 }
 
+void ThriftHandler::invokeRouteChangeListeners(
+    ThreadLocalRouteChangeListener* listener,
+    std::shared_ptr<const RouteChangeBatch> batch) {
+  for (auto& entry : listener->subscribers) {
+    auto& subscriber = entry.second;
+    subscriber->queue.add(*batch);
+    if (!subscriber->sending && !subscriber->queue.empty()) {
+      sendRouteChanges(entry.first, subscriber);
+    }
+  }
+}
+
+void ThriftHandler::sendRouteChanges(
+    const TConnectionContext* ctx,
+    std::shared_ptr<RouteChangeSubscriber> subscriber) {
+  subscriber->sending = true;
+  auto clientDone = [=](ClientReceiveState&& state) {
+    subscriber->sending = false;
+    try {
+      RouteChangeListenerClientAsyncClient::recv_routesChanged(state);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Exception in route change listener: " << ex.what();
+      removeRouteChangeSubscriber(ctx, subscriber);
+      return;
+    }
+    // Whatever changed while that batch was out goes next
+    if (subscriber->subscribed && !subscriber->queue.empty()) {
+      sendRouteChanges(ctx, subscriber);
+    }
+  };
+  subscriber->client->routesChanged(clientDone, subscriber->queue.take());
+}
+
+void ThriftHandler::removeRouteChangeSubscriber(
+    const TConnectionContext* ctx,
+    const std::shared_ptr<RouteChangeSubscriber>& subscriber) {
+  auto info = routeChangeListeners_.get();
+  if (!info) {
+    return;
+  }
+  auto it = info->subscribers.find(ctx);
+  // It may have been replaced, or its connection closed, already
+  if (it != info->subscribers.end() && it->second == subscriber) {
+    subscriber->subscribed = false;
+    info->subscribers.erase(it);
+    sw_->getRouteChangeNotifier()->removeSubscriber();
+  }
+}
+
+void ThriftHandler::async_eb_registerForRouteChanges(
+    ThriftCallback<void> cb,
+    unique_ptr<RouteChangeSubscription> subscription) {
+  folly::Optional<folly::CIDRNetwork> filter;
+  if (subscription->__isset.prefix) {
+    auto ip = toIPAddress(subscription->prefix.ip);
+    auto mask = subscription->prefix.prefixLength;
+    if (mask < 0 || mask > static_cast<int>(ip.bitCount())) {
+      cb->exception(std::make_exception_ptr(
+          FbossError("invalid prefix length ", mask, " for ", ip)));
+      return;
+    }
+    filter = folly::CIDRNetwork(ip.mask(mask), mask);
+  }
+
+  auto ctx = cb->getConnectionContext()->getConnectionContext();
+  auto client = ctx->getDuplexClient<RouteChangeListenerClientAsyncClient>();
+  auto info = routeChangeListeners_.get();
+  CHECK(cb->getEventBase()->isInEventBaseThread());
+  if (!info) {
+    info = new ThreadLocalRouteChangeListener(cb->getEventBase());
+    routeChangeListeners_.reset(info);
+  }
+  DCHECK_EQ(info->eventBase, cb->getEventBase());
+  auto maxPending = std::max(1, FLAGS_max_pending_route_changes);
+  auto subscriber = std::make_shared<RouteChangeSubscriber>(
+      client, RouteChangeQueue(std::move(filter), maxPending));
+  auto& entry = info->subscribers[ctx];
+  if (entry) {
+    // Registering again replaces the filter, and drops what was pending
+    entry->subscribed = false;
+  } else {
+    sw_->getRouteChangeNotifier()->addSubscriber();
+  }
+  entry = std::move(subscriber);
+  cb->done();
+}
+
 void ThriftHandler::startPktCapture(unique_ptr<CaptureInfo> info) {
   ensureConfigured();
   auto* mgr = sw_->getCaptureMgr();
-  auto capture = make_unique<PktCapture>(info->name, info->maxPackets);
+  if (info->snaplen < 0) {
+    throw FbossError("invalid snaplen ", info->snaplen);
+  }
+  auto capture = make_unique<PktCapture>(
+      info->name, info->maxPackets, info->filter, info->snaplen);
   mgr->startCapture(std::move(capture));
 }
 
@@ -918,6 +1278,17 @@ void ThriftHandler::connectionDestroyed(TConnectionContext* ctx) {
     listeners_->clients.erase(ctx);
   }
 
+  // Route change notifications
+  if (routeChangeListeners_) {
+    auto& subscribers = routeChangeListeners_->subscribers;
+    auto it = subscribers.find(ctx);
+    if (it != subscribers.end()) {
+      it->second->subscribed = false;
+      subscribers.erase(it);
+      sw_->getRouteChangeNotifier()->removeSubscriber();
+    }
+  }
+
   // If there is an ongoing high-resolution counter subscription, kill it. Don't
   // grab a write lock if there are no active calls
   if (!highresKillSwitches_.asConst()->empty()) {
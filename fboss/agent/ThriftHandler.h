@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,8 +19,10 @@
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/HighresCounterSubscriptionHandler.h"
+#include "fboss/agent/RouteChangeNotifier.h"
 #include "fboss/agent/if/gen-cpp2/FbossCtrl.h"
 #include "fboss/agent/if/gen-cpp2/NeighborListenerClient.h"
+#include "fboss/agent/if/gen-cpp2/RouteChangeListenerClient.h"
 
 #include <folly/Synchronized.h>
 #include <folly/String.h>
@@ -30,6 +33,7 @@ namespace facebook { namespace fboss {
 
 class Port;
 class SwSwitch;
+class SwitchState;
 class Vlan;
 
 class ThriftHandler : virtual public FbossCtrlSvIf,
@@ -55,6 +59,10 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void async_eb_registerForNeighborChanged(
       ThriftCallback<void> callback) override;
 
+  void async_eb_registerForRouteChanges(
+      ThriftCallback<void> callback,
+      std::unique_ptr<RouteChangeSubscription> subscription) override;
+
   void flushCountersNow() override;
 
   void addUnicastRoute(
@@ -104,6 +112,9 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void getRouteTableByClient(
       std::vector<UnicastRoute>& routeTable, int16_t clientId) override;
   void getRouteTableDetails(std::vector<RouteDetails>& routeTable) override;
+  void getRouteTablePage(
+      RouteTablePage& page,
+      std::unique_ptr<RouteTablePageRequest> request) override;
 
   void getPortStatus(std::map<int32_t, PortStatus>& status,
                      std::unique_ptr<std::vector<int32_t>> ports)
@@ -243,12 +254,58 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   };
   folly::ThreadLocalPtr<ThreadLocalListener, int> listeners_;
 
+  /*
+   * A route change subscriber, and the changes it hasn't been sent yet.
+   * Only one batch is sent at a time, so a slow subscriber gets fewer,
+   * bigger batches rather than an ever longer backlog.
+   */
+  struct RouteChangeSubscriber {
+    RouteChangeSubscriber(
+        std::shared_ptr<RouteChangeListenerClientAsyncClient> client,
+        RouteChangeQueue queue)
+      : client(std::move(client)), queue(std::move(queue)) {}
+
+    std::shared_ptr<RouteChangeListenerClientAsyncClient> client;
+    RouteChangeQueue queue;
+    bool sending{false};
+    // Cleared once unsubscribed, while a batch may still be out
+    bool subscribed{true};
+  };
+  struct ThreadLocalRouteChangeListener {
+    EventBase* eventBase;
+    std::unordered_map<const TConnectionContext*,
+                       std::shared_ptr<RouteChangeSubscriber>>
+        subscribers;
+
+    explicit ThreadLocalRouteChangeListener(EventBase* eb) : eventBase(eb){};
+  };
+  folly::ThreadLocalPtr<ThreadLocalRouteChangeListener, int>
+    routeChangeListeners_;
+
   void onPortStatusChanged(PortID id, PortStatus st);
 
   void invokeNeighborListeners(ThreadLocalListener* info,
                                 std::vector<std::string> added,
                                 std::vector<std::string> deleted);
 
+  void invokeRouteChangeListeners(
+      ThreadLocalRouteChangeListener* info,
+      std::shared_ptr<const RouteChangeBatch> batch);
+  void sendRouteChanges(const TConnectionContext* ctx,
+                        std::shared_ptr<RouteChangeSubscriber> subscriber);
+  void removeRouteChangeSubscriber(
+      const TConnectionContext* ctx,
+      const std::shared_ptr<RouteChangeSubscriber>& subscriber);
+
+  /*
+   * The switch state a route table dump reads from, new for the first page
+   * and pinned until the last.
+   */
+  std::shared_ptr<SwitchState> getRouteTableSnapshot(
+      const RouteTablePageRequest& request,
+      int64_t* snapshotId);
+  void releaseRouteTableSnapshot(int64_t snapshotId);
+
   void getPortInfoHelper(
       PortInfoThrift& portInfo,
       const std::shared_ptr<Port> port);
@@ -286,5 +343,16 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   folly::Synchronized<
       std::unordered_map<const apache::thrift::server::TConnectionContext*,
                          std::shared_ptr<Signal>>> highresKillSwitches_;
+
+  struct RouteTableSnapshot {
+    std::shared_ptr<SwitchState> state;
+    std::chrono::steady_clock::time_point lastUsed;
+  };
+  struct RouteTableSnapshots {
+    int64_t nextId{1};
+    std::map<int64_t, RouteTableSnapshot> snapshots;
+  };
+  // The switch states pinned by paged route table dumps in progress
+  folly::Synchronized<RouteTableSnapshots> routeTableSnapshots_;
 };
 }} // facebook::fboss
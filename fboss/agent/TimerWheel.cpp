@@ -0,0 +1,186 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/TimerWheel.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+using std::chrono::milliseconds;
+
+namespace facebook { namespace fboss {
+
+namespace {
+constexpr uint64_t kSlotMask = TimerWheel::kSlotsPerLevel - 1;
+// The furthest ahead the top level can hold a timer.  Timers due later
+// than this are parked at the end of the top level until they are in range.
+constexpr uint64_t kMaxTicks =
+  uint64_t(1) << (TimerWheel::kBitsPerLevel * TimerWheel::kNumLevels);
+
+uint64_t slotIndex(uint64_t tick, unsigned level) {
+  return (tick >> (TimerWheel::kBitsPerLevel * level)) & kSlotMask;
+}
+}
+
+constexpr unsigned TimerWheel::kBitsPerLevel;
+constexpr unsigned TimerWheel::kSlotsPerLevel;
+constexpr unsigned TimerWheel::kNumLevels;
+
+TimerWheel::TimerWheel(folly::EventBase* evb,
+                       milliseconds tickInterval,
+                       ExpiredFn expired)
+  : AsyncTimeout(evb),
+    start_(Clock::now()),
+    tickInterval_(tickInterval),
+    expired_(std::move(expired)) {
+  CHECK_GT(tickInterval.count(), 0);
+}
+
+TimerWheel::~TimerWheel() {
+  // The slots unlink any timers still in them as they are destroyed
+  cancelTimeout();
+}
+
+void TimerWheel::schedule(Timer* timer, milliseconds timeout) {
+  cancel(timer);
+  auto due = tickAt(Clock::now() + timeout, true);
+  timer->dueTick_ = std::max(due, currentTick_ + 1);
+  place(timer);
+  ++numTimers_;
+  if (!isScheduled() || timer->dueTick_ < wakeupTick_) {
+    arm(timer->dueTick_);
+  }
+}
+
+void TimerWheel::cancel(Timer* timer) {
+  if (!timer->isScheduled()) {
+    return;
+  }
+  timer->hook_.unlink();
+  if (--numTimers_ == 0) {
+    cancelTimeout();
+  }
+}
+
+void TimerWheel::expire(Clock::time_point now) {
+  auto target = tickAt(now, false);
+  if (numTimers_ == 0) {
+    currentTick_ = std::max(currentTick_, target);
+    return;
+  }
+
+  while (currentTick_ < target) {
+    ++currentTick_;
+    if (slotIndex(currentTick_, 0) == 0) {
+      // Level 0 wrapped, so bring down the timers from the next slot of each
+      // level above that wrapped as well
+      for (unsigned level = 1; level < kNumLevels; ++level) {
+        cascade(level);
+        if (slotIndex(currentTick_, level) != 0) {
+          break;
+        }
+      }
+    }
+
+    TimerList due;
+    due.swap(slots_[0][slotIndex(currentTick_, 0)]);
+    while (!due.empty()) {
+      auto* timer = &due.front();
+      due.pop_front();
+      if (timer->dueTick_ > currentTick_) {
+        // Parked at the top level because it was out of range
+        place(timer);
+        continue;
+      }
+      --numTimers_;
+      batch_.push_back(timer);
+    }
+  }
+
+  if (!batch_.empty()) {
+    // The callback may well schedule timers again, but shouldn't re-enter
+    // expire(), so batch_ is only swapped out to be safe.
+    std::vector<Timer*> batch;
+    batch.swap(batch_);
+    expired_(batch);
+    batch.clear();
+    batch_.swap(batch);
+  }
+
+  if (numTimers_ > 0) {
+    arm(nextWakeupTick());
+  } else {
+    cancelTimeout();
+  }
+}
+
+void TimerWheel::timeoutExpired() noexcept {
+  expire(Clock::now());
+}
+
+uint64_t TimerWheel::tickAt(Clock::time_point time, bool roundUp) const {
+  if (time <= start_) {
+    return 0;
+  }
+  auto elapsed = time - start_;
+  uint64_t ticks = elapsed / tickInterval_;
+  if (roundUp && elapsed % tickInterval_ != Clock::duration::zero()) {
+    ++ticks;
+  }
+  return ticks;
+}
+
+void TimerWheel::place(Timer* timer) {
+  auto diff = timer->dueTick_ - currentTick_;
+  for (unsigned level = 0; level < kNumLevels - 1; ++level) {
+    if (diff < (uint64_t(1) << (kBitsPerLevel * (level + 1)))) {
+      slots_[level][slotIndex(timer->dueTick_, level)].push_back(*timer);
+      return;
+    }
+  }
+  auto tick =
+    diff < kMaxTicks ? timer->dueTick_ : currentTick_ + kMaxTicks - 1;
+  slots_[kNumLevels - 1][slotIndex(tick, kNumLevels - 1)].push_back(*timer);
+}
+
+void TimerWheel::cascade(unsigned level) {
+  TimerList timers;
+  timers.swap(slots_[level][slotIndex(currentTick_, level)]);
+  while (!timers.empty()) {
+    auto* timer = &timers.front();
+    timers.pop_front();
+    place(timer);
+  }
+}
+
+uint64_t TimerWheel::nextWakeupTick() const {
+  // The next occupied level 0 slot, or the next time level 0 wraps and
+  // timers come down from above, whichever is first
+  auto wrap = (currentTick_ | kSlotMask) + 1;
+  for (auto tick = currentTick_ + 1; tick < wrap; ++tick) {
+    if (!slots_[0][slotIndex(tick, 0)].empty()) {
+      return tick;
+    }
+  }
+  return wrap;
+}
+
+void TimerWheel::arm(uint64_t tick) {
+  wakeupTick_ = tick;
+  auto delay =
+    start_ + static_cast<int64_t>(tick) * tickInterval_ - Clock::now();
+  auto delayMs = std::chrono::duration_cast<milliseconds>(delay);
+  if (delayMs < delay) {
+    ++delayMs;
+  }
+  scheduleTimeout(std::max(delayMs, milliseconds(0)));
+}
+
+}} // facebook::fboss
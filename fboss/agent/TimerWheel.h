@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <folly/IntrusiveList.h>
+#include <folly/io/async/AsyncTimeout.h>
+
+namespace facebook { namespace fboss {
+
+/*
+ * A hierarchical timer wheel for a large number of timers which are
+ * rescheduled often and need no better than tick resolution, such as the
+ * neighbor cache entries.
+ *
+ * Timers are intrusive, so scheduling or cancelling one never allocates,
+ * and each costs two pointers and a tick count.  The wheel has kNumLevels
+ * levels of kSlotsPerLevel slots: level 0 has one slot per tick, and each
+ * slot of a higher level spans all of the level below it.  A timer goes in
+ * the lowest level which spans its due time, and is moved down a level at a
+ * time as that time gets closer, so it is touched at most kNumLevels times
+ * however long its timeout is.
+ *
+ * The wheel runs off a single AsyncTimeout on its EventBase, which only
+ * fires when there may be timers due.  All the timers due at that point are
+ * handed to the expired callback in one batch, so the owner can take its
+ * locks once for all of them.
+ *
+ * There is no locking: everything, including destroying the wheel, must
+ * happen in the EventBase thread.
+ */
+class TimerWheel : private folly::AsyncTimeout {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  class Timer {
+   public:
+    bool isScheduled() const {
+      return hook_.is_linked();
+    }
+
+   private:
+    friend class TimerWheel;
+    folly::IntrusiveListHook hook_;
+    uint64_t dueTick_{0};
+  };
+
+  typedef std::function<void(const std::vector<Timer*>&)> ExpiredFn;
+
+  TimerWheel(folly::EventBase* evb,
+             std::chrono::milliseconds tickInterval,
+             ExpiredFn expired);
+  ~TimerWheel() override;
+
+  /*
+   * (Re)schedule the timer to expire after the timeout, rounded up to a
+   * whole number of ticks.
+   */
+  void schedule(Timer* timer, std::chrono::milliseconds timeout);
+
+  void cancel(Timer* timer);
+
+  // The number of scheduled timers
+  size_t size() const {
+    return numTimers_;
+  }
+
+  /*
+   * Expire all the timers due by the given time.  This is called from the
+   * EventBase, and only needs calling directly in tests.
+   */
+  void expire(Clock::time_point now);
+
+  static constexpr unsigned kBitsPerLevel = 6;
+  static constexpr unsigned kSlotsPerLevel = 1 << kBitsPerLevel;
+  static constexpr unsigned kNumLevels = 4;
+
+ private:
+  typedef folly::IntrusiveList<Timer, &Timer::hook_> TimerList;
+
+  // Forbidden copy constructor and assignment operator
+  TimerWheel(TimerWheel const &) = delete;
+  TimerWheel& operator=(TimerWheel const &) = delete;
+
+  void timeoutExpired() noexcept override;
+
+  uint64_t tickAt(Clock::time_point time, bool roundUp) const;
+  void place(Timer* timer);
+  void cascade(unsigned level);
+  uint64_t nextWakeupTick() const;
+  void arm(uint64_t tick);
+
+  const Clock::time_point start_;
+  const Clock::duration tickInterval_;
+  ExpiredFn expired_;
+  std::array<std::array<TimerList, kSlotsPerLevel>, kNumLevels> slots_;
+  // The last tick which has been processed
+  uint64_t currentTick_{0};
+  // The tick the AsyncTimeout is scheduled for, if it is scheduled
+  uint64_t wakeupTick_{0};
+  size_t numTimers_{0};
+  // Reused for every batch, to avoid allocating on each tick
+  std::vector<Timer*> batch_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,366 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/WarmBootStateFile.h"
+
+#include <fcntl.h>
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Bits.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/MemoryMapping.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/SysError.h"
+#include "fboss/agent/Utils.h"
+
+DEFINE_bool(binary_warm_boot_state, true,
+            "Write the warm boot state file in the compact binary format "
+            "rather than JSON. Files in either format can be read back.");
+
+using folly::ByteRange;
+using folly::StringPiece;
+using std::string;
+
+namespace facebook { namespace fboss {
+
+namespace {
+
+constexpr uint8_t kMagic[] = {'F', 'B', 'W', 'B'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kBufferSize = 1 << 20;
+// Longest possible varint encoding of a 64 bit value
+constexpr size_t kMaxVarintSize = 10;
+
+enum Tag : uint8_t {
+  TAG_NULL = 0,
+  TAG_FALSE = 1,
+  TAG_TRUE = 2,
+  TAG_INT = 3,
+  TAG_DOUBLE = 4,
+  TAG_STRING = 5,
+  TAG_ARRAY = 6,
+  TAG_OBJECT = 7,
+  // A string to intern, followed by its length and bytes
+  TAG_KEY = 8,
+  // A previously interned string, followed by its id
+  TAG_KEY_REF = 9,
+};
+
+uint64_t zigzagEncode(int64_t val) {
+  return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+int64_t zigzagDecode(uint64_t val) {
+  return static_cast<int64_t>((val >> 1) ^ -(val & 1));
+}
+
+class BinaryStateWriter {
+ public:
+  explicit BinaryStateWriter(const string& filename)
+    : file_(openFile(filename)),
+      buf_(new uint8_t[kBufferSize]) {}
+
+  void writeHeader() {
+    writeBytes(kMagic, sizeof(kMagic));
+    writeByte(kVersion);
+  }
+
+  void write(const folly::dynamic& value);
+
+  void flush() {
+    if (used_) {
+      writeToFile(buf_.get(), used_);
+      used_ = 0;
+    }
+  }
+
+ private:
+  static folly::File openFile(const string& filename) {
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    sysCheckError(fd, "Unable to open warm boot state file ", filename);
+    return folly::File(fd, true);
+  }
+
+  void writeToFile(const uint8_t* data, size_t len) {
+    auto ret = folly::writeFull(file_.fd(), data, len);
+    sysCheckError(ret, "Unable to write warm boot state file");
+  }
+
+  void ensure(size_t len) {
+    if (used_ + len > kBufferSize) {
+      flush();
+    }
+  }
+
+  void writeByte(uint8_t byte) {
+    ensure(1);
+    buf_[used_++] = byte;
+  }
+
+  void writeVarint(uint64_t val) {
+    ensure(kMaxVarintSize);
+    while (val >= 0x80) {
+      buf_[used_++] = 0x80 | (val & 0x7f);
+      val >>= 7;
+    }
+    buf_[used_++] = val;
+  }
+
+  void writeBytes(const void* data, size_t len) {
+    if (len > kBufferSize / 2) {
+      // Don't bother copying large strings through the buffer
+      flush();
+      writeToFile(static_cast<const uint8_t*>(data), len);
+      return;
+    }
+    ensure(len);
+    memcpy(buf_.get() + used_, data, len);
+    used_ += len;
+  }
+
+  void writeString(Tag tag, StringPiece str) {
+    writeByte(tag);
+    writeVarint(str.size());
+    writeBytes(str.data(), str.size());
+  }
+
+  void writeKey(const folly::dynamic& key) {
+    if (!key.isString()) {
+      write(key);
+      return;
+    }
+    const auto& str = key.getString();
+    auto ret = keys_.emplace(str, keys_.size());
+    if (ret.second) {
+      writeString(TAG_KEY, str);
+    } else {
+      writeByte(TAG_KEY_REF);
+      writeVarint(ret.first->second);
+    }
+  }
+
+  folly::File file_;
+  std::unique_ptr<uint8_t[]> buf_;
+  size_t used_{0};
+  std::unordered_map<string, uint64_t> keys_;
+};
+
+void BinaryStateWriter::write(const folly::dynamic& value) {
+  switch (value.type()) {
+    case folly::dynamic::NULLT:
+      writeByte(TAG_NULL);
+      break;
+    case folly::dynamic::BOOL:
+      writeByte(value.getBool() ? TAG_TRUE : TAG_FALSE);
+      break;
+    case folly::dynamic::INT64:
+      writeByte(TAG_INT);
+      writeVarint(zigzagEncode(value.getInt()));
+      break;
+    case folly::dynamic::DOUBLE: {
+      writeByte(TAG_DOUBLE);
+      uint64_t bits;
+      auto dbl = value.getDouble();
+      memcpy(&bits, &dbl, sizeof(bits));
+      bits = folly::Endian::little(bits);
+      writeBytes(&bits, sizeof(bits));
+      break;
+    }
+    case folly::dynamic::STRING:
+      writeString(TAG_STRING, value.getString());
+      break;
+    case folly::dynamic::ARRAY:
+      writeByte(TAG_ARRAY);
+      writeVarint(value.size());
+      for (const auto& elem : value) {
+        write(elem);
+      }
+      break;
+    case folly::dynamic::OBJECT:
+      writeByte(TAG_OBJECT);
+      writeVarint(value.size());
+      for (const auto& item : value.items()) {
+        writeKey(item.first);
+        write(item.second);
+      }
+      break;
+  }
+}
+
+class BinaryStateReader {
+ public:
+  explicit BinaryStateReader(ByteRange data) : data_(data) {}
+
+  void readHeader() {
+    if (!isBinaryState(data_)) {
+      throw FbossError("not a binary warm boot state");
+    }
+    data_.advance(sizeof(kMagic));
+    auto version = readByte();
+    if (version != kVersion) {
+      throw FbossError("unsupported binary warm boot state version ",
+                       static_cast<int>(version));
+    }
+  }
+
+  folly::dynamic read();
+
+  bool done() const {
+    return data_.empty();
+  }
+
+ private:
+  void need(size_t len) const {
+    if (data_.size() < len) {
+      throw FbossError("truncated binary warm boot state");
+    }
+  }
+
+  uint8_t readByte() {
+    need(1);
+    auto byte = data_[0];
+    data_.advance(1);
+    return byte;
+  }
+
+  uint64_t readVarint() {
+    uint64_t val = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      auto byte = readByte();
+      val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return val;
+      }
+    }
+    throw FbossError("invalid varint in binary warm boot state");
+  }
+
+  StringPiece readString() {
+    auto len = readVarint();
+    need(len);
+    StringPiece str(reinterpret_cast<const char*>(data_.data()), len);
+    data_.advance(len);
+    return str;
+  }
+
+  ByteRange data_;
+  std::vector<string> keys_;
+};
+
+folly::dynamic BinaryStateReader::read() {
+  auto tag = readByte();
+  switch (tag) {
+    case TAG_NULL:
+      return nullptr;
+    case TAG_FALSE:
+      return false;
+    case TAG_TRUE:
+      return true;
+    case TAG_INT:
+      return zigzagDecode(readVarint());
+    case TAG_DOUBLE: {
+      need(sizeof(uint64_t));
+      uint64_t bits;
+      memcpy(&bits, data_.data(), sizeof(bits));
+      data_.advance(sizeof(bits));
+      bits = folly::Endian::little(bits);
+      double dbl;
+      memcpy(&dbl, &bits, sizeof(dbl));
+      return dbl;
+    }
+    case TAG_STRING:
+      return readString();
+    case TAG_ARRAY: {
+      auto size = readVarint();
+      folly::dynamic array = folly::dynamic::array;
+      for (uint64_t i = 0; i < size; ++i) {
+        array.push_back(read());
+      }
+      return array;
+    }
+    case TAG_OBJECT: {
+      auto size = readVarint();
+      folly::dynamic object = folly::dynamic::object;
+      for (uint64_t i = 0; i < size; ++i) {
+        auto key = read();
+        object.insert(std::move(key), read());
+      }
+      return object;
+    }
+    case TAG_KEY:
+      keys_.push_back(readString().str());
+      return keys_.back();
+    case TAG_KEY_REF: {
+      auto id = readVarint();
+      if (id >= keys_.size()) {
+        throw FbossError("invalid key id ", id, " in binary warm boot state");
+      }
+      return keys_[id];
+    }
+  }
+  throw FbossError("invalid tag ", static_cast<int>(tag),
+                   " in binary warm boot state");
+}
+
+} // anonymous namespace
+
+bool isBinaryState(ByteRange data) {
+  return data.size() >= sizeof(kMagic) &&
+    memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+folly::dynamic parseBinaryState(ByteRange data) {
+  BinaryStateReader reader(data);
+  reader.readHeader();
+  auto state = reader.read();
+  if (!reader.done()) {
+    throw FbossError("trailing data after binary warm boot state");
+  }
+  return state;
+}
+
+void writeBinaryStateFile(const string& filename,
+                          const folly::dynamic& state) {
+  BinaryStateWriter writer(filename);
+  writer.writeHeader();
+  writer.write(state);
+  writer.flush();
+}
+
+void writeWarmBootStateFile(const string& filename,
+                            const folly::dynamic& state) {
+  if (FLAGS_binary_warm_boot_state) {
+    writeBinaryStateFile(filename, state);
+  } else if (!dumpStateToFile(filename, state)) {
+    throw SysError(errno, "Unable to write warm boot state file ", filename);
+  }
+}
+
+folly::dynamic readWarmBootStateFile(const string& filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  sysCheckError(fd, "Unable to read switch state from : ", filename);
+  folly::MemoryMapping mapping(folly::File(fd, true));
+  mapping.hintLinearScan();
+  auto data = mapping.range();
+  if (isBinaryState(data)) {
+    return parseBinaryState(data);
+  }
+  return folly::parseJson(
+      StringPiece(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+}} // facebook::fboss
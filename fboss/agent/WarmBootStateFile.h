@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <string>
+
+#include <folly/dynamic.h>
+#include <folly/Range.h>
+
+namespace facebook { namespace fboss {
+
+/*
+ * The warm boot state file holds the folly::dynamic form of the SwSwitch and
+ * HwSwitch state, saved on graceful exit and read back on the next (warm)
+ * boot.
+ *
+ * With a full FIB that state is large, so it is normally written in a
+ * compact binary encoding rather than JSON:
+ *
+ *   - A 4 byte magic ("FBWB") and a 1 byte version
+ *   - The value, written depth first as a 1 byte type tag followed by:
+ *       integers:        zigzag encoded varint
+ *       doubles:         8 bytes, little endian
+ *       strings:         varint length and the bytes
+ *       arrays:          varint number of elements and the elements
+ *       objects:         varint number of entries and the key, value pairs
+ *
+ * Object keys repeat a lot (every route has a "network" key, for instance),
+ * so string keys are interned: the first occurrence of a key carries the
+ * string and assigns it the next id, later ones just refer to the id.
+ *
+ * The file is written in a single streaming pass through a fixed size
+ * buffer, and read back from a memory mapping of the file without copying
+ * it into a buffer first.
+ *
+ * Files which don't start with the magic are parsed as JSON, so state files
+ * written as JSON (by older versions, or with --binary_warm_boot_state=false)
+ * can still be read.
+ */
+
+/*
+ * Write the state to the file, in the binary format unless
+ * --binary_warm_boot_state=false.
+ */
+void writeWarmBootStateFile(const std::string& filename,
+                            const folly::dynamic& state);
+
+/*
+ * Write the state to the file in the binary format.
+ */
+void writeBinaryStateFile(const std::string& filename,
+                          const folly::dynamic& state);
+
+/*
+ * Read the state back from a file written in either format.
+ */
+folly::dynamic readWarmBootStateFile(const std::string& filename);
+
+/*
+ * Decode a state in the binary format.  Throws FbossError if the data is not
+ * a complete binary state.
+ */
+folly::dynamic parseBinaryState(folly::ByteRange data);
+
+/*
+ * Whether the data starts like a binary state.
+ */
+bool isBinaryState(folly::ByteRange data);
+
+}} // facebook::fboss
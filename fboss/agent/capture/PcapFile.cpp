@@ -28,12 +28,10 @@ PcapFile::PktHeader::PktHeader(const PcapPkt& pkt) {
   auto ts = pkt.timestamp().time_since_epoch();
   seconds tsSec = std::chrono::duration_cast<seconds>(ts);
   microseconds tsUsec = std::chrono::duration_cast<microseconds>(ts);
-  auto len = pkt.buf()->computeChainDataLength();
-
   timeSec = tsSec.count();
   timeUsec = (tsUsec - tsSec).count();
-  includedLen = len;
-  origLen = len;
+  includedLen = pkt.buf()->computeChainDataLength();
+  origLen = pkt.origLength();
 }
 
 PcapFile::PcapFile() {
@@ -51,7 +49,7 @@ void PcapFile::close() {
   file_.close();
 }
 
-void PcapFile::writeGlobalHeader() {
+void PcapFile::writeGlobalHeader(uint32_t snaplen) {
   struct GlobalHeader {
     uint32_t magic;
     uint16_t versionMajor;
@@ -66,7 +64,7 @@ void PcapFile::writeGlobalHeader() {
   hdr.versionMinor = 4;
   hdr.tzOffset = 0;
   hdr.sigfigs = 0;
-  hdr.snaplen = 0xffff;
+  hdr.snaplen = snaplen;
   // Link type 1 is ethernet.  Other possible types we might want to use
   // include 113 for linux "cooked" capture format.
   hdr.linkType = 1;
@@ -32,7 +32,8 @@ class PcapFile {
 
   void close();
 
-  void writeGlobalHeader();
+  // snaplen is the most bytes of any packet the file will hold
+  void writeGlobalHeader(uint32_t snaplen = 0xffff);
   void writePackets(const std::vector<PcapPkt>& pkt);
 
   // Move constructor and assignment operator
@@ -9,6 +9,8 @@
  */
 #include "fboss/agent/capture/PcapPkt.h"
 
+#include <folly/io/Cursor.h>
+
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/TxPacket.h"
 
@@ -21,28 +23,40 @@ PcapPkt::PcapPkt(const RxPacket* pkt)
   : PcapPkt(pkt, std::chrono::system_clock::now()) {
 }
 
-PcapPkt::PcapPkt(const RxPacket* pkt, TimePoint timestamp)
+PcapPkt::PcapPkt(const RxPacket* pkt, TimePoint timestamp, uint32_t snaplen)
   : initialized_(true),
     rx_(true),
     port_(pkt->getSrcPort()),
     vlan_(pkt->getSrcVlan()),
     timestamp_(timestamp),
     buf_() {
-  pkt->buf()->cloneInto(buf_);
+  copyBuf(pkt->buf(), snaplen);
 }
 
 PcapPkt::PcapPkt(const TxPacket* pkt)
   : PcapPkt(pkt, std::chrono::system_clock::now()) {
 }
 
-PcapPkt::PcapPkt(const TxPacket* pkt, TimePoint timestamp)
+PcapPkt::PcapPkt(const TxPacket* pkt, TimePoint timestamp, uint32_t snaplen)
   : initialized_(true),
     rx_(false),
     port_(0),
     vlan_(0),
     timestamp_(timestamp),
     buf_() {
-  pkt->buf()->cloneInto(buf_);
+  copyBuf(pkt->buf(), snaplen);
+}
+
+void PcapPkt::copyBuf(const folly::IOBuf* buf, uint32_t snaplen) {
+  origLength_ = buf->computeChainDataLength();
+  if (snaplen == 0 || origLength_ <= snaplen) {
+    buf->cloneInto(buf_);
+    return;
+  }
+  // Copy just the part we keep, rather than holding on to the whole buffer
+  buf_ = folly::IOBuf(folly::IOBuf::CREATE, snaplen);
+  folly::io::Cursor(buf).pull(buf_.writableData(), snaplen);
+  buf_.append(snaplen);
 }
 
 }} // facebook::fboss
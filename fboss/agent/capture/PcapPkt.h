@@ -32,15 +32,18 @@ class PcapPkt {
 
   /*
    * Create a PcapPkt from an RxPacket
+   *
+   * If snaplen is non-zero only the first snaplen bytes of the packet are
+   * kept, and those are copied rather than sharing the packet's buffer.
    */
   explicit PcapPkt(const RxPacket* pkt);
-  PcapPkt(const RxPacket* pkt, TimePoint timestamp);
+  PcapPkt(const RxPacket* pkt, TimePoint timestamp, uint32_t snaplen = 0);
 
   /*
    * Create a PcapPkt from a TxPacket
    */
   explicit PcapPkt(const TxPacket* pkt);
-  PcapPkt(const TxPacket* pkt, TimePoint timestamp);
+  PcapPkt(const TxPacket* pkt, TimePoint timestamp, uint32_t snaplen = 0);
 
   bool initialized() const {
     return initialized_;
@@ -63,6 +66,10 @@ class PcapPkt {
   const folly::IOBuf* buf() const {
     return &buf_;
   }
+  // The length of the packet on the wire, which can be more than buf() has
+  uint32_t origLength() const {
+    return origLength_;
+  }
 
   // Move assignment
   PcapPkt(PcapPkt&& other) noexcept {
@@ -77,6 +84,7 @@ class PcapPkt {
     vlan_ = other.vlan_;
     timestamp_ = other.timestamp_;
     buf_ = std::move(other.buf_);
+    origLength_ = other.origLength_;
     return *this;
   }
 
@@ -85,6 +93,8 @@ class PcapPkt {
   PcapPkt(PcapPkt const&) = delete;
   PcapPkt& operator=(PcapPkt const&) = delete;
 
+  void copyBuf(const folly::IOBuf* buf, uint32_t snaplen);
+
   bool initialized_{false};
   // Whether or not we received this packet, or are sending it.
   bool rx_{false};
@@ -101,6 +111,7 @@ class PcapPkt {
   TimePoint timestamp_;
   // The packet contents, starting from the ethernet header.
   folly::IOBuf buf_;
+  uint32_t origLength_{0};
 };
 
 }} // facebook::fboss
@@ -9,6 +9,8 @@
  */
 #include "fboss/agent/capture/PcapQueue.h"
 
+#include <algorithm>
+
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/capture/PcapPkt.h"
@@ -20,99 +22,167 @@ DEFINE_int32(fboss_pcap_queue_depth, 10240,
 
 namespace facebook { namespace fboss {
 
-PcapQueue::PcapQueue(uint32_t pktCapacity, uint64_t bytesCapacity)
+PcapQueue::PcapQueue(uint32_t pktCapacity, uint64_t bytesCapacity,
+                     uint32_t snaplen)
   : pktCapacity_(pktCapacity == 0 ?
                  FLAGS_fboss_pcap_queue_depth : pktCapacity),
-    bytesCapacity_(bytesCapacity) {
-  queue_.reserve(pktCapacity_);
+    bytesCapacity_(bytesCapacity),
+    snaplen_(snaplen),
+    slots_(new Slot[pktCapacity_]) {
+  for (uint32_t i = 0; i < pktCapacity_; ++i) {
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
 }
 
 PcapQueue::~PcapQueue() {
 }
 
+bool PcapQueue::reserveBytes(uint64_t bytes) {
+  auto total = bytesInQueue_.fetch_add(bytes, std::memory_order_relaxed);
+  if (total + bytes >= bytesCapacity_) {
+    bytesInQueue_.fetch_sub(bytes, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
 template<typename PktType>
 void PcapQueue::addPktInternal(const PktType* pkt) {
-  // Check to see if this would exceed the queue capacity.
-  if (queue_.size() >= pktCapacity_) {
-    pktsDropped_ += 1;
-    return;
+  uint64_t bytes = 0;
+  if (bytesCapacity_ > 0) {
+    bytes = pkt->buf()->computeChainDataLength();
+    if (snaplen_ > 0) {
+      bytes = std::min<uint64_t>(bytes, snaplen_);
+    }
+    if (!reserveBytes(bytes)) {
+      pktsDropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
   }
-  auto newBytes = bytesInQueue_ + pkt->buf()->computeChainDataLength();
-  if (bytesCapacity_ > 0 && newBytes >= bytesCapacity_) {
-    pktsDropped_ += 1;
-    return;
+
+  // Claim the slot at the tail
+  auto pos = tail_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[pos % pktCapacity_];
+    auto seq = slot->seq.load(std::memory_order_acquire);
+    auto diff = static_cast<int64_t>(seq - pos);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + 1,
+                                      std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The reader hasn't taken the packet from the previous lap yet, so
+      // the queue is full
+      bytesInQueue_.fetch_sub(bytes, std::memory_order_relaxed);
+      pktsDropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      // Another producer claimed this slot first
+      pos = tail_.load(std::memory_order_relaxed);
+    }
   }
 
-  queue_.emplace_back(pkt);
+  slot->pkt = PcapPkt(pkt, std::chrono::system_clock::now(), snaplen_);
+  slot->seq.store(pos + 1, std::memory_order_release);
+
+  // Pairs with the fence in wait(): either we see that the reader is
+  // waiting, or the reader sees this packet before it goes to sleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (readerWaiting_.load(std::memory_order_relaxed)) {
+    wakeReader();
+  }
 }
 
-void PcapQueue::addPkt(const RxPacket* pkt) {
+void PcapQueue::wakeReader() {
+  // Only one of the producers racing here needs to do the wakeup
+  if (!readerWaiting_.exchange(false)) {
+    return;
+  }
+  // The reader holds the mutex from deciding to sleep until it is actually
+  // waiting, so once we have held it the notification can't be missed.
   {
     std::lock_guard<std::mutex> guard(mutex_);
-    addPktInternal(pkt);
   }
   cv_.notify_one();
 }
 
-void PcapQueue::addPktLocked(const RxPacket* pkt) {
+void PcapQueue::addPkt(const RxPacket* pkt) {
   addPktInternal(pkt);
-  // It is preferred not to be holding the lock when we signal cv_,
-  // but it is okay to call it with the lock held anyway.  (Having the lock
-  // held will just prevent the reader thread from being able to acquire it
-  // immediately when the reader wakes.)
-  cv_.notify_one();
 }
 
 void PcapQueue::addPkt(const TxPacket* pkt) {
-  {
-    std::lock_guard<std::mutex> guard(mutex_);
-    addPktInternal(pkt);
-  }
-  cv_.notify_one();
-}
-
-void PcapQueue::addPktLocked(const TxPacket* pkt) {
   addPktInternal(pkt);
-  // It is preferred not to be holding the lock when we signal cv_,
-  // but it is okay to call it with the lock held anyway.  (Having the lock
-  // held will just prevent the reader thread from being able to acquire it
-  // immediately when the reader wakes.)
-  cv_.notify_one();
 }
 
 void PcapQueue::finish() {
-  std::lock_guard<std::mutex> guard(mutex_);
-  finished_ = true;
+  finished_.store(true, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+  }
   cv_.notify_all();
 }
 
 bool PcapQueue::isFinished() const {
-  std::lock_guard<std::mutex> guard(mutex_);
-  return finished_;
+  return finished_.load(std::memory_order_acquire);
 }
 
 uint64_t PcapQueue::numDropped() const {
-  std::lock_guard<std::mutex> guard(mutex_);
-  return pktsDropped_;
+  return pktsDropped_.load(std::memory_order_relaxed);
+}
+
+bool PcapQueue::pktAvailable() const {
+  const auto& slot = slots_[head_ % pktCapacity_];
+  return slot.seq.load(std::memory_order_acquire) == head_ + 1;
+}
+
+size_t PcapQueue::drain(std::vector<PcapPkt>* pkts) {
+  size_t count = 0;
+  uint64_t bytes = 0;
+  while (pktAvailable()) {
+    auto& slot = slots_[head_ % pktCapacity_];
+    if (bytesCapacity_ > 0) {
+      bytes += slot.pkt.buf()->computeChainDataLength();
+    }
+    pkts->push_back(std::move(slot.pkt));
+    slot.seq.store(head_ + pktCapacity_, std::memory_order_release);
+    ++head_;
+    ++count;
+  }
+  if (bytes) {
+    bytesInQueue_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+  return count;
 }
 
 bool PcapQueue::wait(std::vector<PcapPkt>* swapQueue) {
   swapQueue->clear();
   swapQueue->reserve(pktCapacity_);
 
-  std::unique_lock<std::mutex> guard(mutex_);
-  while (queue_.empty() && !finished_) {
-    cv_.wait(guard);
+  while (true) {
+    if (drain(swapQueue)) {
+      return true;
+    }
+    if (finished_.load(std::memory_order_acquire)) {
+      // Pick up anything added right before finish()
+      return drain(swapQueue) > 0;
+    }
+
+    std::unique_lock<std::mutex> guard(mutex_);
+    while (true) {
+      // A producer clears readerWaiting_ when it wakes us up.  Slots can be
+      // filled out of order, so the packet that woke us may not be the one
+      // at head_ yet, and we have to ask again to be woken for that one.
+      readerWaiting_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (pktAvailable() || finished_.load(std::memory_order_acquire)) {
+        break;
+      }
+      cv_.wait(guard);
+    }
+    readerWaiting_.store(false, std::memory_order_relaxed);
   }
-  if (queue_.empty()) {
-    DCHECK(finished_);
-    queue_.shrink_to_fit();
-    return false;
-  }
-
-  swapQueue->swap(queue_);
-  bytesInQueue_ = 0;
-  return true;
 }
 
 }} // facebook::fboss
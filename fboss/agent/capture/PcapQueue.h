@@ -9,48 +9,53 @@
  */
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
+#include "fboss/agent/capture/PcapPkt.h"
+
 namespace facebook { namespace fboss {
 
 class RxPacket;
 class TxPacket;
-class PcapPkt;
 
 /*
  * PcapQueue stores a queue of PcapPkt objects, for transferring packets
  * from an asynchronous capture thread to a blocking thread that will process
  * the packets.  (For instance, writing them to disk using blocking I/O.)
  *
- * There can only be a single reader.
+ * Packets are added from the packet RX and TX paths, possibly from several
+ * threads at once, so adding a packet never takes a lock: the queue is a
+ * bounded ring of slots allocated up front, which producers claim with an
+ * atomic increment.  When the ring is full the packet is dropped and
+ * counted.
+ *
+ * There can only be a single reader.  It takes all the packets available
+ * at once, and producers only wake it up when it is actually waiting, so
+ * a burst of packets costs at most a wakeup or two.
  */
 class PcapQueue {
  public:
-  explicit PcapQueue(uint32_t pktCapacity, uint64_t bytesCapacity = 0);
+  /*
+   * If snaplen is non-zero, only the first snaplen bytes of each packet
+   * are kept.
+   */
+  explicit PcapQueue(uint32_t pktCapacity, uint64_t bytesCapacity = 0,
+                     uint32_t snaplen = 0);
   virtual ~PcapQueue();
 
   uint32_t getPktCapacity() const {
-    // pktCapacity_ is const, so no need for locking
     return pktCapacity_;
   }
-
-  /*
-   * Get the mutex protecting this PcapQueue.
-   *
-   * This is exposed to allow callers to also protect their own data
-   * with the same mutex if desired.  Callers should call addPktLocked()
-   * instead of addPkt() when they are already holding the PcapQueue mutex.
-   */
-  std::mutex& mutex() const {
-    return mutex_;
+  uint32_t getSnaplen() const {
+    return snaplen_;
   }
 
   void addPkt(const RxPacket* pkt);
-  void addPktLocked(const RxPacket* pkt);
   void addPkt(const TxPacket* pkt);
-  void addPktLocked(const TxPacket* pkt);
 
   /*
    * finish() signals that no more packets will be added to the queue.
@@ -80,22 +85,46 @@ class PcapQueue {
   bool wait(std::vector<PcapPkt>* swapQueue);
 
  private:
+  /*
+   * A slot in the ring.  'seq' says who owns it: the slot at position 'pos'
+   * can be filled by a producer when seq == pos, and read when
+   * seq == pos + 1.  Reading it sets seq to pos + pktCapacity_, handing it
+   * to the producer of the next lap.
+   */
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    PcapPkt pkt;
+  };
+
   // Forbidden copy constructor and assignment operator
   PcapQueue(PcapQueue const &) = delete;
   PcapQueue& operator=(PcapQueue const &) = delete;
 
   template<typename PktType>
   void addPktInternal(const PktType* pkt);
+  bool reserveBytes(uint64_t bytes);
+  void wakeReader();
+  // Move all the packets available to 'pkts', returning how many there were
+  size_t drain(std::vector<PcapPkt>* pkts);
+  bool pktAvailable() const;
 
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
-
-  bool finished_{false};
   const uint32_t pktCapacity_{0};
-  uint64_t bytesCapacity_{0};
-  uint64_t bytesInQueue_{0};
-  uint64_t pktsDropped_{0};
-  std::vector<PcapPkt> queue_;
+  const uint64_t bytesCapacity_{0};
+  const uint32_t snaplen_{0};
+  std::unique_ptr<Slot[]> slots_;
+
+  // Next position to fill, shared by the producers
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> bytesInQueue_{0};
+  std::atomic<uint64_t> pktsDropped_{0};
+
+  // Next position to read, only used by the reader
+  alignas(64) uint64_t head_{0};
+  std::atomic<bool> readerWaiting_{false};
+  std::atomic<bool> finished_{false};
+  // Only used to put the reader to sleep and wake it up
+  std::mutex mutex_;
+  std::condition_variable cv_;
 };
 
 }} // facebook::fboss
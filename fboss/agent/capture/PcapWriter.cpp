@@ -17,15 +17,16 @@ using folly::StringPiece;
 
 namespace facebook { namespace fboss {
 
-PcapWriter::PcapWriter(uint32_t maxBufferedPkts)
-  : queue_(maxBufferedPkts) {
+PcapWriter::PcapWriter(uint32_t maxBufferedPkts, uint32_t snaplen)
+  : queue_(maxBufferedPkts, 0, snaplen) {
 }
 
 PcapWriter::PcapWriter(StringPiece path,
                        bool overwriteExisting,
-                       uint32_t maxBufferedPkts)
+                       uint32_t maxBufferedPkts,
+                       uint32_t snaplen)
   : file_(path, overwriteExisting),
-    queue_(maxBufferedPkts),
+    queue_(maxBufferedPkts, 0, snaplen),
     thread_(&PcapWriter::threadMain, this) {
 }
 
@@ -61,7 +62,11 @@ void PcapWriter::finish() {
 
 void PcapWriter::threadMain() {
   try {
-    file_.writeGlobalHeader();
+    if (queue_.getSnaplen() > 0) {
+      file_.writeGlobalHeader(queue_.getSnaplen());
+    } else {
+      file_.writeGlobalHeader();
+    }
     writeLoop();
     file_.close();
   } catch (const std::exception& ex) {
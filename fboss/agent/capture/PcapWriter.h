@@ -24,37 +24,25 @@ namespace facebook { namespace fboss {
  */
 class PcapWriter {
  public:
-  explicit PcapWriter(uint32_t maxBufferedPkts = 0);
+  /*
+   * If snaplen is non-zero, only the first snaplen bytes of each packet
+   * are written.
+   */
+  explicit PcapWriter(uint32_t maxBufferedPkts = 0, uint32_t snaplen = 0);
   explicit PcapWriter(folly::StringPiece path,
                       bool overwriteExisting = false,
-                      uint32_t maxBufferedPkts = 0);
+                      uint32_t maxBufferedPkts = 0,
+                      uint32_t snaplen = 0);
   virtual ~PcapWriter();
 
   void start(folly::StringPiece path, bool overwriteExisting = false);
 
-  /*
-   * Get the mutex protecting this PcapWriter.
-   *
-   * This is exposed to allow callers to also protect their own data
-   * with the same mutex if desired.  Callers should call addPktLocked()
-   * instead of addPkt() when they are already holding the PcapWriter mutex.
-   */
-  std::mutex& mutex() const {
-    return queue_.mutex();
-  }
-
   void addPkt(const RxPacket* pkt) {
     queue_.addPkt(pkt);
   }
-  void addPktLocked(const RxPacket* pkt) {
-    queue_.addPktLocked(pkt);
-  }
   void addPkt(const TxPacket* pkt) {
     queue_.addPkt(pkt);
   }
-  void addPktLocked(const TxPacket* pkt) {
-    queue_.addPktLocked(pkt);
-  }
   void finish();
 
   /*
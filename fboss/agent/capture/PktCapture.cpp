@@ -11,12 +11,19 @@
 
 #include <folly/Conv.h>
 
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/TxPacket.h"
+
 using folly::StringPiece;
 
 namespace facebook { namespace fboss {
 
-PktCapture::PktCapture(folly::StringPiece name, uint64_t maxPackets)
+PktCapture::PktCapture(folly::StringPiece name, uint64_t maxPackets,
+                       folly::StringPiece filter, uint32_t snaplen)
   : name_(name.str()),
+    filter_(filter.empty() ? nullptr :
+            std::make_unique<PktCaptureFilter>(filter)),
+    writer_(0, snaplen),
     maxPackets_(maxPackets) {
 }
 
@@ -29,17 +36,26 @@ void PktCapture::stop() {
 }
 
 bool PktCapture::packetReceived(const RxPacket* pkt) {
-  std::lock_guard<std::mutex> guard(writer_.mutex());
-  ++numPacketsReceived_;
-  writer_.addPktLocked(pkt);
-  return numPacketsReceived_ < maxPackets_;
+  // Check the filter first, so packets we don't want cost next to nothing
+  if (filter_ && !filter_->matches(pkt->buf())) {
+    return true;
+  }
+  auto count = numPacketsReceived_.fetch_add(1, std::memory_order_relaxed);
+  if (count < maxPackets_) {
+    writer_.addPkt(pkt);
+  }
+  return count + 1 < maxPackets_;
 }
 
 bool PktCapture::packetSent(const TxPacket* pkt) {
-  std::lock_guard<std::mutex> guard(writer_.mutex());
-  ++numPacketsReceived_;
-  writer_.addPktLocked(pkt);
-  return numPacketsReceived_ < maxPackets_;
+  if (filter_ && !filter_->matches(pkt->buf())) {
+    return true;
+  }
+  auto count = numPacketsReceived_.fetch_add(1, std::memory_order_relaxed);
+  if (count < maxPackets_) {
+    writer_.addPkt(pkt);
+  }
+  return count + 1 < maxPackets_;
 }
 
 }} // facebook::fboss
@@ -10,8 +10,11 @@
 #pragma once
 
 #include "fboss/agent/capture/PcapWriter.h"
+#include "fboss/agent/capture/PktCaptureFilter.h"
 
 #include <folly/Range.h>
+#include <atomic>
+#include <memory>
 #include <string>
 
 namespace facebook { namespace fboss {
@@ -24,7 +27,13 @@ class TxPacket;
  */
 class PktCapture {
  public:
-  PktCapture(folly::StringPiece name, uint64_t maxPackets);
+  /*
+   * Only packets matching 'filter' (see PktCaptureFilter) are captured, or
+   * all of them if it is empty.  If snaplen is non-zero only the first
+   * snaplen bytes of each packet are kept.
+   */
+  PktCapture(folly::StringPiece name, uint64_t maxPackets,
+             folly::StringPiece filter = "", uint32_t snaplen = 0);
 
   const std::string& name() const {
     return name_;
@@ -33,6 +42,13 @@ class PktCapture {
   void start(folly::StringPiece path);
   void stop();
 
+  /*
+   * Capture a packet.  These may be called from several threads at once.
+   *
+   * Returns false once the capture has seen maxPackets packets, and should
+   * be stopped.  Packets from other threads racing with the last one are
+   * not captured.
+   */
   bool packetReceived(const RxPacket* pkt);
   bool packetSent(const TxPacket* pkt);
 
@@ -43,11 +59,11 @@ class PktCapture {
 
   const std::string name_;
 
-  // Note: the rest of the state in this class is protcted by
-  // the PcapWriter's mutex.
+  // nullptr if every packet is captured
+  const std::unique_ptr<PktCaptureFilter> filter_;
   PcapWriter writer_;
-  uint64_t maxPackets_{0};
-  uint64_t numPacketsReceived_{0};
+  const uint64_t maxPackets_{0};
+  std::atomic<uint64_t> numPacketsReceived_{0};
 };
 
 }} // facebook::fboss
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PktCaptureFilter.h"
+
+#include <mutex>
+
+#include <folly/ScopeGuard.h>
+#include <folly/io/IOBuf.h>
+
+#include "fboss/agent/FbossError.h"
+
+namespace {
+// The snaplen the filter is compiled for, which just has to cover any
+// packet we can see
+constexpr int kMaxSnaplen = 65535;
+
+// pcap_compile() isn't thread safe in all versions of libpcap
+std::mutex compileMutex;
+}
+
+namespace facebook { namespace fboss {
+
+PktCaptureFilter::PktCaptureFilter(folly::StringPiece expression)
+  : expression_(expression.str()) {
+  std::lock_guard<std::mutex> guard(compileMutex);
+  auto pcap = pcap_open_dead(DLT_EN10MB, kMaxSnaplen);
+  if (!pcap) {
+    throw FbossError("unable to compile capture filter \"", expression_, "\"");
+  }
+  SCOPE_EXIT {
+    pcap_close(pcap);
+  };
+  auto ret = pcap_compile(pcap, &program_, expression_.c_str(), 1,
+                          PCAP_NETMASK_UNKNOWN);
+  if (ret != 0) {
+    throw FbossError("invalid capture filter \"", expression_, "\": ",
+                     pcap_geterr(pcap));
+  }
+}
+
+PktCaptureFilter::~PktCaptureFilter() {
+  pcap_freecode(&program_);
+}
+
+bool PktCaptureFilter::matches(const folly::IOBuf* buf) const {
+  // The program can only look at the first buffer in the chain, and treats
+  // anything past it as missing.  Packets are received into a single
+  // buffer, so in practice this is the whole packet.
+  return bpf_filter(program_.bf_insns, buf->data(),
+                    buf->computeChainDataLength(), buf->length()) != 0;
+}
+
+}} // facebook::fboss
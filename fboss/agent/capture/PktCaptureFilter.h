@@ -0,0 +1,57 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <pcap/pcap.h>
+
+#include <folly/Range.h>
+#include <string>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook { namespace fboss {
+
+/*
+ * A packet filter for a PktCapture, in the pcap-filter(7) syntax that
+ * tcpdump uses.
+ *
+ * The expression is compiled once, by libpcap, to a classic BPF program,
+ * which is then run against each packet without any copying or locking.
+ * The program sees the frame the way it is captured, so filters for
+ * tagged traffic need a "vlan" qualifier (e.g. "vlan and arp").
+ */
+class PktCaptureFilter {
+ public:
+  // Throws FbossError if the expression can't be compiled
+  explicit PktCaptureFilter(folly::StringPiece expression);
+  ~PktCaptureFilter();
+
+  const std::string& expression() const {
+    return expression_;
+  }
+
+  /*
+   * Whether the packet matches the filter.  This may be called from
+   * several threads at once.
+   */
+  bool matches(const folly::IOBuf* buf) const;
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PktCaptureFilter(PktCaptureFilter const &) = delete;
+  PktCaptureFilter& operator=(PktCaptureFilter const &) = delete;
+
+  const std::string expression_;
+  struct bpf_program program_;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/capture/PcapQueue.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+
+#include <folly/Benchmark.h>
+
+#include <thread>
+
+using namespace facebook::fboss;
+
+namespace {
+
+/*
+ * Each benchmark adds packets to a PcapQueue from several producer threads,
+ * the way the RX threads do while a capture is running, with a reader
+ * thread taking them off the queue as fast as it can (without writing them
+ * anywhere).  The time reported is per packet added, in total over all the
+ * producers, whether the packet was queued or dropped.
+ */
+constexpr uint32_t kQueueDepth = 10240;
+
+std::unique_ptr<MockRxPacket> makePkt(PortID port) {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // Ethertype (IPv4), no payload
+    "08 00"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(port);
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+void addPkts(unsigned numIters, unsigned numProducers) {
+  folly::BenchmarkSuspender braces;
+  PcapQueue queue(kQueueDepth);
+  uint64_t numRead = 0;
+  std::thread reader([&]() {
+    std::vector<PcapPkt> pkts;
+    while (queue.wait(&pkts)) {
+      numRead += pkts.size();
+    }
+  });
+
+  // Every producer has its own packet, as they would in real life
+  std::vector<std::unique_ptr<MockRxPacket>> pkts;
+  for (unsigned i = 0; i < numProducers; ++i) {
+    pkts.push_back(makePkt(PortID(i + 1)));
+  }
+
+  braces.dismiss();
+  std::vector<std::thread> producers;
+  for (unsigned i = 0; i < numProducers; ++i) {
+    auto pkt = pkts[i].get();
+    auto count = numIters / numProducers +
+      (i < numIters % numProducers ? 1 : 0);
+    producers.emplace_back([&queue, pkt, count]() {
+      for (unsigned n = 0; n < count; ++n) {
+        queue.addPkt(pkt);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  braces.rehire();
+
+  queue.finish();
+  reader.join();
+  CHECK_EQ(numIters, numRead + queue.numDropped());
+}
+
+} // unnamed namespace
+
+void AddPkts(unsigned numIters, unsigned numProducers) {
+  addPkts(numIters, numProducers);
+}
+
+BENCHMARK_PARAM(AddPkts, 1)
+BENCHMARK_PARAM(AddPkts, 4)
+BENCHMARK_PARAM(AddPkts, 8)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
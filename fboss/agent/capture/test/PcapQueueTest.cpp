@@ -11,6 +11,8 @@
 #include "fboss/agent/capture/PcapQueue.h"
 #include "fboss/agent/hw/mock/MockRxPacket.h"
 
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <gtest/gtest.h>
 
@@ -72,3 +74,143 @@ TEST(PcapQueueTest, SimpleAdd) {
   ByteRange waitedPktData = waitedPktBufClone->coalesce();
   EXPECT_EQ(expectedPktData, waitedPktData);
 }
+
+namespace {
+std::unique_ptr<MockRxPacket> makePkt(PortID port) {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // Ethertype (IPv4), no payload
+    "08 00"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(port);
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+} // unnamed namespace
+
+TEST(PcapQueueTest, DropWhenFull) {
+  PcapQueue queue(4);
+  auto pkt = makePkt(PortID(1));
+  for (int n = 0; n < 10; ++n) {
+    queue.addPkt(pkt.get());
+  }
+  EXPECT_EQ(6, queue.numDropped());
+
+  // Once read, the slots can be used again
+  std::vector<PcapPkt> pkts;
+  ASSERT_TRUE(queue.wait(&pkts));
+  EXPECT_EQ(4, pkts.size());
+  for (int n = 0; n < 3; ++n) {
+    queue.addPkt(pkt.get());
+  }
+  EXPECT_EQ(6, queue.numDropped());
+  ASSERT_TRUE(queue.wait(&pkts));
+  EXPECT_EQ(3, pkts.size());
+
+  queue.finish();
+  EXPECT_FALSE(queue.wait(&pkts));
+  EXPECT_TRUE(pkts.empty());
+}
+
+TEST(PcapQueueTest, DropOverByteCapacity) {
+  // Room for two 68 byte packets
+  PcapQueue queue(100, 68 * 3);
+  auto pkt = makePkt(PortID(1));
+  for (int n = 0; n < 4; ++n) {
+    queue.addPkt(pkt.get());
+  }
+  EXPECT_EQ(2, queue.numDropped());
+
+  std::vector<PcapPkt> pkts;
+  ASSERT_TRUE(queue.wait(&pkts));
+  EXPECT_EQ(2, pkts.size());
+  queue.addPkt(pkt.get());
+  EXPECT_EQ(2, queue.numDropped());
+}
+
+TEST(PcapQueueTest, MultipleProducers) {
+  constexpr int kNumProducers = 8;
+  constexpr int kPktsPerProducer = 10000;
+  PcapQueue queue(256);
+  std::vector<PcapPkt> waitedPkts;
+  std::thread waiter([&]() { pktWaitThread(&queue, &waitedPkts); });
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.emplace_back([&queue, i]() {
+      auto pkt = makePkt(PortID(i + 1));
+      for (int n = 0; n < kPktsPerProducer; ++n) {
+        queue.addPkt(pkt.get());
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  queue.finish();
+  waiter.join();
+
+  // Every packet was either received or counted as dropped
+  EXPECT_EQ(kNumProducers * kPktsPerProducer,
+            waitedPkts.size() + queue.numDropped());
+}
+
+// The reader has to see every packet without waiting for finish(), even when
+// producers fill their slots out of order and one of the later packets is
+// the one that wakes it up.
+TEST(PcapQueueTest, MultipleProducersOutOfOrder) {
+  constexpr int kNumProducers = 4;
+  constexpr int kNumRounds = 2000;
+  PcapQueue queue(kNumProducers * 2);
+  std::atomic<uint64_t> numRead{0};
+  std::thread waiter([&]() {
+    std::vector<PcapPkt> pkts;
+    while (queue.wait(&pkts)) {
+      numRead += pkts.size();
+    }
+  });
+
+  std::vector<std::unique_ptr<MockRxPacket>> pkts;
+  for (int i = 0; i < kNumProducers; ++i) {
+    pkts.push_back(makePkt(PortID(i + 1)));
+  }
+  uint64_t numAdded = 0;
+  for (int round = 0; round < kNumRounds; ++round) {
+    // Each producer adds one packet at about the same time, so the slots
+    // they claim get filled in whatever order the threads run in
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kNumProducers; ++i) {
+      auto pkt = pkts[i].get();
+      producers.emplace_back([&queue, &go, pkt]() {
+        while (!go.load()) {
+          std::this_thread::yield();
+        }
+        queue.addPkt(pkt);
+      });
+    }
+    go = true;
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    numAdded += kNumProducers;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (numRead.load() + queue.numDropped() < numAdded &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(numAdded, numRead.load() + queue.numDropped())
+      << "reader missed a wakeup in round " << round;
+    if (numRead.load() + queue.numDropped() != numAdded) {
+      break;
+    }
+  }
+
+  queue.finish();
+  waiter.join();
+}
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PktCaptureFilter.h"
+#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::ByteRange;
+
+namespace {
+std::unique_ptr<MockRxPacket> makeArpPkt() {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 01 02 03 04 05  02 05 00 00 01 02"
+    // 802.1q, VLAN 1
+    "81 00  00 01"
+    // ARP, htype: ethernet, ptype: IPv4, hlen: 6, plen: 4
+    "08 06  00 01  08 00  06  04"
+    // ARP Reply
+    "00 02"
+    // Sender MAC
+    "02 05 00 00 01 02"
+    // Sender IP: 10.0.0.10
+    "0a 00 00 0a"
+    // Target MAC
+    "02 01 02 03 04 05"
+    // Target IP: 10.0.0.1
+    "0a 00 00 01"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(1));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+} // unnamed namespace
+
+TEST(PktCaptureFilterTest, Match) {
+  auto pkt = makeArpPkt();
+
+  EXPECT_TRUE(PktCaptureFilter("vlan and arp").matches(pkt->buf()));
+  EXPECT_TRUE(PktCaptureFilter("vlan 1 and arp host 10.0.0.10")
+              .matches(pkt->buf()));
+  EXPECT_FALSE(PktCaptureFilter("vlan and ip").matches(pkt->buf()));
+  EXPECT_FALSE(PktCaptureFilter("vlan 2").matches(pkt->buf()));
+  // Without the vlan qualifier the filter looks at the 802.1q ethertype
+  EXPECT_FALSE(PktCaptureFilter("arp").matches(pkt->buf()));
+}
+
+TEST(PktCaptureFilterTest, BadExpression) {
+  EXPECT_THROW(PktCaptureFilter("not a filter"), FbossError);
+}
+
+TEST(PktCaptureFilterTest, Snaplen) {
+  auto pkt = makeArpPkt();
+
+  PcapPkt full(pkt.get(), PcapPkt::TimePoint(), 0);
+  EXPECT_EQ(68, full.origLength());
+  EXPECT_EQ(68, full.buf()->computeChainDataLength());
+
+  PcapPkt truncated(pkt.get(), PcapPkt::TimePoint(), 18);
+  EXPECT_EQ(68, truncated.origLength());
+  ASSERT_EQ(18, truncated.buf()->computeChainDataLength());
+  auto expected = pkt->buf()->clone();
+  expected->trimEnd(68 - 18);
+  EXPECT_EQ(expected->coalesce(), truncated.buf()->clone()->coalesce());
+
+  // A snaplen longer than the packet keeps all of it
+  PcapPkt longer(pkt.get(), PcapPkt::TimePoint(), 1500);
+  EXPECT_EQ(68, longer.buf()->computeChainDataLength());
+}
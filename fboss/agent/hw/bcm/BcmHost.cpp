@@ -45,8 +45,8 @@ using std::shared_ptr;
 using folly::MacAddress;
 using folly::IPAddress;
 
-BcmHost::BcmHost(const BcmSwitch* hw, opennsl_vrf_t vrf, const IPAddress& addr,
-    opennsl_if_t referenced_egress)
+BcmHost::BcmHost(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
+    const IPAddress& addr, opennsl_if_t referenced_egress)
       : hw_(hw), vrf_(vrf), addr_(addr),
       egressId_(referenced_egress) {
   hw_->writableHostTable()->incEgressReference(egressId_);
@@ -170,7 +170,7 @@ BcmHost::~BcmHost() {
   hw_->writableHostTable()->derefEgress(egressId_);
 }
 
-BcmEcmpHost::BcmEcmpHost(const BcmSwitch *hw, opennsl_vrf_t vrf,
+BcmEcmpHost::BcmEcmpHost(const BcmSwitchIf *hw, opennsl_vrf_t vrf,
                          const RouteForwardNexthops& fwd)
     : hw_(hw), vrf_(vrf) {
   CHECK_GT(fwd.size(), 0);
@@ -224,7 +224,7 @@ BcmEcmpHost::~BcmEcmpHost() {
   }
 }
 
-BcmHostTable::BcmHostTable(const BcmSwitch *hw) : hw_(hw) {
+BcmHostTable::BcmHostTable(const BcmSwitchIf *hw) : hw_(hw) {
   auto port2EgressIds = std::make_shared<PortAndEgressIdsMap>();
   port2EgressIds->publish();
   setPort2EgressIdsInternal(port2EgressIds);
@@ -235,12 +235,14 @@ BcmHostTable::~BcmHostTable() {
 
 template<typename KeyT, typename HostT, typename... Args>
 HostT* BcmHostTable::incRefOrCreateBcmHost(
-    HostMap<KeyT, HostT>* map, const KeyT& key, Args... args) {
-  auto ret = map->emplace(key, std::make_pair(nullptr, 1));
+    HostMap<KeyT, HostT>* map, const KeyT& key, uint32_t count,
+    Args... args) {
+  CHECK_GT(count, 0);
+  auto ret = map->emplace(key, std::make_pair(nullptr, count));
   auto& iter = ret.first;
   if (!ret.second) {
     // there was an entry already there
-    iter->second.second++;  // increase the reference counter
+    iter->second.second += count;  // increase the reference counter
     return iter->second.first.get();
   }
   SCOPE_FAIL {
@@ -254,17 +256,18 @@ HostT* BcmHostTable::incRefOrCreateBcmHost(
 
 BcmHost* BcmHostTable::incRefOrCreateBcmHost(
     opennsl_vrf_t vrf, const IPAddress& addr) {
-  return incRefOrCreateBcmHost(&hosts_, std::make_pair(vrf, addr));
+  return incRefOrCreateBcmHost(&hosts_, std::make_pair(vrf, addr), 1);
 }
 
 BcmHost* BcmHostTable::incRefOrCreateBcmHost(
     opennsl_vrf_t vrf, const IPAddress& addr, opennsl_if_t egressId) {
-  return incRefOrCreateBcmHost(&hosts_, std::make_pair(vrf, addr), egressId);
+  return incRefOrCreateBcmHost(&hosts_, std::make_pair(vrf, addr), 1,
+                               egressId);
 }
 
 BcmEcmpHost* BcmHostTable::incRefOrCreateBcmEcmpHost(
-    opennsl_vrf_t vrf, const RouteForwardNexthops& fwd) {
-  return incRefOrCreateBcmHost(&ecmpHosts_, std::make_pair(vrf, fwd));
+    opennsl_vrf_t vrf, const RouteForwardNexthops& fwd, uint32_t count) {
+  return incRefOrCreateBcmHost(&ecmpHosts_, std::make_pair(vrf, fwd), count);
 }
 
 template<typename KeyT, typename HostT, typename... Args>
@@ -308,6 +311,7 @@ BcmEcmpHost* BcmHostTable::getBcmEcmpHost(
 
 template<typename KeyT, typename HostT, typename... Args>
 HostT* BcmHostTable::derefBcmHost(HostMap<KeyT, HostT>* map,
+                                  uint32_t count,
                                   Args... args) noexcept {
   KeyT key{args...};
   auto iter = map->find(key);
@@ -315,8 +319,9 @@ HostT* BcmHostTable::derefBcmHost(HostMap<KeyT, HostT>* map,
     return nullptr;
   }
   auto& entry = iter->second;
-  CHECK_GT(entry.second, 0);
-  if (--entry.second == 0) {
+  CHECK_GE(entry.second, count);
+  entry.second -= count;
+  if (entry.second == 0) {
     map->erase(iter);
     return nullptr;
   }
@@ -325,12 +330,13 @@ HostT* BcmHostTable::derefBcmHost(HostMap<KeyT, HostT>* map,
 
 BcmHost* BcmHostTable::derefBcmHost(
     opennsl_vrf_t vrf, const IPAddress& addr) noexcept {
-  return derefBcmHost(&hosts_, vrf, addr);
+  return derefBcmHost(&hosts_, 1, vrf, addr);
 }
 
 BcmEcmpHost* BcmHostTable::derefBcmEcmpHost(
-    opennsl_vrf_t vrf, const RouteForwardNexthops& fwd) noexcept {
-  return derefBcmHost(&ecmpHosts_, vrf, fwd);
+    opennsl_vrf_t vrf, const RouteForwardNexthops& fwd,
+    uint32_t count) noexcept {
+  return derefBcmHost(&ecmpHosts_, count, vrf, fwd);
 }
 
 BcmEgressBase* BcmHostTable::incEgressReference(opennsl_if_t egressId) {
@@ -356,6 +362,8 @@ BcmEgressBase* BcmHostTable::derefEgress(opennsl_if_t egressId) {
     if (it->second.first->isEcmp()) {
       CHECK(numEcmpEgressProgrammed_ > 0);
       numEcmpEgressProgrammed_--;
+      unindexEcmpEgress(
+          static_cast<const BcmEcmpEgress*>(it->second.first.get()));
     }
     egressMap_.erase(egressId);
     return nullptr;
@@ -460,11 +468,38 @@ void BcmHostTable::insertBcmEgress(
   auto id = egress->getID();
   if (egress->isEcmp()) {
     numEcmpEgressProgrammed_++;
+    indexEcmpEgress(static_cast<const BcmEcmpEgress*>(egress.get()));
   }
   auto ret = egressMap_.emplace(id, std::make_pair(std::move(egress), 1));
   CHECK(ret.second);
 }
 
+void BcmHostTable::indexEcmpEgress(const BcmEcmpEgress* ecmp) {
+  std::lock_guard<std::mutex> g(egressId2EcmpIdsLock_);
+  for (auto path : ecmp->paths()) {
+    egressId2EcmpIds_[path].insert(ecmp->getID());
+  }
+}
+
+void BcmHostTable::unindexEcmpEgress(const BcmEcmpEgress* ecmp) {
+  std::lock_guard<std::mutex> g(egressId2EcmpIdsLock_);
+  for (auto path : ecmp->paths()) {
+    auto it = egressId2EcmpIds_.find(path);
+    CHECK(it != egressId2EcmpIds_.end());
+    it->second.erase(ecmp->getID());
+    if (it->second.empty()) {
+      egressId2EcmpIds_.erase(it);
+    }
+  }
+}
+
+BcmHostTable::Paths BcmHostTable::getEcmpEgressIdsForPath(
+    opennsl_if_t egressId) const {
+  std::lock_guard<std::mutex> g(egressId2EcmpIdsLock_);
+  auto it = egressId2EcmpIds_.find(egressId);
+  return it == egressId2EcmpIds_.end() ? Paths() : it->second;
+}
+
 void BcmHostTable::warmBootHostEntriesSynced() {
   opennsl_port_config_t pcfg;
   auto rv = opennsl_port_config_get(hw_->getUnit(), &pcfg);
@@ -571,26 +606,47 @@ void BcmHostTable::egressResolutionChangedHwNotLocked(
     const Paths& affectedPaths,
     bool up) {
   CHECK(!up);
-  Paths tmpPaths(affectedPaths);
-  opennsl_l3_egress_ecmp_traverse(
-      unit, removeAllEgressesFromEcmpCallback, &tmpPaths);
+  if (warmBootEcmpEgressPending_) {
+    // Some of the ECMP egress objects in HW aren't indexed yet
+    Paths tmpPaths(affectedPaths);
+    opennsl_l3_egress_ecmp_traverse(
+        unit, removeAllEgressesFromEcmpCallback, &tmpPaths);
+    return;
+  }
+  // Copy out what we need, so that the lock isn't held across SDK calls
+  std::vector<std::pair<opennsl_if_t, opennsl_if_t>> ecmpAndPaths;
+  {
+    std::lock_guard<std::mutex> g(egressId2EcmpIdsLock_);
+    for (auto path : affectedPaths) {
+      auto it = egressId2EcmpIds_.find(path);
+      if (it == egressId2EcmpIds_.end()) {
+        continue;
+      }
+      for (auto ecmpId : it->second) {
+        ecmpAndPaths.emplace_back(ecmpId, path);
+      }
+    }
+  }
+  for (const auto& ecmpAndPath : ecmpAndPaths) {
+    BcmEcmpEgress::removeEgressIdHwNotLocked(
+        unit, ecmpAndPath.first, ecmpAndPath.second);
+  }
 }
 
 void BcmHostTable::egressResolutionChangedHwLocked(
     const Paths& affectedPaths,
     bool up) {
-  for (const auto& nextHopsAndEcmpHostInfo : ecmpHosts_) {
-    auto ecmpId = nextHopsAndEcmpHostInfo.second.first->getEcmpEgressId();
-    if (ecmpId == BcmEgressBase::INVALID) {
-      continue;
-    }
-    auto ecmpEgress = static_cast<BcmEcmpEgress*>(getEgressObjectIf(ecmpId));
-    // Must find the egress object, we could have done a slower
-    // dynamic cast check to ensure that this is the right type
-    // our map should be pointing to valid Ecmp egress object for
-    // a ecmp egress Id anyways
-    CHECK(ecmpEgress);
-    for (auto path : affectedPaths) {
+  // We hold the HW lock, so the index can't change under us, but the
+  // linkscan thread may be reading it.
+  for (auto path : affectedPaths) {
+    for (auto ecmpId : getEcmpEgressIdsForPath(path)) {
+      auto ecmpEgress =
+        static_cast<BcmEcmpEgress*>(getEgressObjectIf(ecmpId));
+      // Must find the egress object, we could have done a slower
+      // dynamic cast check to ensure that this is the right type
+      // our map should be pointing to valid Ecmp egress object for
+      // a ecmp egress Id anyways
+      CHECK(ecmpEgress);
       if (up) {
         ecmpEgress->pathReachableHwLocked(path);
       } else {
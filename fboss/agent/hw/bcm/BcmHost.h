@@ -27,17 +27,20 @@ extern "C" {
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <atomic>
+#include <mutex>
+
 namespace facebook { namespace fboss {
 
 class BcmEcmpEgress;
 class BcmEgress;
-class BcmSwitch;
+class BcmSwitchIf;
 class BcmHostTable;
 
 class BcmHost {
  public:
   BcmHost(
-      const BcmSwitch* hw, opennsl_vrf_t vrf, const folly::IPAddress& addr,
+      const BcmSwitchIf* hw, opennsl_vrf_t vrf, const folly::IPAddress& addr,
       opennsl_if_t referenced_egress = BcmEgressBase::INVALID);
   virtual ~BcmHost();
   bool isProgrammed() const {
@@ -77,7 +80,7 @@ class BcmHost {
   void program(opennsl_if_t intf, const folly::MacAddress *mac,
                opennsl_port_t port, RouteForwardAction action);
   void initHostCommon(opennsl_l3_host_t *host) const;
-  const BcmSwitch* hw_;
+  const BcmSwitchIf* hw_;
   opennsl_vrf_t vrf_;
   folly::IPAddress addr_;
   // Port that the corresponding egress object references.
@@ -102,7 +105,7 @@ class BcmHost {
  */
 class BcmEcmpHost {
  public:
-  BcmEcmpHost(const BcmSwitch* hw, opennsl_vrf_t vrf,
+  BcmEcmpHost(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
               const RouteForwardNexthops& fwd);
   virtual ~BcmEcmpHost();
   opennsl_if_t getEgressId() const {
@@ -113,7 +116,7 @@ class BcmEcmpHost {
   }
   folly::dynamic toFollyDynamic() const;
  private:
-  const BcmSwitch* hw_;
+  const BcmSwitchIf* hw_;
   opennsl_vrf_t vrf_;
   /**
    * The egress ID for this ECMP host
@@ -132,7 +135,7 @@ class BcmEcmpHost {
 
 class BcmHostTable {
  public:
-  explicit BcmHostTable(const BcmSwitch *hw);
+  explicit BcmHostTable(const BcmSwitchIf *hw);
   virtual ~BcmHostTable();
   // throw an exception if not found
   BcmHost* getBcmHost(opennsl_vrf_t vrf, const folly::IPAddress& addr) const;
@@ -163,8 +166,12 @@ class BcmHostTable {
       opennsl_vrf_t vrf, const folly::IPAddress& addr);
   BcmHost* incRefOrCreateBcmHost(
       opennsl_vrf_t vrf, const folly::IPAddress& addr, opennsl_if_t egressId);
+  /*
+   * The ECMP variants can take (or release) several references at once, for
+   * a batch of routes using the same nexthops.
+   */
   BcmEcmpHost* incRefOrCreateBcmEcmpHost(
-      opennsl_vrf_t vrf, const RouteForwardNexthops& fwd);
+      opennsl_vrf_t vrf, const RouteForwardNexthops& fwd, uint32_t count = 1);
 
   /**
    * Decrease an existing BcmHost/BcmEcmpHost entry's reference counter by 1.
@@ -179,7 +186,8 @@ class BcmHostTable {
   BcmHost* derefBcmHost(
       opennsl_vrf_t vrf, const folly::IPAddress& addr) noexcept;
   BcmEcmpHost* derefBcmEcmpHost(opennsl_vrf_t vrf,
-                                const RouteForwardNexthops& fwd) noexcept;
+                                const RouteForwardNexthops& fwd,
+                                uint32_t count = 1) noexcept;
   /*
    * APIs to manage egress objects. Multiple host entries can point
    * to a egress object. Lifetime of these egress objects is thus
@@ -254,6 +262,19 @@ class BcmHostTable {
   uint32_t numEcmpEgress() const {
     return numEcmpEgressProgrammed_;
   }
+  /*
+   * The ECMP egress objects that have egressId as one of their paths.
+   */
+  Paths getEcmpEgressIdsForPath(opennsl_if_t egressId) const;
+  /*
+   * Set while there may be ECMP egress objects in HW that this table doesn't
+   * know about yet, which is the case after a warm boot until the warm boot
+   * cache is cleared.  Until then, link down handling has to look through
+   * every ECMP egress object in HW.
+   */
+  void setWarmBootEcmpEgressPending(bool pending) {
+    warmBootEcmpEgressPending_ = pending;
+  }
  private:
   /*
    * Called both while holding and not holding the hw lock.
@@ -261,7 +282,7 @@ class BcmHostTable {
   void linkStateChangedMaybeLocked(opennsl_port_t port, bool up,
       bool locked);
   void egressResolutionChangedHwLocked(const Paths& affectedPaths, bool up);
-  static void egressResolutionChangedHwNotLocked(
+  void egressResolutionChangedHwNotLocked(
       int unit,
       const Paths& affectedPaths,
       bool up);
@@ -273,6 +294,12 @@ class BcmHostTable {
       opennsl_if_t* intfArray,
       void* userData);
   void setPort2EgressIdsInternal(std::shared_ptr<PortAndEgressIdsMap> newMap);
+  /*
+   * Add or remove an ECMP egress object's paths to or from
+   * egressId2EcmpIds_.
+   */
+  void indexEcmpEgress(const BcmEcmpEgress* ecmp);
+  void unindexEcmpEgress(const BcmEcmpEgress* ecmp);
 
   template <typename KeyT, typename HostT>
   using HostMap = boost::container::
@@ -282,13 +309,15 @@ class BcmHostTable {
   HostT* incRefOrCreateBcmHost(
       HostMap<KeyT, HostT>* map,
       const KeyT& key,
+      uint32_t count,
       Args... args);
   template <typename KeyT, typename HostT, typename... Args>
   HostT* getBcmHostIf(const HostMap<KeyT, HostT>* map, Args... args) const;
   template <typename KeyT, typename HostT, typename... Args>
-  HostT* derefBcmHost(HostMap<KeyT, HostT>* map, Args... args) noexcept;
+  HostT* derefBcmHost(HostMap<KeyT, HostT>* map, uint32_t count,
+                      Args... args) noexcept;
 
-  const BcmSwitch* hw_{nullptr};
+  const BcmSwitchIf* hw_{nullptr};
 
   /*
    * The current port -> egressIds map.
@@ -308,6 +337,17 @@ class BcmHostTable {
   boost::container::flat_map<opennsl_if_t, opennsl_port_t> egressId2Port_;
   uint32_t numEcmpEgressProgrammed_{0};
 
+  /*
+   * egressId -> the ECMP egress objects that have it as a path, so that a
+   * port going down only touches the ECMP groups it affects.  This is
+   * updated under the HW lock as ECMP egress objects come and go, but read
+   * from the linkscan callback, which doesn't hold that lock.  So it has a
+   * lock of its own, which is never held across SDK calls.
+   */
+  boost::container::flat_map<opennsl_if_t, Paths> egressId2EcmpIds_;
+  mutable std::mutex egressId2EcmpIdsLock_;
+  std::atomic<bool> warmBootEcmpEgressPending_{false};
+
   boost::container::flat_map<
       opennsl_if_t,
       std::pair<std::unique_ptr<BcmEgressBase>, uint32_t>>
@@ -61,6 +61,58 @@ const string kOutPause = "out_pause_frames";
 
 namespace facebook { namespace fboss {
 
+namespace {
+
+/*
+ * The counters read off every port in updateStats(), and where their values
+ * go in HwPortStats.
+ */
+struct PortStat {
+  const string& name;
+  opennsl_stat_val_t type;
+  int64_t HwPortStats::* field;
+};
+
+const PortStat kPortStats[] = {
+  {kInBytes, opennsl_spl_snmpIfHCInOctets, &HwPortStats::inBytes_},
+  {kInUnicastPkts, opennsl_spl_snmpIfHCInUcastPkts,
+   &HwPortStats::inUnicastPkts_},
+  {kInMulticastPkts, opennsl_spl_snmpIfHCInMulticastPkts,
+   &HwPortStats::inMulticastPkts_},
+  {kInBroadcastPkts, opennsl_spl_snmpIfHCInBroadcastPkts,
+   &HwPortStats::inBroadcastPkts_},
+  {kInDiscards, opennsl_spl_snmpIfInDiscards, &HwPortStats::inDiscards_},
+  {kInErrors, opennsl_spl_snmpIfInErrors, &HwPortStats::inErrors_},
+  {kInIpv4HdrErrors, opennsl_spl_snmpIpInHdrErrors,
+   &HwPortStats::inIpv4HdrErrors_},
+  {kInIpv6HdrErrors, opennsl_spl_snmpIpv6IfStatsInHdrErrors,
+   &HwPortStats::inIpv6HdrErrors_},
+  {kInPause, opennsl_spl_snmpDot3InPauseFrames, &HwPortStats::inPause_},
+  // Egress Stats
+  {kOutBytes, opennsl_spl_snmpIfHCOutOctets, &HwPortStats::outBytes_},
+  {kOutUnicastPkts, opennsl_spl_snmpIfHCOutUcastPkts,
+   &HwPortStats::outUnicastPkts_},
+  {kOutMulticastPkts, opennsl_spl_snmpIfHCOutMulticastPkts,
+   &HwPortStats::outMulticastPkts_},
+  {kOutBroadcastPkts, opennsl_spl_snmpIfHCOutBroadcastPckts,
+   &HwPortStats::outBroadcastPkts_},
+  {kOutDiscards, opennsl_spl_snmpIfOutDiscards, &HwPortStats::outDiscards_},
+  {kOutErrors, opennsl_spl_snmpIfOutErrors, &HwPortStats::outErrors_},
+  {kOutPause, opennsl_spl_snmpDot3OutPauseFrames, &HwPortStats::outPause_},
+};
+constexpr size_t kNumPortStats = sizeof(kPortStats) / sizeof(kPortStats[0]);
+
+// The stat types of kPortStats, as opennsl_stat_multi_get() takes them
+std::vector<opennsl_stat_val_t> getPortStatTypes() {
+  std::vector<opennsl_stat_val_t> types;
+  for (const auto& stat : kPortStats) {
+    types.push_back(stat.type);
+  }
+  return types;
+}
+
+}
+
 static const std::vector<opennsl_stat_val_t> kInPktLengthStats = {
   snmpOpenNSLReceivedPkts64Octets,
   snmpOpenNSLReceivedPkts65to127Octets,
@@ -187,6 +239,19 @@ void BcmPort::reinitPortStats() {
   reinitPortStat(kOutPause);
   reinitPortStat(kOutCongestionDiscards);
 
+  // The counters don't move in portCounters_, so updateStats() can keep
+  // pointers to them rather than look them up by name every time.
+  portStatCounters_.clear();
+  for (const auto& stat : kPortStats) {
+    portStatCounters_.push_back(getPortCounterIf(stat.name));
+  }
+
+  // Start the counters over along with the exported stats
+  std::lock_guard<folly::SpinLock> g(portCountersLock_);
+  prevPortStats_ = HwPortStats();
+  inCounters_ = PortCounters();
+  outCounters_ = PortCounters();
+
   // (re) init out queue length
   auto statMap = fbData->getStatMap();
   const auto expType = stats::AVG;
@@ -201,7 +266,7 @@ void BcmPort::reinitPortStats() {
       statName("out_pkt_lengths"), &pktLenHist);
 }
 
-BcmPort::BcmPort(BcmSwitch* hw, opennsl_port_t port,
+BcmPort::BcmPort(BcmSwitchIf* hw, opennsl_port_t port,
                  BcmPlatformPort* platformPort)
     : hw_(hw),
       port_(port),
@@ -531,75 +596,7 @@ void BcmPort::updateStats() {
   }
   auto now = duration_cast<seconds>(system_clock::now().time_since_epoch());
   HwPortStats curPortStats;
-  updateStat(
-      now, kInBytes, opennsl_spl_snmpIfHCInOctets, &curPortStats.inBytes_);
-  updateStat(
-      now,
-      kInUnicastPkts,
-      opennsl_spl_snmpIfHCInUcastPkts,
-      &curPortStats.inUnicastPkts_);
-  updateStat(
-      now,
-      kInMulticastPkts,
-      opennsl_spl_snmpIfHCInMulticastPkts,
-      &curPortStats.inMulticastPkts_);
-  updateStat(
-      now,
-      kInBroadcastPkts,
-      opennsl_spl_snmpIfHCInBroadcastPkts,
-      &curPortStats.inBroadcastPkts_);
-  updateStat(
-      now,
-      kInDiscards,
-      opennsl_spl_snmpIfInDiscards,
-      &curPortStats.inDiscards_);
-  updateStat(
-      now, kInErrors, opennsl_spl_snmpIfInErrors, &curPortStats.inErrors_);
-  updateStat(
-      now,
-      kInIpv4HdrErrors,
-      opennsl_spl_snmpIpInHdrErrors,
-      &curPortStats.inIpv4HdrErrors_);
-  updateStat(
-      now,
-      kInIpv6HdrErrors,
-      opennsl_spl_snmpIpv6IfStatsInHdrErrors,
-      &curPortStats.inIpv6HdrErrors_);
-  updateStat(
-      now,
-      kInPause,
-      opennsl_spl_snmpDot3InPauseFrames,
-      &curPortStats.inPause_);
-  // Egress Stats
-  updateStat(
-      now, kOutBytes, opennsl_spl_snmpIfHCOutOctets, &curPortStats.outBytes_);
-  updateStat(
-      now,
-      kOutUnicastPkts,
-      opennsl_spl_snmpIfHCOutUcastPkts,
-      &curPortStats.outUnicastPkts_);
-  updateStat(
-      now,
-      kOutMulticastPkts,
-      opennsl_spl_snmpIfHCOutMulticastPkts,
-      &curPortStats.outMulticastPkts_);
-  updateStat(
-      now,
-      kOutBroadcastPkts,
-      opennsl_spl_snmpIfHCOutBroadcastPckts,
-      &curPortStats.outBroadcastPkts_);
-  updateStat(
-      now,
-      kOutDiscards,
-      opennsl_spl_snmpIfOutDiscards,
-      &curPortStats.outDiscards_);
-  updateStat(
-      now, kOutErrors, opennsl_spl_snmpIfOutErrors, &curPortStats.outErrors_);
-  updateStat(
-      now,
-      kOutPause,
-      opennsl_spl_snmpDot3OutPauseFrames,
-      &curPortStats.outPause_);
+  updatePortStats(now, &curPortStats);
 
   setAdditionalStats(now, &curPortStats);
   // Compute non pause discards
@@ -632,6 +629,7 @@ void BcmPort::updateStats() {
     }
   }
   portStats_ = curPortStats;
+  updatePortCounters(curPortStats);
 
   // Update the queue length stat
   uint32_t qlength;
@@ -652,12 +650,85 @@ void BcmPort::updateStats() {
   updatePktLenHist(now, &outPktLengths_, kOutPktLengthStats);
 };
 
+void BcmPort::updatePortStats(
+    std::chrono::seconds now,
+    HwPortStats* curPortStats) {
+  // Read them all in one call, which like updateStat() gets the values the
+  // SDK's counter thread last synced to software.
+  static const std::vector<opennsl_stat_val_t> kPortStatTypes =
+    getPortStatTypes();
+  uint64_t values[kNumPortStats];
+  // opennsl_stat_multi_get() unfortunately doesn't correctly const qualify
+  // it's stats arguments right now.
+  auto ret = opennsl_stat_multi_get(
+      unit_, port_, kNumPortStats,
+      const_cast<opennsl_stat_val_t*>(kPortStatTypes.data()), values);
+  if (OPENNSL_FAILURE(ret)) {
+    // Get what we can one at a time, in case only some stats are unsupported
+    VLOG(1) << "Failed to get stats for port " << port_ << " :"
+            << opennsl_errmsg(ret);
+    for (size_t idx = 0; idx < kNumPortStats; ++idx) {
+      const auto& stat = kPortStats[idx];
+      updateStat(now, portStatCounters_[idx], stat.type,
+                 &(curPortStats->*stat.field));
+    }
+    return;
+  }
+  for (size_t idx = 0; idx < kNumPortStats; ++idx) {
+    portStatCounters_[idx]->updateValue(now, values[idx]);
+    curPortStats->*kPortStats[idx].field = values[idx];
+  }
+}
+
+void BcmPort::updatePortCounters(const HwPortStats& curPortStats) {
+  const auto kUninit = hardware_stats_constants::STAT_UNINITIALIZED();
+  // Add up the increases since the first values read, as MonotonicCounter
+  // does for the exported stats.  A value lower than the last one (the HW
+  // counter was cleared or wrapped) is just the new baseline.
+  auto sinceStart = [&](int64_t HwPortStats::* field, int64_t* counter) {
+    auto value = curPortStats.*field;
+    if (value == kUninit) {
+      // Not read this time, so keep the last value
+      return;
+    }
+    auto& prev = prevPortStats_.*field;
+    if (prev != kUninit && value >= prev) {
+      *counter += value - prev;
+    }
+    prev = value;
+  };
+
+  std::lock_guard<folly::SpinLock> g(portCountersLock_);
+  sinceStart(&HwPortStats::inBytes_, &inCounters_.bytes);
+  sinceStart(&HwPortStats::inUnicastPkts_, &inCounters_.ucastPkts);
+  sinceStart(&HwPortStats::inMulticastPkts_, &inCounters_.multicastPkts);
+  sinceStart(&HwPortStats::inBroadcastPkts_, &inCounters_.broadcastPkts);
+  sinceStart(&HwPortStats::inErrors_, &inCounters_.errors.errors);
+  sinceStart(&HwPortStats::inDiscards_, &inCounters_.errors.discards);
+  sinceStart(&HwPortStats::outBytes_, &outCounters_.bytes);
+  sinceStart(&HwPortStats::outUnicastPkts_, &outCounters_.ucastPkts);
+  sinceStart(&HwPortStats::outMulticastPkts_, &outCounters_.multicastPkts);
+  sinceStart(&HwPortStats::outBroadcastPkts_, &outCounters_.broadcastPkts);
+  sinceStart(&HwPortStats::outErrors_, &outCounters_.errors.errors);
+  sinceStart(&HwPortStats::outDiscards_, &outCounters_.errors.discards);
+}
+
+bool BcmPort::getPortCounters(PortCounters* input,
+                              PortCounters* output) const {
+  if (!shouldReportStats()) {
+    return false;
+  }
+  std::lock_guard<folly::SpinLock> g(portCountersLock_);
+  *input = inCounters_;
+  *output = outCounters_;
+  return true;
+}
+
 void BcmPort::updateStat(
     std::chrono::seconds now,
-    const string& statKey,
+    MonotonicCounter* stat,
     opennsl_stat_val_t type,
     int64_t* statVal) {
-  auto stat = getPortCounterIf(statKey);
   // Use the non-sync API to just get the values accumulated in software.
   // The Broadom SDK's counter thread syncs the HW counters to software every
   // 500000us (defined in config.bcm).
@@ -673,7 +744,7 @@ void BcmPort::updateStat(
 }
 
 bool BcmPort::isMmuLossy() const {
-  return hw_->getMmuState() == BcmSwitch::MmuState::MMU_LOSSY;
+  return hw_->getMmuState() == BcmSwitchIf::MmuState::MMU_LOSSY;
 }
 
 void BcmPort::updatePktLenHist(
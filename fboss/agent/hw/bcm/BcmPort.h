@@ -21,13 +21,15 @@ extern "C" {
 #include "fboss/agent/types.h"
 #include "fboss/agent/hw/bcm/BcmPlatformPort.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
 #include "fboss/agent/hw/bcm/gen-cpp2/hardware_stats_types.h"
 
+#include <folly/SpinLock.h>
 #include <mutex>
 
 namespace facebook { namespace fboss {
 
-class BcmSwitch;
+class BcmSwitchIf;
 class BcmPortGroup;
 class SwitchState;
 class Port;
@@ -44,7 +46,8 @@ class BcmPort {
    * the port yet.  init() will be called soon after construction, and any
    * actual initialization logic should be performed there.
    */
-  BcmPort(BcmSwitch* hw, opennsl_port_t port, BcmPlatformPort* platformPort);
+  BcmPort(BcmSwitchIf* hw, opennsl_port_t port,
+          BcmPlatformPort* platformPort);
 
   void init(bool warmBoot);
 
@@ -58,7 +61,7 @@ class BcmPort {
   BcmPlatformPort* getPlatformPort() const {
     return platformPort_;
   }
-  BcmSwitch* getHW() const {
+  BcmSwitchIf* getHW() const {
     return hw_;
   }
   opennsl_port_t getBcmPortId() const {
@@ -100,6 +103,14 @@ class BcmPort {
    */
   void updateStats();
 
+  /*
+   * The port's counters as of the last updateStats(), cumulative since the
+   * first or since reinitPortStats().  Decreases in the HW counters are not
+   * counted.  Returns false if the port doesn't report stats.  Cheap enough
+   * to call for every port on every thrift request.
+   */
+  bool getPortCounters(PortCounters* input, PortCounters* output) const;
+
   /**
    * Get the state of the port. If there is an error in finding the port state,
    * then an BcmError() exception is thrown.
@@ -139,10 +150,12 @@ class BcmPort {
   bool shouldReportStats() const;
   void reinitPortStats();
   void reinitPortStat(const std::string& newName);
+  void updatePortStats(std::chrono::seconds now, HwPortStats* curPortStats);
   void updateStat(std::chrono::seconds now,
-                  const std::string& statName,
+                  MonotonicCounter* stat,
                   opennsl_stat_val_t type,
                   int64_t* portStatVal);
+  void updatePortCounters(const HwPortStats& curPortStats);
   void updatePktLenHist(std::chrono::seconds now,
                         stats::ExportedHistogramMapImpl::LockableHistogram* hist,
                         const std::vector<opennsl_stat_val_t>& stats);
@@ -165,7 +178,7 @@ class BcmPort {
 
   static constexpr auto kOutCongestionDiscards = "out_congestion_discards";
 
-  BcmSwitch* const hw_{nullptr};
+  BcmSwitchIf* const hw_{nullptr};
   const opennsl_port_t port_;    // Broadcom physical port number
   // The gport_ is logically a const, but needs to be initialized as a parameter
   // to SDK call.
@@ -179,11 +192,19 @@ class BcmPort {
   BcmPortGroup* portGroup_{nullptr};
 
   std::map<std::string, MonotonicCounter> portCounters_;
+  // The counters updatePortStats() reads, resolved from portCounters_ once
+  std::vector<MonotonicCounter*> portStatCounters_;
 
   stats::ExportedStatMapImpl::LockableStat outQueueLen_;
   stats::ExportedHistogramMapImpl::LockableHistogram inPktLengths_;
   stats::ExportedHistogramMapImpl::LockableHistogram outPktLengths_;
   HwPortStats portStats_;
+
+  // The last stats read, which the next increase in the counters is from
+  HwPortStats prevPortStats_;
+  mutable folly::SpinLock portCountersLock_;
+  PortCounters inCounters_;
+  PortCounters outCounters_;
 };
 
 }} // namespace facebook::fboss
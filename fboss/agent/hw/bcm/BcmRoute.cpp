@@ -13,6 +13,9 @@ extern "C" {
 #include <opennsl/l3.h>
 }
 
+#include <algorithm>
+#include <vector>
+
 #include <folly/IPAddress.h>
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
@@ -40,9 +43,19 @@ auto constexpr kRoutes = "routes";
 // TODO: Assumes we have only one VRF
 auto constexpr kDefaultVrf = 0;
 auto constexpr kDefaultMask = 0;
+
+template<typename VrfFibT>
+auto& fibFor(VrfFibT* vrfFib, const folly::IPAddressV4& /*addr*/) {
+  return vrfFib->v4;
+}
+
+template<typename VrfFibT>
+auto& fibFor(VrfFibT* vrfFib, const folly::IPAddressV6& /*addr*/) {
+  return vrfFib->v6;
+}
 }
 
-BcmRoute::BcmRoute(const BcmSwitch* hw, opennsl_vrf_t vrf,
+BcmRoute::BcmRoute(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
                    const folly::IPAddress& addr, uint8_t len)
     : hw_(hw), vrf_(vrf), prefix_(addr), len_(len) {
 }
@@ -81,13 +94,38 @@ bool BcmRoute::canUseHostTable() const {
   return isHostRoute() && hw_->getPlatform()->canUseHostTableForHostRoutes();
 }
 
+bool BcmRoute::isProgrammed(const RouteForwardInfo& fwd) const {
+  return added_ && fwd == fwd_;
+}
+
+opennsl_if_t BcmRoute::incRefEgress(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
+                                    const RouteForwardInfo& fwd,
+                                    uint32_t count) {
+  auto action = fwd.getAction();
+  if (action == RouteForwardAction::DROP) {
+    return hw->getDropEgressId();
+  } else if (action == RouteForwardAction::TO_CPU) {
+    return hw->getToCPUEgressId();
+  }
+  CHECK(action == RouteForwardAction::NEXTHOPS);
+  // need to get an entry from the host table for the forward info
+  const RouteForwardNexthops& nhops = fwd.getNexthops();
+  CHECK_GT(nhops.size(), 0);
+  auto host = hw->writableHostTable()->incRefOrCreateBcmEcmpHost(
+      vrf, nhops, count);
+  return host->getEgressId();
+}
+
 void BcmRoute::program(const RouteForwardInfo& fwd) {
   // if the route has been programmed to the HW, check if the forward info is
   // changed or not. If not, nothing to do.
-  if (added_ && fwd == fwd_) {
+  if (isProgrammed(fwd)) {
     return;
   }
+  program(fwd, incRefEgress(hw_, vrf_, fwd));
+}
 
+void BcmRoute::program(const RouteForwardInfo& fwd, opennsl_if_t egressId) {
   // function to clean up the host reference
   auto cleanupHost = [&] (const RouteForwardNexthops& nhopsClean) noexcept {
     if (nhopsClean.size()) {
@@ -95,23 +133,6 @@ void BcmRoute::program(const RouteForwardInfo& fwd) {
     }
   };
 
-  auto action = fwd.getAction();
-  // find out the egress object ID
-  opennsl_if_t egressId;
-  if (action == RouteForwardAction::DROP) {
-    egressId = hw_->getDropEgressId();
-  } else if (action == RouteForwardAction::TO_CPU) {
-    egressId = hw_->getToCPUEgressId();
-  } else {
-    CHECK(action == RouteForwardAction::NEXTHOPS);
-    // need to get an entry from the host table for the forward info
-    const RouteForwardNexthops& nhops = fwd.getNexthops();
-    CHECK_GT(nhops.size(), 0);
-    auto host = hw_->writableHostTable()->incRefOrCreateBcmEcmpHost(
-        vrf_, nhops);
-    egressId = host->getEgressId();
-  }
-
   // At this point host and egress objects for next hops have been
   // created, what remains to be done is to program route into the
   // route table or host table (if this is a host route and use of
@@ -280,37 +301,36 @@ BcmRoute::~BcmRoute() {
   }
 }
 
-bool BcmRouteTable::Key::operator<(const Key& k2) const {
-  if (vrf < k2.vrf) {
-    return true;
-  } else if (vrf > k2.vrf) {
-    return false;
-  }
-  if (mask < k2.mask) {
-    return true;
-  } else if (mask > k2.mask) {
-    return false;
-  }
-  return network < k2.network;
-}
-
-BcmRouteTable::BcmRouteTable(const BcmSwitch* hw) : hw_(hw) {
+BcmRouteTable::BcmRouteTable(const BcmSwitchIf* hw) : hw_(hw) {
 }
 
 BcmRouteTable::~BcmRouteTable() {
 
 }
 
+template<typename AddrT>
 BcmRoute* BcmRouteTable::getBcmRouteIf(
-    opennsl_vrf_t vrf, const folly::IPAddress& network, uint8_t mask) const {
-  Key key{network, mask, vrf};
-  auto iter = fib_.find(key);
-  if (iter == fib_.end()) {
+    opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix) const {
+  auto vrfIter = fib_.find(vrf);
+  if (vrfIter == fib_.end()) {
+    return nullptr;
+  }
+  const auto& fib = fibFor(&vrfIter->second, prefix.network);
+  auto iter = fib.find(prefix);
+  if (iter == fib.end()) {
     return nullptr;
   }
   return iter->second.get();
 }
 
+BcmRoute* BcmRouteTable::getBcmRouteIf(
+    opennsl_vrf_t vrf, const folly::IPAddress& network, uint8_t mask) const {
+  if (network.isV4()) {
+    return getBcmRouteIf(vrf, RoutePrefixV4{network.asV4(), mask});
+  }
+  return getBcmRouteIf(vrf, RoutePrefixV6{network.asV6(), mask});
+}
+
 BcmRoute* BcmRouteTable::getBcmRoute(
     opennsl_vrf_t vrf, const folly::IPAddress& network, uint8_t mask) const {
   auto rt = getBcmRouteIf(vrf, network, mask);
@@ -331,17 +351,17 @@ void BcmRouteTable::addDefaultRoutes(bool warmBooted) {
 
   // If we've warm booted, we already have routes programmed
   if (!warmBooted) {
-    addRoute<RouteV4>(kDefaultVrf, defaultV4_.get());
-    addRoute<RouteV6>(kDefaultVrf, defaultV6_.get());
+    addDefaultRoute(defaultV4_->prefix().network);
+    addDefaultRoute(defaultV6_->prefix().network);
   }
 }
 
-bool BcmRouteTable::isDefaultRouteV4(const Key& key) {
-  return key.mask == 0 && key.network == defaultV4_->prefix().network;
+void BcmRouteTable::addDefaultRoute(const folly::IPAddressV4& /*addr*/) {
+  addRoute<RouteV4>(kDefaultVrf, defaultV4_.get());
 }
 
-bool BcmRouteTable::isDefaultRouteV6(const Key& key) {
-  return key.mask == 0 && key.network == defaultV6_->prefix().network;
+void BcmRouteTable::addDefaultRoute(const folly::IPAddressV6& /*addr*/) {
+  addRoute<RouteV6>(kDefaultVrf, defaultV6_.get());
 }
 
 template<typename AddrT>
@@ -352,44 +372,156 @@ const Route<AddrT>* BcmRouteTable::createDefaultRoute(const AddrT& ip) {
 
 template<typename RouteT>
 void BcmRouteTable::addRoute(opennsl_vrf_t vrf, const RouteT *route) {
-  const auto& prefix = route->prefix();
-  Key key{folly::IPAddress(prefix.network), prefix.mask, vrf};
-  auto ret = fib_.emplace(key, nullptr);
+  auto bcmRoute = getOrCreateBcmRoute(vrf, route->prefix());
+  SCOPE_FAIL {
+    eraseIfNotAdded(vrf, route->prefix());
+  };
+  CHECK(route->isResolved());
+  bcmRoute->program(route->getForwardInfo());
+}
+
+template<typename AddrT>
+BcmRoute* BcmRouteTable::getOrCreateBcmRoute(
+    opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix) {
+  auto& fib = fibFor(&fib_[vrf], prefix.network);
+  auto ret = fib.emplace(prefix, nullptr);
   if (ret.second) {
     SCOPE_FAIL {
-      fib_.erase(ret.first);
+      fib.erase(ret.first);
     };
-    ret.first->second.reset(new BcmRoute(hw_, vrf,
-                                        folly::IPAddress(prefix.network),
-                                        prefix.mask));
+    ret.first->second = std::make_unique<BcmRoute>(
+        hw_, vrf, folly::IPAddress(prefix.network), prefix.mask);
+  }
+  return ret.first->second.get();
+}
+
+template<typename AddrT>
+void BcmRouteTable::eraseIfNotAdded(
+    opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix) {
+  auto vrfIter = fib_.find(vrf);
+  if (vrfIter == fib_.end()) {
+    return;
+  }
+  auto& fib = fibFor(&vrfIter->second, prefix.network);
+  auto iter = fib.find(prefix);
+  if (iter != fib.end() && !iter->second->isAdded()) {
+    fib.erase(iter);
+  }
+}
+
+void BcmRouteTable::reserve(opennsl_vrf_t vrf, size_t numV4, size_t numV6) {
+  // Only grow the index when it would otherwise have to rehash on the way.
+  // Most batches are small, or change routes that are already there.
+  auto reserveIfNeeded = [](auto& fib, size_t numMore) {
+    auto wanted = fib.size() + numMore;
+    if (wanted > fib.bucket_count() * fib.max_load_factor()) {
+      fib.reserve(wanted);
+    }
+  };
+  auto& vrfFib = fib_[vrf];
+  reserveIfNeeded(vrfFib.v4, numV4);
+  reserveIfNeeded(vrfFib.v6, numV6);
+}
+
+size_t BcmRouteTable::size() const {
+  size_t count = 0;
+  for (const auto& vrfAndFib : fib_) {
+    count += vrfAndFib.second.v4.size() + vrfAndFib.second.v6.size();
+  }
+  return count;
+}
+
+void BcmRouteTable::addRoutes(opennsl_vrf_t vrf,
+                              const RouteBatch::Group& group) {
+  const auto& fwd = group.fwd;
+  // The routes created below but not programmed when something fails
+  // would otherwise stay in fib_ without being in HW
+  SCOPE_FAIL {
+    for (const auto& route : group.v4) {
+      eraseIfNotAdded(vrf, route->prefix());
+    }
+    for (const auto& route : group.v6) {
+      eraseIfNotAdded(vrf, route->prefix());
+    }
+  };
+  std::vector<BcmRoute*> toProgram;
+  toProgram.reserve(group.size());
+  auto addIfChanged = [&](const auto& route) {
+    CHECK(route->isResolved());
+    auto bcmRoute = getOrCreateBcmRoute(vrf, route->prefix());
+    if (!bcmRoute->isProgrammed(fwd)) {
+      toProgram.push_back(bcmRoute);
+    }
+  };
+  for (const auto& route : group.v4) {
+    addIfChanged(route);
+  }
+  for (const auto& route : group.v6) {
+    addIfChanged(route);
+  }
+  if (toProgram.empty()) {
+    return;
+  }
+
+  // Take the references for all the routes at once, so the ECMP host is
+  // looked up (or created) only once for the group.  Every program() call
+  // consumes one of them, whether it succeeds or not.
+  auto egressId = BcmRoute::incRefEgress(hw_, vrf, fwd, toProgram.size());
+  size_t consumed = 0;
+  SCOPE_FAIL {
+    const auto& nhops = fwd.getNexthops();
+    if (nhops.size() && consumed < toProgram.size()) {
+      hw_->writableHostTable()->derefBcmEcmpHost(
+          vrf, nhops, toProgram.size() - consumed);
+    }
+  };
+  for (auto bcmRoute : toProgram) {
+    ++consumed;
+    bcmRoute->program(fwd, egressId);
   }
-  CHECK(route->isResolved());
-  ret.first->second->program(route->getForwardInfo());
 }
 
 template<typename RouteT>
 void BcmRouteTable::deleteRoute(opennsl_vrf_t vrf, const RouteT *route) {
   const auto& prefix = route->prefix();
-  Key key{folly::IPAddress(prefix.network), prefix.mask, vrf};
-  auto iter = fib_.find(key);
-  if (iter == fib_.end()) {
+  auto vrfIter = fib_.find(vrf);
+  if (vrfIter == fib_.end()) {
+    throw FbossError("Failed to delete a non-existing route ", route->str());
+  }
+  auto& fib = fibFor(&vrfIter->second, prefix.network);
+  auto iter = fib.find(prefix);
+  if (iter == fib.end()) {
     throw FbossError("Failed to delete a non-existing route ", route->str());
   }
   // We want to always be left with a default route in ALPM mode
   // so if we're deleting it, add the default DROP route back
-  if (alpmEnabled_ && isDefaultRouteV4(key)) {
-    addRoute<RouteV4>(kDefaultVrf, defaultV4_.get());
-  } else if (alpmEnabled_ && isDefaultRouteV6(key)) {
-    addRoute<RouteV6>(kDefaultVrf, defaultV6_.get());
+  if (alpmEnabled_ && isDefaultRoute(prefix)) {
+    addDefaultRoute(prefix.network);
   } else {
-    fib_.erase(iter);
+    fib.erase(iter);
   }
 }
 
 folly::dynamic BcmRouteTable::toFollyDynamic() const {
   folly::dynamic routesJson = folly::dynamic::array;
-  for (const auto& route : fib_) {
-    routesJson.push_back(route.second->toFollyDynamic());
+  // The index is unordered, so sort the routes by prefix to write the same
+  // warm boot state for the same routes every time
+  auto addRoutes = [&](const auto& fib) {
+    std::vector<typename std::decay_t<decltype(fib)>::const_pointer> routes;
+    routes.reserve(fib.size());
+    for (const auto& route : fib) {
+      routes.push_back(&route);
+    }
+    std::sort(routes.begin(), routes.end(), [](auto a, auto b) {
+      return a->first < b->first;
+    });
+    for (auto route : routes) {
+      routesJson.push_back(route->second->toFollyDynamic());
+    }
+  };
+  for (const auto& vrfAndFib : fib_) {
+    addRoutes(vrfAndFib.second.v4);
+    addRoutes(vrfAndFib.second.v6);
   }
   folly::dynamic routeTable = folly::dynamic::object;
   routeTable[kRoutes] = std::move(routesJson);
@@ -15,16 +15,19 @@ extern "C" {
 }
 
 #include <folly/dynamic.h>
+#include <folly/Hash.h>
 #include <folly/IPAddress.h>
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteBatch.h"
 #include "fboss/agent/state/RouteForwardInfo.h"
 
-#include <boost/container/flat_map.hpp>
+#include <map>
+#include <unordered_map>
 
 namespace facebook { namespace fboss {
 
-class BcmSwitch;
+class BcmSwitchIf;
 class BcmHost;
 
 /**
@@ -32,10 +35,28 @@ class BcmHost;
  */
 class BcmRoute {
  public:
-  BcmRoute(const BcmSwitch* hw, opennsl_vrf_t vrf,
+  BcmRoute(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
            const folly::IPAddress& addr, uint8_t len);
   ~BcmRoute();
   void program(const RouteForwardInfo& fwd);
+  /*
+   * Program the route using an egress obtained from incRefEgress(), taking
+   * over one of the references it took.
+   */
+  void program(const RouteForwardInfo& fwd, opennsl_if_t egressId);
+  // Whether the route is already programmed with this forward info
+  bool isProgrammed(const RouteForwardInfo& fwd) const;
+  // Whether the route has been programmed to HW at all
+  bool isAdded() const {
+    return added_;
+  }
+  /*
+   * Find the egress object for the forward info, taking 'count' references
+   * on the ECMP host for its nexthops (creating it if needed).
+   */
+  static opennsl_if_t incRefEgress(const BcmSwitchIf* hw, opennsl_vrf_t vrf,
+                                   const RouteForwardInfo& fwd,
+                                   uint32_t count = 1);
   static bool deleteLpmRoute(int unit,
                              opennsl_vrf_t vrf,
                              const folly::IPAddress& prefix,
@@ -60,7 +81,7 @@ class BcmRoute {
   // no copy or assign
   BcmRoute(const BcmRoute &) = delete;
   BcmRoute& operator=(const BcmRoute &) = delete;
-  const BcmSwitch* hw_;
+  const BcmSwitchIf* hw_;
   opennsl_vrf_t vrf_;
   folly::IPAddress prefix_;
   uint8_t len_;
@@ -72,7 +93,7 @@ class BcmRoute {
 
 class BcmRouteTable {
  public:
-  explicit BcmRouteTable(const BcmSwitch* hw);
+  explicit BcmRouteTable(const BcmSwitchIf* hw);
   ~BcmRouteTable();
   // throw an error if not found
   BcmRoute* getBcmRoute(
@@ -89,23 +110,60 @@ class BcmRouteTable {
   void addRoute(opennsl_vrf_t vrf, const RouteT *route);
   template<typename RouteT>
   void deleteRoute(opennsl_vrf_t vrf, const RouteT *route);
+  /*
+   * Add or update a group of routes sharing the same forward info.
+   */
+  void addRoutes(opennsl_vrf_t vrf, const RouteBatch::Group& group);
+  /*
+   * Make room for up to this many more routes in a VRF up front, so loading
+   * a large batch of routes (e.g. at FIB sync) doesn't keep growing the
+   * index one rehash at a time.  Does nothing if there is room already.
+   */
+  void reserve(opennsl_vrf_t vrf, size_t numV4, size_t numV6);
+  size_t size() const;
   void addDefaultRoutes(bool warmBooted);
   folly::dynamic toFollyDynamic() const;
  private:
   template<typename AddrT>
   const Route<AddrT>* createDefaultRoute(const AddrT& ip);
+  // (Re)program the DROP default route of the address's family
+  void addDefaultRoute(const folly::IPAddressV4& addr);
+  void addDefaultRoute(const folly::IPAddressV6& addr);
+  template<typename AddrT>
+  BcmRoute* getOrCreateBcmRoute(
+      opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix);
+  template<typename AddrT>
+  BcmRoute* getBcmRouteIf(
+      opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix) const;
+  // Drop the route if it was created but never made it to HW
+  template<typename AddrT>
+  void eraseIfNotAdded(opennsl_vrf_t vrf, const RoutePrefix<AddrT>& prefix);
 
-  struct Key {
-    folly::IPAddress network;
-    uint8_t mask;
-    opennsl_vrf_t vrf;
-    bool operator<(const Key& k2) const;
+  struct PrefixHash {
+    template<typename AddrT>
+    size_t operator()(const RoutePrefix<AddrT>& prefix) const {
+      return folly::hash::hash_combine(prefix.network, prefix.mask);
+    }
   };
+  template<typename AddrT>
+  using Fib = std::unordered_map<RoutePrefix<AddrT>,
+                                 std::unique_ptr<BcmRoute>, PrefixHash>;
 
-  bool isDefaultRouteV4(const Key& key);
-  bool isDefaultRouteV6(const Key& key);
+  /*
+   * The routes of one VRF, indexed by prefix.  Each BcmRoute is allocated
+   * separately, so its address stays the same as the index grows.
+   */
+  struct VrfFib {
+    Fib<folly::IPAddressV4> v4;
+    Fib<folly::IPAddressV6> v6;
+  };
+
+  template<typename AddrT>
+  static bool isDefaultRoute(const RoutePrefix<AddrT>& prefix) {
+    return prefix.mask == 0;
+  }
 
-  const BcmSwitch *hw_;
+  const BcmSwitchIf *hw_;
 
   const std::unique_ptr<RouteV4> defaultV4_ = std::make_unique<RouteV4>(
       createDefaultRoute<folly::IPAddressV4>(folly::IPAddressV4("0.0.0.0")));
@@ -113,7 +171,8 @@ class BcmRouteTable {
       createDefaultRoute<folly::IPAddressV6>(folly::IPAddressV6("::")));
 
   bool alpmEnabled_{false};
-  boost::container::flat_map<Key, std::unique_ptr<BcmRoute>> fib_;
+  // There are only ever a handful of VRFs, each with its own index
+  std::map<opennsl_vrf_t, VrfFib> fib_;
 };
 
 }}
@@ -55,6 +55,7 @@
 #include "fboss/agent/state/VlanMap.h"
 #include "fboss/agent/state/VlanMapDelta.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteBatch.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableMap.h"
@@ -138,6 +139,11 @@ bool BcmSwitch::getPortFECConfig(PortID port) const {
   return getPortTable()->getBcmPort(port)->isFECEnabled();
 }
 
+bool BcmSwitch::getPortCounters(PortID port, PortCounters* input,
+                                PortCounters* output) const {
+  return getPortTable()->getBcmPort(port)->getPortCounters(input, output);
+}
+
 BcmSwitch::BcmSwitch(BcmPlatform *platform, HashMode hashMode)
   : platform_(platform),
     hashMode_(hashMode),
@@ -360,6 +366,7 @@ folly::dynamic BcmSwitch::toFollyDynamic() const {
 void BcmSwitch::clearWarmBootCache() {
   std::lock_guard<std::mutex> g(lock_);
   warmBootCache_->clear();
+  hostTable_->setWarmBootEcmpEgressPending(false);
 }
 
 bool BcmSwitch::isPortUp(PortID port) const {
@@ -538,6 +545,8 @@ HwInitResult BcmSwitch::init(Callback* callback) {
     // opennslSwitchL3EgressMode else the egress ids
     // in the host table don't show up correctly.
     warmBootCache_->populate();
+    hostTable_->setWarmBootEcmpEgressPending(
+        !warmBootCache_->ecmp2EgressIds().empty());
   }
   // create an egress object for ToCPU
   toCPUEgress_ = make_unique<BcmEgress>(this);
@@ -613,6 +622,13 @@ void BcmSwitch::stateChanged(const StateDelta& delta) {
   bcmTableStats_->refresh();
 }
 
+void BcmSwitch::programRoutes(const RouteBatch& batch) {
+  std::lock_guard<std::mutex> g(lock_);
+  processRemovedRoutes(batch);
+  processAddedChangedRoutes(batch);
+  bcmTableStats_->refresh();
+}
+
 void BcmSwitch::stateChangedImpl(const StateDelta& delta) {
   // TODO: This function contains high-level logic for how to apply the
   // StateDelta, and isn't particularly hardware-specific.  I plan to refactor
@@ -623,8 +639,12 @@ void BcmSwitch::stateChangedImpl(const StateDelta& delta) {
   // This ensures that we immediately stop forwarding traffic on these ports.
   processDisabledPorts(delta);
 
+  // The route changes are removed here and added further down, once the
+  // interfaces and neighbors they point to are in place.
+  RouteBatch routes(delta);
+
   // remove all routes to be deleted
-  processRemovedRoutes(delta);
+  processRemovedRoutes(routes);
 
   // delete all interface not existing anymore. that should stop
   // all traffic on that interface now
@@ -670,7 +690,7 @@ void BcmSwitch::stateChangedImpl(const StateDelta& delta) {
   processAclChanges(delta);
 
   // Process any new routes or route changes
-  processAddedChangedRoutes(delta);
+  processAddedChangedRoutes(routes);
 
   processAggregatePortChanges(delta);
 
@@ -1030,85 +1050,43 @@ void BcmSwitch::processArpChanges(const StateDelta& delta) {
   }
 }
 
-template <typename RouteT>
-void BcmSwitch::processChangedRoute(const RouterID id,
-                                    const shared_ptr<RouteT>& oldRoute,
-                                    const shared_ptr<RouteT>& newRoute) {
-  VLOG(3) << "changing to route entry @ vrf " << id << " from old: "
-    << oldRoute->str() << "to new: " << newRoute->str();
-  // if the new route is not resolved, delete it instead of changing it
-  if (!newRoute->isResolved()) {
-    VLOG(1) << "Non-resolved route HW programming is skipped";
-    processRemovedRoute(id, oldRoute);
-  } else {
-    routeTable_->addRoute(getBcmVrfId(id), newRoute.get());
-  }
-}
-
-template <typename RouteT>
-void BcmSwitch::processAddedRoute(const RouterID id,
-                                  const shared_ptr<RouteT>& route) {
-  VLOG(3) << "adding route entry @ vrf " << id << " " << route->str();
-  // if the new route is not resolved, ignore it
-  if (!route->isResolved()) {
-    VLOG(1) << "Non-resolved route HW programming is skipped";
-    return;
-  }
-  routeTable_->addRoute(getBcmVrfId(id), route.get());
-}
-
 template <typename RouteT>
 void BcmSwitch::processRemovedRoute(const RouterID id,
                                     const shared_ptr<RouteT>& route) {
   VLOG(3) << "removing route entry @ vrf " << id << " " << route->str();
-  if (!route->isResolved()) {
-    VLOG(1) << "Non-resolved route HW programming is skipped";
-    return;
-  }
   routeTable_->deleteRoute(getBcmVrfId(id), route.get());
 }
 
-void BcmSwitch::processRemovedRoutes(const StateDelta& delta) {
-  for (auto const& rtDelta : delta.getRouteTablesDelta()) {
-    if (!rtDelta.getOld()) {
-      // no old route table, must not removed route, skip
-      continue;
+void BcmSwitch::processRemovedRoutes(const RouteBatch& routes) {
+  for (const auto& removed : routes.getRemoved()) {
+    for (const auto& route : removed.v4) {
+      processRemovedRoute(removed.vrf, route);
+    }
+    for (const auto& route : removed.v6) {
+      processRemovedRoute(removed.vrf, route);
     }
-    RouterID id = rtDelta.getOld()->getID();
-    forEachRemoved(
-        rtDelta.getRoutesV4Delta(),
-        &BcmSwitch::processRemovedRoute<RouteV4>,
-        this,
-        id);
-    forEachRemoved(
-        rtDelta.getRoutesV6Delta(),
-        &BcmSwitch::processRemovedRoute<RouteV6>,
-        this,
-        id);
   }
 }
 
-void BcmSwitch::processAddedChangedRoutes(const StateDelta& delta) {
-  for (auto const& rtDelta : delta.getRouteTablesDelta()) {
-    if (!rtDelta.getNew()) {
-      // no new route table, must not added or changed route, skip
-      continue;
-    }
-    RouterID id = rtDelta.getNew()->getID();
-    forEachChanged(
-        rtDelta.getRoutesV4Delta(),
-        &BcmSwitch::processChangedRoute<RouteV4>,
-        &BcmSwitch::processAddedRoute<RouteV4>,
-        [&](BcmSwitch *, RouterID, const shared_ptr<RouteV4>&) {},
-        this,
-        id);
-    forEachChanged(
-        rtDelta.getRoutesV6Delta(),
-        &BcmSwitch::processChangedRoute<RouteV6>,
-        &BcmSwitch::processAddedRoute<RouteV6>,
-        [&](BcmSwitch *, RouterID, const shared_ptr<RouteV6>&) {},
-        this,
-        id);
+void BcmSwitch::processAddedChangedRoutes(const RouteBatch& routes) {
+  // Size the route table for the whole batch before adding anything, which
+  // matters when a FIB sync loads a full table at once.
+  std::map<RouterID, std::pair<size_t, size_t>> numRoutes;
+  for (const auto& group : routes.getGroups()) {
+    auto& counts = numRoutes[group.vrf];
+    counts.first += group.v4.size();
+    counts.second += group.v6.size();
+  }
+  for (const auto& vrfAndCounts : numRoutes) {
+    routeTable_->reserve(getBcmVrfId(vrfAndCounts.first),
+                         vrfAndCounts.second.first,
+                         vrfAndCounts.second.second);
+  }
+
+  for (const auto& group : routes.getGroups()) {
+    VLOG(3) << "programming " << group.size() << " route entries @ vrf "
+            << group.vrf << " to " << group.fwd.str();
+    routeTable_->addRoutes(getBcmVrfId(group.vrf), group);
   }
 }
 
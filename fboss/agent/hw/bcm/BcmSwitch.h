@@ -59,6 +59,12 @@ class BufferStatsLogger;
  */
 class BcmSwitchIf : public HwSwitch {
  public:
+  enum class MmuState {
+    UNKNOWN,
+    MMU_LOSSLESS,
+    MMU_LOSSY
+  };
+
   virtual std::unique_ptr<BcmUnit> releaseUnit() = 0;
 
   virtual BcmPlatform* getPlatform() const = 0;
@@ -90,6 +96,8 @@ class BcmSwitchIf : public HwSwitch {
 
   virtual BcmWarmBootCache* getWarmBootCache() const = 0;
 
+  virtual MmuState getMmuState() const = 0;
+
   virtual void dumpState() const = 0;
 };
 
@@ -103,11 +111,6 @@ class BcmSwitch : public BcmSwitchIf {
      FULL_HASH, // Full hash - use src IP, dst IP, src port, dst port
      HALF_HASH  // Half hash - user src IP, dst IP
    };
-   enum class MmuState {
-    UNKNOWN,
-    MMU_LOSSLESS,
-    MMU_LOSSY
-   };
   /*
    * Construct a new BcmSwitch.
    *
@@ -148,7 +151,7 @@ class BcmSwitch : public BcmSwitchIf {
   BcmPlatform* getPlatform() const override {
     return platform_;
   }
-  MmuState getMmuState() const { return mmuState_; }
+  MmuState getMmuState() const override { return mmuState_; }
   uint64_t getMMUCellBytes() const { return mmuCellBytes_; }
 
   std::unique_ptr<TxPacket> allocatePacket(uint32_t size) override;
@@ -207,6 +210,7 @@ class BcmSwitch : public BcmSwitchIf {
   // The following function will modify the object.
   // Lock has to be performed in the function.
   void stateChanged(const StateDelta& delta) override;
+  void programRoutes(const RouteBatch& batch) override;
 
   /*
    * gracefulExit performs the requisite cleanup
@@ -298,6 +302,8 @@ class BcmSwitch : public BcmSwitchIf {
   cfg::PortSpeed getPortSpeed(PortID port) const override;
   cfg::PortSpeed getMaxPortSpeed(PortID port) const override;
   bool getPortFECConfig(PortID port) const override;
+  bool getPortCounters(PortID port, PortCounters* input,
+                       PortCounters* output) const override;
 
   bool isValidStateUpdate(const StateDelta& delta) const override;
 
@@ -355,18 +361,11 @@ class BcmSwitch : public BcmSwitchIf {
   void processChangedPorts(const StateDelta& delta);
   void reconfigurePortGroups(const StateDelta& delta);
 
-  template <typename RouteT>
-  void processChangedRoute(
-      const RouterID id, const std::shared_ptr<RouteT>& oldRoute,
-      const std::shared_ptr<RouteT>& newRoute);
-  template <typename RouteT>
-  void processAddedRoute(
-      const RouterID id, const std::shared_ptr<RouteT>& route);
   template <typename RouteT>
   void processRemovedRoute(
       const RouterID id, const std::shared_ptr<RouteT>& route);
-  void processRemovedRoutes(const StateDelta& delta);
-  void processAddedChangedRoutes(const StateDelta& delta);
+  void processRemovedRoutes(const RouteBatch& routes);
+  void processAddedChangedRoutes(const RouteBatch& routes);
 
   void processAclChanges(const StateDelta& delta);
   void processChangedAcl(const std::shared_ptr<AclEntry>& oldAcl,
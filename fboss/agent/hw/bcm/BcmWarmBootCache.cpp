@@ -17,6 +17,7 @@
 #include <folly/json.h>
 
 #include "fboss/agent/Constants.h"
+#include "fboss/agent/WarmBootStateFile.h"
 #include "fboss/agent/hw/bcm/BcmEgress.h"
 #include "fboss/agent/hw/bcm/BcmPlatform.h"
 #include "fboss/agent/hw/bcm/BcmSwitch.h"
@@ -234,11 +235,8 @@ folly::dynamic BcmWarmBootCache::toFollyDynamic() const {
 }
 
 void BcmWarmBootCache::populateStateFromWarmbootFile() {
-  string warmBootJson;
   const auto& warmBootFile = hw_->getPlatform()->getWarmBootSwitchStateFile();
-  auto ret = folly::readFile(warmBootFile.c_str(), warmBootJson);
-  sysCheckError(ret, "Unable to read switch state from : ", warmBootFile);
-  auto switchStateJson = folly::parseJson(warmBootJson);
+  auto switchStateJson = readWarmBootStateFile(warmBootFile);
   if (switchStateJson.find(kSwSwitch) != switchStateJson.items().end()) {
     dumpedSwSwitchState_ =
         SwitchState::uniquePtrFromFollyDynamic(switchStateJson[kSwSwitch]);
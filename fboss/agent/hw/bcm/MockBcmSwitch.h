@@ -51,6 +51,7 @@ class MockBcmSwitch : public BcmSwitchIf {
   MOCK_CONST_METHOD0(getDropEgressId, opennsl_if_t());
   MOCK_CONST_METHOD0(getToCPUEgressId, opennsl_if_t());
   MOCK_METHOD1(stateChanged, void(const StateDelta& delta));
+  MOCK_METHOD1(programRoutes, void(const RouteBatch& batch));
   MOCK_METHOD1(gracefulExit, void(folly::dynamic& switchState));
   MOCK_CONST_METHOD0(toFollyDynamic, folly::dynamic());
   MOCK_METHOD0(initialConfigApplied, void());
@@ -65,6 +66,7 @@ class MockBcmSwitch : public BcmSwitchIf {
   MOCK_METHOD1(fetchL2Table, void(std::vector<L2EntryThrift>* l2Table));
   MOCK_CONST_METHOD0(writableHostTable, BcmHostTable*());
   MOCK_CONST_METHOD0(getWarmBootCache, BcmWarmBootCache*());
+  MOCK_CONST_METHOD0(getMmuState, MmuState());
   MOCK_CONST_METHOD0(dumpState, void());
   MOCK_CONST_METHOD0(exitFatal, void());
   MOCK_METHOD2(
@@ -9,6 +9,7 @@
  */
 #include "fboss/agent/hw/bcm/BcmUnit.h"
 
+#include "fboss/agent/WarmBootStateFile.h"
 #include "fboss/agent/hw/bcm/BcmAPI.h"
 #include "fboss/agent/hw/bcm/BcmError.h"
 #include "fboss/agent/hw/bcm/BcmWarmBootHelper.h"
@@ -54,6 +55,7 @@ void BcmUnit::detach(const std::string& switchStateFile,
   auto rv = _opennsl_shutdown(unit_);
   bcmCheckError(rv, "failed to clean up BCM state during warm boot shutdown");
 
+  writeWarmBootStateFile(switchStateFile, switchState);
   wbHelper_->setCanWarmBoot();
 }
 
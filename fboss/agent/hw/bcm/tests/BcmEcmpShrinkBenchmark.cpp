@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+
+extern "C" {
+#include <opennsl/error.h>
+#include <opennsl/l3.h>
+}
+
+#include <map>
+#include <vector>
+
+#include "fboss/agent/hw/bcm/BcmEgress.h"
+#include "fboss/agent/hw/bcm/BcmHost.h"
+#include "fboss/agent/hw/bcm/BcmWarmBootCache.h"
+#include "fboss/agent/hw/bcm/MockBcmSwitch.h"
+
+using namespace facebook::fboss;
+using std::make_unique;
+using std::unique_ptr;
+
+/*
+ * An in-process fake of the OpenNSL L3 ECMP calls, which takes the place
+ * of the SDK's as long as this is linked ahead of it.  Like the ASIC, a
+ * traverse walks every ECMP group programmed.  Removing a member is only
+ * counted, so that every link down does the same amount of work.
+ */
+namespace {
+
+std::map<opennsl_if_t, std::vector<opennsl_if_t>> fakeEcmps;
+opennsl_if_t nextFakeEcmpId = 200000;
+uint64_t numFakeEcmpDeletes = 0;
+
+} // unnamed namespace
+
+extern "C" {
+
+int opennsl_l3_egress_ecmp_create(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp,
+    int intf_count,
+    opennsl_if_t* intf_array) {
+  if (!(ecmp->flags & OPENNSL_L3_WITH_ID)) {
+    ecmp->ecmp_intf = nextFakeEcmpId++;
+  }
+  fakeEcmps[ecmp->ecmp_intf].assign(intf_array, intf_array + intf_count);
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_destroy(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp) {
+  if (!fakeEcmps.erase(ecmp->ecmp_intf)) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_delete(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* /*ecmp*/,
+    opennsl_if_t /*intf*/) {
+  ++numFakeEcmpDeletes;
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_traverse(
+    int unit,
+    opennsl_l3_egress_ecmp_traverse_cb trav_fn,
+    void* user_data) {
+  for (auto& idAndIntfs : fakeEcmps) {
+    opennsl_l3_egress_ecmp_t ecmp;
+    opennsl_l3_egress_ecmp_t_init(&ecmp);
+    ecmp.ecmp_intf = idAndIntfs.first;
+    auto& intfs = idAndIntfs.second;
+    trav_fn(unit, &ecmp, intfs.size(), intfs.data(), user_data);
+  }
+  return OPENNSL_E_NONE;
+}
+
+}
+
+namespace {
+
+/*
+ * These benchmarks take a port down with the host table holding a given
+ * number of ECMP groups, as the linkscan callback does, and report the
+ * time per link down.  There is one next hop behind each of 64 ports, and
+ * each group spreads over 4 consecutive ports, so a port is in 1/16th of
+ * the groups.
+ */
+constexpr opennsl_port_t kNumPorts = 64;
+constexpr int kEcmpWidth = 4;
+constexpr opennsl_if_t kFirstEgressId = 100000;
+
+class FakeBcmSwitch : public MockBcmSwitch {
+ public:
+  FakeBcmSwitch() : warmBootCache_(this) {}
+
+  void setHostTable(BcmHostTable* hostTable) {
+    hostTable_ = hostTable;
+  }
+
+  // Called for every group, so don't go through gmock for these
+  int getUnit() const override {
+    return 0;
+  }
+  const BcmHostTable* getHostTable() const override {
+    return hostTable_;
+  }
+  BcmHostTable* writableHostTable() const override {
+    return hostTable_;
+  }
+  BcmWarmBootCache* getWarmBootCache() const override {
+    return &warmBootCache_;
+  }
+
+ private:
+  mutable BcmWarmBootCache warmBootCache_;
+  BcmHostTable* hostTable_{nullptr};
+};
+
+unique_ptr<FakeBcmSwitch> hw;
+
+opennsl_if_t egressIdForPort(opennsl_port_t port) {
+  return kFirstEgressId + port;
+}
+
+unique_ptr<BcmHostTable> makeHostTable(uint32_t numEcmps) {
+  auto table = make_unique<BcmHostTable>(hw.get());
+  hw->setHostTable(table.get());
+  // The next hops must be resolved for the groups to include them
+  for (opennsl_port_t port = 1; port <= kNumPorts; ++port) {
+    table->updatePortEgressMapping(egressIdForPort(port), 0, port);
+  }
+  for (uint32_t i = 0; i < numEcmps; ++i) {
+    BcmEcmpEgress::Paths paths;
+    for (int n = 0; n < kEcmpWidth; ++n) {
+      paths.insert(egressIdForPort((i + n) % kNumPorts + 1));
+    }
+    table->insertBcmEgress(make_unique<BcmEcmpEgress>(hw.get(), paths));
+  }
+  CHECK_EQ(numEcmps, fakeEcmps.size());
+  return table;
+}
+
+void shrinkEcmps(int numIters, uint32_t numEcmps, bool traverse) {
+  folly::BenchmarkSuspender braces;
+  auto table = makeHostTable(numEcmps);
+  // As it is until the warm boot cache is cleared
+  table->setWarmBootEcmpEgressPending(traverse);
+  numFakeEcmpDeletes = 0;
+  braces.dismiss();
+  for (int n = 0; n < numIters; ++n) {
+    table->linkDownHwNotLocked(n % kNumPorts + 1);
+  }
+  braces.rehire();
+  VLOG(1) << numFakeEcmpDeletes << " ECMP members removed";
+  table.reset();
+  hw->setHostTable(nullptr);
+  CHECK(fakeEcmps.empty());
+}
+
+} // unnamed namespace
+
+void ShrinkByTraverse(int numIters, uint32_t numEcmps) {
+  shrinkEcmps(numIters, numEcmps, true);
+}
+
+void ShrinkByIndex(int numIters, uint32_t numEcmps) {
+  shrinkEcmps(numIters, numEcmps, false);
+}
+
+BENCHMARK_PARAM(ShrinkByTraverse, 100)
+BENCHMARK_RELATIVE_PARAM(ShrinkByIndex, 100)
+BENCHMARK_PARAM(ShrinkByTraverse, 1000)
+BENCHMARK_RELATIVE_PARAM(ShrinkByIndex, 1000)
+BENCHMARK_PARAM(ShrinkByTraverse, 10000)
+BENCHMARK_RELATIVE_PARAM(ShrinkByIndex, 10000)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  hw = make_unique<FakeBcmSwitch>();
+  folly::runBenchmarks();
+  hw.reset();
+  return 0;
+}
@@ -0,0 +1,297 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+extern "C" {
+#include <opennsl/error.h>
+#include <opennsl/l3.h>
+}
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fboss/agent/hw/bcm/BcmEgress.h"
+#include "fboss/agent/hw/bcm/BcmHost.h"
+#include "fboss/agent/hw/bcm/BcmWarmBootCache.h"
+#include "fboss/agent/hw/bcm/MockBcmSwitch.h"
+
+using namespace facebook::fboss;
+using std::make_unique;
+using std::unique_ptr;
+
+/*
+ * An in-process fake of the OpenNSL L3 ECMP calls, which takes the place
+ * of the SDK's as long as this is linked ahead of it.  It keeps the members
+ * of each group, so the tests can check which groups a link down shrank.
+ */
+namespace {
+
+std::map<opennsl_if_t, std::vector<opennsl_if_t>> fakeEcmps;
+opennsl_if_t nextFakeEcmpId = 200000;
+int numFakeEcmpTraverses = 0;
+
+} // unnamed namespace
+
+extern "C" {
+
+int opennsl_l3_egress_ecmp_create(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp,
+    int intf_count,
+    opennsl_if_t* intf_array) {
+  if (!(ecmp->flags & OPENNSL_L3_WITH_ID)) {
+    ecmp->ecmp_intf = nextFakeEcmpId++;
+  }
+  fakeEcmps[ecmp->ecmp_intf].assign(intf_array, intf_array + intf_count);
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_destroy(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp) {
+  if (!fakeEcmps.erase(ecmp->ecmp_intf)) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_get(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp,
+    int intf_size,
+    opennsl_if_t* intf_array,
+    int* intf_count) {
+  auto it = fakeEcmps.find(ecmp->ecmp_intf);
+  if (it == fakeEcmps.end()) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  *intf_count = std::min<int>(intf_size, it->second.size());
+  std::copy(it->second.begin(), it->second.begin() + *intf_count,
+            intf_array);
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_delete(
+    int /*unit*/,
+    opennsl_l3_egress_ecmp_t* ecmp,
+    opennsl_if_t intf) {
+  auto it = fakeEcmps.find(ecmp->ecmp_intf);
+  if (it == fakeEcmps.end()) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  auto& intfs = it->second;
+  auto member = std::find(intfs.begin(), intfs.end(), intf);
+  if (member == intfs.end()) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  intfs.erase(member);
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_egress_ecmp_traverse(
+    int unit,
+    opennsl_l3_egress_ecmp_traverse_cb trav_fn,
+    void* user_data) {
+  ++numFakeEcmpTraverses;
+  // The callback may change the members, so hand it a copy
+  auto ecmps = fakeEcmps;
+  for (auto& idAndIntfs : ecmps) {
+    opennsl_l3_egress_ecmp_t ecmp;
+    opennsl_l3_egress_ecmp_t_init(&ecmp);
+    ecmp.ecmp_intf = idAndIntfs.first;
+    auto& intfs = idAndIntfs.second;
+    trav_fn(unit, &ecmp, intfs.size(), intfs.data(), user_data);
+  }
+  return OPENNSL_E_NONE;
+}
+
+}
+
+namespace {
+
+/*
+ * One next hop behind each of 8 ports.  Group n spreads over the next hops
+ * of ports n + 1 and n + 2, so each port is in two of the groups.
+ */
+constexpr opennsl_port_t kNumPorts = 8;
+constexpr opennsl_if_t kFirstEgressId = 100000;
+constexpr opennsl_if_t kDropEgressId = 1;
+
+class FakeBcmSwitch : public MockBcmSwitch {
+ public:
+  FakeBcmSwitch() : warmBootCache_(this) {}
+
+  void setHostTable(BcmHostTable* hostTable) {
+    hostTable_ = hostTable;
+  }
+
+  int getUnit() const override {
+    return 0;
+  }
+  const BcmHostTable* getHostTable() const override {
+    return hostTable_;
+  }
+  BcmHostTable* writableHostTable() const override {
+    return hostTable_;
+  }
+  BcmWarmBootCache* getWarmBootCache() const override {
+    return &warmBootCache_;
+  }
+  opennsl_if_t getDropEgressId() const override {
+    return kDropEgressId;
+  }
+
+ private:
+  mutable BcmWarmBootCache warmBootCache_;
+  BcmHostTable* hostTable_{nullptr};
+};
+
+opennsl_if_t egressIdForPort(opennsl_port_t port) {
+  return kFirstEgressId + port;
+}
+
+BcmHostTable::Paths pathsForGroup(int n) {
+  BcmHostTable::Paths paths;
+  paths.insert(egressIdForPort(n % kNumPorts + 1));
+  paths.insert(egressIdForPort((n + 1) % kNumPorts + 1));
+  return paths;
+}
+
+bool inFakeEcmp(opennsl_if_t ecmpId, opennsl_if_t egressId) {
+  const auto& intfs = fakeEcmps.at(ecmpId);
+  return std::find(intfs.begin(), intfs.end(), egressId) != intfs.end();
+}
+
+class BcmHostTableTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    fakeEcmps.clear();
+    numFakeEcmpTraverses = 0;
+    hw = make_unique<FakeBcmSwitch>();
+    table = make_unique<BcmHostTable>(hw.get());
+    hw->setHostTable(table.get());
+    // The next hops must be resolved for the groups to include them
+    for (opennsl_port_t port = 1; port <= kNumPorts; ++port) {
+      table->updatePortEgressMapping(egressIdForPort(port), 0, port);
+    }
+  }
+
+  void TearDown() override {
+    table.reset();
+    hw->setHostTable(nullptr);
+    EXPECT_TRUE(fakeEcmps.empty());
+  }
+
+  // Create one group for each port, returning their egress IDs
+  std::vector<opennsl_if_t> createGroups() {
+    std::vector<opennsl_if_t> ecmpIds;
+    for (int n = 0; n < kNumPorts; ++n) {
+      auto ecmp = make_unique<BcmEcmpEgress>(hw.get(), pathsForGroup(n));
+      ecmpIds.push_back(ecmp->getID());
+      table->insertBcmEgress(std::move(ecmp));
+    }
+    return ecmpIds;
+  }
+
+  // Check that exactly the groups with port's next hop no longer have it
+  void checkShrunk(const std::vector<opennsl_if_t>& ecmpIds,
+                   opennsl_port_t port) {
+    auto egressId = egressIdForPort(port);
+    for (int n = 0; n < kNumPorts; ++n) {
+      SCOPED_TRACE(n);
+      for (auto path : pathsForGroup(n)) {
+        EXPECT_EQ(path != egressId, inFakeEcmp(ecmpIds[n], path));
+      }
+    }
+  }
+
+  unique_ptr<FakeBcmSwitch> hw;
+  unique_ptr<BcmHostTable> table;
+};
+
+} // unnamed namespace
+
+TEST_F(BcmHostTableTest, EcmpIndex) {
+  auto ecmpIds = createGroups();
+  EXPECT_EQ(kNumPorts, table->numEcmpEgress());
+  for (opennsl_port_t port = 1; port <= kNumPorts; ++port) {
+    SCOPED_TRACE(port);
+    // Port p is in groups p - 2 and p - 1 (mod kNumPorts)
+    BcmHostTable::Paths expected;
+    expected.insert(ecmpIds[(port + kNumPorts - 2) % kNumPorts]);
+    expected.insert(ecmpIds[(port + kNumPorts - 1) % kNumPorts]);
+    EXPECT_EQ(expected, table->getEcmpEgressIdsForPath(egressIdForPort(port)));
+  }
+
+  // A group stays indexed until its last reference goes away
+  table->incEgressReference(ecmpIds[0]);
+  table->derefEgress(ecmpIds[0]);
+  auto forPort1 = table->getEcmpEgressIdsForPath(egressIdForPort(1));
+  EXPECT_EQ(1, forPort1.count(ecmpIds[0]));
+
+  table->derefEgress(ecmpIds[0]);
+  EXPECT_EQ(kNumPorts - 1, table->numEcmpEgress());
+  forPort1 = table->getEcmpEgressIdsForPath(egressIdForPort(1));
+  EXPECT_EQ(0, forPort1.count(ecmpIds[0]));
+  EXPECT_EQ(1, forPort1.count(ecmpIds[kNumPorts - 1]));
+  EXPECT_EQ(1, table->getEcmpEgressIdsForPath(egressIdForPort(2)).size());
+
+  for (int n = 1; n < kNumPorts; ++n) {
+    table->derefEgress(ecmpIds[n]);
+  }
+  EXPECT_EQ(0, table->numEcmpEgress());
+  for (opennsl_port_t port = 1; port <= kNumPorts; ++port) {
+    EXPECT_TRUE(table->getEcmpEgressIdsForPath(egressIdForPort(port))
+                .empty());
+  }
+}
+
+TEST_F(BcmHostTableTest, LinkDownThroughIndex) {
+  auto ecmpIds = createGroups();
+  table->linkDownHwNotLocked(3);
+  EXPECT_EQ(0, numFakeEcmpTraverses);
+  checkShrunk(ecmpIds, 3);
+}
+
+// A next hop going away is handled with the HW lock held
+TEST_F(BcmHostTableTest, NextHopGoneThroughIndex) {
+  auto ecmpIds = createGroups();
+  table->updatePortEgressMapping(egressIdForPort(5), 5, 0);
+  EXPECT_EQ(0, numFakeEcmpTraverses);
+  checkShrunk(ecmpIds, 5);
+}
+
+TEST_F(BcmHostTableTest, LinkDownWarmBootPending) {
+  auto ecmpIds = createGroups();
+  // A group in HW from before the warm boot, which the table doesn't know
+  opennsl_if_t unknownPaths[] = {egressIdForPort(3), egressIdForPort(4)};
+  opennsl_l3_egress_ecmp_t unknown;
+  opennsl_l3_egress_ecmp_t_init(&unknown);
+  opennsl_l3_egress_ecmp_create(0, &unknown, 2, unknownPaths);
+
+  // Until the warm boot cache is cleared, only the traverse finds it
+  table->setWarmBootEcmpEgressPending(true);
+  table->linkDownHwNotLocked(3);
+  EXPECT_EQ(1, numFakeEcmpTraverses);
+  checkShrunk(ecmpIds, 3);
+  EXPECT_FALSE(inFakeEcmp(unknown.ecmp_intf, egressIdForPort(3)));
+  EXPECT_TRUE(inFakeEcmp(unknown.ecmp_intf, egressIdForPort(4)));
+
+  // Afterwards the index is used again, and the unknown group is left alone
+  table->setWarmBootEcmpEgressPending(false);
+  table->linkDownHwNotLocked(4);
+  EXPECT_EQ(1, numFakeEcmpTraverses);
+  EXPECT_TRUE(inFakeEcmp(unknown.ecmp_intf, egressIdForPort(4)));
+  EXPECT_FALSE(inFakeEcmp(ecmpIds[2], egressIdForPort(4)));
+  EXPECT_FALSE(inFakeEcmp(ecmpIds[3], egressIdForPort(4)));
+
+  opennsl_l3_egress_ecmp_destroy(0, &unknown);
+}
@@ -0,0 +1,250 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+extern "C" {
+#include <opennsl/error.h>
+#include <opennsl/port.h>
+#include <opennsl/stat.h>
+}
+
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include "fboss/agent/hw/bcm/BcmPlatformPort.h"
+#include "fboss/agent/hw/bcm/BcmPort.h"
+#include "fboss/agent/hw/bcm/MockBcmSwitch.h"
+
+using namespace facebook::fboss;
+using std::make_unique;
+using std::unique_ptr;
+
+/*
+ * An in-process fake of the OpenNSL port stat calls, which takes the place
+ * of the SDK's as long as this is linked ahead of it.  Every port reads the
+ * same values, and opennsl_stat_multi_get() can be made to fail so the
+ * per-stat fallback is used.
+ */
+namespace {
+
+std::map<opennsl_stat_val_t, uint64> fakeStats;
+bool failFakeMultiGet = false;
+int numFakeMultiGets = 0;
+int numFakeStatGets = 0;
+
+} // unnamed namespace
+
+extern "C" {
+
+int opennsl_port_gport_get(
+    int /*unit*/,
+    opennsl_port_t port,
+    opennsl_gport_t* gport) {
+  *gport = port;
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_port_queued_count_get(
+    int /*unit*/,
+    opennsl_port_t /*port*/,
+    uint32* count) {
+  *count = 0;
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_stat_get(
+    int /*unit*/,
+    opennsl_port_t /*port*/,
+    opennsl_stat_val_t type,
+    uint64* value) {
+  ++numFakeStatGets;
+  *value = fakeStats[type];
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_stat_multi_get(
+    int /*unit*/,
+    opennsl_port_t /*port*/,
+    int nstat,
+    opennsl_stat_val_t* stat_arr,
+    uint64* value_arr) {
+  ++numFakeMultiGets;
+  if (failFakeMultiGet) {
+    return OPENNSL_E_UNAVAIL;
+  }
+  for (int idx = 0; idx < nstat; ++idx) {
+    value_arr[idx] = fakeStats[stat_arr[idx]];
+  }
+  return OPENNSL_E_NONE;
+}
+
+}
+
+namespace {
+
+class FakeBcmSwitch : public MockBcmSwitch {
+ public:
+  int getUnit() const override {
+    return 0;
+  }
+  MmuState getMmuState() const override {
+    return MmuState::UNKNOWN;
+  }
+};
+
+class FakeBcmPlatformPort : public BcmPlatformPort {
+ public:
+  explicit FakeBcmPlatformPort(PortID id) : id_(id) {}
+
+  PortID getPortID() const override {
+    return id_;
+  }
+  void setBcmPort(BcmPort* port) override {
+    port_ = port;
+  }
+  BcmPort* getBcmPort() const override {
+    return port_;
+  }
+  LaneSpeeds supportedLaneSpeeds() const override {
+    return LaneSpeeds();
+  }
+  TransmitterTechnology getTransmitterTech() const override {
+    return TransmitterTechnology::COPPER;
+  }
+  void preDisable(bool /*temporary*/) override {}
+  void postDisable(bool /*temporary*/) override {}
+  void preEnable() override {}
+  void postEnable() override {}
+  bool isMediaPresent() override {
+    return true;
+  }
+  void linkStatusChanged(bool /*up*/, bool /*adminUp*/) override {}
+  void linkSpeedChanged(const cfg::PortSpeed& /*speed*/) override {}
+  void statusIndication(bool /*enabled*/, bool /*link*/,
+                        bool /*ingress*/, bool /*egress*/,
+                        bool /*discards*/, bool /*errors*/) override {}
+  void prepareForGracefulExit() override {}
+  bool shouldDisableFEC() const override {
+    return false;
+  }
+
+ private:
+  PortID id_;
+  BcmPort* port_{nullptr};
+};
+
+class BcmPortTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    fakeStats.clear();
+    failFakeMultiGet = false;
+    numFakeMultiGets = 0;
+    numFakeStatGets = 0;
+    platformPort = make_unique<FakeBcmPlatformPort>(PortID(1));
+    port = make_unique<BcmPort>(&hw, 1, platformPort.get());
+    platformPort->setBcmPort(port.get());
+  }
+
+  void setStats(uint64 inBytes, uint64 outUnicastPkts) {
+    fakeStats[opennsl_spl_snmpIfHCInOctets] = inBytes;
+    fakeStats[opennsl_spl_snmpIfHCOutUcastPkts] = outUnicastPkts;
+  }
+
+  // Check getPortCounters() against the increases expected since the start
+  void checkCounters(int64_t inBytes, int64_t outUnicastPkts) {
+    PortCounters input;
+    PortCounters output;
+    ASSERT_TRUE(port->getPortCounters(&input, &output));
+    EXPECT_EQ(inBytes, input.bytes);
+    EXPECT_EQ(outUnicastPkts, output.ucastPkts);
+    EXPECT_EQ(0, input.ucastPkts);
+    EXPECT_EQ(0, output.bytes);
+  }
+
+  FakeBcmSwitch hw;
+  unique_ptr<FakeBcmPlatformPort> platformPort;
+  unique_ptr<BcmPort> port;
+};
+
+} // unnamed namespace
+
+TEST_F(BcmPortTest, MultiGet) {
+  setStats(1000, 10);
+  port->updateStats();
+  // The first read is the baseline
+  checkCounters(0, 0);
+
+  setStats(1500, 25);
+  port->updateStats();
+  checkCounters(500, 15);
+  EXPECT_EQ(0, numFakeStatGets);
+}
+
+TEST_F(BcmPortTest, PerStatFallback) {
+  failFakeMultiGet = true;
+  setStats(1000, 10);
+  port->updateStats();
+  checkCounters(0, 0);
+  EXPECT_LT(0, numFakeStatGets);
+
+  setStats(1500, 25);
+  port->updateStats();
+  checkCounters(500, 15);
+
+  // Going back to the one call carries on from the same values
+  failFakeMultiGet = false;
+  numFakeStatGets = 0;
+  setStats(1600, 30);
+  port->updateStats();
+  checkCounters(600, 20);
+  EXPECT_EQ(0, numFakeStatGets);
+}
+
+TEST_F(BcmPortTest, CountersNotRead) {
+  PortCounters input;
+  PortCounters output;
+  ASSERT_TRUE(port->getPortCounters(&input, &output));
+  EXPECT_EQ(0, input.bytes);
+  EXPECT_EQ(0, output.ucastPkts);
+}
+
+TEST_F(BcmPortTest, CounterDecrease) {
+  setStats(1000, 10);
+  port->updateStats();
+  setStats(1500, 25);
+  port->updateStats();
+  checkCounters(500, 15);
+
+  // The HW counters were cleared, so the increase is only counted from the
+  // lower values
+  setStats(200, 5);
+  port->updateStats();
+  checkCounters(500, 15);
+  setStats(300, 7);
+  port->updateStats();
+  checkCounters(600, 17);
+}
+
+TEST_F(BcmPortTest, ReinitOnRename) {
+  setStats(1000, 10);
+  port->updateStats();
+  setStats(1500, 25);
+  port->updateStats();
+  checkCounters(500, 15);
+
+  // The counters start over with the stats exported under the new name
+  port->updateName("eth1/1/1");
+  checkCounters(0, 0);
+  setStats(1600, 30);
+  port->updateStats();
+  checkCounters(0, 0);
+  setStats(1700, 32);
+  port->updateStats();
+  checkCounters(100, 2);
+}
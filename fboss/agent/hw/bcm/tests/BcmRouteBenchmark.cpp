@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/IPAddress.h>
+
+extern "C" {
+#include <opennsl/error.h>
+#include <opennsl/l3.h>
+}
+
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "fboss/agent/hw/bcm/BcmRoute.h"
+#include "fboss/agent/hw/bcm/BcmWarmBootCache.h"
+#include "fboss/agent/hw/bcm/MockBcmSwitch.h"
+#include "fboss/agent/state/Route.h"
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+using std::make_shared;
+using std::make_unique;
+using std::unique_ptr;
+
+/*
+ * An in-process fake of the OpenNSL L3 route calls, which takes the place
+ * of the SDK's as long as this is linked ahead of it.  It keeps just enough
+ * state to reject the same mistakes the SDK would.
+ */
+namespace {
+
+typedef std::tuple<opennsl_vrf_t, uint32_t, uint32_t, std::string, std::string>
+  FakeRouteKey;
+std::set<FakeRouteKey> fakeRoutes;
+
+FakeRouteKey fakeRouteKey(const opennsl_l3_route_t* info) {
+  auto bytes = [](const opennsl_ip6_t& addr) {
+    return std::string(reinterpret_cast<const char*>(addr), sizeof(addr));
+  };
+  return FakeRouteKey(info->l3a_vrf, info->l3a_subnet, info->l3a_ip_mask,
+                      bytes(info->l3a_ip6_net), bytes(info->l3a_ip6_mask));
+}
+
+} // unnamed namespace
+
+extern "C" {
+
+int opennsl_l3_route_add(int /*unit*/, opennsl_l3_route_t* info) {
+  auto ret = fakeRoutes.insert(fakeRouteKey(info));
+  if (!ret.second && !(info->l3a_flags & OPENNSL_L3_REPLACE)) {
+    return OPENNSL_E_EXISTS;
+  }
+  return OPENNSL_E_NONE;
+}
+
+int opennsl_l3_route_delete(int /*unit*/, opennsl_l3_route_t* info) {
+  if (!fakeRoutes.erase(fakeRouteKey(info))) {
+    return OPENNSL_E_NOT_FOUND;
+  }
+  return OPENNSL_E_NONE;
+}
+
+}
+
+namespace {
+
+/*
+ * These benchmarks program DROP routes straight into a BcmRouteTable, so
+ * they measure the route table's own data structures plus the (fake) SDK
+ * calls, with no ECMP hosts or state deltas involved.  Three quarters of
+ * the routes are IPv4 /24s and the rest IPv6 /64s.
+ */
+const opennsl_vrf_t kVrf = 0;
+constexpr opennsl_if_t kDropEgressId = 100000;
+
+class FakeBcmSwitch : public MockBcmSwitch {
+ public:
+  FakeBcmSwitch() : warmBootCache_(this) {}
+
+  // Called for every route, so don't go through gmock for these
+  int getUnit() const override {
+    return 0;
+  }
+  opennsl_if_t getDropEgressId() const override {
+    return kDropEgressId;
+  }
+  BcmWarmBootCache* getWarmBootCache() const override {
+    return &warmBootCache_;
+  }
+
+ private:
+  mutable BcmWarmBootCache warmBootCache_;
+};
+
+unique_ptr<FakeBcmSwitch> hw;
+
+RouteBatch::Group makeGroup(uint32_t numRoutes) {
+  RouteBatch::Group group(RouterID(0), RouteForwardInfo());
+  for (uint32_t i = 0; i < numRoutes; ++i) {
+    if (i % 4) {
+      RoutePrefixV4 prefix{IPAddressV4::fromLongHBO((20 << 24) + (i << 8)),
+                           24};
+      group.v4.push_back(
+          make_shared<RouteV4>(prefix, RouteForwardAction::DROP));
+    } else {
+      auto bytes = IPAddressV6("2401:db00::").toByteArray();
+      bytes[4] = (i >> 24) & 0xff;
+      bytes[5] = (i >> 16) & 0xff;
+      bytes[6] = (i >> 8) & 0xff;
+      bytes[7] = i & 0xff;
+      RoutePrefixV6 prefix{IPAddressV6(bytes), 64};
+      group.v6.push_back(
+          make_shared<RouteV6>(prefix, RouteForwardAction::DROP));
+    }
+  }
+  return group;
+}
+
+void loadRoutes(int numIters, uint32_t numRoutes, bool reserve) {
+  folly::BenchmarkSuspender braces;
+  auto group = makeGroup(numRoutes);
+  for (int n = 0; n < numIters; ++n) {
+    auto table = make_unique<BcmRouteTable>(hw.get());
+    braces.dismiss();
+    if (reserve) {
+      table->reserve(kVrf, group.v4.size(), group.v6.size());
+    }
+    table->addRoutes(kVrf, group);
+    braces.rehire();
+    CHECK_EQ(numRoutes, table->size());
+    CHECK_EQ(numRoutes, fakeRoutes.size());
+    table.reset();
+    CHECK(fakeRoutes.empty());
+  }
+}
+
+/*
+ * Remove and re-add single routes from a full table, as route churn does.
+ */
+void churnRoutes(int numIters, uint32_t numRoutes) {
+  folly::BenchmarkSuspender braces;
+  auto group = makeGroup(numRoutes);
+  auto table = make_unique<BcmRouteTable>(hw.get());
+  table->addRoutes(kVrf, group);
+  braces.dismiss();
+  for (int n = 0; n < numIters; ++n) {
+    const auto& route = group.v4[n % group.v4.size()];
+    table->deleteRoute(kVrf, route.get());
+    table->addRoute(kVrf, route.get());
+  }
+  braces.rehire();
+  CHECK_EQ(numRoutes, table->size());
+  table.reset();
+}
+
+} // unnamed namespace
+
+void LoadRoutesNoReserve(int numIters, uint32_t numRoutes) {
+  loadRoutes(numIters, numRoutes, false);
+}
+
+void LoadRoutes(int numIters, uint32_t numRoutes) {
+  loadRoutes(numIters, numRoutes, true);
+}
+
+void ChurnRoutes(int numIters, uint32_t numRoutes) {
+  churnRoutes(numIters, numRoutes);
+}
+
+BENCHMARK_PARAM(LoadRoutesNoReserve, 10000)
+BENCHMARK_RELATIVE_PARAM(LoadRoutes, 10000)
+BENCHMARK_PARAM(LoadRoutesNoReserve, 100000)
+BENCHMARK_RELATIVE_PARAM(LoadRoutes, 100000)
+BENCHMARK_PARAM(LoadRoutesNoReserve, 500000)
+BENCHMARK_RELATIVE_PARAM(LoadRoutes, 500000)
+BENCHMARK_DRAW_LINE()
+BENCHMARK_PARAM(ChurnRoutes, 10000)
+BENCHMARK_PARAM(ChurnRoutes, 100000)
+BENCHMARK_PARAM(ChurnRoutes, 500000)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  hw = make_unique<FakeBcmSwitch>();
+  folly::runBenchmarks();
+  hw.reset();
+  return 0;
+}
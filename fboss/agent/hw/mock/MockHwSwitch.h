@@ -10,6 +10,7 @@
 #pragma once
 
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/state/RouteBatch.h"
 #include "fboss/agent/state/StateDelta.h"
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 
@@ -30,6 +31,7 @@ class MockHwSwitch : public HwSwitch {
 
   MOCK_METHOD1(init, HwInitResult(Callback*));
   MOCK_METHOD1(stateChanged, void(const StateDelta&));
+  MOCK_METHOD1(programRoutes, void(const RouteBatch&));
   MOCK_METHOD2(getAndClearNeighborHit, bool(RouterID, folly::IPAddress&));
 
   virtual std::unique_ptr<TxPacket> allocatePacket(uint32_t size) override;
@@ -33,6 +33,8 @@ MockableHwSwitch::MockableHwSwitch(MockPlatform *platform, HwSwitch* realHw)
     .WillByDefault(Invoke(realHw_, &HwSwitch::init));
   ON_CALL(*this, stateChanged(_))
     .WillByDefault(Invoke(realHw_, &HwSwitch::stateChanged));
+  ON_CALL(*this, programRoutes(_))
+    .WillByDefault(Invoke(realHw_, &HwSwitch::programRoutes));
   ON_CALL(*this, getAndClearNeighborHit(_, _))
     .WillByDefault(Invoke(realHw_, &HwSwitch::getAndClearNeighborHit));
   ON_CALL(*this, toFollyDynamic())
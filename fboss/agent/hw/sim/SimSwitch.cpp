@@ -9,6 +9,9 @@
  */
 #include "fboss/agent/hw/sim/SimSwitch.h"
 
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteBatch.h"
 #include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/hw/mock/MockRxPacket.h"
 #include "fboss/agent/hw/mock/MockTxPacket.h"
@@ -17,6 +20,7 @@
 #include <folly/dynamic.h>
 #include <folly/Memory.h>
 
+using folly::IPAddress;
 using std::make_unique;
 using std::make_shared;
 using std::shared_ptr;
@@ -25,7 +29,8 @@ using std::string;
 namespace facebook { namespace fboss {
 
 SimSwitch::SimSwitch(SimPlatform* platform, uint32_t numPorts)
-  : numPorts_(numPorts) {
+  : numPorts_(numPorts),
+    portCounters_(numPorts + 1) {
 }
 
 HwInitResult SimSwitch::init(HwSwitch::Callback* callback) {
@@ -43,7 +48,86 @@ HwInitResult SimSwitch::init(HwSwitch::Callback* callback) {
 }
 
 void SimSwitch::stateChanged(const StateDelta& delta) {
-  // TODO
+  // TODO: everything but routes
+  programRoutes(RouteBatch(delta));
+}
+
+void SimSwitch::programRoutes(const RouteBatch& batch) {
+  for (const auto& removed : batch.getRemoved()) {
+    auto removeRoute = [&](const auto& route) {
+      const auto& prefix = route->prefix();
+      auto iter = routes_.find(RouteKey{
+          removed.vrf, IPAddress(prefix.network), prefix.mask});
+      if (iter == routes_.end()) {
+        throw FbossError("Failed to delete a non-existing route ",
+                         route->str());
+      }
+      if (iter->second.action == RouteForwardAction::NEXTHOPS) {
+        derefEcmpGroup(iter->second.ecmp, 1);
+      }
+      routes_.erase(iter);
+    };
+    for (const auto& route : removed.v4) {
+      removeRoute(route);
+    }
+    for (const auto& route : removed.v6) {
+      removeRoute(route);
+    }
+  }
+
+  for (const auto& group : batch.getGroups()) {
+    auto action = group.fwd.getAction();
+    bool useEcmp = action == RouteForwardAction::NEXTHOPS;
+    // The ECMP group is looked up once for all the routes in the group
+    EcmpMap::iterator ecmp;
+    if (useEcmp) {
+      ecmp = ecmpGroups_.emplace(
+          EcmpKey{group.vrf, group.fwd.getNexthops()},
+          std::make_pair(nextEcmpID_, 0)).first;
+      if (ecmp->second.first == nextEcmpID_) {
+        ++nextEcmpID_;
+      }
+    }
+    uint32_t refs = 0;
+    auto addRoute = [&](const auto& route) {
+      const auto& prefix = route->prefix();
+      auto ret = routes_.emplace(
+          RouteKey{group.vrf, IPAddress(prefix.network), prefix.mask},
+          SimRoute{action, ecmp});
+      auto& simRoute = ret.first->second;
+      if (!ret.second) {
+        if (simRoute.action == action &&
+            (!useEcmp || simRoute.ecmp == ecmp)) {
+          return;
+        }
+        if (simRoute.action == RouteForwardAction::NEXTHOPS) {
+          derefEcmpGroup(simRoute.ecmp, 1);
+        }
+        simRoute = SimRoute{action, ecmp};
+      }
+      ++refs;
+    };
+    for (const auto& route : group.v4) {
+      addRoute(route);
+    }
+    for (const auto& route : group.v6) {
+      addRoute(route);
+    }
+    if (useEcmp) {
+      ecmp->second.second += refs;
+      if (ecmp->second.second == 0) {
+        ecmpGroups_.erase(ecmp);
+      }
+    }
+  }
+}
+
+void SimSwitch::derefEcmpGroup(EcmpMap::iterator ecmp, uint32_t count) {
+  CHECK_GE(ecmp->second.second, count);
+  ecmp->second.second -= count;
+  if (ecmp->second.second == 0) {
+    ecmpGroups_.erase(ecmp);
+  }
 }
 
 std::unique_ptr<TxPacket> SimSwitch::allocatePacket(uint32_t size) {
@@ -61,12 +145,55 @@ bool SimSwitch::sendPacketOutOfPort(
     PortID portID) noexcept {
   // TODO
   ++txCount_;
+  if (auto counters = portCounters(portID)) {
+    counters->outBytes += pkt->buf()->computeChainDataLength();
+    ++counters->outPkts;
+  }
   return true;
 }
+
 void SimSwitch::injectPacket(std::unique_ptr<RxPacket> pkt) {
+  if (auto counters = portCounters(pkt->getSrcPort())) {
+    counters->inBytes += pkt->getLength();
+    ++counters->inPkts;
+  }
   callback_->packetReceived(std::move(pkt));
 }
 
+int SimSwitch::getHighresSamplers(
+    HighresSamplerList* samplers,
+    const std::string& namespaceString,
+    const std::set<CounterRequest>& counterSet) {
+  if (namespaceString != PortCounterSampler::kIdentifier) {
+    return 0;
+  }
+  auto sampler = make_unique<PortCounterSampler>(
+      counterSet, [this](PortID port, uint64_t* values) {
+        auto counters = portCounters(port);
+        if (!counters) {
+          return false;
+        }
+        values[PortCounterSampler::IN_BYTES] = counters->inBytes;
+        values[PortCounterSampler::IN_PKTS] = counters->inPkts;
+        values[PortCounterSampler::OUT_BYTES] = counters->outBytes;
+        values[PortCounterSampler::OUT_PKTS] = counters->outPkts;
+        return true;
+      });
+  auto numCounters = sampler->numCounters();
+  if (numCounters > 0) {
+    samplers->push_back(std::move(sampler));
+  }
+  return numCounters;
+}
+
+SimSwitch::SimPortCounters* SimSwitch::portCounters(PortID port) {
+  auto idx = static_cast<uint16_t>(port);
+  if (idx == 0 || idx > numPorts_) {
+    return nullptr;
+  }
+  return &portCounters_[idx];
+}
+
 folly::dynamic SimSwitch::toFollyDynamic() const {
   return folly::dynamic::object;
 }
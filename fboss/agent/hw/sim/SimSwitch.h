@@ -9,7 +9,15 @@
  */
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include <folly/IPAddress.h>
+
 #include "fboss/agent/HwSwitch.h"
+#include "fboss/agent/state/RouteForwardInfo.h"
 
 namespace facebook { namespace fboss {
 
@@ -21,6 +29,7 @@ class SimSwitch : public HwSwitch {
 
   HwInitResult init(Callback* callback) override;
   void stateChanged(const StateDelta& delta) override;
+  void programRoutes(const RouteBatch& batch) override;
   std::unique_ptr<TxPacket> allocatePacket(uint32_t size) override;
   bool sendPacketSwitched(std::unique_ptr<TxPacket> pkt) noexcept override;
   bool sendPacketOutOfPort(
@@ -46,9 +55,7 @@ class SimSwitch : public HwSwitch {
 
   int getHighresSamplers(HighresSamplerList* samplers,
                          const std::string& namespaceString,
-                         const std::set<CounterRequest>& counterSet) override {
-    return 0;
-  }
+                         const std::set<CounterRequest>& counterSet) override;
 
   void fetchL2Table(std::vector<L2EntryThrift> *l2Table) override {
     return;
@@ -80,14 +87,53 @@ class SimSwitch : public HwSwitch {
     return true;
   }
 
+  /*
+   * The simulated route table: the number of routes programmed, and of the
+   * ECMP groups they point to.
+   */
+  size_t getNumRoutes() const {
+    return routes_.size();
+  }
+  size_t getNumEcmpGroups() const {
+    return ecmpGroups_.size();
+  }
+
  private:
   // Forbidden copy constructor and assignment operator
   SimSwitch(SimSwitch const &) = delete;
   SimSwitch& operator=(SimSwitch const &) = delete;
 
+  // Counted for each packet injected or sent out of a port
+  struct SimPortCounters {
+    std::atomic<uint64_t> inBytes{0};
+    std::atomic<uint64_t> inPkts{0};
+    std::atomic<uint64_t> outBytes{0};
+    std::atomic<uint64_t> outPkts{0};
+  };
+
+  typedef std::pair<RouterID, RouteForwardNexthops> EcmpKey;
+  // ECMP group ID and reference count
+  typedef std::map<EcmpKey, std::pair<uint32_t, uint32_t>> EcmpMap;
+  typedef std::tuple<RouterID, folly::IPAddress, uint8_t> RouteKey;
+  struct SimRoute {
+    RouteForwardAction action;
+    // Only valid for RouteForwardAction::NEXTHOPS
+    EcmpMap::iterator ecmp;
+  };
+
+  void derefEcmpGroup(EcmpMap::iterator ecmp, uint32_t count);
+  // The port's counters, or nullptr if there is no such port
+  SimPortCounters* portCounters(PortID port);
+
   HwSwitch::Callback* callback_{nullptr};
   uint32_t numPorts_{0};
-  uint64_t txCount_{0};
+  // Updated from the PacketDispatcher threads, if there are any
+  std::atomic<uint64_t> txCount_{0};
+  // Indexed by PortID, so entry 0 is unused
+  std::vector<SimPortCounters> portCounters_;
+  std::map<RouteKey, SimRoute> routes_;
+  EcmpMap ecmpGroups_;
+  uint32_t nextEcmpID_{1};
 };
 
 }} // facebook::fboss
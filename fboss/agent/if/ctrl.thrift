@@ -56,6 +56,69 @@ struct RouteDetails {
   6: optional AdminDistance adminDistance,
 }
 
+/*
+ * Where a paged route table dump resumes: the switch state it is read from,
+ * and the last route returned so far.
+ */
+struct RouteTableCursor {
+  1: i64 snapshotId,
+  2: i32 vrf,
+  3: IpPrefix lastPrefix,
+}
+
+struct RouteTablePageRequest {
+  // From the previous page, unset to start a new dump
+  1: optional RouteTableCursor cursor,
+  2: i32 maxRoutes = 1000,
+  // Only the routes within this prefix
+  3: optional IpPrefix prefix,
+  // Only the routes this client has nexthops for, as getRouteTableByClient
+  4: optional i16 clientId,
+  // Fill in routeDetails, as getRouteTableDetails, rather than routes
+  5: bool details = false,
+}
+
+struct RouteTablePage {
+  1: list<UnicastRoute> routes,
+  2: list<RouteDetails> routeDetails,
+  // Pass this back for the next page, unset after the last page
+  3: optional RouteTableCursor cursor,
+  // The generation of the switch state the dump is read from
+  4: i64 generation,
+}
+
+enum RouteChangeType {
+  ADDED = 1,
+  CHANGED = 2,
+  REMOVED = 3,
+}
+
+struct RouteChange {
+  1: RouteChangeType type,
+  2: i32 vrf,
+  3: IpPrefix prefix,
+  // The route as it is now, unset for REMOVED
+  4: optional RouteDetails route,
+}
+
+/*
+ * The routes that changed since the last batch sent to a subscriber, at most
+ * one change per route.
+ */
+struct RouteChangeBatch {
+  // The generation of the switch state the changes bring the routes up to
+  1: i64 generation,
+  2: list<RouteChange> changes,
+  // Changes were dropped because the subscriber fell too far behind, and it
+  // has to dump the route table again
+  3: bool resyncNeeded = false,
+}
+
+struct RouteChangeSubscription {
+  // Only the routes within this prefix
+  1: optional IpPrefix prefix,
+}
+
 struct ArpEntryThrift {
   1: string mac,
   2: i32 port,
@@ -195,6 +258,18 @@ struct CaptureInfo {
    * large number of packets.
    */
   2: i32 maxPackets
+  /*
+   * Only capture packets matching this filter, in the pcap-filter(7) syntax
+   * used by tcpdump.  Packets are matched as captured, so tagged packets
+   * need a "vlan" qualifier, e.g. "vlan and arp".  An empty filter captures
+   * every packet.
+   */
+  3: string filter
+  /*
+   * Only keep the first snaplen bytes of each packet.  0 keeps the whole
+   * packet.
+   */
+  4: i32 snaplen
 }
 
 struct RouteUpdateLoggingInfo {
@@ -347,6 +422,14 @@ service FbossCtrl extends fb303.FacebookService {
     throws (1: fboss.FbossBaseError error)
   void registerForNeighborChanged()
     throws (1: fboss.FbossBaseError error) (thread='eb')
+  /*
+   * Stream the route changes to this connection, as RouteChangeBatches sent
+   * to RouteChangeListenerClient.  To keep a copy of the routes, register
+   * first and then dump the route table with getRouteTablePage; batches up
+   * to the dump's generation are already in it, and the rest apply on top.
+   */
+  void registerForRouteChanges(1: RouteChangeSubscription subscription)
+    throws (1: fboss.FbossBaseError error) (thread='eb')
   list<string> getInterfaceList()
     throws (1: fboss.FbossBaseError error)
   /*
@@ -359,6 +442,15 @@ service FbossCtrl extends fb303.FacebookService {
     throws (1: fboss.FbossBaseError error)
   list<RouteDetails> getRouteTableDetails()
     throws (1: fboss.FbossBaseError error)
+  /*
+   * The route table, a page at a time.  All the pages of a dump come from
+   * the switch state of the first, so routes aren't missed or repeated
+   * when the table changes in between.  That state is released after the
+   * last page, or if the next page isn't asked for within
+   * --route_table_snapshot_timeout seconds.
+   */
+  RouteTablePage getRouteTablePage(1: RouteTablePageRequest request)
+    throws (1: fboss.FbossBaseError error)
   InterfaceDetail getInterfaceDetail(1: i32 interfaceId)
     throws (1: fboss.FbossBaseError error)
 
@@ -475,3 +567,15 @@ service NeighborListenerClient extends fb303.FacebookService {
   void neighborsChanged(1: list<string> added, 2: list<string> removed)
     throws (1: fboss.FbossBaseError error)
 }
+
+service RouteChangeListenerClient extends fb303.FacebookService {
+  /*
+   * Sends the routes that have changed to the subscriber.
+   *
+   * Only one batch is outstanding at a time, and the changes made while it
+   * is are merged into the next.  Apply ADDED and CHANGED routes as
+   * replacing any route to the prefix, and REMOVED as removing it if there.
+   */
+  void routesChanged(1: RouteChangeBatch batch)
+    throws (1: fboss.FbossBaseError error)
+}
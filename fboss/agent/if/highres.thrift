@@ -11,6 +11,13 @@ enum SleepMethod {
   PAUSE = 1,
 }
 
+enum PublicationFormat {
+  // CounterPublications, sent with publishCounters()
+  STRUCT = 0,
+  // CompactCounterPublications, sent with publishCompactCounters()
+  COMPACT = 1,
+}
+
 struct CounterRequest {
   1 : string namespaceName,
   2 : string counterName,
@@ -37,7 +44,11 @@ struct CounterSubscribeRequest {
   // Whether to lower the priority of the sampling thread
   7 : bool veryNice,
 
-  8 : set<CounterRequest> counterSet
+  8 : set<CounterRequest> counterSet,
+
+  // The publication formats the client can receive.  The server uses the
+  // most compact of them that it supports, or STRUCT if none are given.
+  9 : list<PublicationFormat> formats,
 }
 
 struct HighresTime {
@@ -57,6 +68,36 @@ struct CounterPublication {
   4: map<CounterRequest,list<i64>> counterValues,
 }
 
+/*
+ * A batch of samples in the COMPACT format.  Each counter is given an id, its
+ * index in the counters list sent with the first publication, and its values
+ * are sent as a column: all the values of counter 0, then of counter 1, etc.
+ *
+ * Times and values are delta encoded: each time is sent as the difference
+ * from the one before it, and each value as the difference from the same
+ * counter's value before it, carrying on from the previous publication.  The
+ * first time and values of a subscription are sent as differences from 0.
+ * Every difference is then zigzag and varint encoded.
+ */
+struct CompactCounterPublication {
+  // Full hostname of the publishing server
+  1: string hostname,
+  // The position of this publication in the subscription, starting at 0.
+  // The deltas can't be decoded if a publication is missed.
+  2: i64 seqNum,
+  // The counters in the order of the value columns.  Only sent in the first
+  // publication; empty in the rest.
+  3: list<CounterRequest> counters,
+  // The number of samples in this batch
+  4: i32 numSamples,
+  // The sample times, in nanoseconds since the epoch
+  5: binary times,
+  // The columns of sample values
+  6: binary values,
+}
+
 service FbossHighresClient {
   oneway void publishCounters(1: CounterPublication pub) (thread='eb')
+  oneway void publishCompactCounters(1: CompactCounterPublication pub)
+    (thread='eb')
 }
@@ -16,7 +16,8 @@ namespace facebook { namespace fboss {
 std::pair<std::shared_ptr<SwitchState>, std::string>  applyThriftConfigDefault(
     std::shared_ptr<SwitchState>,
     const Platform*,
-    const cfg::SwitchConfig* prevConfig) {
+    const cfg::SwitchConfig* prevConfig,
+    cfg::SwitchConfig*) {
   throw FbossError("Must specify a configuration file with --config");
 }
 
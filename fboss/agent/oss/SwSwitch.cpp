@@ -8,6 +8,7 @@
  *
  */
 #include "fboss/agent/SwSwitch.h"
+#include "common/stats/ThreadCachedServiceData.h"
 #include <folly/Range.h>
 #include <folly/ThreadName.h>
 
@@ -26,7 +27,9 @@ void SwSwitch::initThread(folly::StringPiece name) {
 
 void SwSwitch::publishInitTimes(std::string name, const float& time) {}
 
-void SwSwitch::publishStats() {}
+void SwSwitch::publishStats() {
+  stats::ThreadCachedServiceData::get()->publishStats();
+}
 
 void SwSwitch::publishSwitchInfo(struct HwInitResult hwInitRet) {}
 
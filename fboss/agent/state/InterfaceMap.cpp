@@ -8,8 +8,10 @@
  *
  */
 #include "fboss/agent/state/InterfaceMap.h"
+#include <algorithm>
 #include <string>
 #include <folly/Conv.h>
+#include <folly/Hash.h>
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/NodeMap-defs.h"
 
@@ -24,8 +26,63 @@ InterfaceMap::InterfaceMap() {
 InterfaceMap::~InterfaceMap() {
 }
 
+namespace {
+// Addresses which folly::IPAddress considers equal to, or in a subnet of, an
+// address of the other family
+bool isCrossFamily(const IPAddress& addr) {
+  return addr.isV6() && (addr.asV6().isIPv4Mapped() || addr.asV6().is6To4());
+}
+}
+
+size_t InterfaceMap::AddrKeyHash::operator()(const AddrKey& key) const {
+  size_t hash = std::hash<IPAddress>()(key.addr);
+  folly::hash::hash_combine(hash, static_cast<uint32_t>(key.router),
+                            key.mask);
+  return hash;
+}
+
+void InterfaceMap::publish() {
+  if (isPublished()) {
+    return;
+  }
+  NodeMapT::publish();
+  buildIndex();
+}
+
+void InterfaceMap::buildIndex() {
+  size_t order = 0;
+  for (const auto& intf : *this) {
+    RouterID router = intf->getRouterID();
+    for (const auto& addr : intf->getAddresses()) {
+      if (isCrossFamily(addr.first)) {
+        addrs_.clear();
+        subnets_.clear();
+        subnetMasks_.clear();
+        vlans_.clear();
+        return;
+      }
+      addrs_.emplace(AddrKey(router, addr.first, addr.first.bitCount()), intf);
+      subnets_.emplace(
+          AddrKey(router, addr.first.mask(addr.second), addr.second),
+          Subnet{IntfAddrToReach(intf.get(), &addr.first, addr.second),
+                 order++});
+      auto& masks = subnetMasks_[router];
+      auto mask = std::make_pair(addr.first.isV4(), addr.second);
+      if (std::find(masks.begin(), masks.end(), mask) == masks.end()) {
+        masks.push_back(mask);
+      }
+    }
+    vlans_.emplace(intf->getVlanID(), intf);
+  }
+  indexed_ = true;
+}
+
 std::shared_ptr<Interface>
 InterfaceMap::getInterfaceIf(RouterID router, const IPAddress& ip) const {
+  if (indexed_ && !isCrossFamily(ip)) {
+    auto it = addrs_.find(AddrKey(router, ip, ip.bitCount()));
+    return it != addrs_.end() ? it->second : nullptr;
+  }
   for (auto itr = begin(); itr != end(); ++itr) {
     if ((*itr)->getRouterID() == router && (*itr)->hasAddress(ip)) {
       return *itr;
@@ -36,6 +93,13 @@ InterfaceMap::getInterfaceIf(RouterID router, const IPAddress& ip) const {
 
 const std::shared_ptr<Interface>&
 InterfaceMap::getInterface(RouterID router, const IPAddress& ip) const {
+  if (indexed_ && !isCrossFamily(ip)) {
+    auto it = addrs_.find(AddrKey(router, ip, ip.bitCount()));
+    if (it != addrs_.end()) {
+      return it->second;
+    }
+    throw FbossError("No interface with ip : ", ip);
+  }
   for (auto itr = begin(); itr != end(); ++itr) {
     if ((*itr)->getRouterID() == router && (*itr)->hasAddress(ip)) {
       return *itr;
@@ -46,6 +110,10 @@ InterfaceMap::getInterface(RouterID router, const IPAddress& ip) const {
 
 std::shared_ptr<Interface>
 InterfaceMap::getInterfaceInVlanIf(VlanID vlan) const {
+  if (indexed_) {
+    auto it = vlans_.find(vlan);
+    return it != vlans_.end() ? it->second : nullptr;
+  }
   for (auto itr = begin(); itr != end(); ++itr) {
     if ((*itr)->getVlanID() == vlan ) {
       return *itr;
@@ -65,6 +133,30 @@ InterfaceMap::getInterfaceInVlan(VlanID vlan) const {
 
 InterfaceMap::IntfAddrToReach InterfaceMap::getIntfAddrToReach(
     RouterID router, const folly::IPAddress& dest) const {
+  if (!indexed_ || isCrossFamily(dest)) {
+    return getIntfAddrToReachSlow(router, dest);
+  }
+  auto masks = subnetMasks_.find(router);
+  if (masks == subnetMasks_.end()) {
+    return IntfAddrToReach(nullptr, nullptr, 0);
+  }
+  const Subnet* found = nullptr;
+  for (const auto& mask : masks->second) {
+    if (mask.first != dest.isV4()) {
+      continue;
+    }
+    auto it = subnets_.find(
+        AddrKey(router, dest.mask(mask.second), mask.second));
+    if (it != subnets_.end() &&
+        (!found || it->second.order < found->order)) {
+      found = &it->second;
+    }
+  }
+  return found ? found->intfAddr : IntfAddrToReach(nullptr, nullptr, 0);
+}
+
+InterfaceMap::IntfAddrToReach InterfaceMap::getIntfAddrToReachSlow(
+    RouterID router, const folly::IPAddress& dest) const {
   for (auto iter = begin(); iter != end(); iter++) {
     const auto& intf = *iter;
     if (intf->getRouterID() == router) {
@@ -8,6 +8,7 @@
  *
  */
 #pragma once
+#include <unordered_map>
 #include <vector>
 #include <folly/IPAddress.h>
 #include "fboss/agent/types.h"
@@ -99,6 +100,12 @@ class InterfaceMap : public NodeMapT<InterfaceMap, InterfaceMapTraits> {
     addNode(interface);
   }
 
+  /*
+   * Publish the map, and build the lookup index used by the address and
+   * VLAN lookups above.
+   */
+  void publish() override;
+
   /*
    * Serialize to a folly::dynamic object
    */
@@ -118,6 +125,48 @@ class InterfaceMap : public NodeMapT<InterfaceMap, InterfaceMapTraits> {
   // Inherit the constructors required for clone()
   using NodeMapT::NodeMapT;
   friend class CloneAllocator;
+
+  struct AddrKey {
+    AddrKey(RouterID router, const folly::IPAddress& addr, uint8_t mask)
+      : router(router), addr(addr), mask(mask) {}
+    bool operator==(const AddrKey& other) const {
+      return router == other.router && mask == other.mask &&
+        addr == other.addr;
+    }
+    RouterID router;
+    folly::IPAddress addr;
+    uint8_t mask;
+  };
+  struct AddrKeyHash {
+    size_t operator()(const AddrKey& key) const;
+  };
+  struct Subnet {
+    IntfAddrToReach intfAddr;
+    // Where the address comes in the linear scan, to pick the same one
+    // the scan would when subnets overlap
+    size_t order;
+  };
+
+  void buildIndex();
+  IntfAddrToReach getIntfAddrToReachSlow(
+      RouterID router, const folly::IPAddress& dest) const;
+
+  /*
+   * Lookup index, built once when the map is published and never changed
+   * after that, so it is safe to read from any thread.  Unpublished maps
+   * (and maps with IPv4-mapped IPv6 interface addresses, which the index
+   * doesn't handle) do linear scans instead.
+   *
+   * addrs_ holds every interface address (as a /32 or /128), subnets_ every
+   * interface subnet, and subnetMasks_ the distinct subnet masks (and
+   * whether they are for IPv4) of each router.
+   */
+  bool indexed_{false};
+  std::unordered_map<AddrKey, std::shared_ptr<Interface>, AddrKeyHash> addrs_;
+  std::unordered_map<AddrKey, Subnet, AddrKeyHash> subnets_;
+  std::unordered_map<uint32_t, std::vector<std::pair<bool, uint8_t>>>
+    subnetMasks_;
+  std::unordered_map<uint16_t, std::shared_ptr<Interface>> vlans_;
 };
 
 }} // facebook::fboss
@@ -85,30 +85,26 @@ void NeighborTable<IPADDR, ENTRY, SUBCLASS>::updateEntry(
     PortID port,
     InterfaceID intfID) {
   CHECK(!this->isPublished());
-  auto& nodes = this->writableNodes();
-  auto it = nodes.find(ip);
-  if (it == nodes.end()) {
+  auto entry = this->getNodeIf(ip);
+  if (!entry) {
     throw FbossError("Neighbor entry for ", ip, " does not exist");
   }
-  auto entry = it->second->clone();
+  entry = entry->clone();
   entry->setMAC(mac);
   entry->setPort(port);
   entry->setIntfID(intfID);
   entry->setState(NeighborState::REACHABLE);
-  it->second = entry;
+  this->updateNode(entry);
 }
 
 template <typename IPADDR, typename ENTRY, typename SUBCLASS>
 void NeighborTable<IPADDR, ENTRY, SUBCLASS>::updateEntry(
     AddressType ip,
     std::shared_ptr<ENTRY> newEntry) {
-  auto& nodes = this->writableNodes();
-  auto it = nodes.find(ip);
-  if (it == nodes.end()) {
+  if (!this->getNodeIf(ip)) {
     throw FbossError("Neighbor entry for ", ip, " does not exist");
   }
-  it->second = newEntry;
-  return;
+  this->updateNode(newEntry);
 }
 
 template<typename IPADDR, typename ENTRY, typename SUBCLASS>
@@ -53,28 +53,31 @@ NodeMapT<MapTypeT, TraitsT>::getNodeIf(KeyType key) const {
 
 template <typename MapTypeT, typename TraitsT>
 void NodeMapT<MapTypeT, TraitsT>::addNode(const std::shared_ptr<Node>& node) {
-  auto& nodes = writableNodes();
-  auto ret = nodes.insert(std::make_pair(TraitsT::getKey(node), node));
+  auto fields = this->writableFields();
+  auto key = TraitsT::getKey(node);
+  auto ret = fields->nodes.insert(std::make_pair(key, node));
   if (!ret.second) {
-    throw FbossError("duplicate node ID ", TraitsT::getKey(node));
+    throw FbossError("duplicate node ID ", key);
   }
+  fields->unpublishedKeys.push_back(std::move(key));
 }
 
 template <typename MapTypeT, typename TraitsT>
 void
 NodeMapT<MapTypeT, TraitsT>::updateNode(const std::shared_ptr<Node>& node) {
-  auto& nodes = writableNodes();
-  auto it = nodes.find(TraitsT::getKey(node));
-  if (it == nodes.end()) {
+  auto fields = this->writableFields();
+  auto it = fields->nodes.find(TraitsT::getKey(node));
+  if (it == fields->nodes.end()) {
     throw FbossError("node ID ", TraitsT::getKey(node), " does not exist");
   }
   it->second = node;
+  fields->unpublishedKeys.push_back(it->first);
 }
 
 template <typename MapTypeT, typename TraitsT>
 void NodeMapT<MapTypeT, TraitsT>::removeNode(
     const std::shared_ptr<Node>& node) {
-  auto& nodes = writableNodes();
+  auto& nodes = this->writableFields()->nodes;
   auto it = nodes.find(TraitsT::getKey(node));
   if (it == nodes.end()) {
     throw FbossError("node ID ", TraitsT::getKey(node), " does not exist");
@@ -95,7 +98,7 @@ NodeMapT<MapTypeT, TraitsT>::removeNode(const KeyType& key) {
 template <typename MapTypeT, typename TraitsT>
 std::shared_ptr<typename TraitsT::Node>
 NodeMapT<MapTypeT, TraitsT>::removeNodeIf(const KeyType& key) {
-  auto& nodes = writableNodes();
+  auto& nodes = this->writableFields()->nodes;
   auto it = nodes.find(key);
   if (it == nodes.end()) {
     return nullptr;
@@ -105,6 +108,33 @@ NodeMapT<MapTypeT, TraitsT>::removeNodeIf(const KeyType& key) {
   return node;
 }
 
+template <typename MapTypeT, typename TraitsT>
+void NodeMapT<MapTypeT, TraitsT>::publish() {
+  if (this->isPublished()) {
+    return;
+  }
+  auto publishChild = [](NodeBase* child) {
+    child->publish();
+  };
+  auto fields = this->writableFields();
+  if (fields->allUnpublished) {
+    fields->forEachChild(publishChild);
+  } else {
+    // Nodes may have been removed again since they were added
+    for (const auto& key : fields->unpublishedKeys) {
+      auto it = fields->nodes.find(key);
+      if (it != fields->nodes.end()) {
+        publishChild(it->second.get());
+      }
+    }
+    fields->extra.forEachChild(publishChild);
+  }
+  // Release the memory too, published maps never need it again
+  std::vector<KeyType>().swap(fields->unpublishedKeys);
+  fields->allUnpublished = false;
+  NodeBase::publish();
+}
+
 template <typename MapTypeT, typename TraitsT>
 folly::dynamic NodeMapT<MapTypeT, TraitsT>::toFollyDynamic() const {
   folly::dynamic nodesJson = folly::dynamic::array;
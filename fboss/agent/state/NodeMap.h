@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <vector>
+
 #include <boost/container/flat_map.hpp>
 
 #include "fboss/agent/state/NodeBase.h"
@@ -30,7 +32,8 @@ struct NodeMapFields {
   NodeMapFields() {}
   NodeMapFields(const NodeMapFields& other, NodeContainer nodes)
     : nodes(std::move(nodes)),
-      extra(other.extra) {}
+      extra(other.extra),
+      allUnpublished(true) {}
 
   template<typename Fn>
   void forEachChild(Fn fn) {
@@ -42,6 +45,16 @@ struct NodeMapFields {
 
   NodeContainer nodes;
   typename TraitsT::ExtraFields extra;
+
+  /*
+   * The keys of the nodes added or replaced since the map was cloned.  All
+   * the other nodes came from the published map it was cloned from, so these
+   * are the only ones publish() needs to visit.  allUnpublished is set when
+   * the nodes were changed without going through NodeMapT, in which case
+   * publish() visits all of them.
+   */
+  std::vector<KeyType> unpublishedKeys;
+  bool allUnpublished{false};
 };
 
 struct NodeMapNoExtraFields {
@@ -100,8 +113,14 @@ class NodeMapT : public NodeBaseT<MapTypeT,
   const NodeContainer& getAllNodes() const {
     return this->getFields()->nodes;
   }
+  /*
+   * Changes made through the returned container are not tracked, so the
+   * next publish() has to visit every node.  Prefer addNode()/updateNode().
+   */
   NodeContainer& writableNodes() {
-    return this->writableFields()->nodes;
+    auto fields = this->writableFields();
+    fields->allUnpublished = true;
+    return fields->nodes;
   }
 
   const ExtraFields& getExtraFields() const {
@@ -136,6 +155,12 @@ class NodeMapT : public NodeBaseT<MapTypeT,
   std::shared_ptr<Node> removeNode(const KeyType& key);
   std::shared_ptr<Node> removeNodeIf(const KeyType& key);
 
+  /*
+   * Publish the map, visiting only the nodes which were added or replaced
+   * since it was cloned.
+   */
+  void publish() override;
+
   /*
    * Serialize to folly::dynamic
    */
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/RouteBatch.h"
+
+#include <map>
+#include <tuple>
+
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteDelta.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/StateDelta.h"
+
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+
+namespace facebook { namespace fboss {
+
+namespace {
+
+typedef std::tuple<RouterID, RouteForwardAction, RouteForwardNexthops>
+  GroupKey;
+typedef std::map<GroupKey, size_t> GroupIndex;
+
+template<typename ListT>
+RouteBatch::RouteList<IPAddressV4>& routesFor(ListT* list,
+                                              const IPAddressV4& /*addr*/) {
+  return list->v4;
+}
+
+template<typename ListT>
+RouteBatch::RouteList<IPAddressV6>& routesFor(ListT* list,
+                                              const IPAddressV6& /*addr*/) {
+  return list->v6;
+}
+
+template<typename AddrT>
+void addToGroup(RouterID vrf, const std::shared_ptr<Route<AddrT>>& route,
+                std::vector<RouteBatch::Group>* groups, GroupIndex* index) {
+  const auto& fwd = route->getForwardInfo();
+  GroupKey key{vrf, fwd.getAction(), fwd.getNexthops()};
+  auto ret = index->emplace(std::move(key), groups->size());
+  if (ret.second) {
+    groups->emplace_back(vrf, fwd);
+  }
+  auto& group = (*groups)[ret.first->second];
+  routesFor(&group, route->prefix().network).push_back(route);
+}
+
+template<typename AddrT>
+void addRibDelta(RouterID vrf, const RibDelta<AddrT>& delta,
+                 RouteBatch::Removed* removed,
+                 std::vector<RouteBatch::Group>* groups, GroupIndex* index) {
+  for (const auto& entry : delta) {
+    const auto& oldRoute = entry.getOld();
+    const auto& newRoute = entry.getNew();
+    if (newRoute && newRoute->isResolved()) {
+      addToGroup(vrf, newRoute, groups, index);
+    } else if (oldRoute && oldRoute->isResolved()) {
+      routesFor(removed, oldRoute->prefix().network).push_back(oldRoute);
+    }
+  }
+}
+
+} // anonymous namespace
+
+RouteBatch::RouteBatch(const StateDelta& delta) {
+  GroupIndex index;
+  for (const auto& rtDelta : delta.getRouteTablesDelta()) {
+    auto vrf = rtDelta.getOld() ? rtDelta.getOld()->getID() :
+      rtDelta.getNew()->getID();
+    Removed removed(vrf);
+    addRibDelta(vrf, rtDelta.getRoutesV4Delta(), &removed, &groups_, &index);
+    addRibDelta(vrf, rtDelta.getRoutesV6Delta(), &removed, &groups_, &index);
+    if (removed.size()) {
+      removed_.push_back(std::move(removed));
+    }
+  }
+}
+
+size_t RouteBatch::numRemoved() const {
+  size_t count = 0;
+  for (const auto& removed : removed_) {
+    count += removed.size();
+  }
+  return count;
+}
+
+size_t RouteBatch::numAddedOrChanged() const {
+  size_t count = 0;
+  for (const auto& group : groups_) {
+    count += group.size();
+  }
+  return count;
+}
+
+}} // facebook::fboss
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+
+#include "fboss/agent/types.h"
+#include "fboss/agent/state/RouteForwardInfo.h"
+
+namespace facebook { namespace fboss {
+
+template<typename AddrT>
+class Route;
+class StateDelta;
+
+/*
+ * RouteBatch is the list of route changes a HwSwitch has to program for a
+ * StateDelta, flattened out of the per-VRF RIB deltas.
+ *
+ * Routes which are added or changed are grouped by VRF and forwarding info,
+ * so all the routes using the same set of nexthops end up next to each other
+ * no matter which address family they are in.  This lets an implementation
+ * look up (or create) the ECMP object for a group once, rather than once per
+ * route.
+ *
+ * Only resolved routes are programmed, so unresolved routes are left out of
+ * the batch and a route which changed to unresolved is listed as removed.
+ */
+class RouteBatch {
+ public:
+  template<typename AddrT>
+  using RouteList = std::vector<std::shared_ptr<Route<AddrT>>>;
+
+  /*
+   * Routes to add or change, all with the same forwarding info.
+   */
+  struct Group {
+    Group(RouterID vrf, const RouteForwardInfo& fwd)
+      : vrf(vrf),
+        fwd(fwd) {}
+
+    size_t size() const {
+      return v4.size() + v6.size();
+    }
+
+    RouterID vrf;
+    RouteForwardInfo fwd;
+    RouteList<folly::IPAddressV4> v4;
+    RouteList<folly::IPAddressV6> v6;
+  };
+
+  /*
+   * Routes to remove from one VRF.  These are the old versions of the routes.
+   */
+  struct Removed {
+    explicit Removed(RouterID vrf) : vrf(vrf) {}
+
+    size_t size() const {
+      return v4.size() + v6.size();
+    }
+
+    RouterID vrf;
+    RouteList<folly::IPAddressV4> v4;
+    RouteList<folly::IPAddressV6> v6;
+  };
+
+  RouteBatch() {}
+  explicit RouteBatch(const StateDelta& delta);
+
+  const std::vector<Removed>& getRemoved() const {
+    return removed_;
+  }
+  const std::vector<Group>& getGroups() const {
+    return groups_;
+  }
+
+  size_t numRemoved() const;
+  size_t numAddedOrChanged() const;
+  bool empty() const {
+    return removed_.empty() && groups_.empty();
+  }
+
+ private:
+  std::vector<Removed> removed_;
+  std::vector<Group> groups_;
+};
+
+}} // facebook::fboss
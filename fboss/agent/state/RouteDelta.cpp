@@ -15,17 +15,98 @@
 
 namespace facebook { namespace fboss {
 
+template<typename AddrT>
+RibDelta<AddrT>::Iterator::Iterator(const Rib* oldRib, const Rib* newRib)
+  : oldNode_(oldRib ? oldRib->routes().root() : nullptr),
+    newNode_(newRib ? newRib->routes().root() : nullptr) {
+  advance();
+}
+
+template<typename AddrT>
+RibDelta<AddrT>::Iterator::Iterator() {}
+
+template<typename AddrT>
+int RibDelta<AddrT>::Iterator::compareNodes() const {
+  // A finished walk sorts after everything still pending on the other side
+  if (!oldNode_) {
+    return 1;
+  }
+  if (!newNode_) {
+    return -1;
+  }
+  const auto& oldAddr = oldNode_->ipAddress();
+  const auto& newAddr = newNode_->ipAddress();
+  if (oldAddr != newAddr) {
+    return oldAddr < newAddr ? -1 : 1;
+  }
+  if (oldNode_->masklen() != newNode_->masklen()) {
+    return oldNode_->masklen() < newNode_->masklen() ? -1 : 1;
+  }
+  return 0;
+}
+
+template<typename AddrT>
+void RibDelta<AddrT>::Iterator::next(const TreeNode** node,
+    Pending* pending, bool descend) {
+  auto cur = *node;
+  if (descend && cur->left()) {
+    if (cur->right()) {
+      pending->push_back(cur->right());
+    }
+    *node = cur->left();
+  } else if (descend && cur->right()) {
+    *node = cur->right();
+  } else if (!pending->empty()) {
+    *node = pending->back();
+    pending->pop_back();
+  } else {
+    *node = nullptr;
+  }
+}
+
+template<typename AddrT>
+void RibDelta<AddrT>::Iterator::advance() {
+  // Move past the change we are currently pointing at
+  if (oldStep_) {
+    next(&oldNode_, &oldPending_, true);
+  }
+  if (newStep_) {
+    next(&newNode_, &newPending_, true);
+  }
+  oldStep_ = newStep_ = false;
+
+  while (oldNode_ || newNode_) {
+    if (oldNode_ == newNode_) {
+      // Shared subtree, nothing below here changed
+      next(&oldNode_, &oldPending_, false);
+      next(&newNode_, &newPending_, false);
+      continue;
+    }
+    auto cmp = compareNodes();
+    const Node* oldRoute = (cmp <= 0 && oldNode_->isValueNode()) ?
+      oldNode_->value().get() : nullptr;
+    const Node* newRoute = (cmp >= 0 && newNode_->isValueNode()) ?
+      newNode_->value().get() : nullptr;
+    if (oldRoute != newRoute) {
+      value_.reset(oldRoute ? oldNode_->value() : nullptr,
+                   newRoute ? newNode_->value() : nullptr);
+      oldStep_ = cmp <= 0;
+      newStep_ = cmp >= 0;
+      return;
+    }
+    if (cmp <= 0) {
+      next(&oldNode_, &oldPending_, true);
+    }
+    if (cmp >= 0) {
+      next(&newNode_, &newPending_, true);
+    }
+  }
+  value_.reset(nullptr, nullptr);
+}
+
+template class RibDelta<folly::IPAddressV4>;
+template class RibDelta<folly::IPAddressV6>;
+
 template class NodeMapDelta<RouteTableMap, RouteTablesDelta>;
 
-using NodeMapRibV4 = RouteTableRibNodeMap<folly::IPAddressV4>;
-template class NodeMapDelta<
-    NodeMapRibV4,
-    DeltaValue<NodeMapRibV4::Node>,
-    MapUniquePointerTraits<NodeMapRibV4>>;
-
-using NodeMapRibV6 = RouteTableRibNodeMap<folly::IPAddressV6>;
-template class NodeMapDelta<
-    NodeMapRibV6,
-    DeltaValue<NodeMapRibV6::Node>,
-    MapUniquePointerTraits<NodeMapRibV6>>;
 }}
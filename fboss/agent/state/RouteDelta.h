@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "fboss/agent/state/NodeMapDelta.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/RouteTable.h"
@@ -17,42 +19,148 @@
 
 namespace facebook { namespace fboss {
 
+/*
+ * RibDelta contains code for examining the differences between two
+ * generations of a RouteTableRib.
+ *
+ * Rather than boxing both RIBs into NodeMaps and comparing them entry by
+ * entry, the Iterator walks the two radix trees side by side.  Tree nodes
+ * are shared between a RIB and its clone until they are modified, so any
+ * subtree reachable from both sides through the same pointer is known to be
+ * unchanged and is skipped without being visited.  Walking the delta thus
+ * costs in proportion to the number of changed routes (times the prefix
+ * depth), not to the size of the table.
+ *
+ * Like NodeMapDelta, a null RIB on either side is treated as empty, so all
+ * routes of the other side show up as added or removed.
+ */
+template<typename AddrT>
+class RibDelta {
+ public:
+  using Rib = RouteTableRib<AddrT>;
+  using Node = Route<AddrT>;
+  class Iterator;
+
+  RibDelta(const Rib* oldRib, const Rib* newRib)
+    : old_(oldRib),
+      new_(newRib) {}
+
+  const Rib* getOld() const {
+    return old_;
+  }
+  const Rib* getNew() const {
+    return new_;
+  }
+
+  /*
+   * Return an iterator pointing to the first change.
+   */
+  Iterator begin() const;
+
+  /*
+   * Return an iterator pointing just past the last change.
+   */
+  Iterator end() const;
+
+ private:
+  // As with NodeMapDelta, the owning StateDelta keeps both RIBs alive.
+  const Rib* old_;
+  const Rib* new_;
+};
+
+/*
+ * An iterator for walking over the routes that changed between the two
+ * RIBs.
+ *
+ * Both trees are walked in preorder, which visits prefixes in increasing
+ * (network, mask length) order regardless of the shape of the tree, so the
+ * two walks can be merged the same way NodeMapDelta merges two sorted maps.
+ */
+template<typename AddrT>
+class RibDelta<AddrT>::Iterator {
+ public:
+  typedef Route<AddrT> Node;
+
+  // Iterator properties
+  typedef std::forward_iterator_tag iterator_category;
+  typedef DeltaValue<Node> value_type;
+  typedef ptrdiff_t difference_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+
+  Iterator(const Rib* oldRib, const Rib* newRib);
+  Iterator();
+
+  const value_type& operator*() const {
+    return value_;
+  }
+  const value_type* operator->() const {
+    return &value_;
+  }
+
+  Iterator& operator++() {
+    advance();
+    return *this;
+  }
+  Iterator operator++(int) {
+    Iterator tmp(*this);
+    advance();
+    return tmp;
+  }
+
+  bool operator==(const Iterator& other) const {
+    return oldNode_ == other.oldNode_ && newNode_ == other.newNode_;
+  }
+  bool operator!=(const Iterator& other) const {
+    return !operator==(other);
+  }
+
+ private:
+  typedef typename Rib::Routes::TreeNode TreeNode;
+  typedef std::vector<const TreeNode*> Pending;
+
+  void advance();
+  int compareNodes() const;
+  static void next(const TreeNode** node, Pending* pending,
+      bool descend);
+
+  const TreeNode* oldNode_{nullptr};
+  const TreeNode* newNode_{nullptr};
+  Pending oldPending_;
+  Pending newPending_;
+  // Which side(s) the current value_ was taken from
+  bool oldStep_{false};
+  bool newStep_{false};
+  value_type value_{nullptr, nullptr};
+};
+
+template<typename AddrT>
+typename RibDelta<AddrT>::Iterator RibDelta<AddrT>::begin() const {
+  if (old_ == new_) {
+    return end();
+  }
+  return Iterator(old_, new_);
+}
+
+template<typename AddrT>
+typename RibDelta<AddrT>::Iterator RibDelta<AddrT>::end() const {
+  return Iterator();
+}
+
 class RouteTablesDelta : public DeltaValue<RouteTable> {
  public:
-  using NodeMapRibV4 = RouteTableRibNodeMap<folly::IPAddressV4>;
-  using NodeMapRibV6 = RouteTableRibNodeMap<folly::IPAddressV6>;
-  using RoutesV4Delta = NodeMapDelta<NodeMapRibV4,
-        DeltaValue<NodeMapRibV4::Node>,
-        MapUniquePointerTraits<NodeMapRibV4>>;
-  using RoutesV6Delta = NodeMapDelta<NodeMapRibV6,
-        DeltaValue<NodeMapRibV6::Node>,
-        MapUniquePointerTraits<NodeMapRibV6>>;
+  using RoutesV4Delta = RibDelta<folly::IPAddressV4>;
+  using RoutesV6Delta = RibDelta<folly::IPAddressV6>;
 
   using DeltaValue<RouteTable>::DeltaValue;
 
   RoutesV4Delta getRoutesV4Delta() const {
-    std::unique_ptr<NodeMapRibV4> oldRib, newRib;
-    if (getOld()) {
-      oldRib.reset(new NodeMapRibV4());
-      oldRib->addRoutes(*(getOld()->getRibV4()));
-    }
-    if (getNew()) {
-      newRib.reset(new NodeMapRibV4());
-      newRib->addRoutes(*(getNew()->getRibV4()));
-    }
-    return RoutesV4Delta(std::move(oldRib), std::move(newRib));
+    return RoutesV4Delta(getOld() ? getOld()->getRibV4().get() : nullptr,
+                         getNew() ? getNew()->getRibV4().get() : nullptr);
   }
   RoutesV6Delta getRoutesV6Delta()  const {
-    std::unique_ptr<NodeMapRibV6> oldRib, newRib;
-    if (getOld()) {
-      oldRib.reset(new NodeMapRibV6());
-      oldRib->addRoutes(*(getOld()->getRibV6()));
-    }
-    if (getNew()) {
-      newRib.reset(new NodeMapRibV6());
-      newRib->addRoutes(*(getNew()->getRibV6()));
-    }
-    return RoutesV6Delta(std::move(oldRib), std::move(newRib));
+    return RoutesV6Delta(getOld() ? getOld()->getRibV6().get() : nullptr,
+                         getNew() ? getNew()->getRibV6().get() : nullptr);
   }
 };
 
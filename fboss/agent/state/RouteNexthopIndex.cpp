@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/RouteNexthopIndex.h"
+
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTableRib.h"
+
+using folly::IPAddressV4;
+using folly::IPAddressV6;
+using facebook::network::PersistentRadixTree;
+
+namespace {
+
+using facebook::fboss::RouteNexthopIndex;
+
+template<typename T>
+bool sameOwner(const std::weak_ptr<T>& a, const std::shared_ptr<T>& b) {
+  return !a.owner_before(b) && !b.owner_before(a);
+}
+
+PersistentRadixTree<IPAddressV4, bool>& dependentTree(
+    RouteNexthopIndex::Dependents* deps, const IPAddressV4& /*addr*/) {
+  return deps->v4;
+}
+
+PersistentRadixTree<IPAddressV6, bool>& dependentTree(
+    RouteNexthopIndex::Dependents* deps, const IPAddressV6& /*addr*/) {
+  return deps->v6;
+}
+
+} // anonymous namespace
+
+namespace facebook { namespace fboss {
+
+template<typename NhAddrT, typename AddrT>
+void RouteNexthopIndex::addDependent(NexthopTree<NhAddrT>* tree,
+    const NhAddrT& nexthop, const RoutePrefix<AddrT>& dependent) {
+  auto mask = NhAddrT::bitCount();
+  auto iter = tree->exactMatch(nexthop, mask);
+  if (iter == tree->end()) {
+    Dependents deps;
+    dependentTree(&deps, dependent.network).insert(
+        dependent.network, dependent.mask, true);
+    tree->insert(nexthop, mask, std::move(deps));
+    return;
+  }
+  // O(1) copy, shares its trees with the indexed value
+  auto deps = iter->value();
+  if (dependentTree(&deps, dependent.network).insert(
+        dependent.network, dependent.mask, true)) {
+    tree->update(nexthop, mask, std::move(deps));
+  }
+}
+
+template<typename NhAddrT, typename AddrT>
+void RouteNexthopIndex::removeDependent(NexthopTree<NhAddrT>* tree,
+    const NhAddrT& nexthop, const RoutePrefix<AddrT>& dependent) {
+  auto mask = NhAddrT::bitCount();
+  auto iter = tree->exactMatch(nexthop, mask);
+  if (iter == tree->end()) {
+    return;
+  }
+  auto deps = iter->value();
+  if (!dependentTree(&deps, dependent.network).erase(
+        dependent.network, dependent.mask)) {
+    return;
+  }
+  if (deps.empty()) {
+    tree->erase(nexthop, mask);
+  } else {
+    tree->update(nexthop, mask, std::move(deps));
+  }
+}
+
+template<typename AddrT>
+void RouteNexthopIndex::addRoute(const Route<AddrT>& route) {
+  if (!route.isWithNexthops()) {
+    return;
+  }
+  for (const auto& nh : route.bestNextHopList()) {
+    if (nh.intfID().hasValue()) {
+      continue;
+    }
+    if (nh.addr().isV4()) {
+      addDependent(&byNexthopV4_, nh.addr().asV4(), route.prefix());
+    } else {
+      addDependent(&byNexthopV6_, nh.addr().asV6(), route.prefix());
+    }
+  }
+}
+
+template<typename AddrT>
+void RouteNexthopIndex::removeRoute(const Route<AddrT>& route) {
+  if (!route.isWithNexthops()) {
+    return;
+  }
+  for (const auto& nh : route.bestNextHopList()) {
+    if (nh.intfID().hasValue()) {
+      continue;
+    }
+    if (nh.addr().isV4()) {
+      removeDependent(&byNexthopV4_, nh.addr().asV4(), route.prefix());
+    } else {
+      removeDependent(&byNexthopV6_, nh.addr().asV6(), route.prefix());
+    }
+  }
+}
+
+bool RouteNexthopIndex::isFor(const std::shared_ptr<RibV4>& ribV4,
+                              const std::shared_ptr<RibV6>& ribV6) const {
+  return sameOwner(ribV4_, ribV4) && sameOwner(ribV6_, ribV6);
+}
+
+void RouteNexthopIndex::setRibs(const std::shared_ptr<RibV4>& ribV4,
+                                const std::shared_ptr<RibV6>& ribV6) {
+  ribV4_ = ribV4;
+  ribV6_ = ribV6;
+}
+
+template void RouteNexthopIndex::addRoute(const Route<IPAddressV4>&);
+template void RouteNexthopIndex::addRoute(const Route<IPAddressV6>&);
+template void RouteNexthopIndex::removeRoute(const Route<IPAddressV4>&);
+template void RouteNexthopIndex::removeRoute(const Route<IPAddressV6>&);
+
+}}
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <folly/IPAddressV4.h>
+#include <folly/IPAddressV6.h>
+
+#include "fboss/agent/state/RouteTypes.h"
+#include "fboss/lib/RadixTree.h"
+
+namespace facebook { namespace fboss {
+
+template<typename AddrT>
+class Route;
+template<typename AddrT>
+class RouteTableRib;
+
+/*
+ * RouteNexthopIndex is a reverse index from nexthop addresses to the routes
+ * (in the same VRF) which list them as nexthops.
+ *
+ * Whenever the route covering some prefix changes, the routes that may
+ * resolve differently are exactly those with a nexthop inside that prefix,
+ * so RouteUpdater uses this index to re-resolve only those.  Since a route
+ * being re-resolved may itself be the resolving route for other nexthops,
+ * the lookup is simply repeated for its prefix, which handles recursive
+ * resolution.
+ *
+ * The index is made of persistent radix trees, so copying it is O(1) and a
+ * modified copy shares all the untouched parts with the original.  It is
+ * stored with the RouteTable but is derived state: it is not serialized,
+ * and it remembers which RIBs it was built from, so a RouteTable whose RIBs
+ * were replaced behind its back (or which was loaded from JSON) is detected
+ * and its index rebuilt.
+ */
+class RouteNexthopIndex {
+ public:
+  typedef RouteTableRib<folly::IPAddressV4> RibV4;
+  typedef RouteTableRib<folly::IPAddressV6> RibV6;
+
+  /*
+   * The routes depending on a single nexthop address.
+   */
+  struct Dependents {
+    facebook::network::PersistentRadixTree<folly::IPAddressV4, bool> v4;
+    facebook::network::PersistentRadixTree<folly::IPAddressV6, bool> v6;
+
+    bool empty() const {
+      return v4.size() == 0 && v6.size() == 0;
+    }
+    template<typename FnV4, typename FnV6>
+    void forEach(FnV4 fnV4, FnV6 fnV6) const {
+      for (const auto& dep : v4) {
+        fnV4(RoutePrefixV4{dep.ipAddress(), dep.masklen()});
+      }
+      for (const auto& dep : v6) {
+        fnV6(RoutePrefixV6{dep.ipAddress(), dep.masklen()});
+      }
+    }
+  };
+
+  /*
+   * Add or remove the entries for all the nexthops of a route.
+   * Link local nexthops with an explicit interface don't go through the
+   * RIB and are not indexed.
+   */
+  template<typename AddrT>
+  void addRoute(const Route<AddrT>& route);
+  template<typename AddrT>
+  void removeRoute(const Route<AddrT>& route);
+
+  /*
+   * Call fn(nexthop, dependents) for every indexed nexthop address falling
+   * inside the given prefix.
+   */
+  template<typename Fn>
+  void forEachNexthopIn(const RoutePrefixV4& prefix, Fn fn) const {
+    forEachNexthopIn(byNexthopV4_, prefix, fn);
+  }
+  template<typename Fn>
+  void forEachNexthopIn(const RoutePrefixV6& prefix, Fn fn) const {
+    forEachNexthopIn(byNexthopV6_, prefix, fn);
+  }
+
+  /*
+   * Whether this index describes the routes in the given RIBs.
+   */
+  bool isFor(const std::shared_ptr<RibV4>& ribV4,
+             const std::shared_ptr<RibV6>& ribV6) const;
+  void setRibs(const std::shared_ptr<RibV4>& ribV4,
+               const std::shared_ptr<RibV6>& ribV6);
+
+ private:
+  template<typename AddrT>
+  using NexthopTree = facebook::network::PersistentRadixTree<AddrT,
+        Dependents>;
+
+  template<typename AddrT, typename Fn>
+  static void forEachNexthopIn(const NexthopTree<AddrT>& tree,
+      const RoutePrefix<AddrT>& prefix, Fn& fn);
+
+  template<typename NhAddrT, typename AddrT>
+  static void addDependent(NexthopTree<NhAddrT>* tree, const NhAddrT& nexthop,
+      const RoutePrefix<AddrT>& dependent);
+  template<typename NhAddrT, typename AddrT>
+  static void removeDependent(NexthopTree<NhAddrT>* tree,
+      const NhAddrT& nexthop, const RoutePrefix<AddrT>& dependent);
+
+  NexthopTree<folly::IPAddressV4> byNexthopV4_;
+  NexthopTree<folly::IPAddressV6> byNexthopV6_;
+  // Weak, the index must not keep replaced RIBs alive. Compared by owner,
+  // so a RIB allocated at the address of a freed one never matches.
+  std::weak_ptr<RibV4> ribV4_;
+  std::weak_ptr<RibV6> ribV6_;
+};
+
+template<typename AddrT, typename Fn>
+void RouteNexthopIndex::forEachNexthopIn(const NexthopTree<AddrT>& tree,
+    const RoutePrefix<AddrT>& prefix, Fn& fn) {
+  typedef typename NexthopTree<AddrT>::TreeNode TreeNode;
+  // Walk down to the topmost node inside the prefix
+  const TreeNode* node = tree.root();
+  while (node && node->masklen() < prefix.mask) {
+    if (prefix.network.mask(node->masklen()) != node->ipAddress()) {
+      return;
+    }
+    node = prefix.network.getNthMSBit(node->masklen()) ?
+      node->right() : node->left();
+  }
+  if (!node || node->ipAddress().mask(prefix.mask) != prefix.network) {
+    return;
+  }
+  // Everything in its subtree falls inside the prefix as well
+  std::vector<const TreeNode*> pending{node};
+  while (!pending.empty()) {
+    node = pending.back();
+    pending.pop_back();
+    if (node->isValueNode()) {
+      fn(node->ipAddress(), node->value());
+    }
+    if (node->right()) {
+      pending.push_back(node->right());
+    }
+    if (node->left()) {
+      pending.push_back(node->left());
+    }
+  }
+}
+
+}}
@@ -47,8 +47,7 @@ RouteTable* RouteTable::modify(std::shared_ptr<SwitchState>* state) {
   auto clonedRouteTableMap = (*state)->getRouteTables()->modify(state);
 
   auto clonedRT = this->clone();
-  auto it = clonedRouteTableMap->writableNodes().find(getID());
-  it->second = clonedRT;
+  clonedRouteTableMap->updateNode(clonedRT);
   return clonedRT.get();
 }
 
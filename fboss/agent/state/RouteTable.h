@@ -14,6 +14,7 @@
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
 #include "fboss/agent/state/NodeBase.h"
+#include "fboss/agent/state/RouteNexthopIndex.h"
 #include "fboss/agent/state/RouteTableRib.h"
 
 namespace facebook { namespace fboss {
@@ -41,6 +42,8 @@ struct RouteTableFields {
   typedef RouteTableRib<folly::IPAddressV6> RibTypeV6;
   std::shared_ptr<RibTypeV4> ribV4;
   std::shared_ptr<RibTypeV6> ribV6;
+  // Maintained by RouteUpdater, not serialized
+  std::shared_ptr<const RouteNexthopIndex> nexthopIndex;
 };
 
 class RouteTable : public NodeBaseT<RouteTable, RouteTableFields> {
@@ -85,6 +88,13 @@ class RouteTable : public NodeBaseT<RouteTable, RouteTableFields> {
   }
   template <typename AddressT>
   const std::shared_ptr<RouteTableRib<AddressT>> getRib() const;
+  /*
+   * The nexthop index of this table, if any. It may be out of date, use
+   * RouteNexthopIndex::isFor() to check whether it matches the RIBs.
+   */
+  const std::shared_ptr<const RouteNexthopIndex>& getNexthopIndex() const {
+    return getFields()->nexthopIndex;
+  }
 
   bool empty() const;
 
@@ -103,6 +113,16 @@ class RouteTable : public NodeBaseT<RouteTable, RouteTableFields> {
   void setRib(std::shared_ptr<RibTypeV6> rib) {
     writableFields()->ribV6.swap(rib);
   }
+  /*
+   * Set the nexthop index, describing the RIBs currently in the table.
+   * This needs to be called again after replacing a RIB with one holding
+   * the same routes, or the index won't be considered valid for it.
+   */
+  void setNexthopIndex(RouteNexthopIndex index) {
+    index.setRibs(getRibV4(), getRibV6());
+    writableFields()->nexthopIndex =
+      std::make_shared<const RouteNexthopIndex>(std::move(index));
+  }
  private:
   // Forbidden copy constructor and assignment operator
   RouteTable(RouteTable const &) = delete;
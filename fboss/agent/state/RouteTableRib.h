@@ -10,6 +10,8 @@
 // Copyright 2004-present Facebook.  All rights reserved.
 #pragma once
 
+#include <vector>
+
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/types.h"
 #include "fboss/agent/state/NodeMap.h"
@@ -73,7 +75,14 @@ class RouteTableRib : public NodeBase {
 
   using Prefix =  RoutePrefix<AddrT>;
   using RouteType = Route<AddrT>;
-  using Routes = facebook::network::RadixTree<AddrT,
+  /*
+   * Routes are kept in a persistent radix tree. Cloning a RouteTableRib
+   * shares the whole tree (and the Route objects in it) with the
+   * original, subsequent changes copy only the paths they touch. Routes
+   * shared this way are published, so they need to be cloned and put
+   * back via updateRoute() before they can be modified.
+   */
+  using Routes = facebook::network::PersistentRadixTree<AddrT,
         std::shared_ptr<Route<AddrT>>>;
 
   bool empty() const {
@@ -85,16 +94,38 @@ class RouteTableRib : public NodeBase {
   }
 
   const Routes& routes() const { return rib_; }
+  /*
+   * Routes put in the tree directly are not tracked, so the next publish()
+   * has to visit all of them.  Prefer addRoute()/updateRoute().
+   */
   Routes& writableRoutes() {
     CHECK(!isPublished());
+    publishAll_ = true;
     return rib_;
   }
 
+  /*
+   * Only the routes added or updated since this RIB was cloned can be
+   * unpublished, the ones it shares with the original are not visited.
+   */
   void publish() override {
-    NodeBase::publish();
-    for (auto routeIter: rib_) {
-      routeIter->value()->publish();
+    if (isPublished()) {
+      return;
+    }
+    if (publishAll_) {
+      for (const auto& routeIter: rib_) {
+        routeIter.value()->publish();
+      }
+    } else {
+      // Some of these may have been replaced or removed since, publishing
+      // them anyway is harmless.
+      for (const auto& rt : unpublished_) {
+        rt->publish();
+      }
     }
+    std::vector<std::shared_ptr<Route<AddrT>>>().swap(unpublished_);
+    publishAll_ = false;
+    NodeBase::publish();
   }
   std::shared_ptr<Route<AddrT>> exactMatch(const Prefix& prefix) const {
     auto citr = rib_.exactMatch(prefix.network, prefix.mask);
@@ -110,14 +141,11 @@ class RouteTableRib : public NodeBase {
   std::shared_ptr<RouteTableRib> clone() const {
     auto routeTableRib = std::make_shared<RouteTableRib>(getNodeID(),
         getGeneration() + 1);
-    for (auto& routeItr: rib_) {
-      /* Explicitly insert cloned routes rather than calling
-       * rib_.clone(), which will just use the shared_ptr copy
-       * constructor
-       */
-      routeTableRib->rib_.insert(routeItr->ipAddress(),
-          routeItr->masklen(), routeItr->value()->clone());
-    }
+    // O(1), the new RIB shares all nodes and routes with this one
+    routeTableRib->rib_ = rib_;
+    // Both empty unless this RIB is unpublished itself
+    routeTableRib->unpublished_ = unpublished_;
+    routeTableRib->publishAll_ = publishAll_;
     return routeTableRib;
   }
   /*
@@ -145,18 +173,23 @@ class RouteTableRib : public NodeBase {
    */
   void addRoute(const std::shared_ptr<Route<AddrT>>& rt) {
     auto inserted = rib_.insert(rt->prefix().network,
-        rt->prefix().mask, rt).second;
+        rt->prefix().mask, rt);
     if (!inserted) {
       throw FbossError("Prefix for: ", rt->str(), " already exists");
     }
+    if (!rt->isPublished()) {
+      unpublished_.push_back(rt);
+    }
   }
   void updateRoute(const std::shared_ptr<Route<AddrT>>& rt) {
-    auto itr = rib_.exactMatch(rt->prefix().network, rt->prefix().mask);
-    if (itr == rib_.end()) {
+    auto updated = rib_.update(rt->prefix().network, rt->prefix().mask, rt);
+    if (!updated) {
       throw FbossError("Update failed, prefix for: ", rt->str(),
           " not present");
     }
-    itr->value() = rt;
+    if (!rt->isPublished()) {
+      unpublished_.push_back(rt);
+    }
   }
   void removeRoute(const std::shared_ptr<Route<AddrT>>& rt) {
     auto erased = rib_.erase(rt->prefix().network, rt->prefix().mask);
@@ -169,6 +202,9 @@ class RouteTableRib : public NodeBase {
 
  private:
   Routes rib_;
+  // Routes added or updated since the last publish(), see publish()
+  std::vector<std::shared_ptr<Route<AddrT>>> unpublished_;
+  bool publishAll_{false};
 };
 
 }}
@@ -15,6 +15,7 @@
 #include "fboss/agent/state/NodeBase.h"
 #include "fboss/agent/state/NodeBase-defs.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteDelta.h"
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableMap.h"
 #include "fboss/agent/state/RouteTableRib.h"
@@ -44,6 +45,11 @@ RouteUpdater::RouteUpdater(const std::shared_ptr<RouteTableMap>& orig)
     auto& rib = clonedRibs_[rt.first];
     rib.v4.rib = rt.second->getRibV4();
     rib.v6.rib = rt.second->getRibV6();
+    const auto& index = rt.second->getNexthopIndex();
+    if (index && index->isFor(rib.v4.rib, rib.v6.rib)) {
+      rib.nexthopIndex = *index;
+      rib.nexthopIndexValid = true;
+    }
   }
 }
 
@@ -53,6 +59,8 @@ RouteUpdater::ClonedRib* RouteUpdater::createNewRib(RouterID id) {
   newRib.v4.cloned = true;
   newRib.v6.rib = make_shared<RouteTableRibV6>();
   newRib.v6.cloned = true;
+  // Nothing to index yet
+  newRib.nexthopIndexValid = true;
   auto ret = clonedRibs_.emplace(id, newRib);
   if (!ret.second) {
     throw FbossError("Duplicated cloned RIB for vrf ", id);
@@ -246,8 +254,13 @@ void RouteUpdater::delNexthopsForClient(const PrefixT& prefix,
     return;
   }
   rib = makeClone(ribCloned);
-  // Re-get the route from the cloned RIB
-  old = rib->exactMatch(prefix);
+  // The cloned RIB shares its routes with the original one. Clone the
+  // route itself before modifying it, unless this update already did.
+  if (old->isPublished()) {
+    old = old->clone(
+        RouteFields<typename PrefixT::AddressT>::COPY_PREFIX_AND_NEXTHOPS);
+    rib->updateRoute(old);
+  }
   old->delNexthopsForClient(clientId);
   // TODO Do I need to publish the change??
   VLOG(3) << "Deleted nexthops for client " << clientId <<
@@ -276,24 +289,26 @@ void RouteUpdater::removeAllNexthopsForClient(RibT *ribCloned,
                                               ClientID clientId) {
   auto rib = makeClone(ribCloned);
 
-  std::vector<std::shared_ptr<Route<AddrT>>> routesToDelete;
+  std::vector<std::shared_ptr<Route<AddrT>>> routesToUpdate;
 
-  for (auto& rt : rib->routes()) {
-    auto route = rt.value().get();
-    if (route->nexthopsIsEmpty()) {
-      continue;
+  for (const auto& rt : rib->routes()) {
+    if (rt.value()->hasNextHopsForClient(clientId)) {
+      routesToUpdate.push_back(rt.value());
+    }
+  }
+
+  // Modify the RIB only after we are done iterating over it
+  for (auto& route : routesToUpdate) {
+    if (route->isPublished()) {
+      route = route->clone(Route<AddrT>::Fields::COPY_PREFIX_AND_NEXTHOPS);
+      rib->updateRoute(route);
     }
     route->delNexthopsForClient(clientId);
     if (route->nexthopsIsEmpty()) {
       // The nexthops we removed was the only one.  Delete the route.
-      routesToDelete.push_back(rt.value());
+      rib->removeRoute(route);
     }
   }
-
-  // Now, delete whatever routes went from 1 nexthoplist to 0.
-  for (std::shared_ptr<Route<AddrT>>& rt : routesToDelete) {
-    rib->removeRoute(rt);
-  }
 }
 
 void RouteUpdater::removeAllNexthopsForClient(RouterID rid, ClientID clientId) {
@@ -341,18 +356,11 @@ void RouteUpdater::resolve(RouteT* route, RtRibT* rib, ClonedRib* ribCloned) {
   if (route->isPublished()) {
     auto newRoute = route->clone(RouteT::Fields::COPY_PREFIX_AND_NEXTHOPS);
     // insert the cloned route back to the RIB
-    // Note: resolve() is called in a loop over 'rib'. But we are modifying
-    // the rib here. Fortunately, updateRoute() here does not actually
-    // invalidate the existing iterator, it just replace the value pointed by
-    // an existing iterator.
-    // It might be nice to change resolve() to accept a RouteTableRib::iterator
-    // as a first argument. This way it could just modify iter.second, instead
-    // of having to call updateRoute(). This way it would be very clear that
-    // this can't invalidate the iterator. (It would also avoid having to
-    // re-lookup the node in updateRoute().)
-    // The current API for the temporary RouteTableRib solution does not return
-    // any iterator. Once we switch to the RadixTree() solution, we should make
-    // this change.
+    // Note: resolveAll() calls resolve() in a loop over 'rib'. Routes with
+    // nexthops have all been cloned by setRoutesWithNhopsForResolution()
+    // before that loop starts, so we only get here for routes which are not
+    // part of that iteration and updateRoute() can't copy any node the loop
+    // is still going to visit.
     rib->updateRoute(newRoute);
     route = newRoute.get();
     CHECK(!route->isPublished());
@@ -403,18 +411,26 @@ void RouteUpdater::resolve(RouteT* route, RtRibT* rib, ClonedRib* ribCloned) {
 
 template<typename RibT>
 void RouteUpdater::setRoutesWithNhopsForResolution(RibT* rib) {
-  for (auto& rt : rib->routes()) {
+  // Routes shared with the previous RIB are published and must be
+  // replaced with clones. Replacing a route copies tree nodes, so
+  // collect them first rather than updating the RIB while iterating it.
+  std::vector<std::shared_ptr<typename RibT::RouteType>> toClone;
+  for (const auto& rt : rib->routes()) {
     auto route = rt.value().get();
     if (route->isWithNexthops()) {
       if (route->isPublished()) {
-        auto newRoute =
-          route->clone(RibT::RouteType::Fields::COPY_PREFIX_AND_NEXTHOPS);
-        rib->updateRoute(newRoute);
-        route = newRoute.get();
+        toClone.push_back(rt.value());
+      } else {
+        route->clearFlags();
       }
-      route->clearFlags();
     }
   }
+  for (const auto& route : toClone) {
+    auto newRoute =
+      route->clone(RibT::RouteType::Fields::COPY_PREFIX_AND_NEXTHOPS);
+    rib->updateRoute(newRoute);
+    newRoute->clearFlags();
+  }
 }
 
 namespace {
@@ -430,32 +446,210 @@ bool allRouteFlagsCleared(const RibT* rib) {
 }
 }
 
-void RouteUpdater::resolve() {
-  // Ideally, just need to resolve the routes that is changed or impacted by
-  // the changed routes.
-  // However, Without copy-on-write RadixTree, it is O(n) to find out the
-  // routes that are changed. In this case, we just simply loop through all
-  // routes and resolve those that are not resolved yet.
+void RouteUpdater::resolveAll(ClonedRib* ribCloned) {
+  if (ribCloned->v4.cloned) {
+    auto rib = ribCloned->v4.rib.get();
+    setRoutesWithNhopsForResolution(rib);
+    for (auto& rt : rib->routes()) {
+      if (rt.value()->needResolve()) {
+        resolve(rt.value().get(), rib, ribCloned);
+      }
+    }
+  }
+  if (ribCloned->v6.cloned) {
+    auto rib = ribCloned->v6.rib.get();
+    setRoutesWithNhopsForResolution(rib);
+    for (auto& rt : rib->routes()) {
+      if (rt.value()->needResolve()) {
+        resolve(rt.value().get(), rib, ribCloned);
+      }
+    }
+  }
+  RouteNexthopIndex index;
+  for (const auto& rt : ribCloned->v4.rib->routes()) {
+    index.addRoute(*rt.value());
+  }
+  for (const auto& rt : ribCloned->v6.rib->routes()) {
+    index.addRoute(*rt.value());
+  }
+  ribCloned->nexthopIndex = std::move(index);
+  ribCloned->nexthopIndexValid = true;
+}
 
-  for (auto& ribCloned : clonedRibs_) {
-    if (ribCloned.second.v4.cloned) {
-      auto rib = ribCloned.second.v4.rib.get();
-      setRoutesWithNhopsForResolution(rib);
-      for (auto& rt : rib->routes()) {
-        if (rt.value()->needResolve()) {
-          resolve(rt.value().get(), rib, &ribCloned.second);
+namespace {
+
+template<typename RouteT>
+bool sameNexthops(const RouteT* oldRt, const RouteT* newRt) {
+  if (!oldRt || !newRt ||
+      oldRt->isWithNexthops() != newRt->isWithNexthops()) {
+    return false;
+  }
+  return !newRt->isWithNexthops() ||
+    oldRt->bestNextHopList() == newRt->bestNextHopList();
+}
+
+/*
+ * Whether a nexthop within 'prefix' has a more specific route in 'rib',
+ * i.e. changes to 'prefix' don't change how it is resolved.
+ */
+template<typename RibT, typename AddrT>
+bool hasMoreSpecificMatch(const RibT* rib, const AddrT& nexthop,
+                          const RoutePrefix<AddrT>& prefix) {
+  if (!rib) {
+    return true;
+  }
+  auto rt = rib->longestMatch(nexthop);
+  return rt && rt->prefix().mask > prefix.mask;
+}
+
+/*
+ * Find the routes that may resolve differently now that the route for
+ * 'prefix' changed, and queue their own prefixes for the same treatment.
+ */
+template<typename AddrT>
+void addDependents(const RoutePrefix<AddrT>& prefix,
+    const RouteTableRib<AddrT>* origRib, const RouteTableRib<AddrT>* newRib,
+    const RouteNexthopIndex& index,
+    std::set<RoutePrefixV4>* affectedV4,
+    std::set<RoutePrefixV6>* affectedV6,
+    std::vector<RoutePrefixV4>* changedV4,
+    std::vector<RoutePrefixV6>* changedV6) {
+  index.forEachNexthopIn(prefix,
+      [&](const AddrT& nexthop, const RouteNexthopIndex::Dependents& deps) {
+        if (hasMoreSpecificMatch(newRib, nexthop, prefix) &&
+            hasMoreSpecificMatch(origRib, nexthop, prefix)) {
+          return;
         }
-      }
+        // A route resolving differently may in turn change the resolution
+        // of routes with nexthops inside it, so queue it up as well.
+        deps.forEach(
+            [&](const RoutePrefixV4& dep) {
+              if (affectedV4->insert(dep).second) {
+                changedV4->push_back(dep);
+              }
+            },
+            [&](const RoutePrefixV6& dep) {
+              if (affectedV6->insert(dep).second) {
+                changedV6->push_back(dep);
+              }
+            });
+      });
+}
+
+} // anonymous namespace
+
+template<typename RibT, typename PrefixT>
+void RouteUpdater::setAffectedRoutesForResolution(RibT* ribCloned,
+    const std::set<PrefixT>& affected) {
+  if (affected.empty()) {
+    return;
+  }
+  auto rib = makeClone(ribCloned);
+  // Clear the flags of all affected routes before resolving any of them,
+  // so they all get resolved again when used as a nexthop's route.
+  for (const auto& prefix : affected) {
+    auto route = rib->exactMatch(prefix);
+    if (!route || !route->isWithNexthops()) {
+      // Removed by this update
+      continue;
+    }
+    if (route->isPublished()) {
+      route = route->clone(
+          RouteFields<typename PrefixT::AddressT>::COPY_PREFIX_AND_NEXTHOPS);
+      rib->updateRoute(route);
     }
-    if (ribCloned.second.v6.cloned) {
-      auto rib = ribCloned.second.v6.rib.get();
-      setRoutesWithNhopsForResolution(rib);
-      for (auto& rt : rib->routes()) {
-        if (rt.value()->needResolve()) {
-          resolve(rt.value().get(), rib, &ribCloned.second);
+    route->clearFlags();
+  }
+}
+
+void RouteUpdater::resolveChanged(RouterID id, ClonedRib* ribCloned) {
+  auto origTable = orig_->getRouteTableIf(id);
+  const RouteTableRibV4* origV4 =
+    origTable ? origTable->getRibV4().get() : nullptr;
+  const RouteTableRibV6* origV6 =
+    origTable ? origTable->getRibV6().get() : nullptr;
+  auto& index = ribCloned->nexthopIndex;
+
+  // Routes which need to be resolved again
+  std::set<PrefixV4> affectedV4;
+  std::set<PrefixV6> affectedV6;
+  // Prefixes whose route changed, so routes with nexthops inside them may
+  // resolve differently
+  std::vector<PrefixV4> changedV4;
+  std::vector<PrefixV6> changedV6;
+
+  auto processDelta = [&](const auto& delta, auto* affected, auto* changed) {
+    for (const auto& entry : delta) {
+      const auto& oldRt = entry.getOld();
+      const auto& newRt = entry.getNew();
+      const auto& prefix = oldRt ? oldRt->prefix() : newRt->prefix();
+      changed->push_back(prefix);
+      if (newRt && newRt->isWithNexthops()) {
+        affected->insert(prefix);
+      }
+      if (!sameNexthops(oldRt.get(), newRt.get())) {
+        if (oldRt) {
+          index.removeRoute(*oldRt);
+        }
+        if (newRt) {
+          index.addRoute(*newRt);
         }
       }
     }
+  };
+  processDelta(RibDelta<IPAddressV4>(origV4, ribCloned->v4.rib.get()),
+      &affectedV4, &changedV4);
+  processDelta(RibDelta<IPAddressV6>(origV6, ribCloned->v6.rib.get()),
+      &affectedV6, &changedV6);
+
+  while (!changedV4.empty() || !changedV6.empty()) {
+    if (!changedV4.empty()) {
+      auto prefix = changedV4.back();
+      changedV4.pop_back();
+      addDependents(prefix, origV4, ribCloned->v4.rib.get(), index,
+          &affectedV4, &affectedV6, &changedV4, &changedV6);
+    } else {
+      auto prefix = changedV6.back();
+      changedV6.pop_back();
+      addDependents(prefix, origV6, ribCloned->v6.rib.get(), index,
+          &affectedV4, &affectedV6, &changedV4, &changedV6);
+    }
+  }
+  VLOG(3) << "Resolving " << affectedV4.size() << " v4 and "
+          << affectedV6.size() << " v6 routes affected by changes in vrf "
+          << id;
+
+  setAffectedRoutesForResolution(&ribCloned->v4, affectedV4);
+  setAffectedRoutesForResolution(&ribCloned->v6, affectedV6);
+  for (const auto& prefix : affectedV4) {
+    auto rib = ribCloned->v4.rib.get();
+    auto route = rib->exactMatch(prefix);
+    if (route && route->needResolve()) {
+      resolve(route.get(), rib, ribCloned);
+    }
+  }
+  for (const auto& prefix : affectedV6) {
+    auto rib = ribCloned->v6.rib.get();
+    auto route = rib->exactMatch(prefix);
+    if (route && route->needResolve()) {
+      resolve(route.get(), rib, ribCloned);
+    }
+  }
+}
+
+void RouteUpdater::resolve() {
+  // Only resolve the routes that changed or are impacted by the changed
+  // routes, as tracked by each VRF's RouteNexthopIndex. If the index can't
+  // be trusted, fall back to resolving all routes once, rebuilding it.
+  for (auto& ribCloned : clonedRibs_) {
+    if (!ribCloned.second.v4.cloned && !ribCloned.second.v6.cloned) {
+      continue;
+    }
+    if (ribCloned.second.nexthopIndexValid) {
+      resolveChanged(ribCloned.first, &ribCloned.second);
+    } else {
+      resolveAll(&ribCloned.second);
+    }
   }
 }
 
@@ -494,6 +688,9 @@ std::shared_ptr<RouteTableMap> RouteUpdater::updateDone() {
         newRt->setRib(origRt->getRibV6());
       }
     }
+    if (rib.nexthopIndexValid) {
+      newRt->setNexthopIndex(rib.nexthopIndex);
+    }
     auto iter = map.emplace(id, std::move(newRt));
     CHECK(iter.second);
   }
@@ -610,35 +807,29 @@ bool RouteUpdater::dedupRoutes(const RibT* oldRib, RibT* newRib) {
   if (oldRib == newRib) {
     return isSame;
   }
-  const auto& oldRoutes = oldRib->routes();
-  auto& newRoutes = newRib->writableRoutes();
-  // Copy routes from old route table if they are
-  // same. For matching prefixes, which don't have
-  // same attributes inherit the generation number
-  for (auto oldIter : oldRoutes) {
-    const auto& oldRt = oldIter->value();
-    auto newIter = newRoutes.exactMatch(oldIter->ipAddress(),
-        oldIter->masklen());
-    if (newIter == newRoutes.end()) {
+  typedef typename RibT::RouteType RouteT;
+  // Only routes differing between the two RIBs need to be looked at
+  std::vector<std::shared_ptr<RouteT>> toReuse;
+  RibDelta<typename RouteT::Prefix::AddressT> delta(oldRib, newRib);
+  for (const auto& entry : delta) {
+    const auto& oldRt = entry.getOld();
+    const auto& newRt = entry.getNew();
+    if (!oldRt || !newRt) {
       isSame = false;
       continue;
     }
-    auto& newRt = newIter->value();
+    // For matching prefixes with the same attributes, reuse the route
+    // from the old route table. Otherwise inherit the generation number.
     if (oldRt->isSame(newRt.get())) {
-      // both routes are completely same, instead of using the new route,
-      // we re-use the old route.
-      newIter->value() = oldRt;
+      toReuse.push_back(oldRt);
     } else {
       isSame = false;
       newRt->inheritGeneration(*oldRt);
     }
   }
-  if (newRoutes.size() != oldRoutes.size()) {
-    isSame = false;
-  } else {
-    // If sizes are same we would have already caught any
-    // difference while looking up all routes from oldRoutes
-    // in newRoutes, so do nothing
+  // Modify the RIB only after we are done walking it
+  for (const auto& oldRt : toReuse) {
+    newRib->updateRoute(oldRt);
   }
   return isSame;
 }
@@ -684,6 +875,12 @@ std::shared_ptr<RouteTableMap> RouteUpdater::deduplicate(
         isSame = false;
         newV6->inheritGeneration(*oldV6);
       }
+      // The old RIBs swapped in above have the same routes, so the index
+      // still applies, but needs to know about them.
+      const auto& index = newTable->getNexthopIndex();
+      if (!isSame && index) {
+        newTable->setNexthopIndex(*index);
+      }
     }
     // if both v4 RIB and v6 rib from the new RouteTable are as same as the
     // old one, we will just reuse the old RouteTable
@@ -14,12 +14,16 @@
 #include <folly/IPAddress.h>
 #include "fboss/agent/state/RouteForwardInfo.h"
 #include "fboss/agent/state/RouteNextHop.h"
+#include "fboss/agent/state/RouteNexthopIndex.h"
 #include "fboss/agent/state/RouteTypes.h"
 #include "fboss/agent/state/RouteTableMap.h"
 
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <set>
+#include <vector>
+
 namespace facebook { namespace fboss {
 
 namespace cfg {
@@ -101,6 +105,11 @@ class RouteUpdater {
       std::shared_ptr<RouteTableRibV6> rib;
       bool cloned{false};
     } v6;
+    // Which routes resolve through which nexthops, for both RIBs. Only
+    // valid if it was inherited in sync with the original RIBs (or the VRF
+    // is new), otherwise all routes get resolved and it is rebuilt.
+    RouteNexthopIndex nexthopIndex;
+    bool nexthopIndexValid{false};
   };
   boost::container::flat_map<RouterID, ClonedRib> clonedRibs_;
   const std::shared_ptr<RouteTableMap>& orig_;
@@ -126,6 +135,13 @@ class RouteUpdater {
 
   // resolve all routes that are not resolved yet
   void resolve();
+  // resolve only the routes affected by the changes made to a VRF
+  void resolveChanged(RouterID id, ClonedRib* ribCloned);
+  // resolve all routes of the cloned RIBs of a VRF, rebuilding its index
+  void resolveAll(ClonedRib* ribCloned);
+  template<typename RibT, typename PrefixT>
+  void setAffectedRoutesForResolution(RibT* ribCloned,
+      const std::set<PrefixT>& affected);
   template<typename RouteT, typename RtRibT>
   void resolve(RouteT* rt, RtRibT* rib, ClonedRib* clonedRib);
   template<typename RtRibT, typename AddrT>
@@ -88,6 +88,68 @@ TEST(Interface, addrToReach) {
   EXPECT_EQ(0, ret.mask);
 }
 
+TEST(Interface, publishedLookups) {
+  auto platform = createMockPlatform();
+  cfg::SwitchConfig config;
+  config.vlans.resize(3);
+  config.interfaces.resize(3);
+  const char* addrs[] = {"10.0.0.1/16", "10.0.1.1/24", "2401:db00::1/64"};
+  for (int i = 0; i < 3; ++i) {
+    config.vlans[i].id = i + 1;
+    auto* intfConfig = &config.interfaces[i];
+    intfConfig->intfID = i + 1;
+    intfConfig->vlanID = i + 1;
+    intfConfig->routerID = 0;
+    intfConfig->mac = "00:02:00:11:22:33";
+    intfConfig->__isset.mac = true;
+    intfConfig->ipAddresses.resize(1);
+    intfConfig->ipAddresses[0] = addrs[i];
+  }
+
+  shared_ptr<SwitchState> oldState = make_shared<SwitchState>();
+  auto state = publishAndApplyConfig(oldState, &config, platform.get());
+  ASSERT_NE(nullptr, state);
+  const auto& intfs = state->getInterfaces();
+
+  // The lookups go through the index once the map is published, and must
+  // give the same answers as the linear scans done before that
+  std::vector<IPAddress> ips = {
+    IPAddress("10.0.0.1"), IPAddress("10.0.1.1"), IPAddress("10.0.1.5"),
+    IPAddress("10.0.2.5"), IPAddress("10.1.0.1"), IPAddress("2401:db00::1"),
+    IPAddress("2401:db00::5"), IPAddress("2401:db01::5"),
+  };
+  auto lookup = [&]() {
+    std::vector<std::tuple<shared_ptr<Interface>, const Interface*,
+                           const IPAddress*, uint8_t>> results;
+    for (const auto& ip : ips) {
+      auto ret = intfs->getIntfAddrToReach(RouterID(0), ip);
+      results.emplace_back(intfs->getInterfaceIf(RouterID(0), ip),
+                           ret.intf, ret.addr, ret.mask);
+      EXPECT_EQ(nullptr, intfs->getInterfaceIf(RouterID(1), ip));
+    }
+    return results;
+  };
+  auto unpublished = lookup();
+  EXPECT_FALSE(intfs->isPublished());
+  state->publish();
+  EXPECT_TRUE(intfs->isPublished());
+  EXPECT_EQ(unpublished, lookup());
+
+  const auto& intf1 = intfs->getInterface(InterfaceID(1));
+  EXPECT_EQ(intf1, intfs->getInterface(RouterID(0), IPAddress("10.0.0.1")));
+  EXPECT_THROW(intfs->getInterface(RouterID(0), IPAddress("10.0.0.2")),
+               FbossError);
+  // The /16 comes first, even though the /24 is a longer match
+  auto ret = intfs->getIntfAddrToReach(RouterID(0), IPAddress("10.0.1.5"));
+  EXPECT_EQ(intf1.get(), ret.intf);
+  EXPECT_EQ(16, ret.mask);
+
+  EXPECT_EQ(intfs->getInterface(InterfaceID(3)),
+            intfs->getInterfaceInVlanIf(VlanID(3)));
+  EXPECT_EQ(nullptr, intfs->getInterfaceInVlanIf(VlanID(4)));
+  EXPECT_THROW(intfs->getInterfaceInVlan(VlanID(4)), FbossError);
+}
+
 TEST(Interface, applyConfig) {
   auto platform = createMockPlatform();
   cfg::SwitchConfig config;
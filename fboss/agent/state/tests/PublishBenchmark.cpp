@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/IPAddress.h>
+#include <folly/MacAddress.h>
+
+#include "fboss/agent/state/ArpTable.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/RouteUpdater.h"
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+/*
+ * Each benchmark makes a single change to a large published table and then
+ * measures publishing the result, which is what SwSwitch does on every state
+ * update.  The "FullPublish" variants hand out the underlying container
+ * before publishing, which makes publish() fall back to visiting every
+ * child like it always used to.  Everything but publish() is excluded from
+ * the measurement.
+ */
+const RouterID kRid(0);
+constexpr uint32_t kNumRoutes = 1000000;
+constexpr uint32_t kNumArpEntries = 100000;
+
+shared_ptr<RouteTableMap> routeTables;
+shared_ptr<ArpTable> arpTable;
+
+IPAddressV4 routeNetwork(uint32_t idx) {
+  return IPAddressV4::fromLongHBO((20 << 24) + (idx << 4));
+}
+
+IPAddressV4 arpAddress(uint32_t idx) {
+  return IPAddressV4::fromLongHBO((10 << 24) + idx);
+}
+
+void initRouteTables() {
+  RouteUpdater updater(make_shared<RouteTableMap>());
+  // Routes with an interface nexthop don't need any interfaces to resolve
+  for (uint32_t i = 0; i < kNumRoutes; ++i) {
+    updater.addRoute(kRid, InterfaceID(1), routeNetwork(i), 28);
+  }
+  routeTables = updater.updateDone();
+  routeTables->publish();
+}
+
+void initArpTable() {
+  arpTable = make_shared<ArpTable>();
+  for (uint32_t i = 0; i < kNumArpEntries; ++i) {
+    arpTable->addEntry(arpAddress(i), MacAddress("02:00:00:00:00:01"),
+                       PortID(1), InterfaceID(1));
+  }
+  arpTable->publish();
+}
+
+void publishRouteChange(int numIters, bool full) {
+  folly::BenchmarkSuspender braces;
+  for (int n = 0; n < numIters; ++n) {
+    RouteUpdater updater(routeTables);
+    updater.addRoute(kRid, InterfaceID(2), routeNetwork(n % kNumRoutes), 28);
+    auto newTables = updater.updateDone();
+    if (full) {
+      newTables->getRouteTable(kRid)->getRibV4()->writableRoutes();
+    }
+    braces.dismiss();
+    newTables->publish();
+    braces.rehire();
+  }
+}
+
+void publishArpChange(int numIters, bool full) {
+  folly::BenchmarkSuspender braces;
+  for (int n = 0; n < numIters; ++n) {
+    auto newTable = arpTable->clone();
+    newTable->updateEntry(arpAddress(n % kNumArpEntries),
+                          MacAddress("02:00:00:00:00:02"),
+                          PortID(2), InterfaceID(1));
+    if (full) {
+      newTable->writableNodes();
+    }
+    braces.dismiss();
+    newTable->publish();
+    braces.rehire();
+  }
+}
+
+} // unnamed namespace
+
+BENCHMARK(RouteTableFullPublish, numIters) {
+  publishRouteChange(numIters, true);
+}
+
+BENCHMARK_RELATIVE(RouteTablePublish, numIters) {
+  publishRouteChange(numIters, false);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ArpTableFullPublish, numIters) {
+  publishArpChange(numIters, true);
+}
+
+BENCHMARK_RELATIVE(ArpTablePublish, numIters) {
+  publishArpChange(numIters, false);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  initRouteTables();
+  initArpTable();
+  folly::runBenchmarks();
+  return 0;
+}
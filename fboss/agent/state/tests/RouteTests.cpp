@@ -16,6 +16,7 @@
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteBatch.h"
 #include "fboss/agent/state/RouteDelta.h"
 #include "fboss/agent/state/RouteTableRib.h"
 #include "fboss/agent/state/RouteTable.h"
@@ -296,6 +297,296 @@ TEST(Route, resolve) {
   }
 }
 
+// Only the routes depending on a changed route should be resolved again
+TEST(Route, resolveAffectedRoutesOnly) {
+  auto platform = createMockPlatform();
+  auto stateV0 = make_shared<SwitchState>();
+
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.vlans[0].id = 1;
+  config.vlans[1].id = 2;
+
+  config.interfaces.resize(2);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(2);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+  config.interfaces[0].ipAddresses[1] = "1::1/48";
+  config.interfaces[1].intfID = 2;
+  config.interfaces[1].vlanID = 2;
+  config.interfaces[1].routerID = 0;
+  config.interfaces[1].__isset.mac = true;
+  config.interfaces[1].mac = "00:00:00:00:00:22";
+  config.interfaces[1].ipAddresses.resize(2);
+  config.interfaces[1].ipAddresses[0] = "2.2.2.2/24";
+  config.interfaces[1].ipAddresses[1] = "2::1/48";
+
+  auto stateV1 = publishAndApplyConfig(stateV0, &config, platform.get());
+  ASSERT_NE(nullptr, stateV1);
+  stateV1->publish();
+
+  auto rid = RouterID(0);
+  RouteForwardNexthops viaIntf1;
+  viaIntf1.emplace(InterfaceID(1), IPAddress("1.1.1.10"));
+  RouteForwardNexthops viaIntf2;
+  viaIntf2.emplace(InterfaceID(2), IPAddress("2.2.2.10"));
+
+  RouteUpdater u1(stateV1->getRouteTables());
+  u1.addRoute(rid, IPAddress("1.1.3.0"), 24,
+              CLIENT_A, makeNextHops({"1.1.1.10"}));
+  // resolved through 1.1.3.0/24, and a v6 route with a v4 nexthop
+  u1.addRoute(rid, IPAddress("8.8.8.0"), 24,
+              CLIENT_A, makeNextHops({"1.1.3.10"}));
+  u1.addRoute(rid, IPAddress("8::"), 64,
+              CLIENT_A, makeNextHops({"1.1.3.10"}));
+  // unrelated to all of the above
+  u1.addRoute(rid, IPAddress("9.9.9.0"), 24,
+              CLIENT_A, makeNextHops({"2.2.2.10"}));
+  auto tables2 = u1.updateDone();
+  ASSERT_NE(nullptr, tables2);
+  tables2->publish();
+  EXPECT_EQ(viaIntf1,
+      GET_ROUTE_V4(tables2, rid, "8.8.8.0/24")->getForwardInfo().getNexthops());
+  EXPECT_EQ(viaIntf1,
+      GET_ROUTE_V6(tables2, rid, "8::/64")->getForwardInfo().getNexthops());
+
+  // A more specific route for the nexthop of 8.8.8.0/24 and 8::/64
+  RouteUpdater u2(tables2);
+  u2.addRoute(rid, IPAddress("1.1.3.0"), 28,
+              CLIENT_A, makeNextHops({"2.2.2.10"}));
+  auto tables3 = u2.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  tables3->publish();
+  EXPECT_EQ(viaIntf2,
+      GET_ROUTE_V4(tables3, rid, "8.8.8.0/24")->getForwardInfo().getNexthops());
+  EXPECT_EQ(viaIntf2,
+      GET_ROUTE_V6(tables3, rid, "8::/64")->getForwardInfo().getNexthops());
+  // Routes which don't depend on the new route are left alone
+  EXPECT_EQ(GET_ROUTE_V4(tables2, rid, "1.1.3.0/24"),
+            GET_ROUTE_V4(tables3, rid, "1.1.3.0/24"));
+  EXPECT_EQ(GET_ROUTE_V4(tables2, rid, "9.9.9.0/24"),
+            GET_ROUTE_V4(tables3, rid, "9.9.9.0/24"));
+
+  // A change two levels down is followed through 1.1.3.0/28 as well
+  RouteUpdater u3(tables3);
+  u3.addRoute(rid, IPAddress("2.2.2.0"), 28, RouteForwardAction::DROP);
+  auto tables4 = u3.updateDone();
+  ASSERT_NE(nullptr, tables4);
+  tables4->publish();
+  EXPECT_TRUE(GET_ROUTE_V4(tables4, rid, "8.8.8.0/24")->isDrop());
+  EXPECT_TRUE(GET_ROUTE_V6(tables4, rid, "8::/64")->isDrop());
+  EXPECT_TRUE(GET_ROUTE_V4(tables4, rid, "9.9.9.0/24")->isDrop());
+  EXPECT_EQ(viaIntf1, GET_ROUTE_V4(tables4, rid, "1.1.3.0/24")
+      ->getForwardInfo().getNexthops());
+
+  // Removing the more specific route brings back the old resolution
+  RouteUpdater u4(tables3);
+  u4.delNexthopsForClient(rid, IPAddress("1.1.3.0"), 28, CLIENT_A);
+  auto tables5 = u4.updateDone();
+  ASSERT_NE(nullptr, tables5);
+  tables5->publish();
+  EXPECT_EQ(viaIntf1,
+      GET_ROUTE_V4(tables5, rid, "8.8.8.0/24")->getForwardInfo().getNexthops());
+  EXPECT_EQ(viaIntf1,
+      GET_ROUTE_V6(tables5, rid, "8::/64")->getForwardInfo().getNexthops());
+
+  // Tables loaded from JSON have no nexthop index, and get fully resolved
+  auto tables6 = RouteTableMap::fromFollyDynamic(tables3->toFollyDynamic());
+  tables6->publish();
+  RouteUpdater u5(tables6);
+  u5.delNexthopsForClient(rid, IPAddress("1.1.3.0"), 28, CLIENT_A);
+  auto tables7 = u5.updateDone();
+  ASSERT_NE(nullptr, tables7);
+  tables7->publish();
+  EXPECT_EQ(viaIntf1,
+      GET_ROUTE_V4(tables7, rid, "8.8.8.0/24")->getForwardInfo().getNexthops());
+  auto table7 = tables7->getRouteTable(rid);
+  ASSERT_NE(nullptr, table7->getNexthopIndex());
+  EXPECT_TRUE(table7->getNexthopIndex()->isFor(
+        table7->getRibV4(), table7->getRibV6()));
+}
+
+namespace {
+template<typename AddrT>
+void expectAllRoutesPublished(const RouteTableRib<AddrT>& rib) {
+  EXPECT_TRUE(rib.isPublished());
+  for (const auto& rt : rib.routes()) {
+    EXPECT_TRUE(rt.value()->isPublished()) << rt.value()->str();
+  }
+}
+}
+
+TEST(Route, publishChangedRoutes) {
+  auto platform = createMockPlatform();
+  auto stateV0 = make_shared<SwitchState>();
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.vlans[0].id = 1;
+  config.vlans[1].id = 2;
+  config.interfaces.resize(2);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+  config.interfaces[1].intfID = 2;
+  config.interfaces[1].vlanID = 2;
+  config.interfaces[1].routerID = 0;
+  config.interfaces[1].__isset.mac = true;
+  config.interfaces[1].mac = "00:00:00:00:00:22";
+  config.interfaces[1].ipAddresses.resize(1);
+  config.interfaces[1].ipAddresses[0] = "2.2.2.2/24";
+
+  auto stateV1 = publishAndApplyConfig(stateV0, &config, platform.get());
+  ASSERT_NE(nullptr, stateV1);
+  stateV1->publish();
+
+  auto rid = RouterID(0);
+  RouteUpdater u1(stateV1->getRouteTables());
+  for (int i = 0; i < 10; ++i) {
+    auto network = IPAddressV4::fromLongHBO((10 << 24) | (i << 16));
+    u1.addRoute(rid, network, 16, CLIENT_A, makeNextHops({"1.1.1.10"}));
+  }
+  auto tables2 = u1.updateDone();
+  ASSERT_NE(nullptr, tables2);
+  tables2->publish();
+  EXPECT_TRUE(tables2->isPublished());
+  expectAllRoutesPublished(*tables2->getRouteTable(rid)->getRibV4());
+  expectAllRoutesPublished(*tables2->getRouteTable(rid)->getRibV6());
+
+  // Add, change and remove a route, all new route objects must get published
+  RouteUpdater u2(tables2);
+  u2.addRoute(rid, IPAddress("10.0.0.0"), 16,
+              CLIENT_A, makeNextHops({"2.2.2.10"}));
+  u2.addRoute(rid, IPAddress("20.0.0.0"), 8,
+              CLIENT_A, makeNextHops({"1.1.1.10"}));
+  u2.delNexthopsForClient(rid, IPAddress("10.1.0.0"), 16, CLIENT_A);
+  auto tables3 = u2.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  auto rt10 = GET_ROUTE_V4(tables3, rid, "10.0.0.0/16");
+  auto rt20 = GET_ROUTE_V4(tables3, rid, "20.0.0.0/8");
+  EXPECT_FALSE(rt10->isPublished());
+  EXPECT_FALSE(rt20->isPublished());
+  tables3->publish();
+  EXPECT_TRUE(tables3->isPublished());
+  EXPECT_TRUE(tables3->getRouteTable(rid)->isPublished());
+  EXPECT_TRUE(rt10->isPublished());
+  EXPECT_TRUE(rt20->isPublished());
+  expectAllRoutesPublished(*tables3->getRouteTable(rid)->getRibV4());
+
+  // Untracked changes still publish everything
+  auto rib = tables3->getRouteTable(rid)->getRibV4()->clone();
+  auto route = make_shared<RouteV4>(RoutePrefixV4{IPAddressV4("30.0.0.0"), 8},
+                                    RouteForwardAction::DROP);
+  rib->writableRoutes().insert(IPAddressV4("30.0.0.0"), 8, route);
+  rib->publish();
+  EXPECT_TRUE(route->isPublished());
+  expectAllRoutesPublished(*rib);
+}
+
+TEST(Route, routeBatch) {
+  auto platform = createMockPlatform();
+  auto stateV0 = make_shared<SwitchState>();
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.vlans[0].id = 1;
+  config.vlans[1].id = 2;
+  config.interfaces.resize(2);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+  config.interfaces[1].intfID = 2;
+  config.interfaces[1].vlanID = 2;
+  config.interfaces[1].routerID = 0;
+  config.interfaces[1].__isset.mac = true;
+  config.interfaces[1].mac = "00:00:00:00:00:22";
+  config.interfaces[1].ipAddresses.resize(1);
+  config.interfaces[1].ipAddresses[0] = "2.2.2.2/24";
+  auto stateV1 = publishAndApplyConfig(stateV0, &config, platform.get());
+  ASSERT_NE(nullptr, stateV1);
+  stateV1->publish();
+
+  auto rid = RouterID(0);
+  RouteUpdater u1(stateV1->getRouteTables());
+  u1.addRoute(rid, IPAddress("10.0.0.0"), 24,
+              CLIENT_A, makeNextHops({"1.1.1.10"}));
+  u1.addRoute(rid, IPAddress("10.0.1.0"), 24,
+              CLIENT_A, makeNextHops({"1.1.1.10"}));
+  u1.addRoute(rid, IPAddress("10::"), 64,
+              CLIENT_A, makeNextHops({"1.1.1.10"}));
+  u1.addRoute(rid, IPAddress("20.0.0.0"), 24,
+              CLIENT_A, makeNextHops({"1.1.1.10", "2.2.2.10"}));
+  u1.addRoute(rid, IPAddress("30.0.0.0"), 24,
+              CLIENT_A, makeNextHops({"99.99.99.99"}));
+  u1.addRoute(rid, IPAddress("40.0.0.0"), 24, RouteForwardAction::DROP);
+  auto stateV2 = stateV1->clone();
+  stateV2->resetRouteTables(u1.updateDone());
+  stateV2->publish();
+
+  // Routes with the same forwarding info are grouped across address
+  // families, and the unresolved 30.0.0.0/24 is left out
+  StateDelta delta1(stateV1, stateV2);
+  RouteBatch batch1(delta1);
+  EXPECT_EQ(0, batch1.numRemoved());
+  EXPECT_EQ(5, batch1.numAddedOrChanged());
+  ASSERT_EQ(3, batch1.getGroups().size());
+  for (const auto& group : batch1.getGroups()) {
+    EXPECT_EQ(rid, group.vrf);
+    if (group.fwd.isDrop()) {
+      ASSERT_EQ(1, group.v4.size());
+      EXPECT_EQ(GET_ROUTE_V4(stateV2->getRouteTables(), rid, "40.0.0.0/24"),
+                group.v4[0]);
+      EXPECT_EQ(0, group.v6.size());
+    } else if (group.fwd.getNexthops().size() == 2) {
+      EXPECT_EQ(1, group.v4.size());
+      EXPECT_EQ(0, group.v6.size());
+    } else {
+      EXPECT_EQ(2, group.v4.size());
+      EXPECT_EQ(1, group.v6.size());
+      for (const auto& route : group.v4) {
+        EXPECT_EQ(group.fwd, route->getForwardInfo());
+      }
+      EXPECT_EQ(group.fwd, group.v6[0]->getForwardInfo());
+    }
+  }
+
+  // Removing a route and making another one unresolved both remove them
+  RouteUpdater u2(stateV2->getRouteTables());
+  u2.delNexthopsForClient(rid, IPAddress("10.0.1.0"), 24, CLIENT_A);
+  u2.addRoute(rid, IPAddress("10::"), 64,
+              CLIENT_A, makeNextHops({"99.99.99.99"}));
+  u2.addRoute(rid, IPAddress("20.0.0.0"), 24,
+              CLIENT_A, makeNextHops({"2.2.2.10"}));
+  auto stateV3 = stateV2->clone();
+  stateV3->resetRouteTables(u2.updateDone());
+  stateV3->publish();
+
+  StateDelta delta2(stateV2, stateV3);
+  RouteBatch batch2(delta2);
+  ASSERT_EQ(1, batch2.getRemoved().size());
+  const auto& removed = batch2.getRemoved()[0];
+  ASSERT_EQ(1, removed.v4.size());
+  EXPECT_EQ(GET_ROUTE_V4(stateV2->getRouteTables(), rid, "10.0.1.0/24"),
+            removed.v4[0]);
+  ASSERT_EQ(1, removed.v6.size());
+  EXPECT_EQ(GET_ROUTE_V6(stateV2->getRouteTables(), rid, "10::/64"),
+            removed.v6[0]);
+  ASSERT_EQ(1, batch2.getGroups().size());
+  ASSERT_EQ(1, batch2.getGroups()[0].v4.size());
+  EXPECT_EQ(GET_ROUTE_V4(stateV3->getRouteTables(), rid, "20.0.0.0/24"),
+            batch2.getGroups()[0].v4[0]);
+}
+
 // Testing add and delete ECMP routes
 TEST(Route, addDel) {
   auto platform = createMockPlatform();
@@ -869,6 +1160,78 @@ TEST(RouteTableMap, applyConfig) {
   EXPECT_EQ(nullptr, publishAndApplyConfig(stateV4, &config, platform.get()));
 }
 
+TEST(RouteTableMap, applyConfigChangedSections) {
+  auto platform = createMockPlatform();
+  auto stateV0 = make_shared<SwitchState>();
+
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:00:00:00:00:11";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "1.1.1.1/24";
+
+  auto stateV1 = publishAndApplyConfig(stateV0, &config, platform.get());
+  ASSERT_NE(nullptr, stateV1);
+  stateV1->publish();
+
+  // Only the ARP settings change, so the interfaces and routes are left be
+  auto configV2 = config;
+  configV2.arpTimeoutSeconds = 100;
+  auto stateV2 = publishAndApplyConfig(stateV1, &configV2, platform.get(),
+                                       &config);
+  ASSERT_NE(nullptr, stateV2);
+  stateV2->publish();
+  EXPECT_EQ(stateV1->getInterfaces(), stateV2->getInterfaces());
+  EXPECT_EQ(stateV1->getVlans(), stateV2->getVlans());
+  EXPECT_EQ(stateV1->getRouteTables(), stateV2->getRouteTables());
+
+  // A static route through a new interface address resolves in the same
+  // pass as the interface route is added
+  auto configV3 = configV2;
+  configV3.interfaces[0].ipAddresses.resize(2);
+  configV3.interfaces[0].ipAddresses[1] = "2.2.2.1/24";
+  configV3.__isset.staticRoutesWithNhops = true;
+  configV3.staticRoutesWithNhops.resize(1);
+  configV3.staticRoutesWithNhops[0].routerID = 0;
+  configV3.staticRoutesWithNhops[0].prefix = "10.0.0.0/8";
+  configV3.staticRoutesWithNhops[0].nexthops.resize(1);
+  configV3.staticRoutesWithNhops[0].nexthops[0] = "2.2.2.2";
+  auto stateV3 = publishAndApplyConfig(stateV2, &configV3, platform.get(),
+                                       &configV2);
+  ASSERT_NE(nullptr, stateV3);
+  stateV3->publish();
+  auto tablesV3 = stateV3->getRouteTables();
+  EXPECT_EQ(stateV2->getRouteTables()->getGeneration() + 1,
+            tablesV3->getGeneration());
+  auto ribV3 = tablesV3->getRouteTable(RouterID(0))->getRibV4();
+  EXPECT_RESOLVED(ribV3->exactMatch({IPAddressV4("2.2.2.0"), 24}));
+  auto staticRoute = ribV3->exactMatch({IPAddressV4("10.0.0.0"), 8});
+  EXPECT_RESOLVED(staticRoute);
+  EXPECT_FWD_INFO(staticRoute, InterfaceID(1), "2.2.2.2");
+
+  // Nothing changed
+  EXPECT_EQ(nullptr, publishAndApplyConfig(stateV3, &configV3, platform.get(),
+                                           &configV3));
+
+  // Dropping the static route leaves the interface routes as they are
+  auto configV4 = configV3;
+  configV4.staticRoutesWithNhops.clear();
+  auto stateV4 = publishAndApplyConfig(stateV3, &configV4, platform.get(),
+                                       &configV3);
+  ASSERT_NE(nullptr, stateV4);
+  EXPECT_EQ(stateV3->getInterfaces(), stateV4->getInterfaces());
+  auto ribV4 = stateV4->getRouteTables()->getRouteTable(RouterID(0))
+    ->getRibV4();
+  EXPECT_EQ(nullptr, ribV4->exactMatch({IPAddressV4("10.0.0.0"), 8}));
+  EXPECT_NE(nullptr, ribV4->exactMatch({IPAddressV4("2.2.2.0"), 24}));
+}
+
 TEST(Route, changedRoutesPostUpdate) {
   auto platform = createMockPlatform();
   auto stateV0 = make_shared<SwitchState>();
@@ -971,6 +1334,59 @@ TEST(Route, changedRoutesPostUpdate) {
   stateV3->publish();
 }
 
+TEST(Route, ribDeltaSkipsSharedSubtrees) {
+  // Build a published RIB with a few thousand routes
+  auto rib1 = make_shared<RouteTableRib<IPAddressV4>>();
+  for (uint32_t i = 0; i < 4096; ++i) {
+    RouteV4::Prefix prefix{IPAddressV4::fromLongHBO((10 << 24) | (i << 8)),
+                           24};
+    rib1->addRoute(make_shared<RouteV4>(prefix, RouteForwardAction::DROP));
+  }
+  rib1->publish();
+
+  using RibV4Delta = RibDelta<IPAddressV4>;
+  auto countChanges = [](const RibV4Delta& delta) {
+    auto cnt = 0;
+    for (auto itr = delta.begin(); itr != delta.end(); ++itr, ++cnt);
+    return cnt;
+  };
+  auto rib2 = rib1->clone();
+  EXPECT_EQ(0, countChanges(RibV4Delta(rib1.get(), rib2.get())));
+
+  // One route added, one removed and one replaced
+  RouteV4::Prefix added{IPAddressV4("11.0.0.0"), 8};
+  RouteV4::Prefix removed{IPAddressV4("10.0.1.0"), 24};
+  RouteV4::Prefix changed{IPAddressV4("10.0.2.0"), 24};
+  rib2->addRoute(make_shared<RouteV4>(added, RouteForwardAction::TO_CPU));
+  rib2->removeRoute(rib1->exactMatch(removed));
+  rib2->updateRoute(make_shared<RouteV4>(changed, RouteForwardAction::TO_CPU));
+
+  std::set<RouteV4::Prefix> foundChanged, foundAdded, foundRemoved;
+  RibV4Delta delta(rib1.get(), rib2.get());
+  DeltaFunctions::forEachChanged(
+      delta,
+      [&] (const shared_ptr<RouteV4>& oldRt,
+           const shared_ptr<RouteV4>& newRt) {
+        EXPECT_EQ(oldRt->prefix(), newRt->prefix());
+        EXPECT_NE(oldRt, newRt);
+        foundChanged.insert(newRt->prefix());
+      },
+      [&] (const shared_ptr<RouteV4>& rt) {
+        foundAdded.insert(rt->prefix());
+      },
+      [&] (const shared_ptr<RouteV4>& rt) {
+        foundRemoved.insert(rt->prefix());
+      });
+  EXPECT_EQ(std::set<RouteV4::Prefix>{changed}, foundChanged);
+  EXPECT_EQ(std::set<RouteV4::Prefix>{added}, foundAdded);
+  EXPECT_EQ(std::set<RouteV4::Prefix>{removed}, foundRemoved);
+  EXPECT_EQ(3, countChanges(delta));
+
+  // A missing RIB on one side shows up as all routes added or removed
+  EXPECT_EQ(4096, countChanges(RibV4Delta(nullptr, rib1.get())));
+  EXPECT_EQ(4096, countChanges(RibV4Delta(rib1.get(), nullptr)));
+}
+
 TEST(Route, PruneAddedRoutes) {
   // start with one interface (21)
   // Add two routes (r1prefix, r2prefix)
@@ -9,6 +9,7 @@
  */
 #include "common/stats/ServiceData.h"
 #include <folly/Memory.h>
+#include <folly/Baton.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include "fboss/agent/AddressUtil.h"
@@ -1352,3 +1353,43 @@ TEST(ArpTest, PortFlapRecover) {
   EXPECT_EQ(entry2->isPending(), false);
   EXPECT_EQ(entry3->isPending(), false);
 }
+
+TEST(ArpTest, BatchedUpdates) {
+  auto sw = setupSwitch();
+  VlanID vlanID(1);
+  auto getArpTable = [&]() {
+    return sw->getState()->getVlans()->getVlanIf(vlanID)->getArpTable();
+  };
+  auto origGeneration = getArpTable()->getGeneration();
+
+  // Hold up the update thread, so that the entries learned from the ARP
+  // replies all queue up behind it
+  folly::Baton<> blocked;
+  folly::Baton<> release;
+  sw->updateState("block updates",
+    [&](const shared_ptr<SwitchState>&) -> shared_ptr<SwitchState> {
+      blocked.post();
+      release.wait();
+      return nullptr;
+    });
+  blocked.wait();
+
+  sendArpReply(sw.get(), "10.0.0.11", "02:10:20:30:40:11", 1);
+  sendArpReply(sw.get(), "10.0.0.12", "02:10:20:30:40:12", 2);
+  sendArpReply(sw.get(), "10.0.0.13", "02:10:20:30:40:13", 3);
+  sendArpReply(sw.get(), "10.0.0.14", "02:10:20:30:40:14", 4);
+  waitForBackgroundThread(sw.get());
+
+  EXPECT_HW_CALL(sw, stateChanged(_)).Times(1);
+  release.post();
+  waitForStateUpdates(sw.get());
+
+  // All four entries went in with a single copy of the ARP table
+  auto arpTable = getArpTable();
+  EXPECT_EQ(origGeneration + 1, arpTable->getGeneration());
+  for (const auto* ip : {"10.0.0.11", "10.0.0.12", "10.0.0.13", "10.0.0.14"}) {
+    auto entry = arpTable->getEntryIf(IPAddressV4(ip));
+    ASSERT_NE(nullptr, entry);
+    EXPECT_FALSE(entry->isPending());
+  }
+}
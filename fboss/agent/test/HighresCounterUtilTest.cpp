@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HighresCounterUtil.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+CounterRequest makeRequest(const string& ns, const string& name) {
+  CounterRequest req;
+  req.namespaceName = ns;
+  req.counterName = name;
+  return req;
+}
+
+const char* const kProcNetDev =
+  "Inter-|   Receive                                                |"
+  "  Transmit\n"
+  " face |bytes    packets errs drop fifo frame compressed multicast|"
+  "bytes    packets errs drop fifo colls carrier compressed\n"
+  "    lo:  123456     100    0    0    0     0          0         0"
+  "   123456     100    0    0    0     0       0          0\n"
+  "  eth0: 1000 10 0 0 0 0 0 0 2000 20 0 0 0 0 0 0\n"
+  "  eth1:300    3    0    0    0     0          0         0"
+  "      400    4    0    0    0     0       0          0\n"
+  "  tap0: 5 1 0 0 0 0 0 0 6 1 0 0 0 0 0 0\n";
+
+}
+
+TEST(HighresCounterUtil, ParseProcNetDev) {
+  uint64_t rx = 0;
+  uint64_t tx = 0;
+  InterfaceRateSampler::parseProcNetDev(kProcNetDev, &rx, &tx);
+  // Only the eth interfaces count, with or without a space after the colon
+  EXPECT_EQ(1300, rx);
+  EXPECT_EQ(2400, tx);
+
+  // A truncated last line still counts what is there
+  InterfaceRateSampler::parseProcNetDev(
+      "  eth0: 1000 10 0 0 0 0 0 0 2000\n  eth1: 7", &rx, &tx);
+  EXPECT_EQ(1007, rx);
+  EXPECT_EQ(2000, tx);
+
+  InterfaceRateSampler::parseProcNetDev("", &rx, &tx);
+  EXPECT_EQ(0, rx);
+  EXPECT_EQ(0, tx);
+}
+
+TEST(HighresCounterUtil, PortCounterSampler) {
+  uint64_t base = 0;
+  auto read = [&](PortID port, uint64_t* values) {
+    auto idx = static_cast<uint16_t>(port);
+    if (idx == 0 || idx > 4) {
+      return false;
+    }
+    for (int i = 0; i < PortCounterSampler::NUM_STATS; ++i) {
+      values[i] = base + idx * 10 + i;
+    }
+    return true;
+  };
+
+  auto ns = PortCounterSampler::kIdentifier;
+  set<CounterRequest> counters{
+    makeRequest(ns, "port1.in_bytes"),
+    makeRequest(ns, "port1.out_pkts"),
+    makeRequest(ns, "port3.out_bytes"),
+    // None of these exist
+    makeRequest(ns, "port5.in_bytes"),
+    makeRequest(ns, "port1.foo"),
+    makeRequest(ns, "portx.in_bytes"),
+    makeRequest(ns, "eth0.in_bytes"),
+  };
+  PortCounterSampler sampler(counters, read);
+  EXPECT_EQ(3, sampler.numCounters());
+
+  CounterPublication pub;
+  sampler.startPublication(&pub, 2);
+  sampler.sample(&pub);
+  base = 100;
+  sampler.sample(&pub);
+
+  EXPECT_EQ(3, pub.counterValues.size());
+  EXPECT_EQ((vector<int64_t>{10, 110}),
+            pub.counterValues[makeRequest(ns, "port1.in_bytes")]);
+  EXPECT_EQ((vector<int64_t>{13, 113}),
+            pub.counterValues[makeRequest(ns, "port1.out_pkts")]);
+  EXPECT_EQ((vector<int64_t>{32, 132}),
+            pub.counterValues[makeRequest(ns, "port3.out_bytes")]);
+
+  // A new publication starts new columns
+  CounterPublication pub2;
+  sampler.startPublication(&pub2, 1);
+  sampler.sample(&pub2);
+  EXPECT_EQ((vector<int64_t>{110}),
+            pub2.counterValues[makeRequest(ns, "port1.in_bytes")]);
+  EXPECT_EQ(2, pub.counterValues[makeRequest(ns, "port1.in_bytes")].size());
+}
+
+TEST(HighresCounterUtil, DumbCounterSampler) {
+  auto ns = DumbCounterSampler::kIdentifier;
+  DumbCounterSampler sampler(
+      {makeRequest(ns, DumbCounterSampler::kDumbCounterName),
+       makeRequest(ns, "bar")});
+  EXPECT_EQ(1, sampler.numCounters());
+
+  CounterPublication pub;
+  sampler.startPublication(&pub, 3);
+  for (int i = 0; i < 3; ++i) {
+    sampler.sample(&pub);
+  }
+  EXPECT_EQ((vector<int64_t>{1, 2, 3}),
+            pub.counterValues[makeRequest(
+                ns, DumbCounterSampler::kDumbCounterName)]);
+}
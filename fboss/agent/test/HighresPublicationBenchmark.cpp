@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <cstdio>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/Memory.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include "fboss/agent/HighresPublicationCodec.h"
+
+using namespace facebook::fboss;
+using apache::thrift::CompactSerializer;
+using std::make_unique;
+using std::string;
+using std::unique_ptr;
+
+namespace {
+
+/*
+ * These benchmarks compare the cost of publishing highres samples as
+ * CounterPublication structs and in the COMPACT format, from the samples
+ * being in a publication to it being serialized for the wire.  The time
+ * reported is per round of samples, for 10 µs samples of byte counters in
+ * batches of kBatchSize.  The bytes sent per round are printed at the end.
+ */
+constexpr int kBatchSize = 100;
+constexpr int64_t kStartNs = 1500000000LL * 1000000000LL;
+constexpr int64_t kIntervalNs = 10000;
+
+void addSample(CounterPublication* pub, unsigned numCounters, int64_t n) {
+  auto ns = kStartNs + n * kIntervalNs;
+  pub->times.emplace_back(apache::thrift::FragileConstructor::FRAGILE,
+                          ns / 1000000000, ns % 1000000000);
+  auto column = pub->counterValues.begin();
+  for (unsigned c = 0; c < numCounters; ++c, ++column) {
+    column->second.push_back(c * 1000000000LL + n * (1000 + c));
+  }
+}
+
+void addCounters(CounterPublication* pub, unsigned numCounters) {
+  for (unsigned c = 0; c < numCounters; ++c) {
+    CounterRequest req;
+    req.namespaceName = "benchmark";
+    req.counterName = folly::to<string>("counter", c);
+    pub->counterValues[req];
+  }
+}
+
+// Publish numIters samples, returning the number of bytes sent
+size_t publishStructs(unsigned numIters, unsigned numCounters) {
+  size_t bytes = 0;
+  auto pub = make_unique<CounterPublication>();
+  addCounters(pub.get(), numCounters);
+  for (unsigned n = 0; n < numIters; ++n) {
+    addSample(pub.get(), numCounters, n);
+    if ((n + 1) % kBatchSize == 0) {
+      bytes += CompactSerializer::serialize<string>(*pub).size();
+      pub = make_unique<CounterPublication>();
+      addCounters(pub.get(), numCounters);
+    }
+  }
+  return bytes;
+}
+
+size_t publishCompact(unsigned numIters, unsigned numCounters) {
+  size_t bytes = 0;
+  CompactPublicationEncoder encoder("switch1");
+  CounterPublication pub;
+  addCounters(&pub, numCounters);
+  for (unsigned n = 0; n < numIters; ++n) {
+    addSample(&pub, numCounters, n);
+    if ((n + 1) % kBatchSize == 0) {
+      auto compact = encoder.encode(&pub);
+      bytes += CompactSerializer::serialize<string>(*compact).size();
+    }
+  }
+  return bytes;
+}
+
+} // unnamed namespace
+
+void StructPublication(unsigned numIters, unsigned numCounters) {
+  folly::doNotOptimizeAway(publishStructs(numIters, numCounters));
+}
+
+void CompactPublication(unsigned numIters, unsigned numCounters) {
+  folly::doNotOptimizeAway(publishCompact(numIters, numCounters));
+}
+
+BENCHMARK_PARAM(StructPublication, 1)
+BENCHMARK_RELATIVE_PARAM(CompactPublication, 1)
+BENCHMARK_PARAM(StructPublication, 16)
+BENCHMARK_RELATIVE_PARAM(CompactPublication, 16)
+BENCHMARK_PARAM(StructPublication, 128)
+BENCHMARK_RELATIVE_PARAM(CompactPublication, 128)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+
+  const unsigned kRounds = 100 * kBatchSize;
+  for (unsigned numCounters : {1, 16, 128}) {
+    printf("%u counters: %.1f bytes/round as structs, "
+           "%.1f bytes/round compact\n",
+           numCounters,
+           double(publishStructs(kRounds, numCounters)) / kRounds,
+           double(publishCompact(kRounds, numCounters)) / kRounds);
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/HighresPublicationCodec.h"
+
+#include "fboss/agent/FbossError.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using std::string;
+using std::vector;
+
+namespace {
+
+CounterRequest makeRequest(const string& name) {
+  CounterRequest req;
+  req.namespaceName = "test";
+  req.counterName = name;
+  return req;
+}
+
+void addSample(CounterPublication* pub,
+               int64_t seconds,
+               int64_t nanoseconds,
+               const vector<int64_t>& values) {
+  pub->times.emplace_back(
+      apache::thrift::FragileConstructor::FRAGILE, seconds, nanoseconds);
+  for (size_t i = 0; i < values.size(); ++i) {
+    pub->counterValues[makeRequest(folly::to<string>("c", i))].push_back(
+        values[i]);
+  }
+}
+
+}
+
+TEST(HighresPublicationCodec, Negotiate) {
+  EXPECT_EQ(PublicationFormat::STRUCT, negotiatePublicationFormat({}));
+  EXPECT_EQ(PublicationFormat::STRUCT,
+            negotiatePublicationFormat({PublicationFormat::STRUCT}));
+  EXPECT_EQ(PublicationFormat::COMPACT,
+            negotiatePublicationFormat(
+                {PublicationFormat::STRUCT, PublicationFormat::COMPACT}));
+}
+
+TEST(HighresPublicationCodec, RoundTrip) {
+  CompactPublicationEncoder encoder("host1");
+  CompactPublicationDecoder decoder;
+
+  // The same publication is refilled for each batch, as SampleProducer does
+  CounterPublication pub;
+  vector<CounterPublication> expected;
+  int64_t time = 1500000000LL * 1000000000LL + 999999990;
+  for (int batch = 0; batch < 3; ++batch) {
+    for (int i = 0; i < 4; ++i) {
+      time += 10 + i;
+      int64_t n = batch * 4 + i;
+      addSample(&pub, time / 1000000000, time % 1000000000,
+                // A counter going up, one going down through zero, and the
+                // extremes
+                {1000000 + n * 1500, 10 - n * 3,
+                 n % 2 ? INT64_MAX : INT64_MIN});
+    }
+    expected.push_back(pub);
+    expected.back().hostname = "host1";
+
+    auto compact = encoder.encode(&pub);
+    EXPECT_EQ("host1", compact->hostname);
+    EXPECT_EQ(batch, compact->seqNum);
+    EXPECT_EQ(4, compact->numSamples);
+    // The counters are only sent with the first batch
+    EXPECT_EQ(batch == 0 ? 3 : 0, compact->counters.size());
+    // Each time delta takes a byte
+    EXPECT_EQ(batch == 0 ? 12 : 4, compact->times.size());
+
+    // The publication is left empty, but with its columns
+    EXPECT_TRUE(pub.times.empty());
+    EXPECT_EQ(3, pub.counterValues.size());
+    for (const auto& column : pub.counterValues) {
+      EXPECT_TRUE(column.second.empty());
+    }
+
+    CounterPublication decoded;
+    decoder.decode(*compact, &decoded);
+    EXPECT_EQ(expected.back(), decoded);
+  }
+}
+
+TEST(HighresPublicationCodec, OutOfSequence) {
+  CompactPublicationEncoder encoder("host1");
+  CompactPublicationDecoder decoder;
+  CounterPublication pub;
+  CounterPublication decoded;
+
+  addSample(&pub, 1, 0, {1});
+  decoder.decode(*encoder.encode(&pub), &decoded);
+  addSample(&pub, 2, 0, {2});
+  encoder.encode(&pub);
+  addSample(&pub, 3, 0, {3});
+  EXPECT_THROW(decoder.decode(*encoder.encode(&pub), &decoded), FbossError);
+}
+
+TEST(HighresPublicationCodec, Truncated) {
+  CompactPublicationEncoder encoder("host1");
+  CompactPublicationDecoder decoder;
+  CounterPublication pub;
+  CounterPublication decoded;
+
+  addSample(&pub, 1, 0, {1, 1000});
+  addSample(&pub, 2, 0, {2, 2000});
+  auto compact = encoder.encode(&pub);
+  compact->values.resize(compact->values.size() - 1);
+  EXPECT_THROW(decoder.decode(*compact, &decoded), FbossError);
+}
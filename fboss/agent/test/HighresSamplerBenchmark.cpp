@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/Memory.h>
+#include "fboss/agent/HighresCounterUtil.h"
+#include "fboss/agent/hw/sim/SimSwitch.h"
+
+using namespace facebook::fboss;
+using std::make_unique;
+using std::set;
+using std::string;
+using std::unique_ptr;
+
+namespace {
+
+/*
+ * These benchmarks take rounds of samples the way a highres subscription's
+ * SampleProducer does, starting a new publication every kBatchSize rounds.
+ * The time reported is per round, so the iterations per second are the
+ * highest sampling rate a subscription could get from each sampler.
+ */
+constexpr int kBatchSize = 100;
+constexpr int kNumPorts = 32;
+
+CounterRequest makeRequest(const string& ns, const string& name) {
+  CounterRequest req;
+  req.namespaceName = ns;
+  req.counterName = name;
+  return req;
+}
+
+void sampleRounds(HighresSampler* sampler, unsigned numIters) {
+  auto pub = make_unique<CounterPublication>();
+  sampler->startPublication(pub.get(), kBatchSize);
+  for (unsigned n = 0; n < numIters; ++n) {
+    sampler->sample(pub.get());
+    if ((n + 1) % kBatchSize == 0) {
+      folly::BenchmarkSuspender braces;
+      pub = make_unique<CounterPublication>();
+      sampler->startPublication(pub.get(), kBatchSize);
+    }
+  }
+}
+
+} // unnamed namespace
+
+BENCHMARK(DumbCounterSampler, numIters) {
+  folly::BenchmarkSuspender braces;
+  auto ns = DumbCounterSampler::kIdentifier;
+  DumbCounterSampler sampler(
+      {makeRequest(ns, DumbCounterSampler::kDumbCounterName)});
+  braces.dismiss();
+
+  sampleRounds(&sampler, numIters);
+}
+
+BENCHMARK(InterfaceRateSampler, numIters) {
+  folly::BenchmarkSuspender braces;
+  auto ns = InterfaceRateSampler::kIdentifier;
+  InterfaceRateSampler sampler(
+      {makeRequest(ns, InterfaceRateSampler::kTxBytesCounterName),
+       makeRequest(ns, InterfaceRateSampler::kRxBytesCounterName)});
+  CHECK_EQ(sampler.numCounters(), 2);
+  braces.dismiss();
+
+  sampleRounds(&sampler, numIters);
+}
+
+/*
+ * Every counter of every port of a SimSwitch, through the sampler it hands
+ * out from getHighresSamplers().
+ */
+BENCHMARK(PortCounterSampler, numIters) {
+  folly::BenchmarkSuspender braces;
+  SimSwitch sim(nullptr, kNumPorts);
+  auto ns = PortCounterSampler::kIdentifier;
+  set<CounterRequest> counters;
+  for (int port = 1; port <= kNumPorts; ++port) {
+    for (auto stat : PortCounterSampler::kStatNames) {
+      counters.insert(
+          makeRequest(ns, folly::to<string>("port", port, ".", stat)));
+    }
+  }
+  HighresSamplerList samplers;
+  CHECK_EQ(sim.getHighresSamplers(&samplers, ns, counters),
+           kNumPorts * PortCounterSampler::NUM_STATS);
+  braces.dismiss();
+
+  sampleRounds(samplers.front().get(), numIters);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <boost/cast.hpp>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Memory.h>
+#include <map>
+#include "fboss/agent/PacketDispatcher.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/sim/SimPlatform.h"
+#include "fboss/agent/hw/sim/SimSwitch.h"
+#include "fboss/agent/state/ArpResponseTable.h"
+#include "fboss/agent/state/Interface.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+DECLARE_int32(packet_dispatch_threads);
+DECLARE_int32(packet_dispatch_queue_depth);
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::make_shared;
+using std::make_unique;
+using std::shared_ptr;
+using std::unique_ptr;
+
+namespace {
+
+/*
+ * These benchmarks simulate an ARP storm: ARP requests for the switch's own
+ * address arrive from kNumPorts ports, through SimSwitch::injectPacket(),
+ * and each one is answered with an ARP reply.  The time reported is per
+ * request, from injecting it to its reply being sent, for a switch handling
+ * trapped packets in the RX thread (0 threads) and with each number of
+ * dispatch threads.
+ *
+ * The dispatch queues are made deep enough that no requests are dropped, so
+ * that only the packet handling throughput is measured.
+ */
+constexpr int kNumPorts = 16;
+const MacAddress kLocalMac("02:00:01:00:00:01");
+
+// A switch for each number of dispatch threads
+std::map<unsigned, unique_ptr<SwSwitch>> switches;
+// An ARP request from each port
+std::vector<unique_ptr<MockRxPacket>> arpRequests;
+
+unique_ptr<SwSwitch> setupSwitch(unsigned numThreads) {
+  FLAGS_packet_dispatch_threads = numThreads;
+  auto sw = make_unique<SwSwitch>(
+      make_unique<SimPlatform>(kLocalMac, kNumPorts));
+  sw->init(nullptr /* No custom TunManager */);
+
+  auto updateFn = [&](const shared_ptr<SwitchState>& oldState) {
+    auto state = oldState->clone();
+
+    auto vlan1 = make_shared<Vlan>(VlanID(1), "Vlan1");
+    state->addVlan(vlan1);
+    for (int idx = 1; idx <= kNumPorts; ++idx) {
+      vlan1->addPort(PortID(idx), false);
+    }
+    auto intf1 = make_shared<Interface>(
+        InterfaceID(1),
+        RouterID(0),
+        VlanID(1),
+        "interface1",
+        kLocalMac,
+        9000,
+        false /* is virtual */);
+    Interface::Addresses addrs1;
+    addrs1.emplace(IPAddress("10.0.0.1"), 24);
+    intf1->setAddresses(addrs1);
+    state->addIntf(intf1);
+
+    auto respTable1 = make_shared<ArpResponseTable>();
+    respTable1->setEntry(IPAddressV4("10.0.0.1"), kLocalMac, InterfaceID(1));
+    state->getVlans()->getVlan(VlanID(1))->setArpResponseTable(respTable1);
+    return state;
+  };
+
+  sw->updateStateBlocking("setup", updateFn);
+  return sw;
+}
+
+void init() {
+  FLAGS_packet_dispatch_queue_depth = 1 << 20;
+  for (unsigned numThreads : {0, 1, 2, 4, 8}) {
+    switches[numThreads] = setupSwitch(numThreads);
+  }
+
+  for (int idx = 1; idx <= kNumPorts; ++idx) {
+    // An ARP request for 10.0.0.1 from 10.0.0.(100 + idx)
+    auto pkt = MockRxPacket::fromHex(folly::sformat(
+        // dst mac, src mac
+        "ff ff ff ff ff ff  00 02 00 01 02 {0:02x}"
+        // 802.1q, VLAN 1
+        "81 00  00 01"
+        // ARP, htype: ethernet, ptype: IPv4, hlen: 6, plen: 4
+        "08 06  00 01  08 00  06  04"
+        // ARP Request
+        "00 01"
+        // Sender MAC
+        "00 02 00 01 02 {0:02x}"
+        // Sender IP
+        "0a 00 00 {1:02x}"
+        // Target MAC
+        "00 00 00 00 00 00"
+        // Target IP: 10.0.0.1
+        "0a 00 00 01",
+        idx, 100 + idx));
+    pkt->padToLength(68);
+    pkt->setSrcPort(PortID(idx));
+    pkt->setSrcVlan(VlanID(1));
+    arpRequests.push_back(std::move(pkt));
+  }
+}
+
+void arpStorm(unsigned numIters, unsigned numThreads) {
+  folly::BenchmarkSuspender braces;
+  auto* sw = switches[numThreads].get();
+  auto* sim = boost::polymorphic_downcast<SimSwitch*>(sw->getHw());
+  sim->resetTxCount();
+  braces.dismiss();
+
+  for (unsigned n = 0; n < numIters; ++n) {
+    sim->injectPacket(arpRequests[n % kNumPorts]->clone());
+  }
+  if (auto* dispatcher = sw->getPacketDispatcher()) {
+    dispatcher->flush();
+  }
+
+  braces.rehire();
+  CHECK_EQ(sim->getTxCount(), numIters);
+}
+
+} // unnamed namespace
+
+void ArpStorm(unsigned numIters, unsigned numThreads) {
+  arpStorm(numIters, numThreads);
+}
+
+BENCHMARK_PARAM(ArpStorm, 0)
+BENCHMARK_PARAM(ArpStorm, 1)
+BENCHMARK_PARAM(ArpStorm, 2)
+BENCHMARK_PARAM(ArpStorm, 4)
+BENCHMARK_PARAM(ArpStorm, 8)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  init();
+  folly::runBenchmarks();
+  switches.clear();
+  return 0;
+}
@@ -0,0 +1,308 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/PacketDispatcher.h"
+
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/SwitchStats.h"
+#include "fboss/agent/hw/mock/MockHwSwitch.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/state/ArpEntry.h"
+#include "fboss/agent/state/ArpTable.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+#include "fboss/agent/test/CounterCache.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <folly/Baton.h>
+#include <folly/Conv.h>
+#include <folly/IPAddressV4.h>
+#include <folly/MacAddress.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+DECLARE_int32(packet_dispatch_threads);
+
+using namespace facebook::fboss;
+using folly::IOBuf;
+using folly::IPAddressV4;
+using folly::MacAddress;
+using std::unique_ptr;
+
+using ::testing::_;
+
+namespace {
+
+constexpr uint16_t kEthertypeArp = 0x0806;
+constexpr uint16_t kEthertypeLldp = 0x88cc;
+
+unique_ptr<RxPacket> makePkt(PortID port) {
+  auto pkt = MockRxPacket::fromHex(
+    // dst mac, src mac
+    "02 00 01 00 00 01  02 00 02 01 02 03"
+    // 802.1q, VLAN 1
+    "81 00 00 01"
+    // Ethertype (ARP), no payload
+    "08 06"
+  );
+  pkt->padToLength(68);
+  pkt->setSrcPort(port);
+  pkt->setSrcVlan(VlanID(1));
+  return std::move(pkt);
+}
+
+/*
+ * The dispatcher only looks at the ethertype and the source port, so the
+ * tests number their packets in the source MAC of the header.
+ */
+L2Header makeHdr(uint16_t ethertype, uint64_t seq) {
+  L2Header hdr;
+  hdr.src = MacAddress::fromHBO(seq);
+  hdr.ethertype = ethertype;
+  hdr.l3Offset = 18;
+  return hdr;
+}
+
+/*
+ * Records the packets handled, by ethertype and source port.
+ */
+class HandledPkts {
+ public:
+  PacketDispatcher::Handler handler() {
+    return [this](unique_ptr<RxPacket> pkt, const L2Header& hdr) {
+      std::lock_guard<std::mutex> g(mutex_);
+      auto key = std::make_pair(hdr.ethertype, pkt->getSrcPort());
+      seqs_[key].push_back(hdr.src.u64HBO());
+      ++count_;
+    };
+  }
+
+  size_t count() {
+    std::lock_guard<std::mutex> g(mutex_);
+    return count_;
+  }
+
+  std::map<std::pair<uint16_t, PortID>, std::vector<uint64_t>> seqs() {
+    std::lock_guard<std::mutex> g(mutex_);
+    return seqs_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<std::pair<uint16_t, PortID>, std::vector<uint64_t>> seqs_;
+  size_t count_{0};
+};
+
+unique_ptr<RxPacket> makeArpRequest(IPAddressV4 senderIP,
+                                    MacAddress senderMac,
+                                    PortID port) {
+  // The target IP belongs to the switch in testConfigA()
+  IPAddressV4 targetIP("10.0.0.1");
+  auto buf = IOBuf::create(68);
+  folly::io::Appender cursor(buf.get(), 0);
+  cursor.push(MacAddress::BROADCAST.bytes(), MacAddress::SIZE);
+  cursor.push(senderMac.bytes(), MacAddress::SIZE);
+  cursor.writeBE<uint16_t>(0x8100); // 802.1Q
+  cursor.writeBE<uint16_t>(1); // VLAN 1
+  cursor.writeBE<uint16_t>(kEthertypeArp);
+  cursor.writeBE<uint16_t>(1); // htype: ethernet
+  cursor.writeBE<uint16_t>(0x0800); // ptype: IPv4
+  cursor.writeBE<uint8_t>(6); // hlen: 6
+  cursor.writeBE<uint8_t>(4); // plen: 4
+  cursor.writeBE<uint16_t>(1); // ARP request
+  cursor.push(senderMac.bytes(), MacAddress::SIZE); // sender MAC
+  cursor.write<uint32_t>(senderIP.toLong()); // sender IP
+  cursor.push(MacAddress::ZERO.bytes(), MacAddress::SIZE); // target MAC
+  cursor.write<uint32_t>(targetIP.toLong()); // target IP
+
+  auto pkt = std::make_unique<MockRxPacket>(std::move(buf));
+  pkt->padToLength(68);
+  pkt->setSrcPort(port);
+  pkt->setSrcVlan(VlanID(1));
+  return std::move(pkt);
+}
+
+} // unnamed namespace
+
+TEST(PacketDispatcherTest, OrderPerTypeAndPort) {
+  constexpr int kNumPorts = 8;
+  constexpr int kNumPkts = 2000;
+  auto sw = createMockSw();
+  HandledPkts handled;
+  PacketDispatcher dispatcher(sw.get(), 4, kNumPkts * 2, handled.handler());
+  EXPECT_EQ(4, dispatcher.numQueues());
+
+  for (uint64_t seq = 0; seq < kNumPkts; ++seq) {
+    PortID port(seq % kNumPorts + 1);
+    EXPECT_TRUE(dispatcher.dispatch(makePkt(port),
+                                    makeHdr(kEthertypeArp, seq)));
+    EXPECT_TRUE(dispatcher.dispatch(makePkt(port),
+                                    makeHdr(kEthertypeLldp, seq)));
+  }
+  dispatcher.flush();
+
+  EXPECT_EQ(kNumPkts * 2, handled.count());
+  auto seqs = handled.seqs();
+  EXPECT_EQ(kNumPorts * 2, seqs.size());
+  for (const auto& entry : seqs) {
+    SCOPED_TRACE(folly::to<std::string>(
+        "ethertype ", entry.first.first,
+        " port ", static_cast<uint16_t>(entry.first.second)));
+    EXPECT_EQ(kNumPkts / kNumPorts, entry.second.size());
+    EXPECT_TRUE(std::is_sorted(entry.second.begin(), entry.second.end()));
+  }
+}
+
+TEST(PacketDispatcherTest, DropWhenQueueFull) {
+  auto sw = createMockSw();
+  folly::Baton<> started;
+  folly::Baton<> release;
+  std::atomic<int> count{0};
+  // One queue with room for two packets, and a handler that holds up the
+  // first packet until we let it go
+  PacketDispatcher dispatcher(sw.get(), 1, 2,
+      [&](unique_ptr<RxPacket> /*pkt*/, const L2Header& /*hdr*/) {
+        if (count++ == 0) {
+          started.post();
+          release.wait();
+        }
+      });
+  CounterCache counters(sw.get());
+
+  EXPECT_TRUE(dispatcher.dispatch(makePkt(PortID(1)),
+                                  makeHdr(kEthertypeArp, 0)));
+  started.wait();
+  EXPECT_TRUE(dispatcher.dispatch(makePkt(PortID(1)),
+                                  makeHdr(kEthertypeArp, 1)));
+  EXPECT_TRUE(dispatcher.dispatch(makePkt(PortID(1)),
+                                  makeHdr(kEthertypeArp, 2)));
+  EXPECT_FALSE(dispatcher.dispatch(makePkt(PortID(1)),
+                                   makeHdr(kEthertypeArp, 3)));
+
+  counters.update();
+  counters.checkDelta(
+      SwitchStats::kCounterPrefix + "dispatch_queue.0.drops.sum", 1);
+  counters.checkDelta(
+      SwitchStats::kCounterPrefix + "trapped.dispatch_drops.sum", 1);
+  counters.checkDelta(SwitchStats::kCounterPrefix + "trapped.drops.sum", 1);
+
+  release.post();
+  dispatcher.flush();
+  EXPECT_EQ(3, count.load());
+}
+
+TEST(PacketDispatcherTest, Flush) {
+  constexpr int kNumPkts = 50;
+  auto sw = createMockSw();
+  std::atomic<int> count{0};
+  PacketDispatcher dispatcher(sw.get(), 2, kNumPkts,
+      [&](unique_ptr<RxPacket> /*pkt*/, const L2Header& /*hdr*/) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++count;
+      });
+
+  // Nothing to wait for
+  dispatcher.flush();
+  EXPECT_EQ(0, count.load());
+
+  for (int n = 0; n < kNumPkts; ++n) {
+    EXPECT_TRUE(dispatcher.dispatch(makePkt(PortID(n % 4 + 1)),
+                                    makeHdr(kEthertypeArp, n)));
+  }
+  dispatcher.flush();
+  EXPECT_EQ(kNumPkts, count.load());
+}
+
+TEST(PacketDispatcherTest, DrainOnShutdown) {
+  constexpr int kNumPkts = 10;
+  auto sw = createMockSw();
+  folly::Baton<> started;
+  folly::Baton<> release;
+  std::atomic<int> count{0};
+  auto dispatcher = std::make_unique<PacketDispatcher>(
+      sw.get(), 1, kNumPkts * 2,
+      [&](unique_ptr<RxPacket> /*pkt*/, const L2Header& /*hdr*/) {
+        if (count++ == 0) {
+          started.post();
+          release.wait();
+        }
+      });
+
+  EXPECT_TRUE(dispatcher->dispatch(makePkt(PortID(1)),
+                                   makeHdr(kEthertypeArp, 0)));
+  started.wait();
+  for (int n = 1; n <= kNumPkts; ++n) {
+    EXPECT_TRUE(dispatcher->dispatch(makePkt(PortID(1)),
+                                     makeHdr(kEthertypeArp, n)));
+  }
+
+  // The packets are still queued behind the first one when the dispatcher
+  // is destroyed, and are handled before it returns
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release.post();
+  });
+  dispatcher.reset();
+  releaser.join();
+  EXPECT_EQ(kNumPkts + 1, count.load());
+}
+
+// Run the real handlers on several dispatch threads, and check that the ARP
+// requests from every port make it into the ARP table.
+TEST(PacketDispatcherTest, ConcurrentArp) {
+  constexpr int kNumHosts = 100;
+  gflags::FlagSaver flagSaver;
+  FLAGS_packet_dispatch_threads = 4;
+  auto config = testConfigA();
+  auto sw = createMockSw(&config);
+  sw->initialConfigApplied(std::chrono::steady_clock::now());
+  waitForStateUpdates(sw.get());
+  ASSERT_NE(nullptr, sw->getPacketDispatcher());
+
+  // Each request is answered
+  EXPECT_HW_CALL(sw, sendPacketSwitched_(_)).Times(kNumHosts);
+  std::vector<std::thread> senders;
+  for (int t = 0; t < 4; ++t) {
+    senders.emplace_back([&sw, t]() {
+      for (int i = t; i < kNumHosts; i += 4) {
+        IPAddressV4 ip(folly::to<std::string>("10.0.0.", i + 10));
+        MacAddress mac = MacAddress::fromHBO(0x020000000100 + i);
+        sw->packetReceived(makeArpRequest(ip, mac, PortID(i % 10 + 1)));
+      }
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+  sw->getPacketDispatcher()->flush();
+  waitForStateUpdates(sw.get());
+
+  auto arpTable = sw->getState()->getVlans()->getVlan(VlanID(1))
+    ->getArpTable();
+  EXPECT_EQ(kNumHosts, arpTable->getAllNodes().size());
+  for (int i = 0; i < kNumHosts; ++i) {
+    IPAddressV4 ip(folly::to<std::string>("10.0.0.", i + 10));
+    auto entry = arpTable->getEntryIf(ip);
+    ASSERT_NE(nullptr, entry) << ip;
+    EXPECT_EQ(MacAddress::fromHBO(0x020000000100 + i), entry->getMac());
+    EXPECT_EQ(PortID(i % 10 + 1), entry->getPort());
+  }
+}
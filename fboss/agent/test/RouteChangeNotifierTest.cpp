@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/RouteChangeNotifier.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+#include <folly/IPAddress.h>
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace facebook::fboss;
+using facebook::network::toBinaryAddress;
+using folly::IPAddress;
+using std::shared_ptr;
+
+namespace {
+
+RouteChange makeChange(RouteChangeType type,
+                       const std::string& ip,
+                       uint8_t mask,
+                       const std::string& action = "") {
+  RouteChange change;
+  change.type = type;
+  change.vrf = 0;
+  change.prefix.ip = toBinaryAddress(IPAddress(ip));
+  change.prefix.prefixLength = mask;
+  if (type != RouteChangeType::REMOVED) {
+    change.route.dest = change.prefix;
+    change.route.action = action;
+    change.__isset.route = true;
+  }
+  return change;
+}
+
+RouteChangeBatch makeBatch(int64_t generation,
+                           std::vector<RouteChange> changes) {
+  RouteChangeBatch batch;
+  batch.generation = generation;
+  batch.changes = std::move(changes);
+  return batch;
+}
+
+class RouteChangeNotifierTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    sw = createMockSw();
+    initState = sw->getState();
+    stateA = testStateA();
+    notifier = std::make_unique<RouteChangeNotifier>(sw.get());
+    notifier->registerListener(
+        [this](shared_ptr<const RouteChangeBatch> batch) {
+          batches.push_back(batch);
+        });
+  }
+
+  size_t countChanges(RouteChangeType type) {
+    size_t count = 0;
+    for (const auto& batch : batches) {
+      for (const auto& change : batch->changes) {
+        count += change.type == type;
+      }
+    }
+    return count;
+  }
+
+  shared_ptr<SwitchState> initState;
+  shared_ptr<SwitchState> stateA;
+  std::unique_ptr<SwSwitch> sw;
+  std::unique_ptr<RouteChangeNotifier> notifier;
+  std::vector<shared_ptr<const RouteChangeBatch>> batches;
+};
+
+} // unnamed namespace
+
+// Nothing is worked out while there are no subscribers
+TEST_F(RouteChangeNotifierTest, NoSubscribers) {
+  notifier->stateUpdated(StateDelta(initState, stateA));
+  EXPECT_TRUE(batches.empty());
+}
+
+TEST_F(RouteChangeNotifierTest, AddedAndRemoved) {
+  notifier->addSubscriber();
+  notifier->stateUpdated(StateDelta(initState, stateA));
+  ASSERT_EQ(1, batches.size());
+  EXPECT_EQ(stateA->getGeneration(), batches[0]->generation);
+  EXPECT_EQ(8, countChanges(RouteChangeType::ADDED));
+  for (const auto& change : batches[0]->changes) {
+    EXPECT_TRUE(change.__isset.route);
+  }
+
+  notifier->stateUpdated(StateDelta(stateA, initState));
+  ASSERT_EQ(2, batches.size());
+  EXPECT_EQ(8, countChanges(RouteChangeType::REMOVED));
+  for (const auto& change : batches[1]->changes) {
+    EXPECT_FALSE(change.__isset.route);
+  }
+
+  // No batch for an update that doesn't touch the routes
+  notifier->stateUpdated(StateDelta(stateA, stateA));
+  EXPECT_EQ(2, batches.size());
+
+  notifier->removeSubscriber();
+  notifier->stateUpdated(StateDelta(initState, stateA));
+  EXPECT_EQ(2, batches.size());
+}
+
+TEST(RouteChangeQueue, Coalesce) {
+  RouteChangeQueue queue(folly::none, 100);
+  EXPECT_TRUE(queue.empty());
+  queue.add(makeBatch(1, {
+    makeChange(RouteChangeType::ADDED, "10.0.0.0", 24, "a1"),
+    makeChange(RouteChangeType::CHANGED, "10.0.1.0", 24, "c1"),
+    makeChange(RouteChangeType::REMOVED, "10.0.2.0", 24),
+    makeChange(RouteChangeType::ADDED, "10.0.3.0", 24, "a1"),
+    makeChange(RouteChangeType::CHANGED, "10.0.4.0", 24, "c1"),
+  }));
+  queue.add(makeBatch(2, {
+    // Added then changed is still added, as it is now
+    makeChange(RouteChangeType::CHANGED, "10.0.0.0", 24, "a2"),
+    makeChange(RouteChangeType::CHANGED, "10.0.1.0", 24, "c2"),
+    // Removed then added again is changed
+    makeChange(RouteChangeType::ADDED, "10.0.2.0", 24, "r2"),
+    // Added then removed is still removed, in case a dump had it
+    makeChange(RouteChangeType::REMOVED, "10.0.3.0", 24),
+    makeChange(RouteChangeType::REMOVED, "10.0.4.0", 24),
+  }));
+  EXPECT_EQ(5, queue.size());
+
+  auto batch = queue.take();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(2, batch.generation);
+  EXPECT_FALSE(batch.resyncNeeded);
+  ASSERT_EQ(5, batch.changes.size());
+  EXPECT_EQ(RouteChangeType::ADDED, batch.changes[0].type);
+  EXPECT_EQ("a2", batch.changes[0].route.action);
+  EXPECT_EQ(RouteChangeType::CHANGED, batch.changes[1].type);
+  EXPECT_EQ("c2", batch.changes[1].route.action);
+  EXPECT_EQ(RouteChangeType::CHANGED, batch.changes[2].type);
+  EXPECT_EQ("r2", batch.changes[2].route.action);
+  EXPECT_EQ(RouteChangeType::REMOVED, batch.changes[3].type);
+  EXPECT_EQ(RouteChangeType::REMOVED, batch.changes[4].type);
+}
+
+TEST(RouteChangeQueue, Filter) {
+  RouteChangeQueue queue(folly::CIDRNetwork(IPAddress("10.1.0.0"), 16), 100);
+  queue.add(makeBatch(1, {
+    makeChange(RouteChangeType::ADDED, "10.0.0.0", 8),
+    makeChange(RouteChangeType::ADDED, "10.1.0.0", 16),
+    makeChange(RouteChangeType::ADDED, "10.1.2.0", 24),
+    makeChange(RouteChangeType::ADDED, "10.2.0.0", 16),
+    makeChange(RouteChangeType::ADDED, "::", 0),
+  }));
+  auto batch = queue.take();
+  ASSERT_EQ(2, batch.changes.size());
+  EXPECT_EQ(16, batch.changes[0].prefix.prefixLength);
+  EXPECT_EQ(24, batch.changes[1].prefix.prefixLength);
+
+  // Changes the filter drops don't make a batch
+  queue.add(makeBatch(2, {makeChange(RouteChangeType::ADDED, "10.2.0.0", 24)}));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(RouteChangeQueue, Resync) {
+  RouteChangeQueue queue(folly::none, 2);
+  queue.add(makeBatch(1, {
+    makeChange(RouteChangeType::ADDED, "10.0.0.0", 24),
+    makeChange(RouteChangeType::ADDED, "10.0.1.0", 24),
+  }));
+  EXPECT_EQ(2, queue.size());
+  queue.add(makeBatch(2, {makeChange(RouteChangeType::ADDED, "10.0.2.0", 24)}));
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(0, queue.size());
+  // Changes made before the resync batch goes out are in the dump after it
+  queue.add(makeBatch(3, {makeChange(RouteChangeType::ADDED, "10.0.3.0", 24)}));
+  EXPECT_EQ(0, queue.size());
+
+  auto batch = queue.take();
+  EXPECT_TRUE(batch.resyncNeeded);
+  EXPECT_EQ(3, batch.generation);
+  EXPECT_TRUE(batch.changes.empty());
+  EXPECT_TRUE(queue.empty());
+
+  queue.add(makeBatch(4, {makeChange(RouteChangeType::ADDED, "10.0.4.0", 24)}));
+  batch = queue.take();
+  EXPECT_FALSE(batch.resyncNeeded);
+  EXPECT_EQ(1, batch.changes.size());
+}
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/IPAddress.h>
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/ThriftHandler.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+#include "fboss/agent/hw/mock/MockHwSwitch.h"
+#include "fboss/agent/hw/sim/SimSwitch.h"
+#include "fboss/agent/test/TestUtils.h"
+
+using namespace facebook::fboss;
+using facebook::network::toBinaryAddress;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using std::make_unique;
+using std::unique_ptr;
+using std::vector;
+using ::testing::_;
+using ::testing::Invoke;
+
+namespace {
+
+/*
+ * These benchmarks run syncFib() for kNumRoutes /24 routes on a SwSwitch
+ * whose HwSwitch programs them into a SimSwitch, so they cover the whole
+ * path from the thrift call down to the (simulated) hardware tables. The
+ * routes are spread over kNumEcmpGroups sets of kEcmpWidth nexthops.
+ *
+ * Each benchmark reports the time per route, i.e. routes/sec.
+ */
+constexpr int16_t kClient = 1;
+constexpr uint32_t kNumRoutes = 100000;
+constexpr uint32_t kNumEcmpGroups = 16;
+constexpr uint32_t kEcmpWidth = 4;
+
+unique_ptr<SwSwitch> sw;
+unique_ptr<ThriftHandler> handler;
+unique_ptr<SimSwitch> sim;
+// Two versions of the same routes, with each route using a different
+// nexthop set in the second one
+vector<UnicastRoute> routeLists[2];
+
+vector<UnicastRoute> makeRoutes(uint32_t groupOffset) {
+  vector<UnicastRoute> routes(kNumRoutes);
+  for (uint32_t i = 0; i < kNumRoutes; ++i) {
+    auto& route = routes[i];
+    route.dest.ip = toBinaryAddress(
+        IPAddress(IPAddressV4::fromLongHBO((20 << 24) + (i << 8))));
+    route.dest.prefixLength = 24;
+    auto group = (i + groupOffset) % kNumEcmpGroups;
+    for (uint32_t j = 0; j < kEcmpWidth; ++j) {
+      // All resolved directly through the 10.0.0.0/16 interface
+      auto nexthop = IPAddressV4::fromLongHBO(
+          (10 << 24) + (1 << 8) + group * kEcmpWidth + j);
+      route.nextHopAddrs.push_back(toBinaryAddress(IPAddress(nexthop)));
+    }
+  }
+  return routes;
+}
+
+void init() {
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "10.0.0.1/16";
+
+  sw = createMockSw(&config);
+  sw->initialConfigApplied(std::chrono::steady_clock::now());
+  sw->fibSynced();
+  handler = make_unique<ThriftHandler>(sw.get());
+
+  // Only the routes synced from here on reach the SimSwitch, which is all
+  // that is measured
+  sim = make_unique<SimSwitch>(nullptr, 0);
+  EXPECT_HW_CALL(sw, stateChanged(_)).WillRepeatedly(
+      Invoke(sim.get(), &SimSwitch::stateChanged));
+
+  routeLists[0] = makeRoutes(0);
+  routeLists[1] = makeRoutes(1);
+}
+
+void syncFib(const vector<UnicastRoute>& routes) {
+  handler->syncFib(kClient, make_unique<vector<UnicastRoute>>(routes));
+}
+
+unsigned syncAllRoutes(unsigned numIters, bool fromEmpty) {
+  folly::BenchmarkSuspender braces;
+  // Start from the other version of the routes, so every route changes
+  syncFib(routeLists[1]);
+  for (unsigned n = 0; n < numIters; ++n) {
+    if (fromEmpty) {
+      syncFib(vector<UnicastRoute>());
+      CHECK_EQ(0, sim->getNumRoutes());
+    }
+    auto routes = make_unique<vector<UnicastRoute>>(routeLists[n % 2]);
+    braces.dismiss();
+    handler->syncFib(kClient, std::move(routes));
+    braces.rehire();
+    CHECK_EQ(kNumRoutes, sim->getNumRoutes());
+    CHECK_EQ(kNumEcmpGroups, sim->getNumEcmpGroups());
+  }
+  return numIters * kNumRoutes;
+}
+
+} // unnamed namespace
+
+BENCHMARK_MULTI(SyncFibAddRoutes, numIters) {
+  return syncAllRoutes(numIters, true);
+}
+
+BENCHMARK_MULTI(SyncFibChangeNexthops, numIters) {
+  return syncAllRoutes(numIters, false);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  init();
+  folly::runBenchmarks();
+  handler.reset();
+  sw.reset();
+  return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/IPAddress.h>
+
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+/*
+ * The routes used in these benchmarks look like a small BGP table on top of
+ * the interfaces from RoutingTest:
+ *
+ *  - kNumNexthops BGP nexthops in 10.1.0.0/24, resolved recursively through
+ *    a single route to the RoutingTest neighbor 10.0.0.10.
+ *  - N /24 routes in 20.0.0.0/8 and up, spread evenly over those nexthops.
+ *
+ * Each benchmark applies a single change to the same table, either one
+ * which no route depends on or one which changes how 1/kNumNexthops of the
+ * routes resolve.
+ */
+const RouterID kRid(0);
+constexpr uint32_t kNumNexthops = 100;
+
+std::unique_ptr<MockPlatform> platform;
+std::map<uint32_t, shared_ptr<RouteTableMap>> tables;
+// Same routes as 'tables', but without the nexthop index
+std::map<uint32_t, shared_ptr<RouteTableMap>> unindexedTables;
+
+// Same interfaces as RoutingFixture::getSwitchConfig() in RoutingTest.cpp
+cfg::SwitchConfig getSwitchConfig() {
+  cfg::SwitchConfig config;
+  config.vlans.resize(2);
+  config.interfaces.resize(2);
+  for (int i = 0; i < 2; ++i) {
+    int32_t id = i + 1;
+    config.vlans[i].name = folly::sformat("Vlan-{}", id);
+    config.vlans[i].id = id;
+    config.vlans[i].routable = true;
+    config.vlans[i].intfID = id;
+
+    auto& intf = config.interfaces[i];
+    intf.intfID = id;
+    intf.vlanID = id;
+    intf.name = folly::sformat("Interface-{}", id);
+    intf.ipAddresses.resize(4);
+    intf.ipAddresses[0] = folly::sformat("169.254.{}.{}/24", id, id);
+    intf.ipAddresses[1] = folly::sformat("10.0.0.{}1/28", id);
+    intf.ipAddresses[2] = folly::sformat("face:b00c::{}1/124", id);
+    intf.ipAddresses[3] = folly::sformat("fe80::{}/64", id);
+  }
+  return config;
+}
+
+IPAddress bgpNexthop(uint32_t idx) {
+  return IPAddress(IPAddressV4::fromLongHBO((10 << 24) | (1 << 16) | idx));
+}
+
+shared_ptr<RouteTableMap> buildTables(uint32_t numRoutes) {
+  auto state = make_shared<SwitchState>();
+  auto config = getSwitchConfig();
+  state = publishAndApplyConfig(state, &config, platform.get());
+  state->publish();
+
+  RouteUpdater updater(state->getRouteTables());
+  RouteNextHops nbh;
+  nbh.emplace(IPAddress("10.0.0.10"));
+  updater.addRoute(kRid, IPAddress("10.1.0.0"), 24, ClientID(1001), nbh);
+  for (uint32_t i = 0; i < numRoutes; ++i) {
+    RouteNextHops nhops;
+    nhops.emplace(bgpNexthop(i % kNumNexthops));
+    auto network = IPAddressV4::fromLongHBO((20 << 24) + (i << 8));
+    updater.addRoute(kRid, network, 24, ClientID(1001), nhops);
+  }
+  auto newTables = updater.updateDone();
+  newTables->publish();
+  return newTables;
+}
+
+void init(uint32_t numRoutes) {
+  auto newTables = buildTables(numRoutes);
+  // Going through JSON drops the nexthop index, as after a warm boot
+  auto unindexed = RouteTableMap::fromFollyDynamic(newTables->toFollyDynamic());
+  unindexed->publish();
+  tables[numRoutes] = newTables;
+  unindexedTables[numRoutes] = unindexed;
+}
+
+/*
+ * Add a route for a prefix no other route resolves through.
+ */
+void flapUnrelatedRoute(const shared_ptr<RouteTableMap>& base, int numIters) {
+  RouteNextHops nhops;
+  nhops.emplace(IPAddress("10.0.0.20"));
+  for (int n = 0; n < numIters; ++n) {
+    RouteUpdater updater(base);
+    updater.addRoute(kRid, IPAddress("30.0.0.0"), 8, ClientID(1001), nhops);
+    folly::doNotOptimizeAway(updater.updateDone());
+  }
+}
+
+/*
+ * Add a more specific route for one of the BGP nexthops, moving the routes
+ * using it to the other interface.
+ */
+void flapNexthopRoute(const shared_ptr<RouteTableMap>& base, int numIters) {
+  RouteNextHops nhops;
+  nhops.emplace(IPAddress("10.0.0.20"));
+  for (int n = 0; n < numIters; ++n) {
+    RouteUpdater updater(base);
+    updater.addRoute(kRid, bgpNexthop(0), 32, ClientID(1001), nhops);
+    folly::doNotOptimizeAway(updater.updateDone());
+  }
+}
+
+} // unnamed namespace
+
+void UnrelatedRouteFullResolve(int numIters, uint32_t numRoutes) {
+  flapUnrelatedRoute(unindexedTables[numRoutes], numIters);
+}
+
+void UnrelatedRoute(int numIters, uint32_t numRoutes) {
+  flapUnrelatedRoute(tables[numRoutes], numIters);
+}
+
+void NexthopRouteFullResolve(int numIters, uint32_t numRoutes) {
+  flapNexthopRoute(unindexedTables[numRoutes], numIters);
+}
+
+void NexthopRoute(int numIters, uint32_t numRoutes) {
+  flapNexthopRoute(tables[numRoutes], numIters);
+}
+
+BENCHMARK_PARAM(UnrelatedRouteFullResolve, 10000)
+BENCHMARK_RELATIVE_PARAM(UnrelatedRoute, 10000)
+BENCHMARK_PARAM(UnrelatedRouteFullResolve, 100000)
+BENCHMARK_RELATIVE_PARAM(UnrelatedRoute, 100000)
+BENCHMARK_PARAM(UnrelatedRouteFullResolve, 500000)
+BENCHMARK_RELATIVE_PARAM(UnrelatedRoute, 500000)
+BENCHMARK_DRAW_LINE()
+BENCHMARK_PARAM(NexthopRouteFullResolve, 10000)
+BENCHMARK_RELATIVE_PARAM(NexthopRoute, 10000)
+BENCHMARK_PARAM(NexthopRouteFullResolve, 100000)
+BENCHMARK_RELATIVE_PARAM(NexthopRoute, 100000)
+BENCHMARK_PARAM(NexthopRouteFullResolve, 500000)
+BENCHMARK_RELATIVE_PARAM(NexthopRoute, 500000)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // Building the tables resolves all their routes, do it once up front
+  platform = createMockPlatform();
+  for (auto numRoutes : {10000, 100000, 500000}) {
+    init(numRoutes);
+  }
+
+  folly::runBenchmarks();
+  return 0;
+}
@@ -143,10 +143,11 @@ shared_ptr<SwitchState> publishAndApplyConfigFile(
   state->publish();
   // Parse the prev JSON config.
   cfg::SwitchConfig prevConfig;
-  if (prevConfigStr.size()) {
-    apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
-        prevConfigStr.c_str(), prevConfig);
+  if (prevConfigStr.empty()) {
+    return applyThriftConfigFile(state, path, platform, nullptr).first;
   }
+  apache::thrift::SimpleJSONSerializer::deserialize<cfg::SwitchConfig>(
+      prevConfigStr.c_str(), prevConfig);
   return applyThriftConfigFile(state, path, platform, &prevConfig).first;
 }
 
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "common/stats/ServiceData.h"
+#include "common/stats/ThreadCachedServiceData.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace facebook;
+using namespace facebook::stats;
+
+namespace {
+
+int64_t getCounter(const std::string& name) {
+  std::map<std::string, int64_t> counters;
+  fbData->getCounters(counters);
+  auto it = counters.find(name);
+  return it == counters.end() ? -1 : it->second;
+}
+
+} // unnamed namespace
+
+TEST(ThreadCachedStats, timeseriesFromThreads) {
+  auto* tcsd = ThreadCachedServiceData::get();
+  auto count = [&](int n) {
+    ThreadCachedServiceData::TLTimeseries ts(
+        tcsd->getThreadStats(), "test.pkts", SUM, RATE);
+    for (int i = 0; i < n; ++i) {
+      ts.addValue(2);
+    }
+  };
+
+  count(10);
+  // Nothing is visible until the stats are published
+  EXPECT_EQ(0, getCounter("test.pkts.sum"));
+  tcsd->publishStats();
+  EXPECT_EQ(20, getCounter("test.pkts.sum"));
+  EXPECT_EQ(20, getCounter("test.pkts.sum.60"));
+  EXPECT_EQ(20, getCounter("test.pkts.sum.3600"));
+  EXPECT_EQ(-1, getCounter("test.pkts.avg"));
+
+  // Counts from a thread which has exited are published as it exits
+  std::thread t1([&]() { count(5); });
+  t1.join();
+  EXPECT_EQ(30, getCounter("test.pkts.sum"));
+
+  // Publishing again doesn't count anything twice
+  count(1);
+  tcsd->publishStats();
+  tcsd->publishStats();
+  EXPECT_EQ(32, getCounter("test.pkts.sum"));
+}
+
+TEST(ThreadCachedStats, histogram) {
+  auto* tcsd = ThreadCachedServiceData::get();
+  ThreadCachedServiceData::TLHistogram hist(
+      tcsd->getThreadStats(), "test.latency", 10, 0, 100, AVG, 50, 100);
+  for (int i = 0; i < 100; ++i) {
+    hist.addValue(i);
+  }
+  // Out of range values go in the end buckets
+  hist.addRepeatedValue(1000, 2);
+  tcsd->publishStats();
+
+  EXPECT_EQ((4950 + 2000) / 102, getCounter("test.latency.avg.60"));
+  // The 51st of 102 samples, interpolated within the [50, 60) bucket
+  EXPECT_EQ(51, getCounter("test.latency.p50.60"));
+  EXPECT_EQ(100, getCounter("test.latency.p100"));
+}
+
+TEST(ThreadCachedStats, counters) {
+  fbData->setCounter("test.counter", 5);
+  EXPECT_EQ(5, getCounter("test.counter"));
+  EXPECT_EQ(7, fbData->incrementCounter("test.counter", 2));
+  EXPECT_TRUE(fbData->clearCounter("test.counter"));
+  EXPECT_EQ(-1, getCounter("test.counter"));
+}
@@ -15,11 +15,18 @@
 #include "fboss/agent/hw/mock/MockPlatform.h"
 #include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/ApplyThriftConfig.h"
+#include "fboss/agent/RouteChangeNotifier.h"
 #include "fboss/agent/state/Route.h"
 
 #include <folly/IPAddress.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include <mutex>
+#include <set>
+
+DECLARE_int32(max_route_table_snapshots);
+
 using namespace facebook::fboss;
 using folly::IPAddress;
 using folly::IPAddressV4;
@@ -281,3 +288,222 @@ TEST(ThriftTest, syncFib) {
   EXPECT_EQ(4, tables3->getRouteTable(rid)->getRibV4()->size());
   EXPECT_EQ(4, tables3->getRouteTable(rid)->getRibV6()->size());
 }
+
+namespace {
+
+// One interface, with an IPv4 and an IPv6 subnet, to route through
+unique_ptr<SwSwitch> setupRouteTableSwitch() {
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(2);
+  config.interfaces[0].ipAddresses[0] = "10.0.0.1/24";
+  config.interfaces[0].ipAddresses[1] = "2401:db00:2110:3001::0001/64";
+
+  auto sw = createMockSw(&config);
+  sw->initialConfigApplied(std::chrono::steady_clock::now());
+  sw->fibSynced();
+  return sw;
+}
+
+std::string prefixStr(const IpPrefix& prefix) {
+  return folly::to<std::string>(
+      facebook::network::toIPAddress(prefix.ip).str(), "/",
+      prefix.prefixLength);
+}
+
+// Page through the whole route table, returning the prefixes in it
+std::set<std::string> dumpRouteTable(ThriftHandler* handler,
+                                     int64_t* generation) {
+  std::set<std::string> dumped;
+  auto request = std::make_unique<RouteTablePageRequest>();
+  request->maxRoutes = 2;
+  request->details = true;
+  while (true) {
+    RouteTablePage page;
+    handler->getRouteTablePage(
+        page, std::make_unique<RouteTablePageRequest>(*request));
+    *generation = page.generation;
+    for (const auto& rd : page.routeDetails) {
+      dumped.insert(prefixStr(rd.dest));
+    }
+    if (!page.__isset.cursor) {
+      return dumped;
+    }
+    request->cursor = page.cursor;
+    request->__isset.cursor = true;
+  }
+}
+
+} // unnamed namespace
+
+TEST(ThriftTest, getRouteTablePage) {
+  auto mockSw = setupRouteTableSwitch();
+  ThriftHandler handler(mockSw.get());
+
+  handler.addUnicastRoute(1, makeUnicastRoute("7.1.0.0/16", "11.11.11.11"));
+  handler.addUnicastRoute(1, makeUnicastRoute("7.2.0.0/16", "11.11.11.11"));
+  handler.addUnicastRoute(2, makeUnicastRoute("8.1.0.0/16", "22.22.22.22"));
+  handler.addUnicastRoute(1, makeUnicastRoute("aaaa:1::0/64", "11:11::0"));
+
+  // Page through all the routes, changing the table in between
+  std::vector<std::string> dumped;
+  auto request = std::make_unique<RouteTablePageRequest>();
+  request->maxRoutes = 2;
+  request->details = true;
+  int numPages = 0;
+  int64_t generation = 0;
+  while (true) {
+    RouteTablePage page;
+    handler.getRouteTablePage(
+        page, std::make_unique<RouteTablePageRequest>(*request));
+    ++numPages;
+    // Every page is of the same state
+    if (numPages == 1) {
+      generation = page.generation;
+      EXPECT_EQ(mockSw->getState()->getGeneration(), generation);
+    }
+    EXPECT_EQ(generation, page.generation);
+    EXPECT_TRUE(page.routes.empty());
+    EXPECT_GE(2, page.routeDetails.size());
+    for (const auto& rd : page.routeDetails) {
+      dumped.push_back(prefixStr(rd.dest));
+    }
+    if (numPages == 1) {
+      handler.addUnicastRoute(
+          1, makeUnicastRoute("7.3.0.0/16", "11.11.11.11"));
+    }
+    if (!page.__isset.cursor) {
+      break;
+    }
+    request->cursor = page.cursor;
+    request->__isset.cursor = true;
+  }
+  // The link local, interface and client routes, as of the first page
+  EXPECT_THAT(dumped, UnorderedElementsAreArray({
+      "10.0.0.0/24", "7.1.0.0/16", "7.2.0.0/16", "8.1.0.0/16",
+      "2401:db00:2110:3001::/64", "fe80::/64", "aaaa:1::/64"}));
+  EXPECT_LE(4, numPages);
+
+  // The snapshot is released after the last page
+  RouteTablePage page;
+  EXPECT_THROW(handler.getRouteTablePage(
+                   page, std::make_unique<RouteTablePageRequest>(*request)),
+               FbossError);
+
+  // Filtered by prefix and client
+  auto filtered = std::make_unique<RouteTablePageRequest>();
+  filtered->prefix = ipPrefix("7.0.0.0", 8);
+  filtered->__isset.prefix = true;
+  filtered->clientId = 1;
+  filtered->__isset.clientId = true;
+  RouteTablePage filteredPage;
+  handler.getRouteTablePage(filteredPage, std::move(filtered));
+  EXPECT_FALSE(filteredPage.__isset.cursor);
+  std::vector<std::string> filteredDumped;
+  for (const auto& route : filteredPage.routes) {
+    filteredDumped.push_back(prefixStr(route.dest));
+    EXPECT_EQ(1, route.nextHopAddrs.size());
+  }
+  EXPECT_THAT(filteredDumped, UnorderedElementsAreArray({
+      "7.1.0.0/16", "7.2.0.0/16", "7.3.0.0/16"}));
+}
+
+// A bad request doesn't pin a snapshot, so it can't push out a dump that is
+// in progress.
+TEST(ThriftTest, getRouteTablePageBadRequest) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_max_route_table_snapshots = 1;
+  auto mockSw = setupRouteTableSwitch();
+  ThriftHandler handler(mockSw.get());
+
+  auto request = std::make_unique<RouteTablePageRequest>();
+  request->maxRoutes = 1;
+  RouteTablePage page;
+  handler.getRouteTablePage(
+      page, std::make_unique<RouteTablePageRequest>(*request));
+  ASSERT_TRUE(page.__isset.cursor);
+
+  auto badPrefix = std::make_unique<RouteTablePageRequest>(*request);
+  badPrefix->prefix = ipPrefix("10.0.0.0", 33);
+  badPrefix->__isset.prefix = true;
+  RouteTablePage badPage;
+  EXPECT_THROW(handler.getRouteTablePage(badPage, std::move(badPrefix)),
+               FbossError);
+
+  // The first dump carries on
+  request->cursor = page.cursor;
+  request->__isset.cursor = true;
+  RouteTablePage nextPage;
+  EXPECT_NO_THROW(handler.getRouteTablePage(
+      nextPage, std::make_unique<RouteTablePageRequest>(*request)));
+}
+
+// A subscriber that registers, then dumps the table while a batch is out,
+// ends up with the same routes as the switch.
+TEST(ThriftTest, routeChangesAfterDump) {
+  auto mockSw = setupRouteTableSwitch();
+  ThriftHandler handler(mockSw.get());
+
+  // Stand in for the handler's subscriber, with the same queue
+  std::mutex queueLock;
+  RouteChangeQueue queue(folly::none, 100);
+  auto notifier = mockSw->getRouteChangeNotifier();
+  notifier->registerListener(
+      [&](std::shared_ptr<const RouteChangeBatch> batch) {
+        std::lock_guard<std::mutex> g(queueLock);
+        queue.add(*batch);
+      });
+  notifier->addSubscriber();
+  auto takeBatch = [&]() {
+    waitForStateUpdates(mockSw.get());
+    std::lock_guard<std::mutex> g(queueLock);
+    return queue.take();
+  };
+
+  handler.addUnicastRoute(1, makeUnicastRoute("7.1.0.0/16", "11.11.11.11"));
+  auto inFlight = takeBatch();
+  ASSERT_EQ(1, inFlight.changes.size());
+
+  // Added before the dump, and removed after it
+  handler.addUnicastRoute(1, makeUnicastRoute("7.2.0.0/16", "11.11.11.11"));
+  int64_t dumpGeneration;
+  auto known = dumpRouteTable(&handler, &dumpGeneration);
+  EXPECT_EQ(1, known.count("7.2.0.0/16"));
+  auto removed = std::make_unique<IpPrefix>();
+  removed->ip = toBinaryAddress(IPAddress("7.2.0.0"));
+  removed->prefixLength = 16;
+  handler.deleteUnicastRoute(1, std::move(removed));
+  handler.addUnicastRoute(1, makeUnicastRoute("7.3.0.0/16", "11.11.11.11"));
+
+  // Apply the batches on top of the dump, as the subscriber would
+  auto apply = [&](const RouteChangeBatch& batch) {
+    EXPECT_FALSE(batch.resyncNeeded);
+    if (batch.generation <= dumpGeneration) {
+      // Already in the dump
+      return;
+    }
+    for (const auto& change : batch.changes) {
+      if (change.type == RouteChangeType::REMOVED) {
+        known.erase(prefixStr(change.prefix));
+      } else {
+        known.insert(prefixStr(change.prefix));
+      }
+    }
+  };
+  apply(inFlight);
+  apply(takeBatch());
+
+  int64_t generation;
+  EXPECT_EQ(dumpRouteTable(&handler, &generation), known);
+  EXPECT_EQ(mockSw->getState()->getGeneration(), generation);
+  EXPECT_EQ(0, known.count("7.2.0.0/16"));
+  EXPECT_EQ(1, known.count("7.3.0.0/16"));
+  notifier->removeSubscriber();
+}
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/TimerWheel.h"
+
+#include <folly/io/async/EventBase.h>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::vector;
+
+namespace {
+
+/*
+ * The tests drive the wheel by calling expire() with times of their own
+ * choosing, without running the EventBase loop.
+ */
+class TimerWheelTest : public ::testing::Test {
+ public:
+  TimerWheelTest()
+    : wheel_(&evb_, milliseconds(10),
+             [this](const vector<TimerWheel::Timer*>& timers) {
+               batches_.push_back(timers);
+             }) {}
+
+  // Expire everything due by the given time after start_
+  vector<TimerWheel::Timer*> expireAt(TimerWheel::Clock::duration elapsed) {
+    batches_.clear();
+    wheel_.expire(start_ + elapsed);
+    vector<TimerWheel::Timer*> expired;
+    for (const auto& batch : batches_) {
+      expired.insert(expired.end(), batch.begin(), batch.end());
+    }
+    return expired;
+  }
+
+ protected:
+  folly::EventBase evb_;
+  TimerWheel wheel_;
+  // Taken after the wheel was created, and before any timer is scheduled
+  TimerWheel::Clock::time_point start_{TimerWheel::Clock::now()};
+  vector<vector<TimerWheel::Timer*>> batches_;
+};
+
+} // unnamed namespace
+
+TEST_F(TimerWheelTest, ExpireInOrder) {
+  TimerWheel::Timer t1, t2, t3;
+  wheel_.schedule(&t1, milliseconds(50));
+  wheel_.schedule(&t2, milliseconds(50));
+  wheel_.schedule(&t3, seconds(5));
+  EXPECT_EQ(3, wheel_.size());
+  EXPECT_TRUE(t1.isScheduled());
+
+  EXPECT_TRUE(expireAt(milliseconds(40)).empty());
+
+  // Timers due on the same tick expire in one batch
+  auto expired = expireAt(milliseconds(500));
+  EXPECT_EQ(1, batches_.size());
+  EXPECT_EQ((vector<TimerWheel::Timer*>{&t1, &t2}), expired);
+  EXPECT_FALSE(t1.isScheduled());
+  EXPECT_FALSE(t2.isScheduled());
+  EXPECT_EQ(1, wheel_.size());
+
+  EXPECT_TRUE(expireAt(milliseconds(4990)).empty());
+  EXPECT_EQ(vector<TimerWheel::Timer*>{&t3}, expireAt(seconds(6)));
+  EXPECT_EQ(0, wheel_.size());
+}
+
+TEST_F(TimerWheelTest, CancelAndReschedule) {
+  TimerWheel::Timer t1, t2;
+  wheel_.schedule(&t1, milliseconds(100));
+  wheel_.schedule(&t2, milliseconds(100));
+  wheel_.cancel(&t1);
+  EXPECT_FALSE(t1.isScheduled());
+  // Cancelling again is harmless
+  wheel_.cancel(&t1);
+  // Rescheduling replaces the earlier timeout
+  wheel_.schedule(&t2, seconds(1));
+  EXPECT_EQ(1, wheel_.size());
+
+  EXPECT_TRUE(expireAt(milliseconds(500)).empty());
+  EXPECT_EQ(vector<TimerWheel::Timer*>{&t2}, expireAt(milliseconds(1100)));
+}
+
+TEST_F(TimerWheelTest, Cascade) {
+  // Timeouts spread over every level of the wheel, and past the end of it
+  vector<milliseconds> timeouts = {
+    milliseconds(10), milliseconds(630), milliseconds(650),
+    milliseconds(41000), milliseconds(41100), milliseconds(2700000),
+    milliseconds(170000000), milliseconds(200000000),
+  };
+  vector<TimerWheel::Timer> timers(timeouts.size());
+  for (size_t i = 0; i < timeouts.size(); ++i) {
+    wheel_.schedule(&timers[i], timeouts[i]);
+  }
+
+  // Step through time, checking each timer expires within a tick of its
+  // timeout, and not before
+  size_t next = 0;
+  for (auto now = milliseconds(0); now <= milliseconds(200000100);
+       now += (next < 3 ? milliseconds(10) : milliseconds(100000))) {
+    for (auto* timer : expireAt(now)) {
+      ASSERT_LT(next, timers.size());
+      EXPECT_EQ(&timers[next], timer);
+      EXPECT_GE(now, timeouts[next]);
+      ++next;
+    }
+  }
+  EXPECT_EQ(timers.size(), next);
+  EXPECT_EQ(0, wheel_.size());
+}
+
+TEST_F(TimerWheelTest, ScheduleFromCallback) {
+  TimerWheel::Timer timer;
+  int count = 0;
+  TimerWheel wheel(&evb_, milliseconds(10),
+                   [&](const vector<TimerWheel::Timer*>& timers) {
+                     ++count;
+                     wheel.schedule(timers[0], milliseconds(100));
+                   });
+  wheel.schedule(&timer, milliseconds(100));
+  wheel.expire(start_ + milliseconds(200));
+  EXPECT_EQ(1, count);
+  EXPECT_TRUE(timer.isScheduled());
+  wheel.expire(start_ + seconds(1));
+  EXPECT_EQ(2, count);
+  wheel.cancel(&timer);
+}
+
+TEST_F(TimerWheelTest, RunOnEventBase) {
+  TimerWheel::Timer t1, t2;
+  wheel_.schedule(&t1, milliseconds(20));
+  wheel_.schedule(&t2, milliseconds(50));
+  evb_.tryRunAfterDelay([&]() { evb_.terminateLoopSoon(); }, 200);
+  evb_.loopForever();
+  EXPECT_EQ(0, wheel_.size());
+  ASSERT_EQ(2, batches_.size());
+  EXPECT_EQ(vector<TimerWheel::Timer*>{&t1}, batches_[0]);
+  EXPECT_EQ(vector<TimerWheel::Timer*>{&t2}, batches_[1]);
+}
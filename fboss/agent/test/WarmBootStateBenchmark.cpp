@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/IPAddress.h>
+
+#include <iostream>
+
+#include "fboss/agent/Constants.h"
+#include "fboss/agent/Utils.h"
+#include "fboss/agent/WarmBootStateFile.h"
+#include "fboss/agent/gen-cpp2/switch_config_types.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteUpdater.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/TestUtils.h"
+
+using namespace facebook::fboss;
+using folly::IPAddress;
+using folly::IPAddressV4;
+using std::make_shared;
+using std::string;
+
+namespace {
+
+/*
+ * These benchmarks write and read back the warm boot state file for a
+ * SwitchState with kNumRoutes BGP-like /24 routes, in the JSON and in the
+ * binary format.  Only the file format is measured: the state is converted
+ * to folly::dynamic up front, and not converted back.
+ */
+const RouterID kRid(0);
+constexpr uint32_t kNumRoutes = 500000;
+constexpr uint32_t kNumNexthops = 100;
+
+folly::dynamic stateJson;
+std::unique_ptr<folly::test::TemporaryDirectory> tmpDir;
+string jsonFile;
+string binaryFile;
+
+void init() {
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(1);
+  config.interfaces[0].ipAddresses[0] = "10.0.0.1/16";
+
+  auto platform = createMockPlatform();
+  auto state = make_shared<SwitchState>();
+  state = publishAndApplyConfig(state, &config, platform.get());
+  RouteUpdater updater(state->getRouteTables());
+  for (uint32_t i = 0; i < kNumRoutes; ++i) {
+    RouteNextHops nhops;
+    nhops.emplace(IPAddress(IPAddressV4::fromLongHBO(
+        (10 << 24) + (1 << 8) + i % kNumNexthops)));
+    auto network = IPAddressV4::fromLongHBO((20 << 24) + (i << 8));
+    updater.addRoute(kRid, network, 24, ClientID(1001), nhops);
+  }
+  state->resetRouteTables(updater.updateDone());
+
+  stateJson = folly::dynamic::object(kSwSwitch, state->toFollyDynamic());
+  tmpDir = std::make_unique<folly::test::TemporaryDirectory>();
+  jsonFile = (tmpDir->path() / "switch_state.json").string();
+  binaryFile = (tmpDir->path() / "switch_state.bin").string();
+}
+
+} // unnamed namespace
+
+BENCHMARK(WriteJsonState, numIters) {
+  for (unsigned n = 0; n < numIters; ++n) {
+    CHECK(dumpStateToFile(jsonFile, stateJson));
+  }
+}
+
+BENCHMARK_RELATIVE(WriteBinaryState, numIters) {
+  for (unsigned n = 0; n < numIters; ++n) {
+    writeBinaryStateFile(binaryFile, stateJson);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ReadJsonState, numIters) {
+  for (unsigned n = 0; n < numIters; ++n) {
+    folly::doNotOptimizeAway(readWarmBootStateFile(jsonFile));
+  }
+}
+
+BENCHMARK_RELATIVE(ReadBinaryState, numIters) {
+  for (unsigned n = 0; n < numIters; ++n) {
+    folly::doNotOptimizeAway(readWarmBootStateFile(binaryFile));
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  init();
+  folly::runBenchmarks();
+
+  CHECK(stateJson == readWarmBootStateFile(binaryFile));
+  std::cout << "State with " << kNumRoutes << " routes: "
+            << boost::filesystem::file_size(jsonFile) << " bytes as JSON, "
+            << boost::filesystem::file_size(binaryFile) << " bytes as binary"
+            << std::endl;
+  tmpDir.reset();
+  return 0;
+}
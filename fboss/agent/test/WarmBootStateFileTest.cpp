@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/WarmBootStateFile.h"
+
+#include <limits>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/json.h>
+
+#include "fboss/agent/FbossError.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::dynamic;
+using std::string;
+
+namespace {
+
+dynamic makeState() {
+  dynamic routes = dynamic::array;
+  for (int i = 0; i < 100; ++i) {
+    routes.push_back(dynamic::object
+        ("network", folly::to<string>("10.0.", i, ".0"))
+        ("mask", 24)
+        ("action", i % 2 ? "DROP" : "NEXTHOPS"));
+  }
+  return dynamic::object
+    ("swSwitch", dynamic::object
+      ("routes", std::move(routes))
+      ("empty", dynamic::object)
+      ("none", nullptr))
+    ("hwSwitch", dynamic::object
+      ("negative", -12345678901234)
+      ("min", std::numeric_limits<int64_t>::min())
+      ("max", std::numeric_limits<int64_t>::max())
+      ("ratio", 0.25)
+      ("flags", dynamic::array(true, false))
+      ("bigString", string(3 << 20, 'x')));
+}
+
+string readRaw(const string& filename) {
+  string data;
+  EXPECT_TRUE(folly::readFile(filename.c_str(), data));
+  return data;
+}
+
+} // unnamed namespace
+
+TEST(WarmBootStateFile, binaryRoundTrip) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto filename = (tmpDir.path() / "switch_state").string();
+  auto state = makeState();
+
+  writeBinaryStateFile(filename, state);
+  auto data = readRaw(filename);
+  EXPECT_TRUE(isBinaryState(folly::ByteRange(folly::StringPiece(data))));
+  EXPECT_EQ(state, readWarmBootStateFile(filename));
+
+  // Repeated keys are only written out once, so the binary file is smaller
+  // than the compact JSON, even though neither is compressed
+  EXPECT_LT(data.size(), folly::toJson(state).size());
+}
+
+TEST(WarmBootStateFile, readJson) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto filename = (tmpDir.path() / "switch_state").string();
+  auto state = makeState();
+
+  ASSERT_TRUE(folly::writeFile(folly::toPrettyJson(state), filename.c_str()));
+  EXPECT_EQ(state, readWarmBootStateFile(filename));
+}
+
+TEST(WarmBootStateFile, nonStringKeys) {
+  dynamic state = dynamic::object(1, "one")(true, dynamic::array(1, 2));
+  folly::test::TemporaryDirectory tmpDir;
+  auto filename = (tmpDir.path() / "switch_state").string();
+
+  writeBinaryStateFile(filename, state);
+  EXPECT_EQ(state, readWarmBootStateFile(filename));
+}
+
+TEST(WarmBootStateFile, badBinaryState) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto filename = (tmpDir.path() / "switch_state").string();
+  writeBinaryStateFile(filename, makeState());
+  auto data = readRaw(filename);
+  auto bytes = [](const string& str) {
+    return folly::ByteRange(folly::StringPiece(str));
+  };
+
+  EXPECT_EQ(makeState(), parseBinaryState(bytes(data)));
+  // Truncated
+  EXPECT_THROW(parseBinaryState(bytes(data.substr(0, data.size() - 1))),
+               FbossError);
+  // Trailing garbage
+  EXPECT_THROW(parseBinaryState(bytes(data + "x")), FbossError);
+  // Unknown version
+  auto badVersion = data;
+  badVersion[4] = 2;
+  EXPECT_THROW(parseBinaryState(bytes(badVersion)), FbossError);
+  // Not binary at all
+  EXPECT_THROW(parseBinaryState(bytes("{}")), FbossError);
+}
@@ -474,4 +474,279 @@ radixTreeItrIncrement() {
   normalize();
 }
 
+template<typename IPADDRTYPE, typename T>
+typename PersistentRadixTreeNode<IPADDRTYPE, T>::TreeDirection
+PersistentRadixTreeNode<IPADDRTYPE, T>::searchDirection(
+    const IPADDRTYPE& toSearch, uint8_t toSearchMasklen) const {
+  // Same logic as RadixTreeNode::searchDirection, see comments there.
+  if (masklen_ < toSearchMasklen) {
+    if (toSearch.mask(masklen_) == ipAddress_) {
+      return toSearch.getNthMSBit(masklen_) == 1 ? TreeDirection::RIGHT :
+        TreeDirection::LEFT;
+    }
+    return TreeDirection::PARENT;
+  }
+  if (masklen_ == toSearchMasklen && ipAddress_ == toSearch) {
+      return TreeDirection::THIS_NODE;
+  }
+  return TreeDirection::PARENT;
+}
+
+template<typename IPADDRTYPE, typename T>
+void PersistentRadixTreeIterator<IPADDRTYPE, T>::step() {
+  if (cursor_->left()) {
+    if (cursor_->right()) {
+      pending_.push_back(cursor_->right());
+    }
+    cursor_ = cursor_->left();
+  } else if (cursor_->right()) {
+    cursor_ = cursor_->right();
+  } else if (!pending_.empty()) {
+    cursor_ = pending_.back();
+    pending_.pop_back();
+  } else {
+    cursor_ = nullptr;
+    root_ = nullptr;
+  }
+}
+
+template<typename IPADDRTYPE, typename T>
+void PersistentRadixTreeIterator<IPADDRTYPE, T>::buildPending() {
+  typedef typename TreeNode::TreeDirection TreeDirection;
+  pending_.clear();
+  auto node = root_;
+  while (node != cursor_) {
+    CHECK(node);
+    auto direction = node->searchDirection(cursor_);
+    if (direction == TreeDirection::LEFT) {
+      if (node->right()) {
+        pending_.push_back(node->right());
+      }
+      node = node->left();
+    } else {
+      CHECK(direction == TreeDirection::RIGHT);
+      node = node->right();
+    }
+  }
+  pendingValid_ = true;
+}
+
+template<typename IPADDRTYPE, typename T>
+const typename PersistentRadixTree<IPADDRTYPE, T>::TreeNode*
+PersistentRadixTree<IPADDRTYPE, T>::longestMatchImpl(
+    const IPADDRTYPE& ipaddr, uint8_t masklen, bool& foundExact) const {
+  const TreeNode* lastValueNodeSeen = nullptr;
+  const TreeNode* curNode = root_.get();
+  while (curNode) {
+    auto searchDirection = curNode->searchDirection(ipaddr, masklen);
+    if (searchDirection == TreeDirection::PARENT) {
+      break;
+    }
+    lastValueNodeSeen = curNode->isValueNode() ? curNode : lastValueNodeSeen;
+    if (searchDirection == TreeDirection::THIS_NODE) {
+      foundExact = curNode->isValueNode();
+      break;
+    }
+    curNode = searchDirection == TreeDirection::LEFT ? curNode->left() :
+      curNode->right();
+  }
+  return lastValueNodeSeen;
+}
+
+template<typename IPADDRTYPE, typename T>
+typename PersistentRadixTree<IPADDRTYPE, T>::ConstIterator
+PersistentRadixTree<IPADDRTYPE, T>::subTreeBegin(
+    const IPADDRTYPE& ipaddr, uint8_t masklen) const {
+  auto prefix = ipaddr.mask(masklen);
+  const TreeNode* curNode = root_.get();
+  while (curNode) {
+    if (curNode->masklen() >= masklen) {
+      // Either all of this subtree is within the prefix, or none of it is
+      if (curNode->ipAddress().mask(masklen) != prefix) {
+        break;
+      }
+      ConstIterator itr(root_.get(), curNode, false);
+      if (curNode->isNonValueNode()) {
+        // Non value nodes have two children, so this stays in the subtree
+        ++itr;
+      }
+      return itr;
+    }
+    auto searchDirection = curNode->searchDirection(prefix, masklen);
+    if (searchDirection == TreeDirection::PARENT) {
+      break;
+    }
+    curNode = searchDirection == TreeDirection::LEFT ? curNode->left() :
+      curNode->right();
+  }
+  return end();
+}
+
+template<typename IPADDRTYPE, typename T>
+bool PersistentRadixTree<IPADDRTYPE, T>::findPath(const IPADDRTYPE& ipaddr,
+    uint8_t masklen, NodePath* path) const {
+  path->clear();
+  const TreeNode* curNode = root_.get();
+  while (curNode) {
+    path->push_back(curNode);
+    auto searchDirection = curNode->searchDirection(ipaddr, masklen);
+    switch (searchDirection) {
+      case TreeDirection::THIS_NODE:
+        return curNode->isValueNode();
+      case TreeDirection::LEFT:
+        curNode = curNode->left();
+        break;
+      case TreeDirection::RIGHT:
+        curNode = curNode->right();
+        break;
+      case TreeDirection::PARENT:
+        return false;
+    }
+  }
+  return false;
+}
+
+template<typename IPADDRTYPE, typename T>
+typename PersistentRadixTree<IPADDRTYPE, T>::NodePtr*
+PersistentRadixTree<IPADDRTYPE, T>::writableSlot(const NodePath& path,
+    size_t depth) {
+  auto slot = &root_;
+  for (size_t i = 0; i < depth; ++i) {
+    // Copying a node copies its child links, so the child pointers
+    // of the writable node still match the ones recorded in path.
+    auto node = writable(*slot);
+    slot = node->left_.get() == path[i + 1] ? &node->left_ : &node->right_;
+    DCHECK_EQ(slot->get(), path[i + 1]);
+  }
+  return slot;
+}
+
+template <typename IPADDRTYPE, typename T>
+template <typename VALUE>
+bool PersistentRadixTree<IPADDRTYPE, T>::insert(const IPADDRTYPE& ipaddr,
+    uint8_t mask, VALUE&& value) {
+  // Can't trust the clients to have 0s in all bits after mask length
+  auto toAdd = ipaddr.mask(mask);
+  auto foundExact = false;
+  longestMatchImpl(toAdd, mask, foundExact);
+  if (foundExact) {
+    // Prefix already exists in the tree, don't copy anything
+    return false;
+  }
+  // From here on the tree is going to change, so every node we pass on
+  // the way down needs to be private to this tree.
+  auto slot = &root_;
+  while (*slot) {
+    auto searchDirection = (*slot)->searchDirection(toAdd, mask);
+    if (searchDirection == TreeDirection::THIS_NODE) {
+      // Non value node for this prefix, just give it a value
+      writable(*slot)->value_ = std::forward<VALUE>(value);
+      ++size_;
+      return true;
+    } else if (searchDirection == TreeDirection::LEFT) {
+      slot = &writable(*slot)->left_;
+    } else if (searchDirection == TreeDirection::RIGHT) {
+      slot = &writable(*slot)->right_;
+    } else {
+      // Node in slot does not cover the new prefix. We need a less
+      // specific node in its place, which has both the existing node
+      // and the new prefix underneath it. See RadixTree::insert for
+      // why the common prefix can't already be in the tree.
+      auto existing = std::move(*slot);
+      auto prefix = IPADDRTYPE::longestCommonPrefix(
+        {existing->ipAddress(), existing->masklen()}, {toAdd, mask});
+      NodePtr newNode = std::make_shared<TreeNode>(toAdd, mask,
+          std::forward<VALUE>(value));
+      NodePtr newParent;
+      if (prefix.first == toAdd && prefix.second == mask) {
+        newParent = std::move(newNode);
+      } else {
+        newParent = std::make_shared<TreeNode>(prefix.first, prefix.second);
+      }
+      auto existingDirection = newParent->searchDirection(existing.get());
+      CHECK(existingDirection == TreeDirection::LEFT ||
+          existingDirection == TreeDirection::RIGHT);
+      if (existingDirection == TreeDirection::LEFT) {
+        newParent->left_ = std::move(existing);
+        newParent->right_ = std::move(newNode);
+      } else {
+        newParent->right_ = std::move(existing);
+        newParent->left_ = std::move(newNode);
+      }
+      *slot = std::move(newParent);
+      ++size_;
+      return true;
+    }
+  }
+  *slot = std::make_shared<TreeNode>(toAdd, mask, std::forward<VALUE>(value));
+  ++size_;
+  return true;
+}
+
+template <typename IPADDRTYPE, typename T>
+template <typename VALUE>
+bool PersistentRadixTree<IPADDRTYPE, T>::update(const IPADDRTYPE& ipaddr,
+    uint8_t mask, VALUE&& value) {
+  NodePath path;
+  if (!findPath(ipaddr, mask, &path)) {
+    return false;
+  }
+  writable(*writableSlot(path, path.size() - 1))->value_ =
+    std::forward<VALUE>(value);
+  return true;
+}
+
+/*
+ * Same cases as RadixTree::erase, which also explains why non value
+ * nodes keep having 2 children. The difference is that rather than
+ * modifying nodes we replace the link pointing to the smallest subtree
+ * affected, so only nodes above that link get copied.
+ */
+template<typename IPADDRTYPE, typename T>
+bool PersistentRadixTree<IPADDRTYPE, T>::erase(const IPADDRTYPE& ipaddr,
+    uint8_t mask) {
+  NodePath path;
+  if (!findPath(ipaddr, mask, &path)) {
+    return false;
+  }
+  auto depth = path.size() - 1;
+  auto toDelete = path[depth];
+  if (toDelete->left() && toDelete->right()) {
+    // Node stays on as a non value node
+    writable(*writableSlot(path, depth))->value_.clear();
+  } else if (toDelete->left() || toDelete->right()) {
+    // Let toDelete's parent adopt toDelete's only child
+    auto child = toDelete->left() ? toDelete->left_ : toDelete->right_;
+    *writableSlot(path, depth) = std::move(child);
+  } else if (depth > 0 && path[depth - 1]->isNonValueNode()) {
+    // Leaf under a non value node, the non value node must go as well
+    // and its other child takes its place.
+    auto parent = path[depth - 1];
+    auto sibling = parent->left() == toDelete ? parent->right_ :
+      parent->left_;
+    CHECK(sibling);
+    *writableSlot(path, depth - 1) = std::move(sibling);
+  } else {
+    // Leaf under a value node, or the only node in the tree
+    writableSlot(path, depth)->reset();
+  }
+  --size_;
+  return true;
+}
+
+template<typename IPADDRTYPE, typename T>
+bool PersistentRadixTree<IPADDRTYPE, T>::radixSubTreesEqual(
+    const TreeNode* nodeA, const TreeNode* nodeB) {
+  if (nodeA == nodeB) {
+    return true;
+  }
+  if (nodeA && nodeB) {
+    if (nodeA->equalSansLinks(*nodeB)) {
+      return radixSubTreesEqual(nodeA->left(), nodeB->left()) &&
+        radixSubTreesEqual(nodeA->right(), nodeB->right());
+    }
+  }
+  return false;
+}
+
 }} //facebook::network
@@ -1064,6 +1064,321 @@ class RadixTree<folly::IPAddress, T> {
   RadixTree<folly::IPAddressV4, T, V4TreeInCompositeTreeTraits<T>> ipv4Tree_;
 };
 
+/*
+ * Node in a PersistentRadixTree. Holds IP, mask and optionally a value,
+ * same as RadixTreeNode. Unlike RadixTreeNode, there is no parent pointer
+ * and children are reference counted, so that a subtree can be shared
+ * between different generations (copies) of a PersistentRadixTree. A node
+ * which is reachable from more than one tree must never be modified,
+ * the tree copies the path leading to such a node before changing it.
+ */
+template<typename IPADDRTYPE, typename T>
+class PersistentRadixTreeNode {
+ public:
+  typedef std::shared_ptr<PersistentRadixTreeNode> NodePtr;
+  typedef typename RadixTreeNode<IPADDRTYPE, T>::TreeDirection TreeDirection;
+
+  PersistentRadixTreeNode(const IPADDRTYPE& ipAddr, uint8_t mlen):
+    ipAddress_(ipAddr), masklen_(mlen) {}
+
+  template<typename VALUE>
+  PersistentRadixTreeNode(const IPADDRTYPE& ipAddr, uint8_t mlen,
+      VALUE&& val): ipAddress_(ipAddr), masklen_(mlen),
+  value_(std::forward<VALUE>(val)) {}
+
+  // Copy value and links, used for copying a path on write.
+  PersistentRadixTreeNode(const PersistentRadixTreeNode& r) = default;
+  PersistentRadixTreeNode& operator=(const PersistentRadixTreeNode& r) =
+    delete;
+
+  const IPADDRTYPE&  ipAddress() const { return ipAddress_;  }
+  bool  isNonValueNode() const { return !isValueNode(); }
+  bool  isValueNode()   const  { return value_.hasValue(); }
+  uint32_t masklen() const { return masklen_; }
+  const PersistentRadixTreeNode* left() const { return left_.get(); }
+  const PersistentRadixTreeNode* right() const { return right_.get();  }
+  bool    isLeaf()  const { return left_ == nullptr && right_ == nullptr; }
+  const T& value() const { return value_.value();  }
+  std::string str(bool printValue = true) const {
+    auto nodeStr = folly::to<std::string>(ipAddress_.str(), "/", masklen_);
+    if (printValue) {
+      nodeStr += isNonValueNode() ?  "(*)" :
+        folly::to<std::string>("(",this->value(), ")");
+    }
+    return nodeStr;
+  }
+
+  // Given a IP, mask pair determine where that might lie w.r.t. this node
+  TreeDirection  searchDirection(const IPADDRTYPE& toSearch,
+      uint8_t masklen) const;
+
+  TreeDirection searchDirection(const PersistentRadixTreeNode* node) const {
+    return searchDirection(node->ipAddress_, node->masklen_);
+  }
+
+  // Comparison with links (left, right) ignored
+  bool equalSansLinks(const PersistentRadixTreeNode& r) const {
+    return ipAddress_ == r.ipAddress_ && masklen_ == r.masklen_ &&
+      isValueNode() == r.isValueNode() && (!isValueNode() ||
+          this->value() == r.value());
+  }
+
+ private:
+  template<typename, typename> friend class PersistentRadixTree;
+
+  IPADDRTYPE ipAddress_;
+  uint32_t masklen_{0}; // Number of bits to match.
+  folly::Optional<T> value_;
+  NodePtr left_{nullptr};
+  NodePtr right_{nullptr};
+};
+
+/*
+ * Forward iterator over a PersistentRadixTree. Traverses the tree in
+ * DFS/preorder fashion, same as RadixTreeIterator. Since nodes have no
+ * parent pointer, the iterator keeps a stack of right subtrees still to
+ * be visited. Iterators returned by lookups don't pay for building this
+ * stack unless they are actually incremented.
+ * Only const iteration is supported, values are changed through the tree
+ * (see PersistentRadixTree::update()) so that shared nodes get copied.
+ */
+template <typename IPADDRTYPE, typename T>
+class PersistentRadixTreeIterator : public std::iterator<
+  std::forward_iterator_tag, PersistentRadixTreeIterator<IPADDRTYPE, T>> {
+ public:
+  typedef PersistentRadixTreeNode<IPADDRTYPE, T> TreeNode;
+
+  // default constructor
+  PersistentRadixTreeIterator() {
+  }
+  // Iterator to the first node of the tree rooted at root
+  explicit PersistentRadixTreeIterator(const TreeNode* root,
+      bool includeNonValNodes = false): root_(root), cursor_(root),
+  includeNonValueNodes_(includeNonValNodes) {
+    if (cursor_ && (!includeNonValueNodes_ && cursor_->isNonValueNode())) {
+      ++(*this);
+    }
+  }
+  // Iterator to node in the tree rooted at root.
+  PersistentRadixTreeIterator(const TreeNode* root, const TreeNode* node,
+      bool includeNonValNodes): root_(node ? root : nullptr), cursor_(node),
+  includeNonValueNodes_(includeNonValNodes), pendingValid_(false) {}
+
+  PersistentRadixTreeIterator& operator++() {
+    checkDereference();
+    if (!pendingValid_) {
+      buildPending();
+    }
+    do {
+      step();
+    } while (cursor_ && !includeNonValueNodes_ && cursor_->isNonValueNode());
+    return *this;
+  }
+
+  PersistentRadixTreeIterator operator++(int) {
+    PersistentRadixTreeIterator tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  bool operator==(const PersistentRadixTreeIterator& r) const {
+    return cursor_ == r.cursor_;
+  }
+
+  bool operator!=(const PersistentRadixTreeIterator& r) const {
+    return cursor_ != r.cursor_;
+  }
+
+  const PersistentRadixTreeIterator& operator*() const {
+    checkDereference();
+    return *this;
+  }
+
+  const PersistentRadixTreeIterator* operator->() const {
+    checkDereference();
+    return this;
+  }
+
+  bool atEnd() const { return cursor_ == nullptr; }
+
+  const T& value() const {
+    checkDereference();
+    CHECK(cursor_->isValueNode());
+    return cursor_->value();
+  }
+
+  const IPADDRTYPE& ipAddress() const {
+    checkDereference();
+    return cursor_->ipAddress();
+  }
+
+  uint8_t masklen() const {
+    checkDereference();
+    return cursor_->masklen();
+  }
+
+  // Node at this cursor location
+  const TreeNode* node() const { return cursor_; }
+  std::string str(bool printValue = true) const {
+    checkDereference();
+    return cursor_->str(printValue);
+  }
+  bool includeNonValueNodes() const { return includeNonValueNodes_; }
+
+ private:
+  void checkDereference() const {
+    CHECK(!atEnd());
+  }
+  // Move cursor to the next node in preorder, value or not
+  void step();
+  // Walk down from root to cursor recording the right subtrees
+  // that preorder traversal still has to visit.
+  void buildPending();
+
+  const TreeNode* root_{nullptr};
+  const TreeNode* cursor_{nullptr};
+  bool  includeNonValueNodes_{false};
+  bool  pendingValid_{true};
+  std::vector<const TreeNode*> pending_;
+};
+
+/*
+ * Persistent (copy on write) radix tree. Supports the same lookups as
+ * RadixTree for a single address family. Copying the tree is O(1), the
+ * copy shares all nodes with the original. Modifying a tree copies just
+ * the nodes on the path from root to the changed node which are still
+ * shared with some other tree, the rest of the tree stays shared. Nodes
+ * owned by just this tree are modified in place, so building up a tree
+ * which is not shared costs no more than with RadixTree.
+ * Like other copy on write structures in the agent, a given tree object
+ * must only be modified by one thread at a time, however copies may be
+ * read and modified concurrently from other threads.
+ */
+template<typename IPADDRTYPE, typename T>
+class PersistentRadixTree {
+ public:
+  typedef PersistentRadixTreeNode<IPADDRTYPE, T>       TreeNode;
+  typedef typename TreeNode::NodePtr                   NodePtr;
+  typedef typename TreeNode::TreeDirection             TreeDirection;
+  typedef PersistentRadixTreeIterator<IPADDRTYPE, T>   ConstIterator;
+  typedef ConstIterator                                Iterator;
+
+  PersistentRadixTree() {}
+  // Copying shares all nodes, O(1)
+  PersistentRadixTree(const PersistentRadixTree& r) = default;
+  PersistentRadixTree& operator=(const PersistentRadixTree& r) = default;
+  PersistentRadixTree(PersistentRadixTree&& r) noexcept
+    : root_(std::move(r.root_)), size_(r.size_) {
+    r.size_ = 0;
+  }
+  PersistentRadixTree& operator=(PersistentRadixTree&& r) noexcept {
+    root_ = std::move(r.root_);
+    size_ = r.size_;
+    r.size_ = 0;
+    return *this;
+  }
+
+  // Explicit spelling of the copy, for symmetry with RadixTree::clone()
+  PersistentRadixTree clone() const {
+    return *this;
+  }
+
+  ConstIterator begin() const { return ConstIterator(root_.get()); }
+  ConstIterator end()   const { return ConstIterator(); }
+
+  // Drop this tree's reference to all nodes.
+  void clear() {
+    root_.reset();
+    size_ = 0;
+  }
+
+  /*
+   * Insert a IP, mask, value in tree. Returns true if a value was
+   * inserted, false if IP, mask already had a value in the tree (the
+   * existing value is left untouched in that case).
+   */
+  template <typename VALUE>
+  bool insert(const IPADDRTYPE& ipaddr, uint8_t masklen, VALUE&& value);
+
+  /*
+   * Replace value for IP, mask. Returns false if IP, mask does not
+   * have a value in the tree.
+   */
+  template <typename VALUE>
+  bool update(const IPADDRTYPE& ipaddr, uint8_t masklen, VALUE&& value);
+
+  // Erase a IP, mask
+  bool erase(const IPADDRTYPE& ipaddr, uint8_t masklen);
+
+  // Given a IP, mask return the node with longest match for it
+  ConstIterator longestMatch(const IPADDRTYPE& ipaddr,
+      uint8_t masklen) const {
+    auto foundExact = false;
+    return ConstIterator(root_.get(),
+        longestMatchImpl(ipaddr, masklen, foundExact), false);
+  }
+
+  /*
+   * Given a IP, mask return node whose IP, mask which matches this prefix
+   * exactly
+   */
+  ConstIterator exactMatch(const IPADDRTYPE& ipaddr,
+      uint8_t  masklen) const {
+    auto foundExact = false;
+    auto match = longestMatchImpl(ipaddr, masklen, foundExact);
+    return ConstIterator(root_.get(), foundExact ? match : nullptr, false);
+  }
+
+  /*
+   * Return the first node, in iteration order, of those within IP, mask,
+   * or end() if there are none.  Those nodes are all visited before any
+   * other, so iteration can stop at the first node outside of IP, mask.
+   */
+  ConstIterator subTreeBegin(const IPADDRTYPE& ipaddr, uint8_t masklen) const;
+
+  // Compare 2 radix (sub) trees. Shared subtrees compare equal right away.
+  static bool radixSubTreesEqual(const TreeNode* nodeA,
+      const TreeNode* nodeB);
+
+  bool operator==(const PersistentRadixTree& r) const {
+    return size_ == r.size_ && radixSubTreesEqual(root(), r.root());
+  }
+
+  bool operator!=(const PersistentRadixTree& r) const {
+    return !(*this == r);
+  }
+
+  size_t size()  const { return size_; }
+  const TreeNode* root() const { return root_.get(); }
+
+ private:
+  typedef std::vector<const TreeNode*> NodePath;
+
+  const TreeNode* longestMatchImpl(const IPADDRTYPE& ipaddr,
+      uint8_t masklen, bool& foundExact) const;
+
+  // Fill path with nodes from root to the value node for IP, mask.
+  // Returns false if there is no such value node.
+  bool findPath(const IPADDRTYPE& ipaddr, uint8_t masklen,
+      NodePath* path) const;
+
+  // Return node held by slot, making a private copy first if the
+  // node is shared with another tree.
+  static TreeNode* writable(NodePtr& slot) {
+    if (slot.use_count() > 1) {
+      slot = std::make_shared<TreeNode>(*slot);
+    }
+    return slot.get();
+  }
+
+  // Make all nodes above path[depth] private to this tree and return
+  // the (now writable) slot holding path[depth].
+  NodePtr* writableSlot(const NodePath& path, size_t depth);
+
+  NodePtr root_{nullptr};
+  size_t size_{0};
+};
+
 // Free standing helper functions
 
 // Given a radix tree iterator get its path from root
@@ -1079,6 +1394,8 @@ std::string trailStr(const typename std::vector<IterType>& trail,
 // Disallow instantiation with folly::IPAddress
 template<typename T>
 class RadixTreeNode<folly::IPAddress, T>;
+template<typename T>
+class PersistentRadixTreeNode<folly::IPAddress, T>;
 
 }} // facebook::network
 
@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <cstdio>
+
+#include <folly/Benchmark.h>
+#include "fboss/lib/usb/CP2112.h"
+#include "fboss/lib/usb/CP2112Simulator.h"
+#include "fboss/lib/usb/WedgeI2CBus.h"
+
+using namespace facebook::fboss;
+using folly::MutableByteRange;
+
+namespace {
+
+/*
+ * These benchmarks read the 256 bytes of a QSFP's lower and upper pages off
+ * a simulated wedge QSFP bus, cycling through the 16 modules, the way
+ * WedgeManager refreshes them.  The time reported is per module read, so the
+ * iterations per second are the modules that could be refreshed per second.
+ * The simulated SMBus runs at 400kHz, as the real one does, which puts the
+ * floor at around 6ms per read.
+ */
+constexpr int kNumModules = 16;
+constexpr uint8_t kEepromAddr = 0xa2;
+constexpr uint8_t kSwitchAddrs[] = {0xe8, 0xec};
+constexpr uint8_t kQsfpAddr = 0xa0;
+// Which switch bit selects each module, as in WedgeI2CBus
+constexpr uint8_t kModuleBits[] = {
+  0x02, 0x01, 0x08, 0x04, 0x20, 0x10, 0x80, 0x40,
+};
+
+void addWedgeBus(CP2112Simulator* sim) {
+  std::vector<uint8_t> image(256, 0xa5);
+  sim->addEeprom(kEepromAddr, image);
+  for (auto sw : kSwitchAddrs) {
+    sim->addSwitch(sw);
+    for (unsigned int channel = 0; channel < 8; ++channel) {
+      sim->addEeprom(sw, channel, kQsfpAddr, image);
+    }
+  }
+}
+
+} // unnamed namespace
+
+/*
+ * The sequence of blocking calls that moduleRead() used to make.
+ */
+BENCHMARK(BlockingModuleRead, numIters) {
+  folly::BenchmarkSuspender braces;
+  CP2112Simulator sim;
+  addWedgeBus(&sim);
+  CP2112 dev(&sim);
+  dev.open();
+  uint8_t buf[256];
+  braces.dismiss();
+
+  for (unsigned int n = 0; n < numIters; ++n) {
+    int module = n % kNumModules;
+    auto sw = kSwitchAddrs[module / 8];
+    dev.writeByte(sw, kModuleBits[module % 8]);
+    dev.writeByte(kQsfpAddr, 0);
+    dev.read(kQsfpAddr, MutableByteRange(buf, 128));
+    dev.writeByte(kQsfpAddr, 128);
+    dev.read(kQsfpAddr, MutableByteRange(buf + 128, 128));
+    dev.writeByte(sw, 0);
+  }
+}
+
+BENCHMARK_RELATIVE(PipelinedModuleRead, numIters) {
+  folly::BenchmarkSuspender braces;
+  CP2112Simulator sim;
+  addWedgeBus(&sim);
+  WedgeI2CBus bus(&sim);
+  bus.open();
+  uint8_t buf[256];
+  braces.dismiss();
+
+  for (unsigned int n = 0; n < numIters; ++n) {
+    bus.moduleRead(n % kNumModules + 1, kQsfpAddr >> 1, 0, sizeof(buf), buf);
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/lib/usb/CP2112.h"
+#include "fboss/lib/usb/CP2112Simulator.h"
+#include "fboss/lib/usb/UsbError.h"
+#include "fboss/lib/usb/WedgeI2CBus.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::MutableByteRange;
+using std::exception_ptr;
+using std::vector;
+
+namespace {
+
+constexpr uint8_t kEepromAddr = 0xa2;
+constexpr uint8_t kSwitch1Addr = 0xe8;
+constexpr uint8_t kSwitch2Addr = 0xec;
+// The QSFP EEPROM address, in the Linux format the bus APIs take
+constexpr uint8_t kQsfpAddr = 0x50;
+
+vector<uint8_t> makeImage(uint8_t tag) {
+  vector<uint8_t> image(256);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = i ^ tag;
+  }
+  return image;
+}
+
+/*
+ * The wedge QSFP bus: an EEPROM on the root bus, and a QSFP behind each
+ * channel of two switches.  The QSFP behind channel c of switch s is tagged
+ * s * 8 + c + 1.
+ */
+void addWedgeBus(CP2112Simulator* sim) {
+  sim->addEeprom(kEepromAddr, makeImage(0));
+  sim->addSwitch(kSwitch1Addr);
+  sim->addSwitch(kSwitch2Addr);
+  for (unsigned int channel = 0; channel < 8; ++channel) {
+    sim->addEeprom(kSwitch1Addr, channel, kQsfpAddr << 1,
+                   makeImage(channel + 1));
+    sim->addEeprom(kSwitch2Addr, channel, kQsfpAddr << 1,
+                   makeImage(channel + 9));
+  }
+}
+
+// Wedge swaps each pair of modules on the switch channels
+uint8_t getModuleTag(unsigned int module) {
+  return ((module - 1) ^ 1) + 1;
+}
+
+}
+
+TEST(CP2112, SyncReadWrite) {
+  CP2112Simulator sim;
+  sim.addEeprom(kEepromAddr, makeImage(0x5a));
+  CP2112 dev(&sim);
+  dev.open();
+  EXPECT_TRUE(dev.isOpen());
+
+  // More than one READ_RESPONSE's worth
+  uint8_t buf[200];
+  dev.writeByte(kEepromAddr, 10);
+  dev.read(kEepromAddr, MutableByteRange(buf, sizeof(buf)));
+  for (size_t i = 0; i < sizeof(buf); ++i) {
+    EXPECT_EQ((10 + i) ^ 0x5a, buf[i]) << "at " << i;
+  }
+
+  uint8_t data[]{4, 0xaa, 0xbb};
+  dev.write(kEepromAddr, folly::ByteRange(data, sizeof(data)));
+  EXPECT_EQ(0xaa, sim.getEeprom(0, 0, kEepromAddr)[4]);
+  EXPECT_EQ(0xbb, sim.getEeprom(0, 0, kEepromAddr)[5]);
+
+  // Nothing answers this address
+  EXPECT_THROW(dev.read(0xa0, MutableByteRange(buf, 8)), UsbError);
+}
+
+TEST(CP2112, AsyncQueue) {
+  CP2112Simulator sim;
+  sim.addEeprom(kEepromAddr, makeImage(0));
+  CP2112 dev(&sim);
+  dev.open();
+
+  vector<int> done;
+  auto expectOk = [&done](int n) {
+    return [&done, n](exception_ptr error) {
+      EXPECT_FALSE(error);
+      done.push_back(n);
+    };
+  };
+
+  uint8_t first[128];
+  uint8_t second[128];
+  dev.writeByteAsync(kEepromAddr, 0, expectOk(0));
+  dev.readAsync(kEepromAddr, MutableByteRange(first, sizeof(first)),
+                expectOk(1));
+  dev.writeByteAsync(kEepromAddr, 128, expectOk(2));
+  dev.readAsync(kEepromAddr, MutableByteRange(second, sizeof(second)),
+                expectOk(3));
+  EXPECT_EQ(4, dev.numQueued());
+  // Nothing happens until the queue is run
+  EXPECT_TRUE(done.empty());
+
+  dev.runQueue();
+  EXPECT_EQ(0, dev.numQueued());
+  EXPECT_EQ((vector<int>{0, 1, 2, 3}), done);
+  for (int i = 0; i < 128; ++i) {
+    EXPECT_EQ(i, first[i]);
+    EXPECT_EQ(i + 128, second[i]);
+  }
+}
+
+TEST(CP2112, AsyncFailureFailsRest) {
+  CP2112Simulator sim;
+  sim.addEeprom(kEepromAddr, makeImage(0));
+  CP2112 dev(&sim);
+  dev.open();
+
+  vector<exception_ptr> errors;
+  auto record = [&errors](exception_ptr error) {
+    errors.push_back(error);
+  };
+
+  uint8_t buf[8];
+  dev.writeByteAsync(kEepromAddr, 0x10, record);
+  // Nothing answers this address
+  dev.readAsync(0xa0, MutableByteRange(buf, sizeof(buf)), record);
+  dev.writeByteAsync(kEepromAddr, 0x20, record);
+  dev.runQueue();
+
+  ASSERT_EQ(3, errors.size());
+  EXPECT_FALSE(errors[0]);
+  EXPECT_TRUE(errors[1]);
+  EXPECT_EQ(errors[1], errors[2]);
+  EXPECT_THROW(std::rethrow_exception(errors[1]), UsbError);
+
+  // The last write wasn't run, and the queue works again afterwards
+  dev.readAsync(kEepromAddr, MutableByteRange(buf, sizeof(buf)), record);
+  dev.runQueue();
+  ASSERT_EQ(4, errors.size());
+  EXPECT_FALSE(errors[3]);
+  EXPECT_EQ(0x10, buf[0]);
+}
+
+TEST(CP2112, WedgeModuleRead) {
+  CP2112Simulator sim;
+  addWedgeBus(&sim);
+  WedgeI2CBus bus(&sim);
+  bus.open();
+
+  for (unsigned int module = 1; module <= 16; ++module) {
+    // Reads of over 128 bytes are split
+    uint8_t buf[256];
+    bus.moduleRead(module, kQsfpAddr, 0, sizeof(buf), buf);
+    auto tag = getModuleTag(module);
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+      ASSERT_EQ(i ^ tag, buf[i]) << "module " << module << " at " << i;
+    }
+    // The module stays selected afterwards, and only it
+    auto channels = sim.getSwitchChannels(kSwitch1Addr) |
+      sim.getSwitchChannels(kSwitch2Addr);
+    EXPECT_EQ(1, __builtin_popcount(channels)) << "module " << module;
+  }
+
+  uint8_t data[]{0x12, 0x34};
+  bus.moduleWrite(3, kQsfpAddr, 100, sizeof(data), data);
+  const auto& image = sim.getEeprom(kSwitch1Addr, getModuleTag(3) - 1,
+                                    kQsfpAddr << 1);
+  EXPECT_EQ(0x12, image[100]);
+  EXPECT_EQ(0x34, image[101]);
+}
+
+TEST(CP2112, WedgeModuleReadFailure) {
+  CP2112Simulator sim;
+  addWedgeBus(&sim);
+  WedgeI2CBus bus(&sim);
+  bus.open();
+
+  // Nothing answers at this address behind the switches
+  uint8_t buf[16];
+  EXPECT_THROW(bus.moduleRead(5, 0x52, 0, sizeof(buf), buf), UsbError);
+  EXPECT_EQ(0, sim.getSwitchChannels(kSwitch1Addr));
+  EXPECT_EQ(0, sim.getSwitchChannels(kSwitch2Addr));
+
+  bus.moduleRead(12, kQsfpAddr, 0, sizeof(buf), buf);
+  EXPECT_EQ(getModuleTag(12), buf[0]);
+}
+
+TEST(CP2112, WedgeModuleStaysSelected) {
+  CP2112Simulator sim;
+  addWedgeBus(&sim);
+  WedgeI2CBus bus(&sim);
+  bus.open();
+
+  uint8_t buf[16];
+  bus.moduleRead(3, kQsfpAddr, 0, sizeof(buf), buf);
+  EXPECT_NE(0, sim.getSwitchChannels(kSwitch1Addr));
+
+  // Accessing the same module again doesn't touch the switches
+  auto numReports = sim.getNumReports();
+  bus.moduleRead(3, kQsfpAddr, 0, sizeof(buf), buf);
+  auto reselectReports = sim.getNumReports() - numReports;
+  numReports = sim.getNumReports();
+  bus.moduleRead(11, kQsfpAddr, 0, sizeof(buf), buf);
+  EXPECT_LT(reselectReports, sim.getNumReports() - numReports);
+  EXPECT_EQ(getModuleTag(11), buf[0]);
+  EXPECT_EQ(0, sim.getSwitchChannels(kSwitch1Addr));
+  EXPECT_NE(0, sim.getSwitchChannels(kSwitch2Addr));
+
+  // Accessing the root bus deselects the module
+  bus.read(kEepromAddr >> 1, 4, sizeof(buf), buf);
+  EXPECT_EQ(4, buf[0]);
+  EXPECT_EQ(0, sim.getSwitchChannels(kSwitch1Addr));
+  EXPECT_EQ(0, sim.getSwitchChannels(kSwitch2Addr));
+}
@@ -51,6 +51,11 @@ BENCHMARK_RELATIVE(RadixTreeInsert4) {
   setupTree4(rtree);
 }
 
+BENCHMARK_RELATIVE(PersistentRadixTreeInsert4) {
+  PersistentRadixTree<IPAddressV4, int> rtree;
+  setupTree4(rtree);
+}
+
 BENCHMARK(PyRadixErase4) {
   PyRadixWrapper<IPAddressV4, int> pyrtree;
   BENCHMARK_SUSPEND {
@@ -191,6 +196,55 @@ BENCHMARK_RELATIVE(RadixTreeLongestMatch6) {
   }
 }
 
+
+/*
+ * Clone a table of a given size and insert one prefix into the clone.
+ * This is what every route update does to the RIB, so it should stay
+ * flat as the table grows for PersistentRadixTree, while RadixTree
+ * pays for a full copy.
+ */
+vector<Prefix4> cloneInsertTable4;
+
+template<typename TREE>
+void setupCloneInsertTree4(TREE& tree, size_t tableSize) {
+  for (auto i = 0; i < tableSize; ++i) {
+    tree.insert(cloneInsertTable4[i].ip, cloneInsertTable4[i].mask, i);
+  }
+}
+
+void RadixTreeCloneInsert4(uint32_t iters, size_t tableSize) {
+  RadixTree<IPAddressV4, int> rtree;
+  BENCHMARK_SUSPEND {
+    setupCloneInsertTree4(rtree, tableSize);
+  }
+  for (auto i = 0; i < iters; ++i) {
+    auto copy = rtree.clone();
+    const auto& pfx = cloneInsertTable4[tableSize + i % 1000];
+    copy.insert(pfx.ip, pfx.mask, i);
+  }
+}
+
+void PersistentRadixTreeCloneInsert4(uint32_t iters, size_t tableSize) {
+  PersistentRadixTree<IPAddressV4, int> rtree;
+  BENCHMARK_SUSPEND {
+    setupCloneInsertTree4(rtree, tableSize);
+  }
+  for (auto i = 0; i < iters; ++i) {
+    auto copy = rtree;
+    const auto& pfx = cloneInsertTable4[tableSize + i % 1000];
+    copy.insert(pfx.ip, pfx.mask, i);
+  }
+}
+
+BENCHMARK_PARAM(RadixTreeCloneInsert4, 1000);
+BENCHMARK_RELATIVE_PARAM(PersistentRadixTreeCloneInsert4, 1000);
+BENCHMARK_PARAM(RadixTreeCloneInsert4, 10000);
+BENCHMARK_RELATIVE_PARAM(PersistentRadixTreeCloneInsert4, 10000);
+BENCHMARK_PARAM(RadixTreeCloneInsert4, 100000);
+BENCHMARK_RELATIVE_PARAM(PersistentRadixTreeCloneInsert4, 100000);
+BENCHMARK_PARAM(RadixTreeCloneInsert4, 500000);
+BENCHMARK_RELATIVE_PARAM(PersistentRadixTreeCloneInsert4, 500000);
+
 }
 
 int main (int argc, char *argv[]) {
@@ -246,6 +300,15 @@ int main (int argc, char *argv[]) {
     auto newIp = pfx.ip.mask(newMask);
     longestMatchSet6.insert(Prefix6(newIp, newMask));
   }
+  // Table sizes used for clone + insert, plus 1000 prefixes to insert
+  set<Prefix4> cloneInsertSet4;
+  while (cloneInsertSet4.size() < 500000 + 1000) {
+    auto mask = folly::Random::rand32(8, 33);
+    auto ip = IPAddressV4::fromLongHBO(folly::Random::rand32()).mask(mask);
+    if (cloneInsertSet4.insert(Prefix4(ip, mask)).second) {
+      cloneInsertTable4.push_back(Prefix4(ip, mask));
+    }
+  }
   runBenchmarks();
 }
 
@@ -81,6 +81,24 @@ struct RadixTreeNodeAccessor {
   static const TreeNode* right(const TreeNode& node) { return node.right(); }
 };
 
+template<typename IPAddrType, typename T>
+struct PersistentRadixTreeNodeAccessor {
+  typedef PersistentRadixTreeNode<IPAddrType, T>  TreeNode;
+  static IPAddrType ipAddress(const TreeNode& node) { return node.ipAddress(); }
+  static uint8_t masklen(const TreeNode& node) { return node.masklen(); }
+  static bool  isNonValueNode(const TreeNode& node){
+    return node.isNonValueNode();
+  }
+  static const T&  value(const TreeNode& node) {
+    if (!node.isValueNode()) {
+      throw logic_error("Can't access value on non value nodes");
+    }
+    return node.value();
+  }
+  static const TreeNode* left(const TreeNode& node)  { return node.left();  }
+  static const TreeNode* right(const TreeNode& node) { return node.right(); }
+};
+
 template<typename IPAddrType, typename T>
 struct RadixAndPyRadixNodeEqual {
   bool operator()(const RadixTreeNode<IPAddrType, T>& l,
@@ -1447,3 +1465,164 @@ TEST(RadixTree, SubTreeIterator) {
   }
   EXPECT_EQ(rtree.end().subTreeIterator(), rtree.end());
 }
+
+// Compare a PersistentRadixTree with a RadixTree node by node
+template<typename IPAddrType, typename T>
+bool persistentTreeEqual(const PersistentRadixTree<IPAddrType, T>& ptree,
+    const RadixTree<IPAddrType, T>& rtree) {
+  typedef PersistentRadixTreeNode<IPAddrType, T> NodeA;
+  typedef RadixTreeNode<IPAddrType, T> NodeB;
+  typedef PersistentRadixTreeNodeAccessor<IPAddrType, T> NodeAAccessor;
+  typedef RadixTreeNodeAccessor<IPAddrType, T> NodeBAccessor;
+  return ptree.size() == rtree.size() &&
+    radixTreeEqual<IPAddrType, T, NodeA, NodeB, NodeAAccessor, NodeBAccessor,
+      RadixTreeNodeEqualSansLinks<IPAddrType, T, NodeA, NodeB, NodeAAccessor,
+      NodeBAccessor>>(ptree.root(), rtree.root());
+}
+
+TEST(PersistentRadixTree, CompareWithRadixTree) {
+  RadixTree<IPAddressV4, int> rtree;
+  PersistentRadixTree<IPAddressV4, int> ptree;
+  setupTestTree4(rtree);
+  for (const auto& itr: rtree) {
+    EXPECT_TRUE(ptree.insert(itr.ipAddress(), itr.masklen(), itr.value()));
+  }
+  EXPECT_TRUE(persistentTreeEqual(ptree, rtree));
+  // Duplicate insert is rejected and leaves the value alone
+  EXPECT_FALSE(ptree.insert(ip128_0_0_0, 2, 100));
+  EXPECT_EQ(1, ptree.exactMatch(ip128_0_0_0, 2)->value());
+
+  std::vector<std::pair<IPAddressV4, uint8_t>> prefixes;
+  auto const kInsertCount = 1000;
+  for (auto i = 0; i < kInsertCount; ++i) {
+    auto mask = folly::Random::rand32(33);
+    auto ip = IPAddressV4::fromLongHBO(folly::Random::rand32()).mask(mask);
+    auto insertedR = rtree.insert(ip, mask, i).second;
+    EXPECT_EQ(insertedR, ptree.insert(ip, mask, i));
+    if (insertedR) {
+      prefixes.emplace_back(ip, mask);
+    }
+  }
+  EXPECT_TRUE(persistentTreeEqual(ptree, rtree));
+  for (auto i = 0; i < prefixes.size(); i += 3) {
+    EXPECT_TRUE(rtree.erase(prefixes[i].first, prefixes[i].second));
+    EXPECT_TRUE(ptree.erase(prefixes[i].first, prefixes[i].second));
+    EXPECT_FALSE(ptree.erase(prefixes[i].first, prefixes[i].second));
+  }
+  for (auto i = 1; i < prefixes.size(); i += 3) {
+    rtree.exactMatch(prefixes[i].first, prefixes[i].second).setValue(-i);
+    EXPECT_TRUE(ptree.update(prefixes[i].first, prefixes[i].second, -i));
+  }
+  EXPECT_TRUE(persistentTreeEqual(ptree, rtree));
+  // Lookups and iteration agree as well
+  for (const auto& pfx: prefixes) {
+    auto ritr = rtree.longestMatch(pfx.first, pfx.second);
+    auto pitr = ptree.longestMatch(pfx.first, pfx.second);
+    ASSERT_EQ(ritr == rtree.end(), pitr == ptree.end());
+    if (ritr != rtree.end()) {
+      EXPECT_EQ(ritr->value(), pitr->value());
+    }
+  }
+  auto pitr = ptree.begin();
+  for (const auto& ritr: rtree) {
+    ASSERT_NE(ptree.end(), pitr);
+    EXPECT_EQ(ritr.ipAddress(), pitr->ipAddress());
+    EXPECT_EQ(ritr.masklen(), pitr->masklen());
+    ++pitr;
+  }
+  EXPECT_EQ(ptree.end(), pitr);
+}
+
+TEST(PersistentRadixTree, CopyOnWrite) {
+  RadixTree<IPAddressV4, int> rtree;
+  PersistentRadixTree<IPAddressV4, int> orig;
+  setupTestTree4(rtree);
+  for (const auto& itr: rtree) {
+    orig.insert(itr.ipAddress(), itr.masklen(), itr.value());
+  }
+  // Copy shares everything
+  auto copy = orig;
+  EXPECT_EQ(orig.root(), copy.root());
+  EXPECT_TRUE(orig == copy);
+
+  // 160/3 lives under 128/1, changing it must leave 0/1 subtree shared
+  EXPECT_TRUE(copy.update(ip160_0_0_0, 3, 50));
+  EXPECT_NE(orig.root(), copy.root());
+  EXPECT_EQ(orig.root()->left(), copy.root()->left());
+  EXPECT_NE(orig.root()->right(), copy.root()->right());
+  EXPECT_EQ(5, orig.exactMatch(ip160_0_0_0, 3)->value());
+  EXPECT_EQ(50, copy.exactMatch(ip160_0_0_0, 3)->value());
+
+  // Inserts and erases on the copy don't show up in the original
+  EXPECT_TRUE(copy.insert(ip48_0_0_0, 6, 10));
+  EXPECT_TRUE(copy.erase(ip72_0_0_0, 6));
+  EXPECT_TRUE(copy.erase(ip0_0_0_0, 4));
+  EXPECT_TRUE(persistentTreeEqual(orig, rtree));
+  rtree.exactMatch(ip160_0_0_0, 3).setValue(50);
+  rtree.insert(ip48_0_0_0, 6, 10);
+  rtree.erase(ip72_0_0_0, 6);
+  rtree.erase(ip0_0_0_0, 4);
+  EXPECT_TRUE(persistentTreeEqual(copy, rtree));
+  EXPECT_TRUE(orig != copy);
+
+  // Modifying a tree which is no longer shared doesn't copy the path
+  auto root = copy.root();
+  EXPECT_TRUE(copy.update(ip160_0_0_0, 3, 51));
+  EXPECT_EQ(root, copy.root());
+}
+
+TEST(PersistentRadixTree, IteratorFromMatch) {
+  RadixTree<IPAddressV4, int> rtree;
+  PersistentRadixTree<IPAddressV4, int> ptree;
+  auto inserted = setupTestTree4(rtree);
+  for (const auto& itr: rtree) {
+    ptree.insert(itr.ipAddress(), itr.masklen(), itr.value());
+  }
+  // Iterating on from a looked up node visits the same nodes
+  // as iterating on from the same node in RadixTree
+  for (const auto& pfx: inserted) {
+    auto ritr = rtree.exactMatch(pfx.ip, pfx.mask);
+    auto pitr = ptree.exactMatch(pfx.ip, pfx.mask);
+    for (; ritr != rtree.end(); ++ritr, ++pitr) {
+      ASSERT_NE(ptree.end(), pitr);
+      EXPECT_EQ(ritr->value(), pitr->value());
+    }
+    EXPECT_EQ(ptree.end(), pitr);
+  }
+  EXPECT_EQ(ptree.end(), ptree.exactMatch(ip0_0_0_0, 0));
+}
+
+TEST(PersistentRadixTree, SubTreeBegin) {
+  RadixTree<IPAddressV4, int> rtree;
+  PersistentRadixTree<IPAddressV4, int> ptree;
+  setupTestTree4(rtree);
+  for (const auto& itr: rtree) {
+    ptree.insert(itr.ipAddress(), itr.masklen(), itr.value());
+  }
+  auto within = [](const PersistentRadixTree<IPAddressV4, int>::ConstIterator&
+                   itr, const Prefix4& pfx) {
+    return itr.masklen() >= pfx.mask &&
+      itr.ipAddress().mask(pfx.mask) == pfx.ip.mask(pfx.mask);
+  };
+  // Value nodes, non value nodes, and prefixes with no node at all
+  vector<Prefix4> prefixes = {
+    {ip0_0_0_0, 0}, {ip0_0_0_0, 1}, {ip0_0_0_0, 2}, {ip64_0_0_0, 2},
+    {ip72_0_0_0, 6}, {ip80_0_0_0, 5}, {ip128_0_0_0, 1}, {ip160_0_0_0, 4},
+    {IPAddressV4("200.0.0.0"), 8},
+  };
+  for (const auto& pfx: prefixes) {
+    vector<int> expected;
+    for (const auto& itr: ptree) {
+      if (within(itr, pfx)) {
+        expected.push_back(itr.value());
+      }
+    }
+    // The nodes within the prefix come first, and together
+    vector<int> found;
+    auto itr = ptree.subTreeBegin(pfx.ip, pfx.mask);
+    for (; itr != ptree.end() && within(itr, pfx); ++itr) {
+      found.push_back(itr.value());
+    }
+    EXPECT_EQ(expected, found) << pfx.ip << "/" << (int)pfx.mask;
+  }
+}
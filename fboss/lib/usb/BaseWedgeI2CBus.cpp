@@ -11,6 +11,9 @@
 #include "fboss/lib/usb/BaseWedgeI2CBus.h"
 #include "fboss/lib/usb/UsbError.h"
 
+#include <folly/ScopeGuard.h>
+
+using folly::ByteRange;
 using folly::MutableByteRange;
 using std::lock_guard;
 
@@ -19,6 +22,10 @@ namespace facebook { namespace fboss {
 BaseWedgeI2CBus::BaseWedgeI2CBus() {
 }
 
+BaseWedgeI2CBus::BaseWedgeI2CBus(CP2112Endpoint* endpoint)
+  : dev_(endpoint) {
+}
+
 void BaseWedgeI2CBus::open() {
   dev_.open();
 
@@ -35,6 +42,20 @@ void BaseWedgeI2CBus::close() {
 
 void BaseWedgeI2CBus::read(uint8_t address, int offset,
                            int len, uint8_t* buf) {
+  // The selected module might answer at the same address as the device on
+  // the root bus.
+  unselectQsfp();
+  readAt(address, offset, len, buf);
+}
+
+void BaseWedgeI2CBus::write(uint8_t address, int offset,
+                            int len, const uint8_t* buf) {
+  unselectQsfp();
+  writeAt(address, offset, len, buf);
+}
+
+void BaseWedgeI2CBus::readAt(uint8_t address, int offset,
+                             int len, uint8_t* buf) {
   CHECK_LE(offset, 255);
 
   // CP2112 uses addresses in the on-the-wire format, while we generally
@@ -47,18 +68,18 @@ void BaseWedgeI2CBus::read(uint8_t address, int offset,
   // that's okay since there aren't any other master devices on the bus.
 
   // Also note that we can't read more than 128 bytes at a time.
-  dev_.writeByte(address, offset);
+  busWriteByte(address, offset);
   if (len > 128) {
-    dev_.read(address, MutableByteRange(buf, 128));
-    dev_.writeByte(address, offset + 128);
-    dev_.read(address, MutableByteRange(buf + 128, len - 128));
+    busRead(address, MutableByteRange(buf, 128));
+    busWriteByte(address, offset + 128);
+    busRead(address, MutableByteRange(buf + 128, len - 128));
   } else {
-    dev_.read(address, MutableByteRange(buf, len));
+    busRead(address, MutableByteRange(buf, len));
   }
 }
 
-void BaseWedgeI2CBus::write(uint8_t address, int offset,
-                            int len, const uint8_t* buf) {
+void BaseWedgeI2CBus::writeAt(uint8_t address, int offset,
+                              int len, const uint8_t* buf) {
   CHECK_LE(offset, 255);
 
   // CP2112 uses addresses in the on-the-wire format, while we generally
@@ -73,27 +94,99 @@ void BaseWedgeI2CBus::write(uint8_t address, int offset,
   uint8_t output[61]; // USB buffer size;
   output[0] = offset;
   memcpy(output + 1, buf, len);
-  dev_.write(address, MutableByteRange(output, len + 1));
+  busWrite(address, ByteRange(output, len + 1));
 }
 
 void BaseWedgeI2CBus::moduleRead(unsigned int module, uint8_t address,
                                  int offset, int len, uint8_t* buf) {
-  selectQsfp(module);
-  CHECK_NE(selectedPort_, NO_PORT);
-
-  read(address, offset, len, buf);
-
-  unselectQsfp();
+  // The module is left selected afterwards, so that further accesses to it
+  // needn't select it again.
+  pipelined([&] {
+    selectQsfp(module);
+    CHECK_NE(selectedPort_, NO_PORT);
+
+    readAt(address, offset, len, buf);
+  });
 }
 
 void BaseWedgeI2CBus::moduleWrite(unsigned int module, uint8_t address,
                                   int offset, int len, const uint8_t* buf) {
-  selectQsfp(module);
-  CHECK_NE(selectedPort_, NO_PORT);
+  pipelined([&] {
+    selectQsfp(module);
+    CHECK_NE(selectedPort_, NO_PORT);
 
-  write(address, offset, len, buf);
+    writeAt(address, offset, len, buf);
+  });
+}
 
-  unselectQsfp();
+void BaseWedgeI2CBus::pipelined(const std::function<void()>& fn) {
+  CHECK(!pipelining_);
+  pipelining_ = true;
+  pipelineError_ = nullptr;
+  SCOPE_EXIT {
+    pipelining_ = false;
+  };
+
+  // Whatever was queued has to be run even if fn() throws, so that it isn't
+  // left for the next caller.
+  std::exception_ptr error;
+  try {
+    fn();
+  } catch (const std::exception&) {
+    error = std::current_exception();
+  }
+  try {
+    dev_.runQueue();
+  } catch (const std::exception&) {
+    if (!error) {
+      error = std::current_exception();
+    }
+  }
+  if (!error) {
+    error = pipelineError_;
+  }
+  if (!error) {
+    return;
+  }
+
+  // selectedPort_ was updated as the switch writes were queued, so we no
+  // longer know which module is selected.  Deselect them all.
+  selectedPort_ = NO_PORT;
+  pipelining_ = false;
+  try {
+    initBus();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "failed to reset QSFP switches: " << ex.what();
+  }
+  std::rethrow_exception(error);
+}
+
+void BaseWedgeI2CBus::busRead(uint8_t address, MutableByteRange buf) {
+  if (!pipelining_) {
+    dev_.read(address, buf);
+    return;
+  }
+  dev_.readAsync(address, buf, [this](std::exception_ptr error) {
+    if (error && !pipelineError_) {
+      pipelineError_ = error;
+    }
+  });
+}
+
+void BaseWedgeI2CBus::busWrite(uint8_t address, ByteRange buf) {
+  if (!pipelining_) {
+    dev_.write(address, buf);
+    return;
+  }
+  dev_.writeAsync(address, buf, [this](std::exception_ptr error) {
+    if (error && !pipelineError_) {
+      pipelineError_ = error;
+    }
+  });
+}
+
+void BaseWedgeI2CBus::busWriteByte(uint8_t address, uint8_t value) {
+  busWrite(address, ByteRange(&value, sizeof(value)));
 }
 
 void BaseWedgeI2CBus::selectQsfp(unsigned int port) {
@@ -12,6 +12,8 @@
 #include "fboss/lib/usb/TransceiverI2CApi.h"
 #include "fboss/lib/usb/CP2112.h"
 
+#include <exception>
+#include <functional>
 #include <mutex>
 #include <folly/Range.h>
 
@@ -20,11 +22,20 @@ namespace facebook { namespace fboss {
 /*
  * A small wrapper around CP2112 which is aware of the topology of wedge's QSFP
  * I2C bus, and can select specific QSFPs to query.
+ *
+ * moduleRead() and moduleWrite() queue up the switch writes selecting the
+ * module, the transfers to it, and the switch writes deselecting it again,
+ * and run them back to back as one CP2112 transaction queue.
  */
 class BaseWedgeI2CBus : public TransceiverI2CApi {
 
  public:
   BaseWedgeI2CBus();
+  /*
+   * Use the given endpoint rather than a CP2112 on USB, such as a
+   * CP2112Simulator.
+   */
+  explicit BaseWedgeI2CBus(CP2112Endpoint* endpoint);
   virtual ~BaseWedgeI2CBus() {}
   virtual void open() override;
   virtual void close() override;
@@ -32,6 +43,9 @@ class BaseWedgeI2CBus : public TransceiverI2CApi {
                           int offset, int len, uint8_t* buf) override;
   virtual void moduleWrite(unsigned int module, uint8_t i2cAddress,
                            int offset, int len, const uint8_t* buf) override;
+  /*
+   * Access a device on the root bus, rather than behind the switches.
+   */
   void read(uint8_t i2cAddress, int offset, int len, uint8_t* buf);
   void write(uint8_t i2cAddress, int offset, int len, const uint8_t* buf);
 
@@ -44,7 +58,16 @@ class BaseWedgeI2CBus : public TransceiverI2CApi {
   virtual void verifyBus(bool autoReset = true) = 0;
   virtual void selectQsfpImpl(unsigned int module) = 0;
 
+  /*
+   * Write a byte on the bus, for selectQsfpImpl() to set the switches with.
+   * This is queued with the other transactions when pipelining.
+   */
+  void busWriteByte(uint8_t address, uint8_t value);
+
   CP2112 dev_;
+  // The module the switches currently connect to the bus.  It stays
+  // selected between accesses to it, until another module or a device on the
+  // root bus is accessed, or the bus is reopened.
   unsigned int selectedPort_{NO_PORT};
 
  private:
@@ -55,9 +78,28 @@ class BaseWedgeI2CBus : public TransceiverI2CApi {
   void selectQsfp(unsigned int module);
   void unselectQsfp();
 
+  /*
+   * Access whichever device answers the address, with the switches as they
+   * are.
+   */
+  void readAt(uint8_t address, int offset, int len, uint8_t* buf);
+  void writeAt(uint8_t address, int offset, int len, const uint8_t* buf);
+
+  /*
+   * Queue the transactions that fn makes, rather than running each of them
+   * as it is made, then run them all.  Throws the first failure.
+   */
+  void pipelined(const std::function<void()>& fn);
+  void busRead(uint8_t address, folly::MutableByteRange buf);
+  void busWrite(uint8_t address, folly::ByteRange buf);
+
   // Forbidden copy constructor and assignment operator
   BaseWedgeI2CBus(BaseWedgeI2CBus const &) = delete;
   BaseWedgeI2CBus& operator=(BaseWedgeI2CBus const &) = delete;
+
+  bool pipelining_{false};
+  // The first failure of the transactions being pipelined
+  std::exception_ptr pipelineError_;
 };
 
 }} // facebook::fboss
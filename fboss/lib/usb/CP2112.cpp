@@ -30,9 +30,14 @@
 #include "fboss/agent/BmcRestClient.h"
 
 #include <folly/Bits.h>
+#include <folly/Memory.h>
 #include <folly/ScopeGuard.h>
 #include <libusb-1.0/libusb.h>
 
+#include <unordered_set>
+
+using facebook::fboss::CP2112Endpoint;
+using facebook::fboss::LibusbError;
 using folly::ByteRange;
 using folly::Endian;
 using folly::StringPiece;
@@ -105,10 +110,168 @@ void vlogHex(int vlogLevel,
   VLOG(vlogLevel) << hexBuf;
 }
 
+/*
+ * The CP2112's interrupt endpoint, using libusb's asynchronous transfer API.
+ */
+class LibusbEndpoint : public CP2112Endpoint {
+ public:
+  LibusbEndpoint(libusb_context* ctx, libusb_device_handle* handle)
+    : ctx_(ctx),
+      handle_(handle) {}
+  ~LibusbEndpoint() override;
+
+  void submitOut(const uint8_t* report,
+                 milliseconds timeout,
+                 Callback callback) override {
+    // The CP2112 always uses endpoint 1 for interrupt transfers.
+    submit(LIBUSB_ENDPOINT_OUT | 1, report, timeout, std::move(callback));
+  }
+  void submitIn(milliseconds timeout, Callback callback) override {
+    submit(LIBUSB_ENDPOINT_IN | 1, nullptr, timeout, std::move(callback));
+  }
+  void handleEvents(milliseconds timeout) override;
+
+ private:
+  struct Transfer {
+    Transfer(LibusbEndpoint* ep, Callback cb)
+      : endpoint(ep),
+        callback(std::move(cb)),
+        xfer(libusb_alloc_transfer(0)) {}
+    ~Transfer() {
+      libusb_free_transfer(xfer);
+    }
+
+    LibusbEndpoint* endpoint;
+    Callback callback;
+    libusb_transfer* xfer;
+    uint8_t buf[REPORT_SIZE];
+  };
+
+  void submit(uint8_t endpoint, const uint8_t* report,
+              milliseconds timeout, Callback callback);
+  static void LIBUSB_CALL transferDone(libusb_transfer* xfer);
+
+  libusb_context* ctx_;
+  libusb_device_handle* handle_;
+  std::unordered_set<Transfer*> pending_;
+};
+
+LibusbEndpoint::~LibusbEndpoint() {
+  // Outstanding transfers can only be freed once they have completed,
+  // so cancel them and wait for their callbacks.
+  for (auto* transfer : pending_) {
+    libusb_cancel_transfer(transfer->xfer);
+  }
+  while (!pending_.empty()) {
+    try {
+      handleEvents(milliseconds(100));
+    } catch (const LibusbError& ex) {
+      LOG(ERROR) << "abandoning " << pending_.size()
+                 << " outstanding CP2112 transfers: " << ex.what();
+      break;
+    }
+  }
+}
+
+void LibusbEndpoint::submit(uint8_t endpoint,
+                            const uint8_t* report,
+                            milliseconds timeout,
+                            Callback callback) {
+  auto transfer = std::make_unique<Transfer>(this, std::move(callback));
+  if (!transfer->xfer) {
+    throw LibusbError(LIBUSB_ERROR_NO_MEM, "failed to allocate USB transfer");
+  }
+  if (report) {
+    memcpy(transfer->buf, report, REPORT_SIZE);
+  }
+  libusb_fill_interrupt_transfer(transfer->xfer, handle_, endpoint,
+                                 transfer->buf, REPORT_SIZE,
+                                 &LibusbEndpoint::transferDone,
+                                 transfer.get(), timeout.count());
+  int rc = libusb_submit_transfer(transfer->xfer);
+  if (rc != 0) {
+    throw LibusbError(rc, "failed to submit USB transfer");
+  }
+  pending_.insert(transfer.release());
+}
+
+void LibusbEndpoint::transferDone(libusb_transfer* xfer) {
+  std::unique_ptr<Transfer> transfer(static_cast<Transfer*>(xfer->user_data));
+  transfer->endpoint->pending_.erase(transfer.get());
+
+  // Report failures the way libusb's synchronous API does
+  int rc;
+  switch (xfer->status) {
+    case LIBUSB_TRANSFER_COMPLETED:
+      rc = 0;
+      break;
+    case LIBUSB_TRANSFER_TIMED_OUT:
+      rc = LIBUSB_ERROR_TIMEOUT;
+      break;
+    case LIBUSB_TRANSFER_CANCELLED:
+      rc = LIBUSB_ERROR_INTERRUPTED;
+      break;
+    case LIBUSB_TRANSFER_STALL:
+      rc = LIBUSB_ERROR_PIPE;
+      break;
+    case LIBUSB_TRANSFER_NO_DEVICE:
+      rc = LIBUSB_ERROR_NO_DEVICE;
+      break;
+    case LIBUSB_TRANSFER_OVERFLOW:
+      rc = LIBUSB_ERROR_OVERFLOW;
+      break;
+    default:
+      rc = LIBUSB_ERROR_IO;
+      break;
+  }
+
+  ByteRange report;
+  if (rc == 0 && (xfer->endpoint & LIBUSB_ENDPOINT_IN)) {
+    report = ByteRange(transfer->buf, xfer->actual_length);
+  }
+  transfer->callback(rc, report);
+}
+
+void LibusbEndpoint::handleEvents(milliseconds timeout) {
+  timeval tv;
+  tv.tv_sec = timeout.count() / 1000;
+  tv.tv_usec = (timeout.count() % 1000) * 1000;
+  int rc = libusb_handle_events_timeout_completed(ctx_, &tv, nullptr);
+  if (rc != 0 && rc != LIBUSB_ERROR_INTERRUPTED) {
+    throw LibusbError(rc, "failed to handle USB events");
+  }
+}
+
 }
 
 namespace facebook { namespace fboss {
 
+struct CP2112::Transaction {
+  enum Type {
+    READ,
+    WRITE,
+  };
+
+  Transaction(Type t, uint64_t txnId, TransactionCallback cb)
+    : type(t),
+      id(txnId),
+      callback(std::move(cb)) {}
+
+  StringPiece operation() const {
+    return type == READ ? "read" : "write";
+  }
+
+  const Type type;
+  const uint64_t id;
+  TransactionCallback callback;
+  uint8_t request[CP2112Endpoint::REPORT_SIZE]{0};
+  MutableByteRange readBuf;
+  steady_clock::time_point end;
+  bool started{false};
+  uint32_t statusPolls{0};
+  uint16_t bytesRead{0};
+};
+
 CP2112::CP2112()
   : ownCtx_(true) {
   lastResetTime_ =  std::chrono::steady_clock::now();
@@ -123,6 +286,11 @@ CP2112::CP2112(libusb_context* ctx)
     ownCtx_(false) {
 }
 
+CP2112::CP2112(CP2112Endpoint* endpoint)
+  : externalEndpoint_(endpoint),
+    ownCtx_(false) {
+}
+
 CP2112::~CP2112() {
   close();
   if (ctx_ && ownCtx_) {
@@ -135,9 +303,13 @@ void CP2112::open(bool setSmbusConfig) {
     close();
   };
 
-  openDevice();
-  if (setSmbusConfig) {
-    initSettings();
+  if (externalEndpoint_) {
+    endpoint_ = externalEndpoint_;
+  } else {
+    openDevice();
+    if (setSmbusConfig) {
+      initSettings();
+    }
   }
   // Just in case the device had a transfer in progress or anything
   // when we attached to it, call flushTransfers to cancel any outstanding
@@ -146,6 +318,11 @@ void CP2112::open(bool setSmbusConfig) {
 }
 
 void CP2112::close() {
+  failQueued(std::make_exception_ptr(UsbError("CP2112 device closed")));
+  endpoint_ = nullptr;
+  // Destroying the endpoint waits for any outstanding transfers,
+  // so do this before closing the handle.
+  usbEndpoint_.reset();
   handle_.close();
   dev_.reset();
 }
@@ -280,18 +457,34 @@ void CP2112::setSMBusConfig(SMBusConfig config) {
   featureReportOut(ReportID::SMBUS_CONFIG, buf, sizeof(buf));
 }
 
-void CP2112::read(uint8_t address,
-                  MutableByteRange buf,
-                  milliseconds timeout) {
-  if (buf.size() > 512) {
+void CP2112::checkReadLength(size_t length) {
+  if (length > 512) {
     throw UsbError("cannot read more than 512 bytes at once");
   }
-  if (buf.size() < 1) {
+  if (length < 1) {
     // As far as I can tell, CP2112 doesn't support 0-length "quick" reads.
     // The docs indicate that 0-lengths reads will be ignored.  The transfer
     // status after issuing a 0-length read appears to confirm this.
     throw UsbError("0-length reads are not allowed");
   }
+}
+
+void CP2112::checkWriteLength(size_t length) {
+  if (length > 61) {
+    throw UsbError("cannot write more than 61 bytes at once");
+  }
+  if (length < 1) {
+    // As far as I can tell, CP2112 doesn't support 0-length "quick" writes.
+    // The docs indicate that 0-lengths writes will be ignored.  The transfer
+    // status after issuing a 0-length write appears to confirm this.
+    throw UsbError("attempted 0-length write");
+  }
+}
+
+void CP2112::read(uint8_t address,
+                  MutableByteRange buf,
+                  milliseconds timeout) {
+  checkReadLength(buf.size());
   ensureGoodState();
 
   // Send the read request
@@ -306,15 +499,7 @@ void CP2112::read(uint8_t address,
 }
 
 void CP2112::write(uint8_t address, ByteRange buf, milliseconds timeout) {
-  if (buf.size() > 61) {
-    throw UsbError("cannot write more than 61 bytes at once");
-  }
-  if (buf.size() < 1) {
-    // As far as I can tell, CP2112 doesn't support 0-length "quick" writes.
-    // The docs indicate that 0-lengths writes will be ignored.  The transfer
-    // status after issuing a 0-length write appears to confirm this.
-    throw UsbError("attempted 0-length write");
-  }
+  checkWriteLength(buf.size());
   ensureGoodState();
 
   // Send the write request
@@ -362,10 +547,362 @@ void CP2112::writeReadUnsafe(uint8_t address,
   processReadResponse(readBuf, timeout);
 }
 
+void CP2112::readAsync(uint8_t address,
+                       MutableByteRange buf,
+                       TransactionCallback callback) {
+  checkReadLength(buf.size());
+
+  auto txn = std::make_unique<Transaction>(
+      Transaction::READ, nextTransactionId_++, std::move(callback));
+  txn->request[0] = ReportID::READ_REQUEST;
+  txn->request[1] = address;
+  setBE<uint16_t>(txn->request + 2, buf.size());
+  txn->readBuf = buf;
+  queue_.push_back(std::move(txn));
+}
+
+void CP2112::writeAsync(uint8_t address,
+                        ByteRange buf,
+                        TransactionCallback callback) {
+  checkWriteLength(buf.size());
+
+  auto txn = std::make_unique<Transaction>(
+      Transaction::WRITE, nextTransactionId_++, std::move(callback));
+  txn->request[0] = ReportID::WRITE;
+  txn->request[1] = address;
+  txn->request[2] = buf.size();
+  memcpy(txn->request + 3, buf.begin(), buf.size());
+  queue_.push_back(std::move(txn));
+}
+
+void CP2112::runQueue() {
+  CHECK(isOpen());
+
+  // Callbacks may queue more transactions after a failure has emptied the
+  // queue, so keep going until it stays empty.
+  while (!queue_.empty()) {
+    try {
+      ensureGoodState();
+    } catch (const std::exception&) {
+      failQueued(std::current_exception());
+      continue;
+    }
+
+    // Everything from here on happens in the transfer callbacks.  Transfers
+    // submitted for a transaction that has since failed may still be
+    // outstanding, and are waited for too.
+    startTransaction();
+    try {
+      while ((!queue_.empty() && queue_.front()->started) ||
+             transfersInFlight_ > 0) {
+        endpoint_->handleEvents(milliseconds(10));
+      }
+    } catch (const std::exception&) {
+      busGood_ = false;
+      failQueued(std::current_exception());
+      throw;
+    }
+  }
+}
+
+CP2112::Transaction* CP2112::currentTransaction(uint64_t id) {
+  if (queue_.empty() || queue_.front()->id != id) {
+    return nullptr;
+  }
+  return queue_.front().get();
+}
+
+void CP2112::startTransaction() {
+  if (queue_.empty()) {
+    return;
+  }
+
+  auto txn = queue_.front().get();
+  auto id = txn->id;
+  txn->started = true;
+  txn->end = steady_clock::now() + defaultTimeout_;
+  submitOutAsync(id,
+                 txn->type == Transaction::READ ? "read" : "write request",
+                 txn->request, defaultTimeout_);
+  // Start polling the transfer status straight away, rather than waiting for
+  // the request to be sent first.
+  if (currentTransaction(id)) {
+    pollTransferStatus(txn);
+  }
+}
+
+void CP2112::finishTransaction(std::exception_ptr error) {
+  DCHECK(!queue_.empty());
+  auto txn = std::move(queue_.front());
+  queue_.pop_front();
+  if (error) {
+    // The rest of the queue fails along with it.  Transactions queued by the
+    // callbacks are left for runQueue() to start afresh.
+    failQueued(error, std::move(txn));
+    return;
+  }
+  txn->callback(nullptr);
+  startTransaction();
+}
+
+void CP2112::failQueued(std::exception_ptr error,
+                        std::unique_ptr<Transaction> first) {
+  std::deque<std::unique_ptr<Transaction>> failed;
+  failed.swap(queue_);
+  if (first) {
+    failed.push_front(std::move(first));
+  }
+  for (auto& txn : failed) {
+    txn->callback(error);
+  }
+}
+
+void CP2112::pollTransferStatus(Transaction* txn) {
+  auto id = txn->id;
+  ++txn->statusPolls;
+  uint8_t usbBuf[CP2112Endpoint::REPORT_SIZE]{
+    ReportID::XFER_STATUS_REQUEST, 1};
+  auto timeLeft = duration_cast<milliseconds>(txn->end - steady_clock::now());
+  submitOutAsync(id, "get xfer status", usbBuf, timeLeft);
+  if (!currentTransaction(id)) {
+    return;
+  }
+  // As in getTransferStatusImpl(), always allow 20ms for the response
+  submitInAsync(id, milliseconds(20),
+                [this](Transaction* t, int rc, ByteRange report) {
+                  onTransferStatus(t, rc, report);
+                });
+}
+
+void CP2112::onTransferStatus(Transaction* txn, int rc, ByteRange report) {
+  auto operation = txn->operation();
+  if (rc != 0) {
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        LibusbError(rc, "error waiting for interrupt response")));
+    return;
+  }
+
+  if (report[0] == ReportID::READ_RESPONSE && txn->statusPolls == 1) {
+    // A final empty READ_RESPONSE left over from a previous read, as handled
+    // in getTransferStatusImpl().  Our XFER_STATUS_RESPONSE follows it.
+    if (report[2] != 0) {
+      busGood_ = false;
+      finishTransaction(std::make_exception_ptr(UsbError(
+          "unexepected response length ", (int)report[2], "should be 0.")));
+      return;
+    }
+    ++txn->statusPolls;
+    submitInAsync(txn->id, milliseconds(20),
+                  [this](Transaction* t, int rc2, ByteRange report2) {
+                    onTransferStatus(t, rc2, report2);
+                  });
+    return;
+  }
+
+  if (report[0] != ReportID::XFER_STATUS_RESPONSE) {
+    LOG(DFATAL) << "received unexpected interrupt response while waiting on "
+      << operation << " transfer status: " << (int)report[0];
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("unexpected response ", (int)report[0],
+                 "while waiting on ", operation, " transfer status")));
+    return;
+  }
+
+  uint8_t status0 = report[1];
+  uint8_t status1 = report[2];
+  VLOG(5) << operation << " xfer status:"
+    << " status0=" << (int)status0
+    << " status1=" << (int)status1
+    << " status2=" << readBE<uint16_t>(report.data() + 3)
+    << " status3=" << readBE<uint16_t>(report.data() + 5);
+
+  if (status0 == 2) {
+    // successfully completed
+    if (txn->type == Transaction::READ) {
+      forceSendRead(txn);
+    } else {
+      finishTransaction(nullptr);
+    }
+  } else if (status0 == 3) {
+    finishTransaction(std::make_exception_ptr(UsbError(
+        operation, " failed: ", getCompleteStatusMsg(status1))));
+  } else if (status0 != 1) {
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("unexpected transaction status ", status0,
+                 " while waiting on ", operation, " completion")));
+  } else if (steady_clock::now() >= txn->end) {
+    // Cancel the transfer, and leave resyncing with the device to
+    // ensureGoodState() rather than waiting for the cancel here.
+    auto id = txn->id;
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("timed out waiting on ", operation, " response: ",
+                 getBusyStatusMsg(status1))));
+    uint8_t usbBuf[CP2112Endpoint::REPORT_SIZE]{ReportID::CANCEL_XFER, 1};
+    submitOutAsync(id, "cancel transfer", usbBuf, milliseconds(5));
+  } else {
+    // Still busy.  Poll again immediately: the round trip over USB is delay
+    // enough.
+    pollTransferStatus(txn);
+  }
+}
+
+void CP2112::forceSendRead(Transaction* txn) {
+  // See processReadResponse() for how the read response is fetched.
+  auto id = txn->id;
+  uint8_t usbBuf[CP2112Endpoint::REPORT_SIZE]{ReportID::READ_FORCE_SEND, 1};
+  submitOutAsync(id, "read force send", usbBuf, milliseconds(5));
+  if (!currentTransaction(id)) {
+    return;
+  }
+  submitInAsync(id, milliseconds(10),
+                [this](Transaction* t, int rc, ByteRange report) {
+                  onReadResponse(t, rc, report);
+                });
+}
+
+void CP2112::onReadResponse(Transaction* txn, int rc, ByteRange report) {
+  if (rc == LIBUSB_ERROR_TIMEOUT) {
+    if (steady_clock::now() >= txn->end) {
+      finishTransaction(std::make_exception_ptr(
+          UsbError("timed out waiting on read response data")));
+    } else {
+      VLOG(1) << "timed out waiting on READ_RESPONSE, sending READ_FORCE_SEND";
+      forceSendRead(txn);
+    }
+    return;
+  } else if (rc != 0) {
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        LibusbError(rc, "error waiting for interrupt response")));
+    return;
+  }
+
+  if (report[0] != ReportID::READ_RESPONSE) {
+    LOG(DFATAL) << "received unexpected interrupt response while waiting on "
+      "read response: " << (int)report[0];
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("unexpected device status waiting on read response")));
+    return;
+  }
+
+  uint8_t status = report[1];
+  uint8_t length = report[2];
+  VLOG(5) << "SMBus read response: status=" << (int)status
+    << ", length=" << (int)length;
+  if (length > CP2112Endpoint::REPORT_SIZE - 3 ||
+      size_t(txn->bytesRead) + length > txn->readBuf.size()) {
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("read response of ", length, " bytes overruns ",
+                 txn->readBuf.size(), " byte read")));
+    return;
+  }
+  memcpy(txn->readBuf.begin() + txn->bytesRead, report.data() + 3, length);
+  txn->bytesRead += length;
+
+  if (status == 0 || status == 2) {
+    // As in processReadResponse(), wait for the final 0-length response
+    if (txn->bytesRead == txn->readBuf.size() && length == 0) {
+      finishTransaction(nullptr);
+      return;
+    }
+  } else if (status != 1) {
+    LOG(DFATAL) << "unexpected read failure after successful "
+      << "XFER_STATUS_RESPONSE";
+    busGood_ = false;
+    finishTransaction(std::make_exception_ptr(
+        UsbError("unexpected status ", status,
+                 " while waiting on read response")));
+    return;
+  }
+
+  if (steady_clock::now() >= txn->end) {
+    finishTransaction(std::make_exception_ptr(
+        UsbError("timed out waiting on read response data")));
+  } else if (txn->bytesRead < txn->readBuf.size() && length < 61) {
+    forceSendRead(txn);
+  } else {
+    submitInAsync(txn->id, milliseconds(10),
+                  [this](Transaction* t, int rc2, ByteRange report2) {
+                    onReadResponse(t, rc2, report2);
+                  });
+  }
+}
+
+void CP2112::submitOutAsync(uint64_t id,
+                            StringPiece name,
+                            const uint8_t* report,
+                            milliseconds timeout) {
+  vlogHex(6, "intr out:", report, CP2112Endpoint::REPORT_SIZE);
+  auto callback = [this, id, name](int rc, ByteRange) {
+    --transfersInFlight_;
+    if (rc != 0 && currentTransaction(id)) {
+      busGood_ = false;
+      finishTransaction(std::make_exception_ptr(
+          LibusbError(rc, "failed to send ", name, " request")));
+    }
+  };
+
+  // Use the same minimum timeout as intrOut()
+  ++transfersInFlight_;
+  try {
+    endpoint_->submitOut(report, std::max(timeout, milliseconds(5)),
+                         std::move(callback));
+  } catch (const std::exception&) {
+    --transfersInFlight_;
+    busGood_ = false;
+    if (currentTransaction(id)) {
+      finishTransaction(std::current_exception());
+    }
+  }
+}
+
+void CP2112::submitInAsync(uint64_t id,
+                           milliseconds timeout,
+                           ResponseHandler handler) {
+  auto callback = [this, id, handler](int rc, ByteRange report) {
+    --transfersInFlight_;
+    auto txn = currentTransaction(id);
+    if (!txn) {
+      // The transaction has already failed
+      return;
+    }
+    if (rc == 0) {
+      if (report.size() != CP2112Endpoint::REPORT_SIZE) {
+        busGood_ = false;
+        finishTransaction(std::make_exception_ptr(
+            UsbError("unexpected interrupt response length received from "
+                     "CP2112:", report.size())));
+        return;
+      }
+      vlogHex(6, "intr in:", report.data(), report.size());
+    }
+    handler(txn, rc, report);
+  };
+
+  ++transfersInFlight_;
+  try {
+    endpoint_->submitIn(timeout, std::move(callback));
+  } catch (const std::exception&) {
+    --transfersInFlight_;
+    busGood_ = false;
+    if (currentTransaction(id)) {
+      finishTransaction(std::current_exception());
+    }
+  }
+}
+
 void CP2112::openDevice() {
   dev_ = UsbDevice::find(ctx_, VENDOR_ID, PRODUCT_ID);
   handle_ = dev_.open();
   handle_.claimInterface(0);
+  usbEndpoint_ = std::make_unique<LibusbEndpoint>(ctx_, handle_.handle());
+  endpoint_ = usbEndpoint_.get();
 }
 
 void CP2112::initSettings() {
@@ -773,7 +1310,7 @@ milliseconds CP2112::updateTimeLeft(steady_clock::time_point end, bool sleep) {
 uint16_t CP2112::featureReportIn(ReportID report,
                                  uint8_t* buf,
                                  uint16_t length) {
-  CHECK(isOpen());
+  CHECK(handle_.isOpen());
   uint8_t bRequestType = (LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_CLASS |
                           LIBUSB_RECIPIENT_INTERFACE);
   uint8_t bRequest = Hid::GET_REPORT;
@@ -803,6 +1340,7 @@ void CP2112::fullFeatureReportIn(ReportID report,
 void CP2112::featureReportOut(ReportID report,
                               const uint8_t* buf,
                               uint16_t length) {
+  CHECK(handle_.isOpen());
   uint8_t bRequestType = (LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_CLASS |
                           LIBUSB_RECIPIENT_INTERFACE);
   uint8_t bRequest = Hid::SET_REPORT;
@@ -826,13 +1364,9 @@ void CP2112::intrOut(StringPiece name,
                      const uint8_t* buf, uint16_t length,
                      milliseconds timeout) {
   // The CP2112 always uses 64-byte interrupt transfers.
-  DCHECK_EQ(length, 64);
+  DCHECK_EQ(length, CP2112Endpoint::REPORT_SIZE);
   vlogHex(6, "intr out:", buf, length);
 
-  // The CP2112 always uses endpoint 1 for interrupt transfers.
-  uint8_t outEndpoint = LIBUSB_ENDPOINT_OUT | 1;
-  int lenResult;
-
   // Always pass in a timeout of at least 5ms, even if the caller specifies
   // something smaller.  We generally don't want to timeout inside
   // libusb calls--if this occurs we can't easily tell if the tranfer was sent
@@ -840,11 +1374,9 @@ void CP2112::intrOut(StringPiece name,
   //
   // This minimum timeout helps ensure that we timeout inside our own timeout
   // checks, and not inside libusb calls.
-  int usbTimeout = std::max(timeout.count(), 5L);
+  auto usbTimeout = std::max(timeout, milliseconds(5));
 
-  int rc = libusb_interrupt_transfer(handle_.handle(), outEndpoint,
-                                     const_cast<uint8_t*>(buf), length,
-                                     &lenResult, usbTimeout);
+  int rc = transferSync(buf, nullptr, nullptr, usbTimeout);
   if (rc != 0) {
     busGood_ = false;
     throw LibusbError(rc, "failed to send ", name, " request");
@@ -854,19 +1386,14 @@ void CP2112::intrOut(StringPiece name,
 void CP2112::intrIn(uint8_t* buf, uint16_t length,
                     milliseconds timeout) {
   // The CP2112 always uses 64-byte interrupt transfers.
-  DCHECK_EQ(length, 64);
-
-  // The CP2112 always uses endpoint 1 for interrupt transfers.
-  uint8_t outEndpoint = LIBUSB_ENDPOINT_IN | 1;
-  int lenResult;
+  DCHECK_EQ(length, CP2112Endpoint::REPORT_SIZE);
 
   // Pass in a timeout of at least 1ms for libusb.
   // With a timeout of 0 libusb won't even bother checking for available data,
   // it just returns a timeout error immediately.
-  int usbTimeout = std::max(timeout.count(), 1L);
-  int rc = libusb_interrupt_transfer(handle_.handle(), outEndpoint,
-                                     buf, length,
-                                     &lenResult, usbTimeout);
+  auto usbTimeout = std::max(timeout, milliseconds(1));
+  uint16_t lenResult{0};
+  int rc = transferSync(nullptr, buf, &lenResult, usbTimeout);
   if (rc != 0) {
     busGood_ = false;
     throw LibusbError(rc, "error waiting for interrupt response");
@@ -879,6 +1406,47 @@ void CP2112::intrIn(uint8_t* buf, uint16_t length,
   vlogHex(6, "intr in:", buf, length);
 }
 
+int CP2112::transferSync(const uint8_t* out,
+                         uint8_t* in,
+                         uint16_t* inLength,
+                         milliseconds timeout) {
+  CHECK(isOpen());
+  DCHECK_EQ(transfersInFlight_, 0) << "blocking CP2112 call while running "
+    "queued transactions";
+
+  // The result lives on the heap, so that if handleEvents() throws the
+  // transfer can still complete into it later.
+  struct Result {
+    bool done{false};
+    int rc{0};
+    uint16_t length{0};
+    uint8_t report[CP2112Endpoint::REPORT_SIZE];
+  };
+  auto result = std::make_shared<Result>();
+  auto callback = [result](int rc, ByteRange report) {
+    result->rc = rc;
+    result->length = std::min<size_t>(report.size(), sizeof(result->report));
+    memcpy(result->report, report.data(), result->length);
+    result->done = true;
+  };
+
+  if (out) {
+    endpoint_->submitOut(out, timeout, std::move(callback));
+  } else {
+    endpoint_->submitIn(timeout, std::move(callback));
+  }
+  // The transfer's own timeout bounds how long this takes
+  while (!result->done) {
+    endpoint_->handleEvents(timeout);
+  }
+
+  if (in) {
+    memcpy(in, result->report, result->length);
+    *inLength = result->length;
+  }
+  return result->rc;
+}
+
 bool CP2112::SMBusConfig::operator==(const SMBusConfig& other) const {
   return memcmp(this, &other, sizeof(SMBusConfig)) == 0;
 }
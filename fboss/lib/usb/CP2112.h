@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include "fboss/lib/usb/CP2112Endpoint.h"
 #include "fboss/lib/usb/UsbDevice.h"
 #include "fboss/lib/usb/UsbHandle.h"
 
@@ -16,18 +17,24 @@
 
 #include <chrono>
 #include <cstdint>
-
-struct libusb_transfer;
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
 
 namespace facebook { namespace fboss {
 
 /*
  * An interface to the Silicon Labs CP2112 USB to SMBus bridge.
  *
- * This currently provides only a blocking API.  It would be straightforward to
- * implement a non-blocking API, but Linux's standard I2C APIs only provide
- * blocking APIs.  Code that wants to deal with other I2C interfaces therefore
- * already has to support blocking operation.
+ * This provides a blocking API, since Linux's standard I2C APIs only provide
+ * blocking APIs, and code that wants to deal with other I2C interfaces
+ * therefore already has to support blocking operation.  Sequences of reads and
+ * writes can also be queued up and run back to back with readAsync(),
+ * writeAsync() and runQueue(), which is considerably faster.
+ *
+ * The device is driven through a CP2112Endpoint, which is normally its USB
+ * interrupt endpoint, but can be a CP2112Simulator instead.
  */
 class CP2112 {
  public:
@@ -207,12 +214,18 @@ class CP2112 {
 
   CP2112();
   explicit CP2112(libusb_context* ctx);
+  /*
+   * Drive a CP2112 through the given endpoint rather than over USB, such as a
+   * CP2112Simulator.  The endpoint must outlive the CP2112.  The feature
+   * report APIs (GPIOs, SMBus config, version, and reset) aren't available.
+   */
+  explicit CP2112(CP2112Endpoint* endpoint);
   ~CP2112();
 
   void open(bool setSmbusConfig=true);
   void close();
   bool isOpen() const {
-    return handle_.isOpen();
+    return endpoint_ != nullptr;
   }
 
   std::chrono::milliseconds getDefaultTimeout() const {
@@ -308,6 +321,47 @@ class CP2112 {
     writeReadUnsafe(address, writeBuf, readBuf, defaultTimeout_);
   }
 
+  /*
+   * Asynchronous transactions.
+   *
+   * readAsync() and writeAsync() queue up an SMBus read or write, with the
+   * same limits as read() and write(), to be run by runQueue().  Queued
+   * transactions run in order.  Each step of a transaction--its request, the
+   * transfer status polls, and fetching the read response--is submitted from
+   * the completion of the step before, as is the request of the next
+   * transaction, so the device is never left waiting on us.  A busy transfer
+   * is polled again straight away, rather than after sleeping as the blocking
+   * calls do.
+   *
+   * The callback is invoked once the transaction is done, with a null
+   * exception_ptr on success.  If a transaction fails, the ones queued after
+   * it are failed with the same error without being run, just as a sequence
+   * of blocking calls would stop at the first exception.  A read's buf must
+   * stay valid until its callback; a write's is copied.  Callbacks may queue
+   * further transactions, but must not throw.
+   */
+  typedef std::function<void(std::exception_ptr)> TransactionCallback;
+
+  void readAsync(uint8_t address, folly::MutableByteRange buf,
+                 TransactionCallback callback);
+  void writeAsync(uint8_t address, folly::ByteRange buf,
+                  TransactionCallback callback);
+  void writeByteAsync(uint8_t address, uint8_t value,
+                      TransactionCallback callback) {
+    writeAsync(address, folly::ByteRange(&value, sizeof(value)),
+               std::move(callback));
+  }
+
+  /*
+   * Run the queued transactions, returning once all of them are done.  Each
+   * transaction has the default timeout.  Failures are only reported to the
+   * callbacks.
+   */
+  void runQueue();
+  size_t numQueued() const {
+    return queue_.size();
+  }
+
   /*
    * Cancel any pending transfers.
    *
@@ -360,9 +414,16 @@ class CP2112 {
   CP2112(CP2112 const &) = delete;
   CP2112& operator=(CP2112 const &) = delete;
 
+  struct Transaction;
+  typedef std::function<void(Transaction* txn, int rc,
+                             folly::ByteRange report)> ResponseHandler;
+
   void openDevice();
   void initSettings();
 
+  static void checkReadLength(size_t length);
+  static void checkWriteLength(size_t length);
+
   void ensureGoodState();
   void flushTransfers();
 
@@ -388,10 +449,36 @@ class CP2112 {
                std::chrono::milliseconds timeout);
   void intrIn(uint8_t* buf, uint16_t length,
               std::chrono::milliseconds timeout);
+  int transferSync(const uint8_t* out, uint8_t* in, uint16_t* inLength,
+                   std::chrono::milliseconds timeout);
+
+  // The transaction queue
+  Transaction* currentTransaction(uint64_t id);
+  void startTransaction();
+  void finishTransaction(std::exception_ptr error);
+  void failQueued(std::exception_ptr error,
+                  std::unique_ptr<Transaction> first = nullptr);
+  void pollTransferStatus(Transaction* txn);
+  void onTransferStatus(Transaction* txn, int rc, folly::ByteRange report);
+  void forceSendRead(Transaction* txn);
+  void onReadResponse(Transaction* txn, int rc, folly::ByteRange report);
+  void submitOutAsync(uint64_t id, folly::StringPiece name,
+                      const uint8_t* report,
+                      std::chrono::milliseconds timeout);
+  void submitInAsync(uint64_t id, std::chrono::milliseconds timeout,
+                     ResponseHandler handler);
 
   libusb_context* ctx_{nullptr};
   UsbDevice dev_;
   UsbHandle handle_;
+  std::unique_ptr<CP2112Endpoint> usbEndpoint_;
+  // The endpoint given to the constructor, if not using USB
+  CP2112Endpoint* const externalEndpoint_{nullptr};
+  // The endpoint in use, while open
+  CP2112Endpoint* endpoint_{nullptr};
+  std::deque<std::unique_ptr<Transaction>> queue_;
+  uint64_t nextTransactionId_{0};
+  uint32_t transfersInFlight_{0};
   bool ownCtx_{false};
   bool busGood_{true};
   std::chrono::milliseconds defaultTimeout_{500};
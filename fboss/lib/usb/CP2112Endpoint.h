@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace facebook { namespace fboss {
+
+/*
+ * The interrupt endpoint that a CP2112 exchanges its SMBus reports over.
+ *
+ * All transfers are asynchronous.  submitOut() and submitIn() return as soon
+ * as the transfer is queued, and its callback is invoked from a later call to
+ * handleEvents() once it is done.  The callback gets 0 or a libusb error code
+ * (LIBUSB_ERROR_TIMEOUT if the transfer didn't complete within its timeout),
+ * and for an IN transfer the report that was received.  Any number of
+ * transfers may be outstanding at once, and the transfers in each direction
+ * complete in the order they were submitted.
+ *
+ * Callbacks may submit further transfers, but must not throw.
+ */
+class CP2112Endpoint {
+ public:
+  enum : uint16_t {
+    REPORT_SIZE = 64,
+  };
+
+  typedef std::function<void(int rc, folly::ByteRange report)> Callback;
+
+  virtual ~CP2112Endpoint() {}
+
+  /*
+   * Send a REPORT_SIZE byte report to the device.  The report is copied, and
+   * needn't stay valid until the transfer completes.
+   */
+  virtual void submitOut(const uint8_t* report,
+                         std::chrono::milliseconds timeout,
+                         Callback callback) = 0;
+  /*
+   * Receive the next report from the device.
+   */
+  virtual void submitIn(std::chrono::milliseconds timeout,
+                        Callback callback) = 0;
+
+  /*
+   * Wait up to timeout for outstanding transfers to complete, and invoke the
+   * callbacks of those that do.
+   */
+  virtual void handleEvents(std::chrono::milliseconds timeout) = 0;
+
+ protected:
+  CP2112Endpoint() {}
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  CP2112Endpoint(CP2112Endpoint const &) = delete;
+  CP2112Endpoint& operator=(CP2112Endpoint const &) = delete;
+};
+
+}} // facebook::fboss
@@ -0,0 +1,311 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/lib/usb/CP2112Simulator.h"
+
+#include "fboss/lib/usb/UsbError.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using folly::ByteRange;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+// The interrupt reports, as in CP2112
+enum ReportID : uint8_t {
+  READ_REQUEST = 0x10,
+  READ_FORCE_SEND = 0x12,
+  READ_RESPONSE = 0x13,
+  WRITE = 0x14,
+  XFER_STATUS_REQUEST = 0x15,
+  XFER_STATUS_RESPONSE = 0x16,
+  CANCEL_XFER = 0x17,
+};
+
+// The most read data a READ_RESPONSE carries
+constexpr size_t kMaxResponseData = 61;
+
+}
+
+namespace facebook { namespace fboss {
+
+void CP2112Simulator::addSwitch(uint8_t address) {
+  Device dev;
+  dev.address = address;
+  dev.isSwitch = true;
+  devices_.push_back(std::move(dev));
+}
+
+void CP2112Simulator::addEeprom(uint8_t address, std::vector<uint8_t> image) {
+  addEeprom(NO_SWITCH, 0, address, std::move(image));
+}
+
+void CP2112Simulator::addEeprom(uint8_t switchAddress,
+                                unsigned int channel,
+                                uint8_t address,
+                                std::vector<uint8_t> image) {
+  CHECK(!image.empty());
+  CHECK_LT(channel, 8);
+  Device dev;
+  dev.address = address;
+  dev.switchAddress = switchAddress;
+  dev.channel = channel;
+  dev.image = std::move(image);
+  devices_.push_back(std::move(dev));
+}
+
+uint8_t CP2112Simulator::getSwitchChannels(uint8_t address) const {
+  auto dev = findDevice(NO_SWITCH, 0, address);
+  CHECK(dev && dev->isSwitch) << "no switch at " << (int)address;
+  return dev->channels;
+}
+
+const std::vector<uint8_t>& CP2112Simulator::getEeprom(
+    uint8_t switchAddress,
+    unsigned int channel,
+    uint8_t address) const {
+  auto dev = findDevice(switchAddress, channel, address);
+  CHECK(dev && !dev->isSwitch) << "no EEPROM at " << (int)address;
+  return dev->image;
+}
+
+CP2112Simulator::Device* CP2112Simulator::findDevice(uint8_t switchAddress,
+                                                     unsigned int channel,
+                                                     uint8_t address) {
+  for (auto& dev : devices_) {
+    if (dev.address == address && dev.switchAddress == switchAddress &&
+        (switchAddress == NO_SWITCH || dev.channel == channel)) {
+      return &dev;
+    }
+  }
+  return nullptr;
+}
+
+const CP2112Simulator::Device* CP2112Simulator::findDevice(
+    uint8_t switchAddress,
+    unsigned int channel,
+    uint8_t address) const {
+  return const_cast<CP2112Simulator*>(this)->findDevice(
+      switchAddress, channel, address);
+}
+
+bool CP2112Simulator::isReachable(const Device& dev) const {
+  if (dev.switchAddress == NO_SWITCH) {
+    return true;
+  }
+  auto sw = findDevice(NO_SWITCH, 0, dev.switchAddress);
+  return sw && sw->isSwitch && (sw->channels & (1 << dev.channel));
+}
+
+CP2112Simulator::Device* CP2112Simulator::addressDevice(uint8_t address,
+                                                        bool* conflict) {
+  Device* found = nullptr;
+  *conflict = false;
+  for (auto& dev : devices_) {
+    if (dev.address == address && isReachable(dev)) {
+      if (found) {
+        *conflict = true;
+      }
+      found = &dev;
+    }
+  }
+  return found;
+}
+
+void CP2112Simulator::submitOut(const uint8_t* report,
+                                milliseconds timeout,
+                                Callback callback) {
+  Transfer transfer;
+  transfer.seqNum = nextSeqNum_++;
+  std::copy(report, report + REPORT_SIZE, transfer.report.begin());
+  transfer.deadline = steady_clock::now() + timeout;
+  transfer.callback = std::move(callback);
+  outs_.push_back(std::move(transfer));
+}
+
+void CP2112Simulator::submitIn(milliseconds timeout, Callback callback) {
+  Transfer transfer;
+  transfer.seqNum = nextSeqNum_++;
+  transfer.deadline = steady_clock::now() + timeout;
+  transfer.callback = std::move(callback);
+  ins_.push_back(std::move(transfer));
+}
+
+void CP2112Simulator::handleEvents(milliseconds timeout) {
+  auto end = steady_clock::now() + timeout;
+  while (true) {
+    auto now = steady_clock::now();
+    bool progress = false;
+    while (completeOne(now)) {
+      progress = true;
+    }
+    if (progress || ins_.empty() || now >= end) {
+      return;
+    }
+    // Nothing to do until the first IN transfer times out
+    std::this_thread::sleep_until(std::min(end, ins_.front().deadline));
+  }
+}
+
+bool CP2112Simulator::completeOne(steady_clock::time_point now) {
+  // The device sees an OUT report before any IN transfer submitted after it,
+  // but OUT transfers don't wait on IN transfers that have no response.
+  bool outFirst = !outs_.empty() &&
+    (ins_.empty() || outs_.front().seqNum < ins_.front().seqNum);
+  if (!outFirst && !ins_.empty() &&
+      (!responses_.empty() || ins_.front().deadline <= now)) {
+    auto transfer = std::move(ins_.front());
+    ins_.pop_front();
+    if (responses_.empty()) {
+      transfer.callback(LIBUSB_ERROR_TIMEOUT, ByteRange());
+      return true;
+    }
+    transfer.report = responses_.front();
+    responses_.pop_front();
+    ++numReports_;
+    transfer.callback(0, ByteRange(transfer.report.data(), REPORT_SIZE));
+    return true;
+  }
+
+  if (outs_.empty()) {
+    return false;
+  }
+  auto transfer = std::move(outs_.front());
+  outs_.pop_front();
+  ++numReports_;
+  processOut(transfer.report);
+  transfer.callback(0, ByteRange());
+  return true;
+}
+
+void CP2112Simulator::processOut(const Report& report) {
+  switch (report[0]) {
+    case READ_REQUEST:
+      startTransfer(State::READ, report[1], (report[2] << 8) | report[3],
+                    nullptr);
+      break;
+    case WRITE:
+      startTransfer(State::WRITE, report[1], report[2], &report[3]);
+      break;
+    case XFER_STATUS_REQUEST:
+      sendTransferStatus();
+      break;
+    case READ_FORCE_SEND:
+      sendReadResponses();
+      break;
+    case CANCEL_XFER:
+      state_ = State::IDLE;
+      break;
+    default:
+      VLOG(2) << "simulated CP2112 ignoring report " << (int)report[0];
+      break;
+  }
+}
+
+void CP2112Simulator::startTransfer(State state,
+                                    uint8_t address,
+                                    size_t length,
+                                    const uint8_t* writeData) {
+  auto now = steady_clock::now();
+  state_ = state;
+  failed_ = false;
+  readData_.clear();
+  readSent_ = 0;
+
+  bool conflict;
+  auto dev = addressDevice(address, &conflict);
+  if (!dev || conflict) {
+    // Nothing acknowledges the address, or several devices do and fight
+    // over the bus.
+    failed_ = true;
+    failStatus_ = conflict ? 2 : 0;
+    busyUntil_ = now + byteTime_;
+    return;
+  }
+
+  // The data, plus the address byte
+  busyUntil_ = now + byteTime_ * static_cast<int64_t>(length + 1);
+  if (state == State::READ) {
+    for (size_t n = 0; n < length; ++n) {
+      if (dev->isSwitch) {
+        readData_.push_back(dev->channels);
+      } else {
+        readData_.push_back(dev->image[dev->offset]);
+        dev->offset = (dev->offset + 1) % dev->image.size();
+      }
+    }
+  } else if (dev->isSwitch) {
+    dev->channels = writeData[length - 1];
+  } else {
+    dev->offset = writeData[0] % dev->image.size();
+    for (size_t n = 1; n < length; ++n) {
+      dev->image[dev->offset] = writeData[n];
+      dev->offset = (dev->offset + 1) % dev->image.size();
+    }
+  }
+}
+
+void CP2112Simulator::sendTransferStatus() {
+  Report report{};
+  report[0] = XFER_STATUS_RESPONSE;
+  if (state_ == State::IDLE) {
+    report[1] = 0;
+  } else if (steady_clock::now() < busyUntil_) {
+    report[1] = 1;
+    report[2] = state_ == State::READ ? 2 : 3;
+  } else if (failed_) {
+    report[1] = 3;
+    report[2] = failStatus_;
+  } else {
+    report[1] = 2;
+    report[2] = 5;
+    report[5] = readData_.size() >> 8;
+    report[6] = readData_.size() & 0xff;
+  }
+  responses_.push_back(report);
+}
+
+void CP2112Simulator::sendReadResponses() {
+  if (state_ == State::READ && steady_clock::now() < busyUntil_) {
+    sendReport(READ_RESPONSE, 1, nullptr, 0);
+    return;
+  }
+  if (state_ == State::READ && !failed_) {
+    while (readSent_ < readData_.size()) {
+      auto length = std::min(kMaxResponseData, readData_.size() - readSent_);
+      sendReport(READ_RESPONSE, 2, readData_.data() + readSent_, length);
+      readSent_ += length;
+    }
+    state_ = State::IDLE;
+  }
+  // Like the chip, always finish with an empty response
+  sendReport(READ_RESPONSE, 0, nullptr, 0);
+}
+
+void CP2112Simulator::sendReport(uint8_t id,
+                                 uint8_t status,
+                                 const uint8_t* data,
+                                 uint8_t length) {
+  Report report{};
+  report[0] = id;
+  report[1] = status;
+  report[2] = length;
+  if (length > 0) {
+    memcpy(report.data() + 3, data, length);
+  }
+  responses_.push_back(report);
+}
+
+}} // facebook::fboss
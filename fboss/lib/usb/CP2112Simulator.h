@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/lib/usb/CP2112Endpoint.h"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+/*
+ * A software CP2112, so that the code driving one can be tested and
+ * benchmarked with no device attached.  Hand it to CP2112's endpoint
+ * constructor.
+ *
+ * It answers the interrupt reports the way the chip does, including the
+ * behavior CP2112 works around: read data is only sent after a
+ * READ_FORCE_SEND, and is followed by an extra 0-length READ_RESPONSE.  The
+ * SMBus behind it has PCA9548 switches and EEPROMs on it, which are backed by
+ * in-memory images.  SMBus transfers take as long as they would on the wire,
+ * and report busy until then.  USB latency isn't simulated: reports are
+ * exchanged as soon as handleEvents() is called.
+ *
+ * Addresses are in the on-the-wire format that CP2112 takes.
+ */
+class CP2112Simulator : public CP2112Endpoint {
+ public:
+  CP2112Simulator() {}
+
+  /*
+   * Add a PCA9548 switch to the root bus.
+   */
+  void addSwitch(uint8_t address);
+  /*
+   * Add an EEPROM with the given contents to the root bus, or behind the
+   * given channel (0-7) of a switch.  An EEPROM has a single address pointer,
+   * which writes set with their first byte, and which wraps at the end of
+   * the image.
+   */
+  void addEeprom(uint8_t address, std::vector<uint8_t> image);
+  void addEeprom(uint8_t switchAddress, unsigned int channel,
+                 uint8_t address, std::vector<uint8_t> image);
+
+  /*
+   * The channels the given switch currently has enabled.
+   */
+  uint8_t getSwitchChannels(uint8_t address) const;
+  const std::vector<uint8_t>& getEeprom(uint8_t switchAddress,
+                                        unsigned int channel,
+                                        uint8_t address) const;
+
+  /*
+   * How long each byte takes on the SMBus.  Defaults to the 22.5us of 9 bits
+   * at 400kHz, the speed CP2112 configures.  Zero makes SMBus transfers
+   * instantaneous.
+   */
+  void setByteTime(std::chrono::nanoseconds byteTime) {
+    byteTime_ = byteTime;
+  }
+
+  /*
+   * The number of reports exchanged so far, in both directions.
+   */
+  uint64_t getNumReports() const {
+    return numReports_;
+  }
+
+  void submitOut(const uint8_t* report,
+                 std::chrono::milliseconds timeout,
+                 Callback callback) override;
+  void submitIn(std::chrono::milliseconds timeout,
+                Callback callback) override;
+  void handleEvents(std::chrono::milliseconds timeout) override;
+
+ private:
+  enum : uint8_t {
+    NO_SWITCH = 0,
+  };
+
+  typedef std::array<uint8_t, REPORT_SIZE> Report;
+
+  struct Device {
+    uint8_t address{0};
+    bool isSwitch{false};
+    // Where the device is attached
+    uint8_t switchAddress{NO_SWITCH};
+    uint8_t channel{0};
+    // The enabled channels of a switch
+    uint8_t channels{0};
+    // The contents and address pointer of an EEPROM
+    std::vector<uint8_t> image;
+    size_t offset{0};
+  };
+
+  struct Transfer {
+    uint64_t seqNum;
+    Report report;
+    std::chrono::steady_clock::time_point deadline;
+    Callback callback;
+  };
+
+  enum class State {
+    IDLE,
+    READ,
+    WRITE,
+  };
+
+  // Forbidden copy constructor and assignment operator
+  CP2112Simulator(CP2112Simulator const &) = delete;
+  CP2112Simulator& operator=(CP2112Simulator const &) = delete;
+
+  Device* findDevice(uint8_t switchAddress, unsigned int channel,
+                     uint8_t address);
+  const Device* findDevice(uint8_t switchAddress, unsigned int channel,
+                           uint8_t address) const;
+  bool isReachable(const Device& dev) const;
+  /*
+   * The device that answers the given address, or null if none does.  Sets
+   * conflict if several do.
+   */
+  Device* addressDevice(uint8_t address, bool* conflict);
+
+  bool completeOne(std::chrono::steady_clock::time_point now);
+  void processOut(const Report& report);
+  void startTransfer(State state, uint8_t address, size_t length,
+                     const uint8_t* writeData);
+  void sendTransferStatus();
+  void sendReadResponses();
+  void sendReport(uint8_t id, uint8_t status, const uint8_t* data,
+                  uint8_t length);
+
+  std::vector<Device> devices_;
+  std::chrono::nanoseconds byteTime_{22500};
+
+  // The current SMBus transfer
+  State state_{State::IDLE};
+  bool failed_{false};
+  uint8_t failStatus_{0};
+  std::chrono::steady_clock::time_point busyUntil_;
+  std::vector<uint8_t> readData_;
+  size_t readSent_{0};
+
+  // Reports waiting to be taken by IN transfers
+  std::deque<Report> responses_;
+  std::deque<Transfer> outs_;
+  std::deque<Transfer> ins_;
+  uint64_t nextSeqNum_{0};
+  uint64_t numReports_{0};
+};
+
+}} // facebook::fboss
@@ -19,6 +19,10 @@ namespace facebook { namespace fboss {
 WedgeI2CBus::WedgeI2CBus() {
 }
 
+WedgeI2CBus::WedgeI2CBus(CP2112Endpoint* endpoint)
+  : BaseWedgeI2CBus(endpoint) {
+}
+
 void WedgeI2CBus::initBus() {
   dev_.writeByte(ADDR_SWITCH_1, 0);
   dev_.writeByte(ADDR_SWITCH_2, 0);
@@ -66,19 +70,19 @@ void WedgeI2CBus::selectQsfpImpl(unsigned int port) {
   // to ensure that we never have more than one port selected at a time.
   if (newValues.first == 0) {
     if (newValues.first != oldValues.first) {
-      dev_.writeByte(ADDR_SWITCH_1, newValues.first);
+      busWriteByte(ADDR_SWITCH_1, newValues.first);
     }
     selectedPort_ = NO_PORT; // In case the second write throws
     if (newValues.second != oldValues.second) {
-      dev_.writeByte(ADDR_SWITCH_2, newValues.second);
+      busWriteByte(ADDR_SWITCH_2, newValues.second);
     }
   } else {
     if (newValues.second != oldValues.second) {
-      dev_.writeByte(ADDR_SWITCH_2, newValues.second);
+      busWriteByte(ADDR_SWITCH_2, newValues.second);
     }
     selectedPort_ = NO_PORT; // In case the second write throws
     if (newValues.first != oldValues.first) {
-      dev_.writeByte(ADDR_SWITCH_1, newValues.first);
+      busWriteByte(ADDR_SWITCH_1, newValues.first);
     }
   }
   selectedPort_ = port;
@@ -19,6 +19,7 @@ namespace facebook { namespace fboss {
 class WedgeI2CBus : public BaseWedgeI2CBus {
  public:
   WedgeI2CBus();
+  explicit WedgeI2CBus(CP2112Endpoint* endpoint);
   virtual ~WedgeI2CBus() {}
 
  protected:
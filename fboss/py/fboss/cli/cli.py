@@ -312,16 +312,20 @@ class RouteCli(object):
     @click.command()
     @click.option('--client-id', type=int, default=None,
                   help='If pass, show all routes programmed by certain client')
+    @click.option('--prefix', type=str, default=None,
+                  help='If pass, show only the routes within this prefix')
     @click.pass_obj
-    def _table(cli_opts, client_id):
+    def _table(cli_opts, client_id, prefix):
         ''' Show the route table '''
-        route.RouteTableCmd(cli_opts).run(client_id)
+        route.RouteTableCmd(cli_opts).run(client_id, prefix)
 
     @click.command()
+    @click.option('--prefix', type=str, default=None,
+                  help='If pass, show only the routes within this prefix')
     @click.pass_obj
-    def _details(cli_opts):
+    def _details(cli_opts, prefix):
         ''' Show details of the route table '''
-        route.RouteTableDetailsCmd(cli_opts).run()
+        route.RouteTableDetailsCmd(cli_opts).run(prefix)
 
 
 # -- Main Command Group -- #
@@ -11,6 +11,36 @@
 from facebook.network.Address.ttypes import Address, AddressType
 from fboss.cli.utils import utils
 from fboss.cli.commands import commands as cmds
+from neteng.fboss.ctrl.ttypes import IpPrefix, RouteTablePageRequest
+
+# How many routes to ask the agent for at a time
+ROUTE_TABLE_PAGE_SIZE = 1000
+
+
+def parse_prefix(prefix):
+    ip, _, length = prefix.partition('/')
+    addr = utils.ip_to_binary(ip)
+    if not length:
+        length = len(addr.addr) * 8
+    return IpPrefix(ip=addr, prefixLength=int(length))
+
+
+def get_route_table(client, client_id=None, prefix=None, details=False):
+    ''' Fetch the route table a page at a time, yielding the routes (or
+        route details) as they arrive. '''
+    request = RouteTablePageRequest(maxRoutes=ROUTE_TABLE_PAGE_SIZE,
+                                    details=details)
+    if client_id is not None:
+        request.clientId = client_id
+    if prefix is not None:
+        request.prefix = parse_prefix(prefix)
+    while True:
+        page = client.getRouteTablePage(request)
+        for entry in (page.routeDetails if details else page.routes):
+            yield entry
+        if page.cursor is None:
+            return
+        request.cursor = page.cursor
 
 
 def nexthop_to_str(nh):
@@ -61,30 +91,28 @@ class RouteIpCmd(cmds.FbossCmd):
 
 
 class RouteTableCmd(cmds.FbossCmd):
-    def run(self, client_id):
+    def run(self, client_id, prefix=None):
         self._client = self._create_agent_client()
-        if client_id is None:
-            resp = self._client.getRouteTable()
-        else:
-            resp = self._client.getRouteTableByClient(client_id)
-        if not resp:
-            print("No Route Table Entries Found")
-            return
-        for entry in resp:
+        found = False
+        for entry in get_route_table(self._client, client_id, prefix):
+            found = True
             print("Network Address: %s/%d" %
                                 (utils.ip_ntop(entry.dest.ip.addr),
                                             entry.dest.prefixLength))
             # Need to check the nextHopAddresses
             for nextHop in entry.nextHopAddrs:
                 print("\tvia %s" % nexthop_to_str(nextHop))
+        if not found:
+            print("No Route Table Entries Found")
 
 
 class RouteTableDetailsCmd(cmds.FbossCmd):
-    def run(self):
+    def run(self, prefix=None):
         self._client = self._create_agent_client()
-        resp = self._client.getRouteTableDetails()
-        if not resp:
-            print("No Route Table Details Found")
-            return
-        for entry in resp:
+        found = False
+        for entry in get_route_table(self._client, prefix=prefix,
+                                     details=True):
+            found = True
             printRouteDetailEntry(entry)
+        if not found:
+            print("No Route Table Details Found")
@@ -145,4 +145,7 @@ struct TransceiverInfo {
   10: optional Cable cable,
   12: list<Channel> channels,
   13: optional TransceiverSettings settings,
+  // When the data was last read from the transceiver, in seconds since the
+  // epoch
+  14: optional i64 timeCollected,
 }
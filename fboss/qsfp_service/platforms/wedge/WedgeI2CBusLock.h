@@ -17,8 +17,14 @@
 namespace facebook { namespace fboss {
 
 /*
- * A small wrapper around CP2112 which is aware of the topology of wedge's QSFP
- * I2C bus, and can select specific QSFPs to query.
+ * Serializes access to a single I2C controller and everything behind it.
+ * Platforms with several controllers have one of these for each, so that
+ * they can be used in parallel.
+ *
+ * Each access opens the bus and closes it again afterwards, unless the bus
+ * has been opened with open(), which allows for a batch of accesses to
+ * share one open.  That also lets the module that was accessed last stay
+ * selected on the bus.
  */
 class WedgeI2CBusLock {
  public:
@@ -1,35 +1,57 @@
 #include "fboss/qsfp_service/platforms/wedge/WedgeManager.h"
 
+#include <folly/ScopeGuard.h>
 #include <folly/gen/Base.h>
+#include <gflags/gflags.h>
+
+#include <ctime>
 
 #include "fboss/lib/usb/UsbError.h"
 #include "fboss/qsfp_service/sff/QsfpModule.h"
 #include "fboss/qsfp_service/platforms/wedge/WedgeQsfp.h"
 
+DEFINE_int32(qsfp_refresh_interval_secs, 1,
+             "How often to poll the transceivers in the background. Modules "
+             "only re-read their data from I2C once it is 5 seconds old.");
+
 namespace facebook { namespace fboss {
 WedgeManager::WedgeManager(){
 }
 
+WedgeManager::~WedgeManager() {
+  stopRefreshThreads();
+}
+
 void WedgeManager::initTransceiverMap(){
   // If we can't get access to the USB devices, don't bother to
   // create the QSFP objects;  this is likely to be a permanent
   // error.
   try {
-    wedgeI2CBusLock_ = std::make_unique<WedgeI2CBusLock>(getI2CBus());
+    for (auto& bus : getI2CBuses()) {
+      wedgeI2CBusLocks_.push_back(
+          std::make_unique<WedgeI2CBusLock>(std::move(bus)));
+    }
   } catch (const LibusbError& ex) {
     LOG(ERROR) << "failed to initialize USB to I2C interface";
+    wedgeI2CBusLocks_.clear();
     return;
   }
 
   // Wedge port 0 is the CPU port, so the first port associated with
   // a QSFP+ is port 1.  We start the transceiver IDs with 0, though.
   for (int idx = 0; idx < getNumQsfpModules(); idx++) {
-    auto qsfpImpl = std::make_unique<WedgeQsfp>(idx, wedgeI2CBusLock_.get());
+    auto busLock = wedgeI2CBusLocks_.at(getBusSegment(idx)).get();
+    auto qsfpImpl =
+      std::make_unique<WedgeQsfp>(idx, busLock, getBusModule(idx));
     auto qsfp = std::make_unique<QsfpModule>(std::move(qsfpImpl));
     qsfp->detectTransceiver();
     transceivers_.push_back(move(qsfp));
     LOG(INFO) << "making QSFP for " << idx;
   }
+
+  // Have info for every module before any thrift calls come in
+  refreshTransceivers();
+  startRefreshThreads();
 }
 
 void WedgeManager::getTransceiversInfo(std::map<int32_t, TransceiverInfo>& info,
@@ -43,13 +65,119 @@ void WedgeManager::getTransceiversInfo(std::map<int32_t, TransceiverInfo>& info,
 
   for (const auto& i : *ids) {
     TransceiverInfo trans;
-    if (isValidTransceiver(i)) {
-      trans = transceivers_[TransceiverID(i)]->getTransceiverInfo();
+    if (isValidTransceiver(i) && i < snapshots_.size()) {
+      auto snapshot = std::atomic_load(&snapshots_[i]);
+      if (snapshot) {
+        trans = *snapshot;
+      }
     }
     info[i] = trans;
   }
 }
 
+std::vector<std::vector<int>> WedgeManager::getModulesBySegment() const {
+  boost::container::flat_map<int, std::vector<int>> segments;
+  for (int idx = 0; idx < transceivers_.size(); idx++) {
+    segments[getBusSegment(idx)].push_back(idx);
+  }
+  std::vector<std::vector<int>> modules;
+  for (auto& segment : segments) {
+    modules.push_back(std::move(segment.second));
+  }
+  return modules;
+}
+
+void WedgeManager::refreshModules(const std::vector<int>& modules) {
+  // Keep the bus open for the whole pass, rather than opening and verifying
+  // it for every access.  That also saves re-selecting each module for
+  // every read of it.
+  WedgeI2CBusLock* busLock = nullptr;
+  auto segment = modules.empty() ? -1 : getBusSegment(modules.front());
+  if (segment >= 0 && segment < wedgeI2CBusLocks_.size()) {
+    busLock = wedgeI2CBusLocks_[segment].get();
+    try {
+      busLock->open();
+    } catch (const std::exception& ex) {
+      // Each access will try to open it by itself
+      LOG(ERROR) << "Error opening I2C bus segment " << segment << ": "
+                 << ex.what();
+      busLock = nullptr;
+    }
+  }
+  SCOPE_EXIT {
+    if (busLock) {
+      busLock->close();
+    }
+  };
+
+  for (auto idx : modules) {
+    try {
+      std::shared_ptr<const TransceiverInfo> info =
+        std::make_shared<TransceiverInfo>(
+            transceivers_[idx]->getTransceiverInfo());
+      std::atomic_store(&snapshots_[idx], std::move(info));
+    } catch (const std::exception& ex) {
+      // Keep serving the last info we got
+      LOG(ERROR) << "Error refreshing transceiver " << idx << ": "
+                 << ex.what();
+    }
+  }
+}
+
+void WedgeManager::refreshTransceivers() {
+  CHECK(refreshThreads_.empty());
+  snapshots_.resize(transceivers_.size());
+
+  auto segments = getModulesBySegment();
+  if (segments.size() == 1) {
+    refreshModules(segments.front());
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (const auto& modules : segments) {
+    threads.emplace_back([this, &modules] { refreshModules(modules); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void WedgeManager::refreshLoop(const std::vector<int>& modules) {
+  std::unique_lock<std::mutex> lock(refreshMutex_);
+  while (!refreshCond_.wait_for(
+             lock, std::chrono::seconds(FLAGS_qsfp_refresh_interval_secs),
+             [this] { return stopRefresh_; })) {
+    lock.unlock();
+    refreshModules(modules);
+    lock.lock();
+  }
+}
+
+void WedgeManager::startRefreshThreads() {
+  CHECK(refreshThreads_.empty());
+  snapshots_.resize(transceivers_.size());
+  {
+    std::lock_guard<std::mutex> g(refreshMutex_);
+    stopRefresh_ = false;
+  }
+  for (auto& modules : getModulesBySegment()) {
+    refreshThreads_.emplace_back(
+        [this, modules] { refreshLoop(modules); });
+  }
+}
+
+void WedgeManager::stopRefreshThreads() {
+  {
+    std::lock_guard<std::mutex> g(refreshMutex_);
+    stopRefresh_ = true;
+  }
+  refreshCond_.notify_all();
+  for (auto& thread : refreshThreads_) {
+    thread.join();
+  }
+  refreshThreads_.clear();
+}
+
 void WedgeManager::customizeTransceiver(int32_t idx, cfg::PortSpeed speed) {
   transceivers_.at(idx)->customizeTransceiver(speed);
 }
@@ -57,4 +185,10 @@ void WedgeManager::customizeTransceiver(int32_t idx, cfg::PortSpeed speed) {
 std::unique_ptr<BaseWedgeI2CBus> WedgeManager::getI2CBus() {
   return std::make_unique<WedgeI2CBus>();
 }
+
+std::vector<std::unique_ptr<BaseWedgeI2CBus>> WedgeManager::getI2CBuses() {
+  std::vector<std::unique_ptr<BaseWedgeI2CBus>> buses;
+  buses.push_back(getI2CBus());
+  return buses;
+}
 }} // facebook::fboss
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <boost/container/flat_map.hpp>
 
 #include "fboss/lib/usb/WedgeI2CBus.h"
@@ -7,22 +13,79 @@
 #include "fboss/qsfp_service/TransceiverManager.h"
 
 namespace facebook { namespace fboss {
+/*
+ * The transceivers are polled in the background, and getTransceiversInfo()
+ * returns the latest TransceiverInfo read from each, so thrift calls never
+ * wait on I2C.  Each module's info is an immutable snapshot, which the
+ * refresh threads swap in atomically.
+ *
+ * There is a refresh thread for each I2C bus segment, so modules on
+ * segments which can be accessed independently are polled in parallel.
+ * Each segment is a separate I2C controller with its own lock.
+ */
 class WedgeManager : public TransceiverManager {
  public:
   WedgeManager();
-  virtual ~WedgeManager() override {}
+  virtual ~WedgeManager() override;
   void initTransceiverMap() override;
   void getTransceiversInfo(std::map<int32_t, TransceiverInfo>& info,
     std::unique_ptr<std::vector<int32_t>> ids) override;
   void customizeTransceiver(int32_t idx, cfg::PortSpeed speed) override;
 
   virtual int getNumQsfpModules() override { return 16; }
+
+  /*
+   * Refresh the info of every transceiver once, in parallel across bus
+   * segments, and return when done.  This can only be called while the
+   * refresh threads aren't running.
+   */
+  void refreshTransceivers();
+
+  /*
+   * Start and stop polling the transceivers in the background.
+   */
+  void startRefreshThreads();
+  void stopRefreshThreads();
+
  private:
   // Forbidden copy constructor and assignment operator
   WedgeManager(WedgeManager const &) = delete;
   WedgeManager& operator=(WedgeManager const &) = delete;
+
+  // The modules on each bus segment
+  std::vector<std::vector<int>> getModulesBySegment() const;
+  void refreshModules(const std::vector<int>& modules);
+  void refreshLoop(const std::vector<int>& modules);
+
+  // Only ever accessed with std::atomic_load() and std::atomic_store()
+  std::vector<std::shared_ptr<const TransceiverInfo>> snapshots_;
+
+  std::vector<std::thread> refreshThreads_;
+  std::mutex refreshMutex_;
+  std::condition_variable refreshCond_;
+  bool stopRefresh_{false};
+
  protected:
   virtual std::unique_ptr<BaseWedgeI2CBus> getI2CBus();
-  std::unique_ptr<WedgeI2CBusLock> wedgeI2CBusLock_;
+
+  /*
+   * The I2C bus topology.  getI2CBuses() returns a bus for each I2C
+   * controller the modules are attached to, which are the bus segments.
+   * A module is on the segment getBusSegment() returns, and is module
+   * number getBusModule() on that bus.  Modules on different segments
+   * must be accessible at the same time.
+   */
+  virtual std::vector<std::unique_ptr<BaseWedgeI2CBus>> getI2CBuses();
+  virtual int getBusSegment(int module) const {
+    // All the modules are behind a single CP2112
+    return 0;
+  }
+  virtual unsigned int getBusModule(int module) const {
+    // Bus module numbers start at 1
+    return module + 1;
+  }
+
+  // Indexed by bus segment
+  std::vector<std::unique_ptr<WedgeI2CBusLock>> wedgeI2CBusLocks_;
 };
 }} // facebook::fboss
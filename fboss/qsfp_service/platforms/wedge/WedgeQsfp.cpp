@@ -23,8 +23,10 @@ using std::unique_ptr;
 
 namespace facebook { namespace fboss {
 
-WedgeQsfp::WedgeQsfp(int module, WedgeI2CBusLock* wedgeI2CBus)
+WedgeQsfp::WedgeQsfp(int module, WedgeI2CBusLock* wedgeI2CBus,
+                     unsigned int busModule)
   : module_(module),
+    busModule_(busModule),
     wedgeI2CBusLock_(wedgeI2CBus) {
   moduleName_ = folly::to<std::string>(module);
 }
@@ -33,12 +35,13 @@ WedgeQsfp::~WedgeQsfp() {
 }
 
 // Note that the module_ starts at 0, but the USB I2C bus module
-// assumes that QSFP module numbers extend from 1 to 16.
+// assumes that QSFP module numbers extend from 1 to 16, which is what
+// busModule_ is.
 //
 bool WedgeQsfp::detectTransceiver() {
   uint8_t buf[1];
   try {
-    wedgeI2CBusLock_->moduleRead(module_ + 1, TransceiverI2CApi::ADDR_QSFP,
+    wedgeI2CBusLock_->moduleRead(busModule_, TransceiverI2CApi::ADDR_QSFP,
                                  0, sizeof(buf), buf);
   } catch (const UsbError& ex) {
     /*
@@ -55,7 +58,7 @@ bool WedgeQsfp::detectTransceiver() {
 int WedgeQsfp::readTransceiver(int dataAddress, int offset,
                                int len, uint8_t* fieldValue) {
   try {
-    wedgeI2CBusLock_->moduleRead(module_ + 1, dataAddress, offset, len,
+    wedgeI2CBusLock_->moduleRead(busModule_, dataAddress, offset, len,
                                   fieldValue);
   } catch (const UsbError& ex) {
     LOG(ERROR) << "Read from transceiver " << module_ << " at offset " <<
@@ -69,7 +72,7 @@ int WedgeQsfp::readTransceiver(int dataAddress, int offset,
 int WedgeQsfp::writeTransceiver(int dataAddress, int offset,
                             int len, uint8_t* fieldValue) {
   try {
-    wedgeI2CBusLock_->moduleWrite(module_ + 1, dataAddress, offset, len,
+    wedgeI2CBusLock_->moduleWrite(busModule_, dataAddress, offset, len,
                                    fieldValue);
   } catch (const UsbError& ex) {
     LOG(ERROR) << "Write to transceiver " << module_ << " at offset "
@@ -21,7 +21,11 @@ namespace facebook { namespace fboss {
  */
 class WedgeQsfp : public TransceiverImpl {
  public:
-  WedgeQsfp(int module, WedgeI2CBusLock* i2c);
+  /*
+   * busModule is the number the module has on the i2c bus, which may
+   * differ from module when there are several buses.
+   */
+  WedgeQsfp(int module, WedgeI2CBusLock* i2c, unsigned int busModule);
   virtual ~WedgeQsfp() override;
 
   /* This function is used to read the SFP EEprom */
@@ -38,6 +42,7 @@ class WedgeQsfp : public TransceiverImpl {
 
  private:
   int module_;
+  unsigned int busModule_;
   std::string moduleName_;
   WedgeI2CBusLock* wedgeI2CBusLock_;
 };
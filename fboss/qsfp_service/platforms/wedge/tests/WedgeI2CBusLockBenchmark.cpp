@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Memory.h>
+#include "fboss/lib/usb/CP2112Simulator.h"
+#include "fboss/lib/usb/WedgeI2CBus.h"
+#include "fboss/qsfp_service/platforms/wedge/WedgeI2CBusLock.h"
+
+using namespace facebook::fboss;
+
+namespace {
+
+/*
+ * These benchmarks refresh the live data of QSFPs the way QsfpModule does
+ * once it has read a module in full: four small reads of the lower page.
+ * The modules are spread over two simulated CP2112s, with a wedge bus of 16
+ * modules behind each.  The time reported is per module refreshed, so the
+ * iterations per second are the modules refreshed per second.
+ */
+constexpr unsigned int kNumBuses = 2;
+constexpr unsigned int kModulesPerBus = 16;
+constexpr uint8_t kEepromAddr = 0xa2;
+constexpr uint8_t kSwitchAddrs[] = {0xe8, 0xec};
+constexpr uint8_t kQsfpAddr = 0xa0;
+// The offsets and lengths of the reads
+constexpr std::pair<int, int> kDomReads[] = {
+  {191, 1}, {0, 15}, {22, 36}, {87, 12},
+};
+
+struct SimulatedBus {
+  SimulatedBus() {
+    std::vector<uint8_t> image(256, 0);
+    sim.addEeprom(kEepromAddr, image);
+    for (auto sw : kSwitchAddrs) {
+      sim.addSwitch(sw);
+      for (unsigned int channel = 0; channel < 8; ++channel) {
+        sim.addEeprom(sw, channel, kQsfpAddr, image);
+      }
+    }
+    lock = std::make_unique<WedgeI2CBusLock>(
+        std::make_unique<WedgeI2CBus>(&sim));
+  }
+
+  CP2112Simulator sim;
+  std::unique_ptr<WedgeI2CBusLock> lock;
+};
+
+void refreshModule(WedgeI2CBusLock* lock, unsigned int module) {
+  uint8_t buf[128];
+  for (const auto& read : kDomReads) {
+    lock->moduleRead(module, kQsfpAddr >> 1, read.first, read.second, buf);
+  }
+}
+
+/*
+ * Refresh n modules, a pass over the bus at a time, optionally keeping the
+ * bus open for each pass.
+ */
+void refreshModules(WedgeI2CBusLock* lock, unsigned int n, bool openPerPass) {
+  while (n > 0) {
+    if (openPerPass) {
+      lock->open();
+    }
+    for (unsigned int module = 1; module <= kModulesPerBus && n > 0;
+         ++module, --n) {
+      refreshModule(lock, module);
+    }
+    if (openPerPass) {
+      lock->close();
+    }
+  }
+}
+
+} // unnamed namespace
+
+/*
+ * One thread refreshing both buses, opening the bus for every access, as
+ * happened when all the modules were behind one lock.
+ */
+BENCHMARK(SerialOpenPerAccess, numIters) {
+  folly::BenchmarkSuspender braces;
+  SimulatedBus buses[kNumBuses];
+  braces.dismiss();
+
+  for (unsigned int bus = 0; bus < kNumBuses; ++bus) {
+    refreshModules(buses[bus].lock.get(),
+                   numIters / kNumBuses + (bus < numIters % kNumBuses),
+                   false);
+  }
+}
+
+BENCHMARK_RELATIVE(SerialOpenPerPass, numIters) {
+  folly::BenchmarkSuspender braces;
+  SimulatedBus buses[kNumBuses];
+  braces.dismiss();
+
+  for (unsigned int bus = 0; bus < kNumBuses; ++bus) {
+    refreshModules(buses[bus].lock.get(),
+                   numIters / kNumBuses + (bus < numIters % kNumBuses),
+                   true);
+  }
+}
+
+/*
+ * A thread per bus, each with its own lock, as WedgeManager refreshes them.
+ */
+BENCHMARK_RELATIVE(ParallelOpenPerPass, numIters) {
+  folly::BenchmarkSuspender braces;
+  SimulatedBus buses[kNumBuses];
+  braces.dismiss();
+
+  std::vector<std::thread> threads;
+  for (unsigned int bus = 0; bus < kNumBuses; ++bus) {
+    unsigned int n = numIters / kNumBuses + (bus < numIters % kNumBuses);
+    auto lock = buses[bus].lock.get();
+    threads.emplace_back([lock, n] { refreshModules(lock, n, true); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -8,6 +8,9 @@
  *
  */
 
+#include <condition_variable>
+#include <mutex>
+
 #include <folly/Memory.h>
 #include "fboss/agent/gen-cpp2/switch_config_types.h"
 #include "fboss/qsfp_service/if/gen-cpp2/transceiver_types.h"
@@ -47,22 +50,73 @@ class WedgeManagerTest : public ::testing::Test {
 };
 
 TEST_F(WedgeManagerTest, getTransceiverInfo) {
-  // If no ids are passed in, info for all should be returned
-  for (const auto& trans : wedgeManager_->mockTransceivers_) {
-    EXPECT_CALL(*trans, getTransceiverInfo()).Times(1);
+  // The transceivers are only read when refreshing
+  for (int i = 0; i < wedgeManager_->mockTransceivers_.size(); i++) {
+    TransceiverInfo trans;
+    trans.present = true;
+    trans.port = i;
+    EXPECT_CALL(*wedgeManager_->mockTransceivers_[i], getTransceiverInfo())
+      .WillOnce(Return(trans));
   }
+  wedgeManager_->refreshTransceivers();
+
+  // If no ids are passed in, info for all should be returned
   std::map<int32_t, TransceiverInfo> transInfo;
   wedgeManager_->getTransceiversInfo(transInfo,
       std::make_unique<std::vector<int32_t>>());
+  EXPECT_EQ(wedgeManager_->getNumQsfpModules(), transInfo.size());
+  for (const auto& info : transInfo) {
+    EXPECT_TRUE(info.second.present);
+    EXPECT_EQ(info.first, info.second.port);
+  }
 
   // Otherwise, just return the ids requested
+  transInfo.clear();
   std::vector<int32_t> data = {1, 3, 7};
+  wedgeManager_->getTransceiversInfo(transInfo,
+      std::make_unique<std::vector<int32_t>>(data));
+  EXPECT_EQ(data.size(), transInfo.size());
   for (const auto& i : data) {
-    MockQsfpModule* qsfp = wedgeManager_->mockTransceivers_[i];
-    EXPECT_CALL(*qsfp, getTransceiverInfo()).Times(1);
+    EXPECT_EQ(i, transInfo[i].port);
   }
+}
+
+TEST_F(WedgeManagerTest, refreshInBackground) {
+  // Before anything has been read, there is no info
+  std::map<int32_t, TransceiverInfo> transInfo;
   wedgeManager_->getTransceiversInfo(transInfo,
-      std::make_unique<std::vector<int32_t>>(data));
+      std::make_unique<std::vector<int32_t>>(std::vector<int32_t>{0}));
+  EXPECT_FALSE(transInfo[0].present);
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  int numRefreshed = 0;
+  for (auto* trans : wedgeManager_->mockTransceivers_) {
+    TransceiverInfo info;
+    info.present = true;
+    EXPECT_CALL(*trans, getTransceiverInfo())
+      .WillRepeatedly(Invoke([&, info] {
+        std::lock_guard<std::mutex> g(mutex);
+        ++numRefreshed;
+        cond.notify_all();
+        return info;
+      }));
+  }
+
+  wedgeManager_->startRefreshThreads();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&] {
+      return numRefreshed >= wedgeManager_->getNumQsfpModules();
+    });
+  }
+  wedgeManager_->stopRefreshThreads();
+
+  wedgeManager_->getTransceiversInfo(transInfo,
+      std::make_unique<std::vector<int32_t>>());
+  for (const auto& info : transInfo) {
+    EXPECT_TRUE(info.second.present);
+  }
 }
 
 }
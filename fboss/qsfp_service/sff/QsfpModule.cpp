@@ -60,6 +60,7 @@ static SffFieldInfo::SffFieldMap qsfpFields = {
   {SffField::VENDOR_OUI, {QsfpPages::PAGE0, 165, 3} },
   {SffField::PART_NUMBER, {QsfpPages::PAGE0, 168, 16} },
   {SffField::REVISION_NUMBER, {QsfpPages::PAGE0, 184, 2} },
+  {SffField::CHECK_CODE_BASEID, {QsfpPages::PAGE0, 191, 1} },
   {SffField::OPTIONS, {QsfpPages::PAGE0, 195, 1} },
   {SffField::VENDOR_SERIAL_NUMBER, {QsfpPages::PAGE0, 196, 16} },
   {SffField::MFG_DATE, {QsfpPages::PAGE0, 212, 8} },
@@ -540,6 +541,7 @@ void QsfpModule::setPresent(bool present) {
    */
   if (present_ == false) {
     dirty_ = true;
+    staticDataValid_ = false;
   }
 }
 
@@ -560,6 +562,8 @@ TransceiverInfo QsfpModule::getTransceiverInfo() {
     return info;
   }
 
+  info.timeCollected = lastReadTime_;
+  info.__isset.timeCollected = true;
   if (getSensorInfo(info.sensor)) {
     info.__isset.sensor = true;
   }
@@ -595,7 +599,13 @@ void QsfpModule::refreshCacheIfPossibleLocked() {
     dirty_ = true;
   }
   if (!cacheIsValid()) {
+    bool wasPresent = present_;
     detectTransceiverLocked();
+    // A newly inserted module has just been read in full;  one that was
+    // already there only needs its live data refreshed.
+    if (wasPresent && present_) {
+      updateQsfpData();
+    }
   }
 }
 
@@ -640,43 +650,101 @@ int QsfpModule::getFieldValue(SffField fieldName,
 void QsfpModule::updateQsfpData() {
   if (present_) {
     try {
-      LOG(INFO) << "Performing qsfp data cache refresh for transceiver " <<
-        folly::to<std::string>(qsfpImpl_->getName());
-      qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 0,
-          sizeof(qsfpIdprom_), qsfpIdprom_);
-      lastReadTime_ = std::time(nullptr);
-      dirty_ = false;
-      setQsfpIdprom();
-      /*
-       * XXX:  Should we bother to read this other data every time?
-       *       Surely, it isn't changing?  Is there some other utility to
-       *       update this stuff?  Perhaps just reading the base 128 bytes
-       *       is enough after we initially determine that somethings there?
-       */
-
-      // If we have flat memory, we don't have to set the page
-      if (!flatMem_) {
-        uint8_t page = 0;
-        qsfpImpl_->writeTransceiver(TransceiverI2CApi::ADDR_QSFP, 127,
-            sizeof(page), &page);
-      }
-      qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 128,
-          sizeof(qsfpPage0_), qsfpPage0_);
-      if (!flatMem_) {
-        uint8_t page = 3;
-        qsfpImpl_->writeTransceiver(TransceiverI2CApi::ADDR_QSFP, 127,
-            sizeof(page), &page);
-        qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 128,
-            sizeof(qsfpPage3_), qsfpPage3_);
+      if (!staticDataValid_ || !readQsfpDomData()) {
+        LOG(INFO) << "Performing qsfp data cache refresh for transceiver " <<
+          folly::to<std::string>(qsfpImpl_->getName());
+        readAllQsfpPages();
       }
     } catch (const std::exception& ex) {
       dirty_ = true;
+      // We can't tell whether the module was swapped while we failed to
+      // read it, so start over with everything.
+      staticDataValid_ = false;
       LOG(WARNING) << "Error reading data for transceiver:" <<
            folly::to<std::string>(qsfpImpl_->getName()) << " " << ex.what();
     }
   }
 }
 
+void QsfpModule::readAllQsfpPages() {
+  staticDataValid_ = false;
+  qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 0,
+      sizeof(qsfpIdprom_), qsfpIdprom_);
+  lastReadTime_ = std::time(nullptr);
+  dirty_ = false;
+  setQsfpIdprom();
+
+  // If we have flat memory, we don't have to set the page.  Otherwise
+  // read page 3 first, so that page 0 is left selected and readQsfpDomData()
+  // can check its checksum without changing pages.
+  if (!flatMem_) {
+    uint8_t page = 3;
+    qsfpImpl_->writeTransceiver(TransceiverI2CApi::ADDR_QSFP, 127,
+        sizeof(page), &page);
+    qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 128,
+        sizeof(qsfpPage3_), qsfpPage3_);
+    page = 0;
+    qsfpImpl_->writeTransceiver(TransceiverI2CApi::ADDR_QSFP, 127,
+        sizeof(page), &page);
+  }
+  qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, 128,
+      sizeof(qsfpPage0_), qsfpPage0_);
+  staticDataValid_ = true;
+}
+
+bool QsfpModule::readQsfpDomData() {
+  /*
+   * The vendor, cable and threshold data in pages 0 and 3 doesn't change
+   * while the module stays in.  If the module was swapped between two
+   * polls, or its EEPROM rewritten, page 0's checksum (or the identifier)
+   * gives it away, and everything is read again.
+   */
+  int dataAddress;
+  int offset;
+  int length;
+  getQsfpFieldAddress(SffField::CHECK_CODE_BASEID, dataAddress, offset,
+                      length);
+  uint8_t checksum;
+  qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, offset,
+      sizeof(checksum), &checksum);
+  if (checksum != qsfpPage0_[offset - MAX_QSFP_PAGE_SIZE]) {
+    LOG(INFO) << "Static data changed on transceiver " <<
+      folly::to<std::string>(qsfpImpl_->getName());
+    return false;
+  }
+
+  uint8_t identifier = qsfpIdprom_[0];
+  readLowerPageRange(SffField::IDENTIFIER, SffField::CHANNEL_TX_PWR_ALARMS);
+  if (qsfpIdprom_[0] != identifier) {
+    LOG(INFO) << "Identifier changed on transceiver " <<
+      folly::to<std::string>(qsfpImpl_->getName());
+    return false;
+  }
+  lastReadTime_ = std::time(nullptr);
+  dirty_ = false;
+  // Also throws if the module has been reset and is still coming up
+  setQsfpIdprom();
+  readLowerPageRange(SffField::TEMPERATURE, SffField::CHANNEL_TX_PWR);
+  readLowerPageRange(SffField::RATE_SELECT_RX, SffField::CDR_CONTROL);
+  return true;
+}
+
+void QsfpModule::readLowerPageRange(SffField first, SffField last) {
+  int dataAddress;
+  int offset;
+  int length;
+  int lastOffset;
+  getQsfpFieldAddress(first, dataAddress, offset, length);
+  CHECK_EQ(dataAddress, QsfpPages::LOWER);
+  getQsfpFieldAddress(last, dataAddress, lastOffset, length);
+  CHECK_EQ(dataAddress, QsfpPages::LOWER);
+  length = lastOffset + length - offset;
+  CHECK_GT(length, 0);
+  CHECK_LE(offset + length, sizeof(qsfpIdprom_));
+  qsfpImpl_->readTransceiver(TransceiverI2CApi::ADDR_QSFP, offset,
+      length, qsfpIdprom_ + offset);
+}
+
 void QsfpModule::customizeTransceiver(cfg::PortSpeed speed) {
   lock_guard<std::mutex> g(qsfpModuleMutex_);
   refreshCacheIfPossibleLocked();
@@ -116,6 +116,8 @@ class QsfpModule : public Transceiver {
   bool dirty_{false};
   // Flat memory systems don't support paged access to extra data
   bool flatMem_{false};
+  // Whether pages 0 and 3 have been read from the module that is plugged in
+  bool staticDataValid_{false};
 
   /*
    * qsfpModuleMutex_ is held around all the read and writes to the qsfpModule
@@ -285,8 +287,28 @@ class QsfpModule : public Transceiver {
   virtual bool cacheIsValid() const;
   /*
    * Update the cached data with the information from the physical QSFP.
+   *
+   * Everything is read when a module is first seen.  After that only the
+   * live sensors, flags and control bytes are, which is a fraction of the
+   * I2C traffic.
    */
   virtual void updateQsfpData();
+  /*
+   * Read the whole lower page, and upper pages 0 and 3, which hold the
+   * static vendor, cable and threshold data.
+   */
+  void readAllQsfpPages();
+  /*
+   * Read just the sensors, flags and control bytes of the lower page.
+   * Returns false if the module's static data has changed since it was read,
+   * in which case all the pages need to be read again.
+   */
+  bool readQsfpDomData();
+  /*
+   * Read the lower page from the start of the field first through the end
+   * of the field last into the cache.
+   */
+  void readLowerPageRange(SffField first, SffField last);
 };
 
 }} //namespace facebook::fboss
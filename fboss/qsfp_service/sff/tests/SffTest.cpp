@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <folly/Conv.h>
 #include <folly/Memory.h>
+#include <folly/ScopeGuard.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include "fboss/qsfp_service/sff/TransceiverImpl.h"
@@ -45,10 +46,37 @@ class SffTransceiver : public TransceiverImpl {
   folly::StringPiece getName() override;
   int getNum() override;
 
+  /* The I2C traffic so far */
+  int getBytesRead() const {
+    return bytesRead_;
+  }
+  int getNumWrites() const {
+    return numWrites_;
+  }
+  void resetCounters() {
+    bytesRead_ = 0;
+    numWrites_ = 0;
+  }
+
  private:
   int module_;
   std::string moduleName_;
   int page_{0};
+  int bytesRead_{0};
+  int numWrites_{0};
+};
+
+/*
+ * Lets the tests force a refresh without waiting out the read interval.
+ */
+class TestQsfpModule : public QsfpModule {
+ public:
+  explicit TestQsfpModule(std::unique_ptr<TransceiverImpl> qsfpImpl)
+    : QsfpModule(std::move(qsfpImpl)) {}
+
+  void expireCache() {
+    lastReadTime_ = 0;
+  }
 };
 
 static uint8_t pageLower[] = {
@@ -119,6 +147,7 @@ int SffTransceiver::readTransceiver(int dataAddress, int offset,
                                     int len, uint8_t* fieldValue) {
   int read = 0;
   EXPECT_EQ(0x50, dataAddress);
+  bytesRead_ += len;
   if (offset < QsfpModule::MAX_QSFP_PAGE_SIZE) {
     read = len;
     if (QsfpModule::MAX_QSFP_PAGE_SIZE - offset < len) {
@@ -148,6 +177,7 @@ int SffTransceiver::writeTransceiver(int dataAddress, int offset,
   EXPECT_EQ(offset, 127);
   EXPECT_EQ(len, 1);
   page_ = *fieldValue;
+  ++numWrites_;
   return len;
 }
 
@@ -179,4 +209,52 @@ TEST(SffTest, simpleRead) {
   EXPECT_FALSE(info.channels[1].sensors.txBias.flags.alarm.low);
 }
 
+TEST(SffTest, domOnlyRefresh) {
+  // The test changes the module's contents, so put them back afterwards
+  auto savedLower = pageLower[22];
+  auto savedName = page0[20];
+  auto savedChecksum = page0[63];
+  SCOPE_EXIT {
+    pageLower[22] = savedLower;
+    page0[20] = savedName;
+    page0[63] = savedChecksum;
+  };
+
+  auto qsfpImpl = make_unique<SffTransceiver>(1);
+  auto impl = qsfpImpl.get();
+  TestQsfpModule qsfp(std::move(qsfpImpl));
+  const int pageSize = QsfpModule::MAX_QSFP_PAGE_SIZE;
+
+  // Everything is read on insertion
+  TransceiverInfo info = qsfp.getTransceiverInfo();
+  EXPECT_EQ(3 * pageSize, impl->getBytesRead());
+  EXPECT_EQ(2, impl->getNumWrites());
+  EXPECT_DOUBLE_EQ(31.015625, info.sensor.temp.value);
+
+  // Within the read interval, nothing is read
+  impl->resetCounters();
+  qsfp.getTransceiverInfo();
+  EXPECT_EQ(0, impl->getBytesRead());
+
+  // After it, only the live data is, without changing pages
+  pageLower[22] = 0x20;
+  page0[20] = 'B';
+  qsfp.expireCache();
+  info = qsfp.getTransceiverInfo();
+  EXPECT_GT(pageSize, impl->getBytesRead());
+  EXPECT_EQ(0, impl->getNumWrites());
+  EXPECT_DOUBLE_EQ(32.015625, info.sensor.temp.value);
+  EXPECT_EQ("FACETEST", info.vendor.name);
+  EXPECT_DOUBLE_EQ(75.0, info.thresholds.temp.alarm.high);
+
+  // Unless the checksum shows the static data has changed
+  impl->resetCounters();
+  page0[63] ^= 0xff;
+  qsfp.expireCache();
+  info = qsfp.getTransceiverInfo();
+  EXPECT_EQ(3 * pageSize + 1, impl->getBytesRead());
+  EXPECT_EQ(2, impl->getNumWrites());
+  EXPECT_EQ("BACETEST", info.vendor.name);
+}
+
 } // namespace facebook::fboss